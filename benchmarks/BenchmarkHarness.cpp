@@ -0,0 +1,279 @@
+#include "BenchmarkHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+using namespace OurPaintDCM::Benchmark;
+
+namespace {
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+/**
+ * @brief Counters per operation (averaged over the counted regions), IPC and misses per constraint.
+ *
+ * Unmeasured events are omitted; per-constraint ratios need Measurement::constraints.
+ */
+void writeJsonHardware(std::ostream& out, const Measurement& measurement) {
+    const auto& counts = *measurement.hardware;
+    const double operations = static_cast<double>(counts.regions) *
+                              static_cast<double>(std::max<std::size_t>(measurement.operations, 1));
+    out << "{\"regions\": " << counts.regions;
+    for (std::size_t i = 0; i < kHardwareEventCount; ++i) {
+        const auto event = static_cast<HardwareEvent>(i);
+        if (counts.has(event)) {
+            out << ", \"" << hardwareEventName(event) << "\": " << static_cast<double>(counts[event]) / operations;
+        }
+    }
+    if (counts.has(HardwareEvent::ET_CYCLES) && counts.has(HardwareEvent::ET_INSTRUCTIONS)) {
+        out << ", \"ipc\": " << counts.ratio(HardwareEvent::ET_INSTRUCTIONS, HardwareEvent::ET_CYCLES);
+    }
+    if (measurement.constraints > 0) {
+        const double perConstraint = operations * static_cast<double>(measurement.constraints);
+        for (const auto event : {HardwareEvent::ET_L1D_MISSES, HardwareEvent::ET_LLC_MISSES}) {
+            if (counts.has(event)) {
+                out << ", \"" << hardwareEventName(event) << "PerConstraint\": "
+                    << static_cast<double>(counts[event]) / perConstraint;
+            }
+        }
+    }
+    out << '}';
+}
+
+std::string isoTimestamp() {
+    const std::time_t now = std::time(nullptr);
+    std::tm utc{};
+#if defined(_WIN32)
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+}
+
+double OurPaintDCM::Benchmark::percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double position = std::clamp(q, 0.0, 1.0) * static_cast<double>(sorted.size() - 1);
+    const auto lower = static_cast<std::size_t>(std::floor(position));
+    const std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+    const double weight = position - static_cast<double>(lower);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * weight;
+}
+
+Statistics Statistics::of(std::vector<double> samples) {
+    Statistics stats;
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    stats.median = percentile(samples, 0.5);
+    stats.p90 = percentile(samples, 0.9);
+    stats.p95 = percentile(samples, 0.95);
+    stats.p99 = percentile(samples, 0.99);
+    return stats;
+}
+
+Statistics Statistics::of(const LatencyHistogram& histogram) {
+    Statistics stats;
+    stats.min = static_cast<double>(histogram.min());
+    stats.max = static_cast<double>(histogram.max());
+    stats.mean = histogram.mean();
+    stats.median = static_cast<double>(histogram.valueAtQuantile(0.5));
+    stats.p90 = static_cast<double>(histogram.valueAtQuantile(0.9));
+    stats.p95 = static_cast<double>(histogram.valueAtQuantile(0.95));
+    stats.p99 = static_cast<double>(histogram.valueAtQuantile(0.99));
+    return stats;
+}
+
+Options Options::parse(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + flag);
+            }
+            return argv[++i];
+        };
+        if (flag == "--output") {
+            options.output = value();
+        } else if (flag == "--repetitions") {
+            options.repetitions = std::max<std::size_t>(std::stoul(value()), 1);
+        } else if (flag == "--max-entities") {
+            options.maxEntities = std::stoul(value());
+        } else if (flag == "--filter") {
+            options.filter = value();
+        } else if (flag == "--family") {
+            options.family = value();
+        } else if (flag == "--frames") {
+            options.frames = std::max<std::size_t>(std::stoul(value()), 1);
+        } else if (flag == "--path") {
+            options.path = value();
+        } else if (flag == "--perf-counters") {
+            options.perfCounters = true;
+        } else {
+            throw std::invalid_argument("Unknown option " + flag +
+                                        " (expected --output, --repetitions, --max-entities, --filter,"
+                                        " --family, --frames, --path, --perf-counters)");
+        }
+    }
+    return options;
+}
+
+std::vector<std::size_t> OurPaintDCM::Benchmark::scalingSizes(std::size_t maxEntities, std::size_t minEntities) {
+    std::vector<std::size_t> sizes;
+    for (std::size_t size = std::max<std::size_t>(minEntities, 1); size <= std::min<std::size_t>(maxEntities, 1'000'000); size *= 10) {
+        sizes.push_back(size);
+    }
+    return sizes;
+}
+
+std::vector<double> OurPaintDCM::Benchmark::repeat(std::size_t repetitions,
+                                                   const std::function<void()>& prepare,
+                                                   const std::function<void()>& body) {
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+    for (std::size_t i = 0; i < repetitions; ++i) {
+        if (prepare) {
+            prepare();
+        }
+        startHardwareCounters();
+        const auto start = Clock::now();
+        body();
+        samples.push_back(elapsedNs(start));
+        stopHardwareCounters();
+    }
+    return samples;
+}
+
+Report::Report(std::string executable, Options options)
+    : _executable(std::move(executable)), _options(std::move(options)) {
+    if (_options.perfCounters) {
+        const auto error = enableHardwareCounters();
+        if (!error.empty()) {
+            std::cerr << _executable << ": hardware counters off, " << error << '\n';
+        }
+    }
+}
+
+void Report::add(Measurement measurement) {
+    if (hardwareCountersEnabled()) {
+        auto counts = takeHardwareCounts();
+        if (counts.regions > 0 && !measurement.hardware) {
+            measurement.hardware = counts;
+        }
+    }
+    const auto stats = measurement.statistics();
+    std::cerr << std::left << std::setw(32) << measurement.name << std::right
+              << " entities=" << std::setw(8) << measurement.entities
+              << "  median=" << std::setw(12) << std::fixed << std::setprecision(3) << stats.median / 1e6 << " ms"
+              << "  p90=" << std::setw(12) << stats.p90 / 1e6 << " ms";
+    if (measurement.histogram) {
+        std::cerr << "  p99=" << std::setw(12) << stats.p99 / 1e6 << " ms"
+                  << "  max=" << std::setw(12) << stats.max / 1e6 << " ms";
+    }
+    if (const auto& hardware = measurement.hardware) {
+        std::cerr << "  ipc=" << std::setprecision(2)
+                  << hardware->ratio(HardwareEvent::ET_INSTRUCTIONS, HardwareEvent::ET_CYCLES);
+    }
+    std::cerr << '\n';
+    std::cerr.unsetf(std::ios::floatfield);
+    _measurements.push_back(std::move(measurement));
+}
+
+void Report::writeJson(std::ostream& out) const {
+    out << std::setprecision(17);
+    out << "{\n  \"context\": {\"executable\": ";
+    writeJsonString(out, _executable);
+    out << ", \"date\": \"" << isoTimestamp() << '"';
+#ifdef NDEBUG
+    out << ", \"buildType\": \"release\"";
+#else
+    out << ", \"buildType\": \"debug\"";
+#endif
+#ifdef OURPAINTDCM_INSTRUMENTATION
+    out << ", \"instrumentation\": true";
+#else
+    out << ", \"instrumentation\": false";
+#endif
+    out << ", \"hardwareCounters\": " << (hardwareCountersEnabled() ? "true" : "false");
+    out << ", \"repetitions\": " << _options.repetitions
+        << ", \"maxEntities\": " << _options.maxEntities << "},\n  \"benchmarks\": [";
+
+    bool first = true;
+    for (const auto& measurement : _measurements) {
+        const auto stats = measurement.statistics();
+        out << (first ? "\n" : ",\n") << "    {\"name\": ";
+        first = false;
+        writeJsonString(out, measurement.name);
+        out << ", \"entities\": " << measurement.entities
+            << ", \"operations\": " << measurement.operations
+            << ", \"unit\": \"ns\""
+            << ", \"repetitions\": " << (measurement.histogram ? measurement.histogram->count() : measurement.samples.size())
+            << ", \"min\": " << stats.min
+            << ", \"median\": " << stats.median
+            << ", \"mean\": " << stats.mean
+            << ", \"p90\": " << stats.p90
+            << ", \"p95\": " << stats.p95
+            << ", \"p99\": " << stats.p99
+            << ", \"max\": " << stats.max
+            << ", \"medianPerOperation\": " << stats.median / static_cast<double>(std::max<std::size_t>(measurement.operations, 1))
+            << ", \"samples\": [";
+        for (std::size_t i = 0; i < measurement.samples.size(); ++i) {
+            out << (i == 0 ? "" : ", ") << measurement.samples[i];
+        }
+        out << "], \"counters\": {";
+        bool firstCounter = true;
+        for (const auto& [key, value] : measurement.counters) {
+            out << (firstCounter ? "" : ", ");
+            firstCounter = false;
+            writeJsonString(out, key);
+            out << ": " << value;
+        }
+        out << '}';
+        if (measurement.histogram) {
+            out << ", \"histogram\": ";
+            measurement.histogram->writeJsonBuckets(out);
+        }
+        if (measurement.hardware) {
+            out << ", \"hardware\": ";
+            writeJsonHardware(out, measurement);
+        }
+        out << '}';
+    }
+    out << "\n  ]\n}\n";
+}
+
+void Report::write() const {
+    if (_options.output.empty()) {
+        writeJson(std::cout);
+        return;
+    }
+    std::ofstream file(_options.output);
+    if (!file) {
+        throw std::runtime_error("Cannot open benchmark output: " + _options.output);
+    }
+    writeJson(file);
+}
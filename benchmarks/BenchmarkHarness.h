@@ -0,0 +1,133 @@
+#ifndef OURPAINTDCM_BENCHMARKS_BENCHMARKHARNESS_H
+#define OURPAINTDCM_BENCHMARKS_BENCHMARKHARNESS_H
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HardwareCounters.h"
+#include "LatencyHistogram.h"
+
+/**
+ * @file BenchmarkHarness.h
+ * @brief Repetitions, summary statistics and JSON output shared by the benchmark executables.
+ */
+namespace OurPaintDCM::Benchmark {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Summary of a sample set; percentiles interpolate linearly between order statistics.
+ */
+struct Statistics {
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double median = 0.0;
+    double p90 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+
+    static Statistics of(std::vector<double> samples);
+    static Statistics of(const LatencyHistogram& histogram);
+};
+
+/// @brief Value at quantile @p q in [0, 1] of ascending @p sorted samples.
+double percentile(const std::vector<double>& sorted, double q);
+
+/**
+ * @brief Samples of one benchmark at one sketch size.
+ */
+struct Measurement {
+    std::string name;                            ///< Benchmark name, e.g. "solve.global"
+    std::size_t entities = 0;                    ///< Figures in the sketch
+    std::size_t operations = 1;                  ///< Operations timed by one sample
+    std::vector<double> samples{};               ///< Nanoseconds per sample
+    std::map<std::string, double> counters{};    ///< Extra per-measurement values
+    std::optional<LatencyHistogram> histogram{}; ///< Per-operation latencies, replacing samples when set
+    std::size_t constraints = 0;                 ///< Requirements the timed work touches, for misses per constraint
+    std::optional<HardwareCounts> hardware{};    ///< Counters of the timed regions, with --perf-counters
+
+    Statistics statistics() const { return histogram ? Statistics::of(*histogram) : Statistics::of(samples); }
+};
+
+/**
+ * @brief Command-line options common to every benchmark executable.
+ *
+ * --output FILE (JSON destination, default stdout), --repetitions N, --max-entities N and
+ * --filter TEXT (run only benchmarks whose name contains TEXT). Sizes stop at 10k entities by
+ * default; pass --max-entities 1000000 for the full scaling curve.
+ *
+ * Benchmarks that replay sketches or drags also read --family TEXT (sketch families whose
+ * name contains TEXT), --frames N (frames per synthetic drag) and --path FILE (recorded drag).
+ *
+ * --perf-counters reads CPU counters around every timed region (Linux only, see HardwareCounters.h).
+ */
+struct Options {
+    std::string output;
+    std::size_t repetitions = 5;
+    std::size_t maxEntities = 10'000;
+    std::string filter;
+    std::string family;
+    std::size_t frames = 600;
+    std::string path;
+    bool perfCounters = false;
+
+    /// @throws std::invalid_argument on an unknown flag or a missing value.
+    static Options parse(int argc, char** argv);
+
+    bool selected(const std::string& name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+    bool familySelected(std::string_view name) const { return family.empty() || name.find(family) != std::string_view::npos; }
+};
+
+/// @brief Sketch sizes from @p minEntities to 1M entities (×10 steps), limited to @p maxEntities.
+std::vector<std::size_t> scalingSizes(std::size_t maxEntities, std::size_t minEntities = 1'000);
+
+/**
+ * @brief Time @p body @p repetitions times, calling @p prepare untimed before each run.
+ *
+ * Each run is also a hardware counter region when counters are enabled.
+ * @return Nanoseconds per run.
+ */
+std::vector<double> repeat(std::size_t repetitions,
+                           const std::function<void()>& prepare,
+                           const std::function<void()>& body);
+
+/// @brief Nanoseconds elapsed since @p start.
+inline double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Collects measurements and writes them as one JSON document.
+ */
+class Report {
+    std::string _executable;
+    Options _options;
+    std::vector<Measurement> _measurements;
+
+public:
+    Report(std::string executable, Options options);
+
+    /**
+     * @brief Keep @p measurement and print its summary line to stderr.
+     *
+     * With --perf-counters the regions counted since the previous add() are attached to it.
+     */
+    void add(Measurement measurement);
+
+    const std::vector<Measurement>& measurements() const noexcept { return _measurements; }
+
+    void writeJson(std::ostream& out) const;
+
+    /// @brief Write to Options::output, or to stdout when it is empty.
+    void write() const;
+};
+}
+
+#endif // OURPAINTDCM_BENCHMARKS_BENCHMARKHARNESS_H
@@ -0,0 +1,282 @@
+/**
+ * Scaling benchmarks for DCMManager: edit throughput, solve latency per mode, component
+ * maintenance and diagnose(), each at 1k..1M entities.
+ * Run: DCMManagerBenchmark [--output results.json] [--repetitions N] [--max-entities N] [--filter TEXT]
+ *                          [--perf-counters]
+ * JSON goes to --output (or stdout), a summary line per measurement to stderr.
+ */
+#include "BenchmarkHarness.h"
+#include "DCMManager.h"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Benchmark;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+/// Dense SVD in diagnose() is cubic; larger sketches would take hours.
+constexpr std::size_t kDiagnoseMaxEntities = 1'000;
+
+/**
+ * @brief Grid of independent, well-constrained rectangles: 4 points and 4 lines (8 entities)
+ * per cell, held by a fixed corner, two distances and horizontal/vertical sides.
+ */
+struct RectangleSketch {
+    struct Cell {
+        std::array<ID, 4> points;
+        std::array<ID, 4> lines;
+    };
+
+    static constexpr std::size_t kEntitiesPerCell = 8;
+    static constexpr std::size_t kRequirementsPerCell = 7;
+    static constexpr double kWidth = 3.0;
+    static constexpr double kHeight = 2.0;
+
+    std::vector<Cell> cells;
+
+    static std::size_t cellCount(std::size_t entities) { return std::max<std::size_t>(entities / kEntitiesPerCell, 1); }
+
+    static std::array<double, 2> origin(std::size_t cell) {
+        return {static_cast<double>(cell % 1000) * 10.0, static_cast<double>(cell / 1000) * 10.0};
+    }
+
+    void addFigures(DCMManager& manager, std::size_t entities) {
+        cells.resize(cellCount(entities));
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            const auto [x, y] = origin(c);
+            auto& cell = cells[c];
+            cell.points[0] = manager.addFigure(FigureDescriptor::point(x, y));
+            cell.points[1] = manager.addFigure(FigureDescriptor::point(x + kWidth, y));
+            cell.points[2] = manager.addFigure(FigureDescriptor::point(x + kWidth, y + kHeight));
+            cell.points[3] = manager.addFigure(FigureDescriptor::point(x, y + kHeight));
+            for (std::size_t i = 0; i < 4; ++i) {
+                cell.lines[i] = manager.addFigure(FigureDescriptor::line(cell.points[i], cell.points[(i + 1) % 4]));
+            }
+        }
+    }
+
+    std::vector<RequirementDescriptor> requirements() const {
+        std::vector<RequirementDescriptor> descriptors;
+        descriptors.reserve(cells.size() * kRequirementsPerCell);
+        for (const auto& cell : cells) {
+            descriptors.push_back(RequirementDescriptor::fixPoint(cell.points[0]));
+            descriptors.push_back(RequirementDescriptor::horizontal(cell.lines[0]));
+            descriptors.push_back(RequirementDescriptor::vertical(cell.lines[1]));
+            descriptors.push_back(RequirementDescriptor::horizontal(cell.lines[2]));
+            descriptors.push_back(RequirementDescriptor::vertical(cell.lines[3]));
+            descriptors.push_back(RequirementDescriptor::pointPointDist(cell.points[0], cell.points[1], kWidth));
+            descriptors.push_back(RequirementDescriptor::pointPointDist(cell.points[1], cell.points[2], kHeight));
+        }
+        return descriptors;
+    }
+
+    /// @brief Setup for the solve benchmarks: figures, then every requirement in one batch.
+    void build(DCMManager& manager, std::size_t entities) {
+        addFigures(manager, entities);
+        manager.addRequirements(requirements());
+    }
+
+    /// @brief Descriptor moving the free corner of cell @p c off its solution by @p offset.
+    PointUpdateDescriptor perturbation(std::size_t c, double offset) const {
+        const auto [x, y] = origin(c);
+        return PointUpdateDescriptor(cells[c].points[2], x + kWidth + offset, y + kHeight + offset);
+    }
+
+    std::vector<PointUpdateDescriptor> perturbAll(double offset) const {
+        std::vector<PointUpdateDescriptor> updates;
+        updates.reserve(cells.size());
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            updates.push_back(perturbation(c, offset));
+        }
+        return updates;
+    }
+};
+
+/// @brief Offset alternating in sign, so every repetition starts off the solution.
+double alternatingOffset(std::size_t& run) {
+    return (run++ % 2 == 0) ? 0.25 : -0.25;
+}
+
+void benchAddFigure(Report& report, const Options& options, std::size_t entities) {
+    std::unique_ptr<DCMManager> manager;
+    RectangleSketch sketch;
+    Measurement m{.name = "edit.addFigure", .entities = entities};
+    m.samples = repeat(options.repetitions,
+                       [&] { manager = std::make_unique<DCMManager>(); sketch = {}; },
+                       [&] { sketch.addFigures(*manager, entities); });
+    m.operations = sketch.cells.size() * RectangleSketch::kEntitiesPerCell;
+    report.add(std::move(m));
+}
+
+void benchAddRequirement(Report& report, const Options& options, std::size_t entities) {
+    std::unique_ptr<DCMManager> manager;
+    RectangleSketch sketch;
+    std::vector<RequirementDescriptor> descriptors;
+    Measurement m{.name = "edit.addRequirement", .entities = entities};
+    m.samples = repeat(options.repetitions,
+                       [&] {
+                           manager = std::make_unique<DCMManager>();
+                           sketch = {};
+                           sketch.addFigures(*manager, entities);
+                           descriptors = sketch.requirements();
+                       },
+                       [&] {
+                           // One call per requirement: this is the cost being measured.
+                           for (const auto& descriptor : descriptors) {
+                               manager->addRequirement(descriptor);
+                           }
+                       });
+    m.operations = sketch.cells.size() * RectangleSketch::kRequirementsPerCell;
+    m.constraints = 1;
+    report.add(std::move(m));
+}
+
+void benchSolveGlobal(Report& report, const Options& options, std::size_t entities) {
+    DCMManager manager;
+    RectangleSketch sketch;
+    sketch.build(manager, entities);
+    manager.setSolveMode(SolveMode::GLOBAL);
+
+    Measurement m{.name = "solve.global", .entities = entities};
+    std::size_t run = 0;
+    manager.updatePoints(sketch.perturbAll(alternatingOffset(run)));
+    const auto coldStart = Clock::now();
+    manager.solve();
+    m.counters["coldNs"] = elapsedNs(coldStart);
+
+    bool converged = true;
+    m.samples = repeat(options.repetitions,
+                       [&] { manager.updatePoints(sketch.perturbAll(alternatingOffset(run))); },
+                       [&] { converged = manager.solve() && converged; });
+    m.counters["converged"] = converged ? 1.0 : 0.0;
+    m.counters["iterations"] = static_cast<double>(manager.getLastSolveReport().iterations);
+    m.constraints = manager.getLastSolveReport().requirements;
+    report.add(std::move(m));
+}
+
+void benchSolveLocal(Report& report, const Options& options, std::size_t entities) {
+    DCMManager manager;
+    RectangleSketch sketch;
+    sketch.build(manager, entities);
+    manager.solveDirty();
+    manager.setSolveMode(SolveMode::LOCAL);
+
+    const std::size_t cell = sketch.cells.size() / 2;
+    const auto component = manager.getComponentForFigure(sketch.cells[cell].points[0]);
+    std::size_t run = 0;
+
+    Measurement componentSolve{.name = "solve.local.component", .entities = entities};
+    componentSolve.samples = repeat(options.repetitions,
+                                    [&] { manager.updatePoint(sketch.perturbation(cell, alternatingOffset(run))); },
+                                    [&] { manager.solve(component); });
+    componentSolve.constraints = manager.getLastSolveReport().requirements;
+    report.add(std::move(componentSolve));
+
+    Measurement dirty{.name = "solve.local.dirty", .entities = entities};
+    dirty.samples = repeat(options.repetitions,
+                           [&] { manager.updatePoint(sketch.perturbation(cell, alternatingOffset(run))); },
+                           [&] { manager.solveDirty(); });
+    dirty.constraints = manager.getLastSolveReport().requirements;
+    report.add(std::move(dirty));
+}
+
+void benchSolveDrag(Report& report, const Options& options, std::size_t entities) {
+    DCMManager manager;
+    RectangleSketch sketch;
+    sketch.build(manager, entities);
+    manager.solveDirty();
+    manager.setSolveMode(SolveMode::DRAG);
+
+    const std::size_t cell = sketch.cells.size() / 2;
+    std::size_t run = 0;
+    manager.updatePoint(sketch.perturbation(cell, alternatingOffset(run)));
+
+    Measurement m{.name = "solve.drag", .entities = entities};
+    m.samples = repeat(options.repetitions, {}, [&] {
+        manager.updatePoint(sketch.perturbation(cell, alternatingOffset(run)));
+    });
+    m.constraints = manager.getLastSolveReport().requirements;
+    report.add(std::move(m));
+}
+
+void benchComponents(Report& report, const Options& options, std::size_t entities) {
+    DCMManager manager;
+    RectangleSketch sketch;
+    sketch.build(manager, entities);
+    if (sketch.cells.size() < 2) {
+        return;
+    }
+    const auto& first = sketch.cells.front();
+    const auto& last = sketch.cells.back();
+
+    Measurement merge{.name = "components.merge", .entities = entities};
+    Measurement split{.name = "components.split", .entities = entities};
+    ID bridge;
+    for (std::size_t i = 0; i < options.repetitions; ++i) {
+        auto start = Clock::now();
+        bridge = manager.addRequirement(RequirementDescriptor::pointPointDist(first.points[2], last.points[2], 1.0));
+        merge.samples.push_back(elapsedNs(start));
+
+        start = Clock::now();
+        manager.removeRequirement(bridge);
+        split.samples.push_back(elapsedNs(start));
+    }
+    split.counters["components"] = static_cast<double>(manager.getComponentCount());
+    report.add(std::move(merge));
+    report.add(std::move(split));
+}
+
+void benchDiagnose(Report& report, const Options& options, std::size_t entities) {
+    if (entities > kDiagnoseMaxEntities) {
+        return;
+    }
+    DCMManager manager;
+    RectangleSketch sketch;
+    sketch.build(manager, entities);
+    const auto& system = manager.getRequirementSystem();
+
+    Measurement m{.name = "diagnose", .entities = entities};
+    SystemStatus status = SystemStatus::UNKNOWN;
+    m.samples = repeat(options.repetitions, {}, [&] { status = system.diagnose(); });
+    m.counters["status"] = static_cast<double>(status);
+    m.constraints = system.getRequirements().size();
+    report.add(std::move(m));
+}
+}
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = Options::parse(argc, argv);
+        Report report("DCMManagerBenchmark", options);
+
+        using Bench = void (*)(Report&, const Options&, std::size_t);
+        const std::array<std::pair<const char*, Bench>, 7> benchmarks{{
+            {"edit.addFigure", benchAddFigure},
+            {"edit.addRequirement", benchAddRequirement},
+            {"solve.global", benchSolveGlobal},
+            {"solve.local", benchSolveLocal},
+            {"solve.drag", benchSolveDrag},
+            {"components", benchComponents},
+            {"diagnose", benchDiagnose},
+        }};
+        for (const auto& [name, bench] : benchmarks) {
+            if (!options.selected(name)) {
+                continue;
+            }
+            for (const std::size_t entities : scalingSizes(options.maxEntities)) {
+                bench(report, options, entities);
+            }
+        }
+        report.write();
+    } catch (const std::exception& e) {
+        std::cerr << "DCMManagerBenchmark: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * Drag-frame latency: replays a mouse path through DCMManager::updatePoint in DRAG mode and
+ * records every frame into a LatencyHistogram, per sketch family and size.
+ * Run: DragLatencyBenchmark [--output results.json] [--repetitions N] [--max-entities N]
+ *                           [--family TEXT] [--frames N] [--path FILE] [--perf-counters]
+ * --repetitions is the number of dragged handles per sketch; each replays the whole path.
+ * --path reads a recorded drag: one "dx dy" offset from the grabbed point per line, '#' starts
+ * a comment. Without it a synthetic figure-eight of --frames frames is used.
+ * Sizes start at 100 entities: a drag re-solves the whole touched component, and the connected
+ * families are past interactive rates well before 1k.
+ */
+#include "BenchmarkHarness.h"
+#include "SketchGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Benchmark;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+using DragPath = std::vector<std::array<double, 2>>;
+
+constexpr std::array<SketchFamily, 5> kFamilies{
+    SketchFamily::ET_RECTANGLE_GRID, SketchFamily::ET_TRUSS_LATTICE, SketchFamily::ET_BOLT_CIRCLE,
+    SketchFamily::ET_OPEN_LINKAGE, SketchFamily::ET_DISCONNECTED_PARTS};
+
+/// Half-width of the synthetic path, in sketch units (parts are ~10 units across).
+constexpr double kPathRadius = 1.0;
+/// Frames per loop of the synthetic path: two seconds at 60 Hz.
+constexpr std::size_t kFramesPerLoop = 120;
+constexpr std::size_t kMinEntities = 100;
+/// Replay stops once a measurement has spent this long; counted as "truncated".
+constexpr std::chrono::seconds kReplayBudget{60};
+/// Median frame beyond which larger sizes of the same family are skipped.
+constexpr double kSkipLargerAfterNs = 1e9;
+
+/// @brief Figure-eight around the grabbed point, small per-frame steps like a real mouse.
+DragPath syntheticPath(std::size_t frames) {
+    DragPath path;
+    path.reserve(frames);
+    for (std::size_t i = 1; i <= frames; ++i) {
+        const double t = 2.0 * std::numbers::pi * static_cast<double>(i) / kFramesPerLoop;
+        path.push_back({kPathRadius * std::sin(t), 0.5 * kPathRadius * std::sin(2.0 * t)});
+    }
+    return path;
+}
+
+DragPath recordedPath(const std::string& file) {
+    std::ifstream in(file);
+    if (!in) {
+        throw std::runtime_error("Cannot open drag path: " + file);
+    }
+    DragPath path;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::array<double, 2> offset{};
+        if (fields >> offset[0] >> offset[1]) {
+            path.push_back(offset);
+        }
+    }
+    if (path.empty()) {
+        throw std::runtime_error("Drag path has no frames: " + file);
+    }
+    return path;
+}
+
+/**
+ * @brief Drag @p Options::repetitions handles, spread over the sketch, along @p path.
+ *
+ * Under-constrained sketches are used so every handle can actually move. Iterations are the
+ * outer iterations of the in-tree LM solver, which runs both the default and the rigid-cluster
+ * drag paths. The opt-in expression-tree path does not report its iterations, so the iteration
+ * counters are left out when it is enabled.
+ * @return Median frame latency in nanoseconds (0 when nothing was dragged).
+ */
+double benchDrag(Report& report, const Options& options, const DragPath& path,
+               SketchFamily family, std::size_t entities) {
+    DCMManager manager;
+    const auto sketch = generateSketch(manager, {family, entities, 1, ConstraintLevel::ET_UNDER});
+    if (sketch.handles.empty()) {
+        return 0.0;
+    }
+    manager.solveDirty();
+    manager.setSolveMode(SolveMode::DRAG);
+
+    Measurement m{.name = "drag." + std::string(sketchFamilyName(family)), .entities = entities};
+    m.histogram.emplace();
+    std::size_t iterations = 0;
+    std::size_t maxIterations = 0;
+    std::size_t cacheMisses = 0;
+    std::size_t failed = 0;
+    bool truncated = false;
+
+    const auto replayStart = Clock::now();
+    const std::size_t handles = std::min(options.repetitions, sketch.handles.size());
+    for (std::size_t h = 0; h < handles && !truncated; ++h) {
+        const ID handle = sketch.handles[(2 * h + 1) * sketch.handles.size() / (2 * handles)];
+        const auto grabbed = manager.getFigure(handle)->coords;
+        for (const auto& [dx, dy] : path) {
+            if (Clock::now() - replayStart > kReplayBudget) {
+                truncated = true;
+                break;
+            }
+            startHardwareCounters();
+            const auto start = Clock::now();
+            manager.updatePoint(PointUpdateDescriptor(handle, grabbed[0] + dx, grabbed[1] + dy));
+            m.histogram->record(elapsedNs(start));
+            stopHardwareCounters();
+
+            const auto& frame = manager.getLastSolveReport();
+            m.constraints = std::max(m.constraints, frame.requirements);
+            iterations += frame.iterations;
+            maxIterations = std::max(maxIterations, frame.iterations);
+            cacheMisses += frame.cacheMisses;
+            failed += frame.termination == SolveTermination::ET_NOT_CONVERGED ? 1 : 0;
+        }
+    }
+
+    const auto frames = static_cast<double>(m.histogram->count());
+    m.counters["handles"] = static_cast<double>(handles);
+    m.counters["frames"] = frames;
+    if (!manager.getExpressionTreeSolveEnabled()) {
+        m.counters["iterationsPerFrame"] = static_cast<double>(iterations) / frames;
+        m.counters["maxIterations"] = static_cast<double>(maxIterations);
+    }
+    m.counters["cacheMisses"] = static_cast<double>(cacheMisses);
+    m.counters["failedConvergences"] = static_cast<double>(failed);
+    m.counters["truncated"] = truncated ? 1.0 : 0.0;
+    const double median = m.statistics().median;
+    report.add(std::move(m));
+    return median;
+}
+}
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = Options::parse(argc, argv);
+        Report report("DragLatencyBenchmark", options);
+        const DragPath path = options.path.empty() ? syntheticPath(options.frames) : recordedPath(options.path);
+
+        for (const auto family : kFamilies) {
+            if (!options.familySelected(sketchFamilyName(family))) {
+                continue;
+            }
+            for (const std::size_t entities : scalingSizes(options.maxEntities, kMinEntities)) {
+                if (benchDrag(report, options, path, family, entities) > kSkipLargerAfterNs) {
+                    std::cerr << "drag." << sketchFamilyName(family)
+                              << ": median frame over 1 s, skipping larger sizes\n";
+                    break;
+                }
+            }
+        }
+        report.write();
+    } catch (const std::exception& e) {
+        std::cerr << "DragLatencyBenchmark: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "HardwareCounters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace OurPaintDCM::Benchmark;
+
+namespace {
+HardwareCounts pending;
+
+#if defined(__linux__)
+struct EventConfig {
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr std::array<EventConfig, kHardwareEventCount> kEventConfigs{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+/**
+ * @brief One perf event group: the first event that opens leads, so all are scheduled together.
+ *
+ * A group read returns the values in the order the events joined; slotEvent maps them back.
+ */
+struct EventGroup {
+    int leader = -1;
+    std::array<int, kHardwareEventCount> fds{};
+    std::array<std::size_t, kHardwareEventCount> slotEvent{};
+    std::size_t opened = 0;
+
+    ~EventGroup() {
+        for (std::size_t slot = 0; slot < opened; ++slot) {
+            close(fds[slot]);
+        }
+    }
+};
+
+EventGroup group;
+
+int openEvent(const EventConfig& event, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+}
+
+std::string_view OurPaintDCM::Benchmark::hardwareEventName(HardwareEvent event) noexcept {
+    switch (event) {
+        case HardwareEvent::ET_CYCLES:
+            return "cycles";
+        case HardwareEvent::ET_INSTRUCTIONS:
+            return "instructions";
+        case HardwareEvent::ET_L1D_MISSES:
+            return "l1dMisses";
+        case HardwareEvent::ET_LLC_MISSES:
+            return "llcMisses";
+        case HardwareEvent::ET_BRANCH_MISSES:
+            return "branchMisses";
+        case HardwareEvent::ET_COUNT:
+            break;
+    }
+    return "unknown";
+}
+
+double HardwareCounts::ratio(HardwareEvent numerator, HardwareEvent denominator) const noexcept {
+    if (!has(numerator) || !has(denominator) || (*this)[denominator] == 0) {
+        return 0.0;
+    }
+    return static_cast<double>((*this)[numerator]) / static_cast<double>((*this)[denominator]);
+}
+
+std::string OurPaintDCM::Benchmark::enableHardwareCounters() {
+#if defined(__linux__)
+    if (group.leader != -1) {
+        return {};
+    }
+    int firstError = 0;
+    for (std::size_t event = 0; event < kHardwareEventCount; ++event) {
+        const int fd = openEvent(kEventConfigs[event], group.leader);
+        if (fd == -1) {
+            firstError = firstError == 0 ? errno : firstError;
+            continue;
+        }
+        if (group.leader == -1) {
+            group.leader = fd;
+        }
+        group.fds[group.opened] = fd;
+        group.slotEvent[group.opened] = event;
+        ++group.opened;
+        pending.measured[event] = true;
+    }
+    if (group.leader == -1) {
+        return std::string("perf_event_open failed: ") + std::strerror(firstError) +
+               " (no PMU exposed, e.g. in a VM, or kernel.perf_event_paranoid too strict)";
+    }
+    return {};
+#else
+    return "hardware counters need Linux perf_event_open";
+#endif
+}
+
+bool OurPaintDCM::Benchmark::hardwareCountersEnabled() noexcept {
+#if defined(__linux__)
+    return group.leader != -1;
+#else
+    return false;
+#endif
+}
+
+void OurPaintDCM::Benchmark::startHardwareCounters() noexcept {
+#if defined(__linux__)
+    if (group.leader == -1) {
+        return;
+    }
+    ioctl(group.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void OurPaintDCM::Benchmark::stopHardwareCounters() noexcept {
+#if defined(__linux__)
+    if (group.leader == -1) {
+        return;
+    }
+    ioctl(group.leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // Layout of a PERF_FORMAT_GROUP read: nr, time enabled, time running, then nr values.
+    std::array<std::uint64_t, 3 + kHardwareEventCount> buffer{};
+    const auto bytes = read(group.leader, buffer.data(), sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || buffer[0] != group.opened) {
+        return;
+    }
+    const std::uint64_t enabled = buffer[1];
+    const std::uint64_t running = buffer[2];
+    // Multiplexed groups only ran for part of the region; extrapolate like perf stat does.
+    const double scale = running > 0 && running < enabled
+                             ? static_cast<double>(enabled) / static_cast<double>(running)
+                             : 1.0;
+    for (std::size_t slot = 0; slot < group.opened; ++slot) {
+        pending.values[group.slotEvent[slot]] +=
+            static_cast<std::uint64_t>(static_cast<double>(buffer[3 + slot]) * scale);
+    }
+    ++pending.regions;
+#endif
+}
+
+HardwareCounts OurPaintDCM::Benchmark::takeHardwareCounts() noexcept {
+    HardwareCounts counts = pending;
+    pending.values = {};
+    pending.regions = 0;
+    return counts;
+}
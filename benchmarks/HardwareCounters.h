@@ -0,0 +1,98 @@
+#ifndef OURPAINTDCM_BENCHMARKS_HARDWARECOUNTERS_H
+#define OURPAINTDCM_BENCHMARKS_HARDWARECOUNTERS_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @file HardwareCounters.h
+ * @brief CPU performance counters around measured regions, read through Linux perf_event_open.
+ *
+ * Counting is off until enableHardwareCounters() succeeds; until then, and on every other
+ * platform, start/stop are no-ops. Events count user space of the calling thread only, so
+ * work that solveDirty() hands to its worker threads is not included. Regions accumulate
+ * until takeHardwareCounts(), which the Report does for every measurement it receives.
+ *
+ * Example:
+ * @code
+ * enableHardwareCounters();
+ * {
+ *     HardwareCounterRegion region;
+ *     manager.solve();
+ * }
+ * const auto counts = takeHardwareCounts();
+ * const double ipc = counts.ratio(HardwareEvent::ET_INSTRUCTIONS, HardwareEvent::ET_CYCLES);
+ * @endcode
+ */
+namespace OurPaintDCM::Benchmark {
+/**
+ * @brief Counted events; each is opened separately, so a CPU lacking one still reports the rest.
+ */
+enum class HardwareEvent : std::uint8_t {
+    ET_CYCLES,        ///< Core cycles
+    ET_INSTRUCTIONS,  ///< Retired instructions
+    ET_L1D_MISSES,    ///< L1 data cache read misses
+    ET_LLC_MISSES,    ///< Last-level cache misses
+    ET_BRANCH_MISSES, ///< Mispredicted branches
+    ET_COUNT
+};
+
+inline constexpr std::size_t kHardwareEventCount = static_cast<std::size_t>(HardwareEvent::ET_COUNT);
+
+/// @brief Stable camelCase name of an event, for JSON keys.
+std::string_view hardwareEventName(HardwareEvent event) noexcept;
+
+/**
+ * @brief Event totals over one or more regions, scaled up when the kernel multiplexed them.
+ */
+struct HardwareCounts {
+    std::array<std::uint64_t, kHardwareEventCount> values{};
+    std::array<bool, kHardwareEventCount> measured{}; ///< False for events the CPU or kernel refused
+    std::uint64_t regions = 0;
+
+    std::uint64_t operator[](HardwareEvent event) const noexcept {
+        return values[static_cast<std::size_t>(event)];
+    }
+
+    bool has(HardwareEvent event) const noexcept {
+        return measured[static_cast<std::size_t>(event)];
+    }
+
+    /// @brief numerator / denominator, or 0 when either is unmeasured or the denominator is 0.
+    double ratio(HardwareEvent numerator, HardwareEvent denominator) const noexcept;
+};
+
+/**
+ * @brief Open the counters for the calling thread.
+ * @return Empty on success, otherwise why counting stays off (e.g. perf_event_paranoid).
+ */
+std::string enableHardwareCounters();
+
+/// True once enableHardwareCounters() has opened at least one event.
+bool hardwareCountersEnabled() noexcept;
+
+/// @brief Reset and start the counters for one region.
+void startHardwareCounters() noexcept;
+
+/// @brief Stop the counters and add the region to the pending totals.
+void stopHardwareCounters() noexcept;
+
+/// @brief Pending totals since the last call; zero regions when nothing was counted.
+HardwareCounts takeHardwareCounts() noexcept;
+
+/**
+ * @brief Counts the enclosing scope as one region.
+ */
+class HardwareCounterRegion {
+public:
+    HardwareCounterRegion() noexcept { startHardwareCounters(); }
+    ~HardwareCounterRegion() { stopHardwareCounters(); }
+
+    HardwareCounterRegion(const HardwareCounterRegion&) = delete;
+    HardwareCounterRegion& operator=(const HardwareCounterRegion&) = delete;
+};
+}
+
+#endif // OURPAINTDCM_BENCHMARKS_HARDWARECOUNTERS_H
@@ -0,0 +1,297 @@
+/**
+ * Per-kernel micro-benchmarks: evaluate and gradient of every RequirementFunction next to the
+ * math-library ErrorFunction tree the LM pipeline builds for the same requirement.
+ * Run: KernelBenchmark [--output results.json] [--repetitions N] [--filter TEXT] [--perf-counters]
+ *
+ * Names are "kernel.<requirement>.<path>.<op>[.cold]":
+ * - path "analytic": RequirementFunction; ops evaluate, gradient (map result) and gradientInto;
+ * - path "tree": ErrorFunction; ops evaluate, gradient (derivative trees built once, as the LM
+ *   task does, then evaluated) and derive (building those derivative trees).
+ * Hot variants loop over a few instances that stay in L1. Cold variants flush the caches before
+ * every sample and touch each of many instances once, with every coordinate on its own cache
+ * line, like the first solve after an edit. --max-entities does not apply.
+ * JSON goes to --output (or stdout), a summary line per measurement to stderr.
+ */
+#include "BenchmarkHarness.h"
+#include "RequirementTraits.h"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Benchmark;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+using OurPaintDCM::Function::RequirementFunction;
+
+struct KernelCase {
+    RequirementType type;
+    const char* name;
+};
+
+/// Fix requirements share FixCoordinateFunction; one row of ET_FIXPOINT stands for all three.
+constexpr std::array<KernelCase, 14> kKernelCases{{
+    {RequirementType::ET_POINTLINEDIST, "pointLineDist"},
+    {RequirementType::ET_POINTONLINE, "pointOnLine"},
+    {RequirementType::ET_POINTPOINTDIST, "pointPointDist"},
+    {RequirementType::ET_POINTONPOINT, "pointOnPoint"},
+    {RequirementType::ET_LINECIRCLEDIST, "lineCircleDist"},
+    {RequirementType::ET_LINEONCIRCLE, "lineOnCircle"},
+    {RequirementType::ET_LINEINCIRCLE, "lineInCircle"},
+    {RequirementType::ET_LINELINEPARALLEL, "lineLineParallel"},
+    {RequirementType::ET_LINELINEPERPENDICULAR, "lineLinePerpendicular"},
+    {RequirementType::ET_LINELINEANGLE, "lineLineAngle"},
+    {RequirementType::ET_VERTICAL, "vertical"},
+    {RequirementType::ET_HORIZONTAL, "horizontal"},
+    {RequirementType::ET_ARCCENTERONPERPENDICULAR, "arcCenterOnPerpendicular"},
+    {RequirementType::ET_FIXPOINT, "fixCoordinate"},
+}};
+
+constexpr std::size_t kHotInstances = 16;
+constexpr std::size_t kHotPasses = 256;
+constexpr std::size_t kColdInstances = 4096;
+/// Doubles per cache line; cold coordinates are spread one per line.
+constexpr std::size_t kLineDoubles = 64 / sizeof(double);
+/// Larger than the last-level cache of current desktop CPUs.
+constexpr std::size_t kFlushBytes = 64 * 1024 * 1024;
+constexpr double kDistance = 2.0;
+constexpr double kAngle = 0.5;
+
+volatile double sink = 0.0;
+
+/// @brief Read and write every line of a buffer larger than the caches.
+void flushCaches() {
+    static std::vector<char> buffer(kFlushBytes, 1);
+    char sum = 0;
+    for (std::size_t i = 0; i < buffer.size(); i += 64) {
+        sum = static_cast<char>(sum + buffer[i]);
+        buffer[i] = sum;
+    }
+    sink = sink + sum;
+}
+
+/**
+ * @brief Instances of one requirement type over a shared coordinate pool.
+ *
+ * Math Variables are owned once per coordinate, like the solver's variable registry, so
+ * derivative() is taken against the same objects the LM task would use.
+ */
+struct KernelSet {
+    std::size_t variableCount = 0;
+    std::vector<double> pool;
+    std::vector<std::unique_ptr<Variable>> registry; ///< One per coordinate, in pool order of use
+    std::vector<std::vector<Variable*>> instanceVariables;
+    std::vector<std::shared_ptr<RequirementFunction>> analytic;
+    std::vector<std::unique_ptr<::Function>> trees;
+    std::vector<std::vector<std::unique_ptr<::Function>>> derivatives; ///< Per tree, one per variable
+
+    /// @brief Derivative trees of every instance, replacing any built before.
+    void derive() {
+        derivatives.resize(trees.size());
+        for (std::size_t i = 0; i < trees.size(); ++i) {
+            derivatives[i].clear();
+            for (Variable* variable : instanceVariables[i]) {
+                derivatives[i].emplace_back(trees[i]->derivative(variable));
+            }
+        }
+    }
+};
+
+/**
+ * @brief Build @p instances kernels of @p type; @p scattered puts every coordinate on its own
+ * cache line in random order instead of packing them.
+ */
+KernelSet buildKernelSet(RequirementType type, std::size_t instances, bool scattered, std::mt19937& random) {
+    KernelSet set;
+    Requirements::visitRequirementType(type, [&](auto tag) {
+        using Tag = decltype(tag);
+        set.variableCount = Tag::rows == Requirements::RowKind::Fix ? 1 : Tag::variableCount;
+    });
+
+    const std::size_t coordinates = instances * set.variableCount;
+    const std::size_t stride = scattered ? kLineDoubles : 1;
+    std::vector<std::size_t> order(coordinates);
+    std::iota(order.begin(), order.end(), 0);
+    if (scattered) {
+        std::shuffle(order.begin(), order.end(), random);
+    }
+    std::uniform_real_distribution<double> value(1.0, 10.0);
+    set.pool.resize(coordinates * stride);
+    for (double& coordinate : set.pool) {
+        coordinate = value(random);
+    }
+
+    for (std::size_t i = 0; i < instances; ++i) {
+        std::vector<VAR> refs(set.variableCount);
+        std::vector<Variable*> variables(set.variableCount);
+        for (std::size_t k = 0; k < set.variableCount; ++k) {
+            refs[k] = &set.pool[order[i * set.variableCount + k] * stride];
+            set.registry.push_back(std::make_unique<Variable>(refs[k]));
+            variables[k] = set.registry.back().get();
+        }
+        set.instanceVariables.push_back(variables);
+
+        Requirements::visitRequirementType(type, [&](auto tag) {
+            using Tag = decltype(tag);
+            if constexpr (Tag::rows == Requirements::RowKind::Fix) {
+                set.analytic.push_back(std::make_shared<OurPaintDCM::Function::FixCoordinateFunction>(
+                    Tag::type, refs, *refs[0] + 1.0));
+                // Same residual tree DCMManager builds for a fix row.
+                set.trees.emplace_back(new Subtraction(new Variable(refs[0]), new Constant(*refs[0] + 1.0)));
+            } else {
+                const double param = Tag::type == RequirementType::ET_LINELINEANGLE ? kAngle : kDistance;
+                if constexpr (!std::is_void_v<typename Tag::Kernel>) {
+                    std::array<VAR, Tag::variableCount> vars{};
+                    std::copy(refs.begin(), refs.end(), vars.begin());
+                    set.analytic.push_back(Requirements::makeKernel<Tag>(vars, param));
+                }
+                if constexpr (!std::is_void_v<typename Tag::ErrorKernel>) {
+                    std::vector<Variable*> owned;
+                    for (VAR ref : refs) {
+                        owned.push_back(new Variable(ref));
+                    }
+                    set.trees.emplace_back(Requirements::makeErrorKernel<Tag>(std::move(owned), param));
+                }
+            }
+        });
+    }
+    return set;
+}
+
+/// @brief One timed kernel operation over every instance of a set.
+using KernelPass = void (*)(KernelSet&, double&);
+
+void analyticEvaluate(KernelSet& set, double& sum) {
+    for (const auto& function : set.analytic) {
+        sum += function->evaluate();
+    }
+}
+
+void analyticGradient(KernelSet& set, double& sum) {
+    for (const auto& function : set.analytic) {
+        for (const auto& [var, partial] : function->gradient()) {
+            sum += partial;
+        }
+    }
+}
+
+void analyticGradientInto(KernelSet& set, double& sum) {
+    std::array<double, RequirementFunction::kMaxVarCount> partials{};
+    for (const auto& function : set.analytic) {
+        function->gradientInto(std::span(partials.data(), set.variableCount));
+        sum += partials[0];
+    }
+}
+
+void treeEvaluate(KernelSet& set, double& sum) {
+    for (const auto& tree : set.trees) {
+        sum += tree->evaluate();
+    }
+}
+
+void treeGradient(KernelSet& set, double& sum) {
+    for (const auto& partials : set.derivatives) {
+        for (const auto& partial : partials) {
+            sum += partial->evaluate();
+        }
+    }
+}
+
+void treeDerive(KernelSet& set, double& sum) {
+    set.derive();
+    sum += static_cast<double>(set.derivatives.size());
+}
+
+struct KernelOp {
+    const char* path;
+    const char* op;
+    KernelPass pass;
+    bool analytic;
+    bool cold; ///< Also run the cache-cold variant
+};
+
+constexpr std::array<KernelOp, 6> kKernelOps{{
+    {"analytic", "evaluate", analyticEvaluate, true, true},
+    {"analytic", "gradient", analyticGradient, true, true},
+    {"analytic", "gradientInto", analyticGradientInto, true, true},
+    {"tree", "evaluate", treeEvaluate, false, true},
+    {"tree", "gradient", treeGradient, false, true},
+    {"tree", "derive", treeDerive, false, false},
+}};
+
+void benchKernel(Report& report, const Options& options, const KernelCase& kernel, std::mt19937& random) {
+    const auto nameOf = [&](const KernelOp& op) {
+        return std::string("kernel.") + kernel.name + '.' + op.path + '.' + op.op;
+    };
+    if (std::none_of(kKernelOps.begin(), kKernelOps.end(), [&](const KernelOp& op) {
+            return options.selected(nameOf(op)) || (op.cold && options.selected(nameOf(op) + ".cold"));
+        })) {
+        return;
+    }
+    KernelSet hot = buildKernelSet(kernel.type, kHotInstances, false, random);
+    KernelSet cold = buildKernelSet(kernel.type, kColdInstances, true, random);
+    hot.derive();
+    cold.derive();
+
+    for (const auto& op : kKernelOps) {
+        const std::size_t instances = op.analytic ? hot.analytic.size() : hot.trees.size();
+        if (instances == 0) {
+            continue;
+        }
+        const std::string name = nameOf(op);
+        double sum = 0.0;
+
+        if (options.selected(name)) {
+            op.pass(hot, sum);
+            Measurement m{.name = name, .entities = instances};
+            m.samples = repeat(options.repetitions, {}, [&] {
+                for (std::size_t pass = 0; pass < kHotPasses; ++pass) {
+                    op.pass(hot, sum);
+                }
+            });
+            m.operations = instances * kHotPasses;
+            m.constraints = 1;
+            m.counters["variables"] = static_cast<double>(hot.variableCount);
+            report.add(std::move(m));
+        }
+
+        const std::string coldName = name + ".cold";
+        if (op.cold && options.selected(coldName)) {
+            Measurement m{.name = coldName, .entities = kColdInstances};
+            m.samples = repeat(options.repetitions, flushCaches, [&] { op.pass(cold, sum); });
+            m.operations = kColdInstances;
+            m.constraints = 1;
+            m.counters["variables"] = static_cast<double>(cold.variableCount);
+            report.add(std::move(m));
+        }
+        sink = sink + sum;
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    try {
+        const auto options = Options::parse(argc, argv);
+        Report report("KernelBenchmark", options);
+
+        std::mt19937 random(20240607u);
+        for (const auto& kernel : kKernelCases) {
+            benchKernel(report, options, kernel, random);
+        }
+        report.write();
+    } catch (const std::exception& e) {
+        std::cerr << "KernelBenchmark: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <ostream>
+
+using namespace OurPaintDCM::Benchmark;
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t ns) noexcept {
+    if (ns < kSubBuckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    const unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - kPrecisionBits;
+    const std::size_t top = static_cast<std::size_t>(ns >> shift);
+    return kSubBuckets + (shift - 1) * (kSubBuckets / 2) + (top - kSubBuckets / 2);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const std::size_t offset = index - kSubBuckets;
+    const unsigned shift = static_cast<unsigned>(offset / (kSubBuckets / 2)) + 1;
+    const std::uint64_t top = offset % (kSubBuckets / 2) + kSubBuckets / 2;
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t ns) noexcept {
+    ++_buckets[bucketIndex(ns)];
+    ++_count;
+    _min = std::min(_min, ns);
+    _max = std::max(_max, ns);
+    _sum += static_cast<double>(ns);
+}
+
+void LatencyHistogram::record(double ns) noexcept {
+    record(ns > 0.0 ? static_cast<std::uint64_t>(std::llround(ns)) : std::uint64_t{0});
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        _buckets[i] += other._buckets[i];
+    }
+    _count += other._count;
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+    _sum += other._sum;
+}
+
+std::uint64_t LatencyHistogram::valueAtQuantile(double q) const noexcept {
+    if (_count == 0) {
+        return 0;
+    }
+    const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(_count);
+    const auto target = std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(rank)), 1);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += _buckets[i];
+        if (seen >= target) {
+            return std::clamp(bucketUpperBound(i), min(), _max);
+        }
+    }
+    return _max;
+}
+
+void LatencyHistogram::writeJsonBuckets(std::ostream& out) const {
+    out << '[';
+    bool first = true;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        if (_buckets[i] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << '[' << bucketUpperBound(i) << ", " << _buckets[i] << ']';
+        first = false;
+    }
+    out << ']';
+}
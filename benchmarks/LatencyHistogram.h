@@ -0,0 +1,63 @@
+#ifndef OURPAINTDCM_BENCHMARKS_LATENCYHISTOGRAM_H
+#define OURPAINTDCM_BENCHMARKS_LATENCYHISTOGRAM_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+
+/**
+ * @file LatencyHistogram.h
+ * @brief Log-linear latency histogram with bounded relative error (HdrHistogram layout).
+ */
+namespace OurPaintDCM::Benchmark {
+/**
+ * @brief Fixed-size histogram of nanosecond latencies.
+ *
+ * Values below 2^kPrecisionBits are counted exactly; above that, every power-of-two range is
+ * split into 2^(kPrecisionBits-1) equal buckets, so a reported value is never more than
+ * 1/64 (1.6%) above the recorded one. Buckets live inline: record() never allocates and
+ * costs a bit scan and an increment, cheap enough to call on every drag frame.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kPrecisionBits = 7;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kPrecisionBits;
+    static constexpr std::size_t kBucketCount = kSubBuckets + (64 - kPrecisionBits) * (kSubBuckets / 2);
+
+    void record(std::uint64_t ns) noexcept;
+
+    /// @brief Record a duration in nanoseconds; negative values count as zero.
+    void record(double ns) noexcept;
+
+    void merge(const LatencyHistogram& other) noexcept;
+    void reset() noexcept { *this = LatencyHistogram{}; }
+
+    std::uint64_t count() const noexcept { return _count; }
+    std::uint64_t min() const noexcept { return _count == 0 ? 0 : _min; }
+    std::uint64_t max() const noexcept { return _max; }
+    double mean() const noexcept { return _count == 0 ? 0.0 : _sum / static_cast<double>(_count); }
+
+    /**
+     * @brief Smallest bucket upper bound that covers at least @p q in [0, 1] of the samples.
+     *
+     * Clamped to max(), so the top quantile reports the exact worst case.
+     */
+    std::uint64_t valueAtQuantile(double q) const noexcept;
+
+    /// @brief Write non-empty buckets as a JSON array of [upper bound ns, count] pairs.
+    void writeJsonBuckets(std::ostream& out) const;
+
+private:
+    static std::size_t bucketIndex(std::uint64_t ns) noexcept;
+    static std::uint64_t bucketUpperBound(std::size_t index) noexcept;
+
+    std::array<std::uint64_t, kBucketCount> _buckets{};
+    std::uint64_t _count = 0;
+    std::uint64_t _min = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t _max = 0;
+    double _sum = 0.0;
+};
+}
+
+#endif // OURPAINTDCM_BENCHMARKS_LATENCYHISTOGRAM_H
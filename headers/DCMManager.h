@@ -5,15 +5,19 @@
 #include "RequirementSystem.h"
 #include "RequirementDescriptor.h"
 #include "FigureDescriptor.h"
+#include "SolveReport.h"
 #include "Graph.h"
 #include "Function.h"
+#include "MemoryUsage.h"
 
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <memory>
 #include <cmath>
+#include <cstdint>
 #include <initializer_list>
+#include <span>
 
 namespace OurPaintDCM {
 
@@ -190,6 +194,19 @@ public:
      */
     Utils::ID addRequirement(const Utils::RequirementDescriptor& descriptor);
 
+    /**
+     * @brief Add several requirements at once.
+     *
+     * Same result as calling addRequirement() for each descriptor in order, but the function
+     * layer is rebuilt once for the whole batch, so loading a large sketch stays linear.
+     * Every descriptor is validated before any is added.
+     *
+     * @param descriptors Requirement descriptors, added in order.
+     * @return IDs of the requirements, in the same order.
+     * @throws std::invalid_argument if a descriptor fails validation or an id is zero or repeated.
+     */
+    std::vector<Utils::ID> addRequirements(const std::vector<Utils::RequirementDescriptor>& descriptors);
+
     /**
      * @brief Remove a requirement by ID.
      * @param reqId ID of the requirement to remove.
@@ -313,6 +330,95 @@ public:
     /// @brief Get current solving mode.
     Utils::SolveMode getSolveMode() const noexcept;
 
+    /**
+     * @brief Enable local relaxation for DRAG solves.
+     *
+     * With relaxation enabled, a drag first solves only the requirements within @p hops
+     * hops of the edited figures, holding variables outside that neighbourhood fixed.
+     * Hops follow figure dependencies and shared requirements; coincident points always
+     * enter together. If the boundary requirements cannot be satisfied, the radius is
+     * doubled until the whole component is covered.
+     *
+     * @param hops Initial neighbourhood radius; 0 disables relaxation (default).
+     */
+    void setRelaxationHops(std::size_t hops) noexcept;
+
+    /// @brief Get the initial local relaxation radius (0 when disabled).
+    std::size_t getRelaxationHops() const noexcept;
+
+    /**
+     * @brief Set the size above which a solve uses the iterative inner solver.
+     *
+     * Components with at least this many free variables are solved by Levenberg-Marquardt
+     * with preconditioned conjugate gradients on the normal equations (2×2 block-Jacobi per
+     * point) instead of a block Cholesky factorization, so memory grows linearly with the
+     * number of Jacobian non-zeros.
+     *
+     * @param variables Free-variable threshold (default 20000).
+     */
+    void setIterativeSolveThreshold(std::size_t variables);
+
+    /// @brief Get the free-variable threshold of the iterative inner solver.
+    std::size_t getIterativeSolveThreshold() const noexcept;
+
+    /**
+     * @brief Enable the constructive pre-solve stage.
+     *
+     * Points determined by two requirements on already known geometry (two distances, or a
+     * distance and a line incidence, or two line incidences) are placed in closed form, in
+     * order outward from fixed and dragged points. Only the remaining cyclic cores are handed
+     * to the numeric solver. If a placement leaves requirements unsatisfied, the affected
+     * solve falls back to the purely numeric pipeline. Off by default: placed points land
+     * on the branch nearest their current position, which can differ from the minimum the
+     * numeric solver reaches for the same sketch.
+     *
+     * @param enabled true to enable (default false).
+     */
+    void setConstructiveSolveEnabled(bool enabled);
+
+    /// @brief Check whether the constructive pre-solve stage is enabled.
+    bool getConstructiveSolveEnabled() const noexcept;
+
+    /**
+     * @brief Solve with the math library's expression-tree tasks.
+     *
+     * By default every solve runs the in-tree Levenberg-Marquardt on the requirement functions,
+     * which evaluates residuals and the Jacobian on the shared thread pool and factorizes the
+     * normal equations by block Cholesky. When enabled, components below the iterative threshold
+     * are built as SparseLSMTask expression trees and solved by the math library's SparseLMSolver
+     * instead. Both reach the same requirements, but an under-constrained sketch may settle in a
+     * different position.
+     *
+     * @param enabled true to enable (default false).
+     */
+    void setExpressionTreeSolveEnabled(bool enabled);
+
+    /// @brief Check whether the expression-tree solve is enabled.
+    bool getExpressionTreeSolveEnabled() const noexcept;
+
+    /**
+     * @brief Enable rigid-cluster solving for DRAG solves.
+     *
+     * Subsketches fully determined by their own rotation- and translation-invariant requirements
+     * (a dimensioned rectangle, a bolt pattern) are detected once per structural edit. While their
+     * internal requirements hold, a drag moves each such cluster as one rigid body with 3 DOF
+     * (2 when a horizontal/vertical requirement pins its orientation). Drags that this reduced
+     * problem cannot satisfy fall back to the regular solve.
+     *
+     * @param enabled true to enable (default false).
+     */
+    void setRigidClustersEnabled(bool enabled) noexcept;
+
+    /// @brief Check whether rigid-cluster solving is enabled.
+    bool getRigidClustersEnabled() const noexcept;
+
+    /**
+     * @brief Get the rigid clusters detected in a component.
+     * @param componentId Component to analyse.
+     * @return Sorted point IDs of each cluster (coincident points included).
+     */
+    std::vector<std::vector<Utils::ID>> getRigidClusters(ComponentID componentId);
+
     /**
      * @brief Solve the constraint system according to the current mode.
      *
@@ -320,20 +426,93 @@ public:
      * LOCAL  — solves only the specified component (Levenberg-Marquardt).
      * DRAG   — lightweight gradient descent, intended to be called from updatePoint/updateCircle.
      *
+     * When every requirement of the target is already satisfied, returns true without
+     * building or running the optimizer.
+     *
      * @param componentId Component to solve (used only in LOCAL mode).
      * @return true if the solver converged.
      */
     bool solve(std::optional<ComponentID> componentId = std::nullopt);
 
+    /**
+     * @brief Re-solve only the components touched since they were last solved.
+     *
+     * Every update*, addFigure, addRequirement and updateRequirementParam marks the affected
+     * component dirty; a converged solve of a component (or a converged GLOBAL solve) marks it clean.
+     * Dirty components are solved independently of the current mode, in parallel when there is more
+     * than one. Converged components leave the dirty set; the rest stay dirty. Clean components are
+     * never touched.
+     *
+     * @return true if every dirty component converged.
+     */
+    bool solveDirty();
+
+    /**
+     * @brief Telemetry of the most recent solve.
+     *
+     * Covers the last solve(), solveDirty() or drag update that solved, including every
+     * component or relaxation region it ran. Valid until the next solve.
+     */
+    const Utils::SolveReport& getLastSolveReport() const noexcept;
+
+    /**
+     * @brief Get components that changed since they were last solved.
+     * @return Sorted vector of dirty component IDs.
+     */
+    std::vector<ComponentID> getDirtyComponents() const;
+
+    /**
+     * @brief Heap bytes held by the manager, broken down per subsystem.
+     *
+     * Walks every container, so it costs about as much as copying the sketch's IDs; call it
+     * for diagnostics, not per frame. See Utils::MemoryUsage for what is counted.
+     */
+    Utils::MemoryUsage memoryUsage() const;
+
 private:
     struct SolveCache;
+    struct SolveCacheEntry;
+    struct RigidClusterSet;
     struct BatchUpdateContext;
     struct FixedGeometry;
 
     bool solveWithLockedVars(std::optional<ComponentID> componentId,
-                             const std::unordered_set<double*>& lockedVars);
+                             const std::vector<Utils::VarHandle>& lockHandles);
+    std::unordered_set<double*> resolveLocks(const std::vector<Utils::VarHandle>& lockHandles);
+    std::optional<ComponentID> resolveSolveTarget(std::optional<ComponentID> componentId) const;
+    SolveCacheEntry& prepareSolveEntry(std::optional<ComponentID> target,
+                                       const std::vector<Utils::VarHandle>& lockHandles);
+    System::RequirementSystem& solveEntrySystem(SolveCacheEntry& entry);
+    void buildSolvePipeline(SolveCacheEntry& entry, const std::unordered_set<double*>& lockedVars);
+    /// Outcome of running a prepared entry; pipeline rebuilds are left to the calling thread.
+    enum class SolveEntryOutcome : std::uint8_t {
+        ET_CONVERGED,
+        ET_NOT_CONVERGED,
+        ET_NEEDS_NUMERIC_REBUILD ///< Constructed points missed their requirements
+    };
+
+    /// runSolveEntryPipeline() and finishSolveEntry() on the calling thread.
+    bool runSolveEntry(SolveCacheEntry& entry);
+    /// Run a built pipeline; touches only the entry's own geometry, so entries may run concurrently.
+    SolveEntryOutcome runSolveEntryPipeline(SolveCacheEntry& entry);
+    /// Rebuild without construction if asked, then record the final residual; calling thread only.
+    bool finishSolveEntry(SolveCacheEntry& entry, SolveEntryOutcome outcome);
+    bool executeSolvePipeline(SolveCacheEntry& entry);
+    void finishSatisfiedEntry(SolveCacheEntry& entry);
+    bool solveRelaxed(ComponentID componentId,
+                      const std::vector<Utils::ID>& seeds,
+                      const std::vector<Utils::VarHandle>& lockHandles);
+    std::unordered_set<Utils::ID> collectRelaxationRegion(const std::vector<Utils::ID>& seeds,
+                                                          std::size_t hops);
+    RigidClusterSet& rigidClustersFor(ComponentID componentId);
+    bool solveWithRigidClusters(ComponentID componentId, const std::vector<Utils::VarHandle>& lockHandles);
     void invalidateSolveCache() noexcept;
 
+    void markFigureDirty(Utils::ID figureId);
+    void markComponentDirty(ComponentID componentId);
+    bool isComponentDirty(ComponentID componentId) const noexcept;
+    void markSolved(std::optional<ComponentID> target) noexcept;
+
     Figures::GeometryStorage _storage;
     System::RequirementSystem _reqSystem;
 
@@ -343,21 +522,34 @@ private:
     std::vector<Utils::ID> _requirementOrder;
     std::unordered_map<Utils::ID, ComponentID> _figureToComponent;
     std::vector<std::unordered_set<Utils::ID>> _components;
+    /// Dirty flag per ComponentID; IDs past the end are clean, so clear() marks everything solved.
+    std::vector<char> _dirtyComponents;
     ComponentID _nextComponentId = 0;
     std::size_t _activeComponentCount = 0;
     Utils::SolveMode _solveMode = Utils::SolveMode::GLOBAL;
+    std::size_t _relaxationHops = 0;
+    bool _rigidClustersEnabled = false;
+    bool _constructiveSolveEnabled = false;
+    bool _expressionTreeSolveEnabled = false;
+    std::size_t _iterativeSolveThreshold = 20000;
     std::unique_ptr<SolveCache> _solveCache;
+    std::unique_ptr<BatchUpdateContext> _batchUpdate;
+    Utils::SolveReport _lastSolveReport;
 
     std::unique_ptr<System::RequirementSystem> buildSubsystem(ComponentID componentId) const;
 
-    FixedGeometry collectFixedGeometry() const;
+    /// Points and circles pinned by fix requirements; cached until the solve cache is invalidated.
+    const FixedGeometry& collectFixedGeometry();
     bool pointGroupHasFixConstraint(
         Utils::ID pointId,
         const std::unordered_set<Utils::ID>& fixedPointIds) const;
     void addDragLocks(Utils::ID figureId,
-                      std::initializer_list<double*> vars,
+                      std::initializer_list<std::optional<Utils::VarHandle>> handles,
                       BatchUpdateContext& context);
+    /// Reset and return the context reused by every update batch.
+    BatchUpdateContext& beginBatchUpdate();
     void solveDragUpdates(const BatchUpdateContext& context);
+    void updatePointBatch(std::span<const Utils::PointUpdateDescriptor> descriptors);
     void applyPointUpdateNoSolve(const Utils::PointUpdateDescriptor& descriptor,
                                  const FixedGeometry& fixedGeometry,
                                  BatchUpdateContext& context);
@@ -380,6 +572,8 @@ private:
     void validateFigureUpdate(const Utils::FigureUpdateDescriptor& descriptor) const;
 
     /// Rebuild _reqSystem from _requirementRecords and mark it in sync.
+    void validateNewRequirement(const Utils::RequirementDescriptor& descriptor) const;
+    void recordRequirement(Utils::ID reqId, const Utils::RequirementDescriptor& descriptor);
     void rebuildRequirementSystem();
     /// If records and _reqSystem differ, perform rebuildRequirementSystem().
     void syncRequirementSystemIfNeeded();
@@ -0,0 +1,99 @@
+#ifndef OURPAINTDCM_HEADERS_SKETCHGENERATOR_H
+#define OURPAINTDCM_HEADERS_SKETCHGENERATOR_H
+
+#include "DCMManager.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace OurPaintDCM {
+
+/**
+ * @brief Parametric families of synthetic sketches.
+ */
+enum class SketchFamily : std::uint8_t {
+    /// One grid of rectangles: horizontal/vertical sides, dimension chains along two edges.
+    ET_RECTANGLE_GRID,
+    /// One rod lattice: a distance on every member, diagonal braces along two edges.
+    ET_TRUSS_LATTICE,
+    /// Flanges with holes on a pitch circle, spaced by chord distances.
+    ET_BOLT_CIRCLE,
+    /// One long chain of links with fixed lengths and joint angles.
+    ET_OPEN_LINKAGE,
+    /// Many independent triangles, rectangles and fixed circles.
+    ET_DISCONNECTED_PARTS
+};
+
+/**
+ * @brief How many requirements a generated sketch carries relative to its degrees of freedom.
+ */
+enum class ConstraintLevel : std::uint8_t {
+    /// No free degrees of freedom (bolt-circle hole radii excepted, see SketchFamily).
+    ET_WELL,
+    /// Degree-removing requirements dropped, leaving mechanisms.
+    ET_UNDER,
+    /// Redundant but consistent requirements added.
+    ET_OVER
+};
+
+/**
+ * @brief Parameters of a generated sketch.
+ */
+struct SketchSpec {
+    SketchFamily family = SketchFamily::ET_RECTANGLE_GRID;
+    std::size_t targetEntities = 1000;  ///< Figures to create (points, lines, circles); approximate
+    std::uint64_t seed = 1;             ///< Same seed and spec give the same sketch on every platform
+    ConstraintLevel level = ConstraintLevel::ET_WELL;
+    double variantRatio = 0.5;          ///< Share of requirements dropped (ET_UNDER) or added (ET_OVER)
+    double jitter = 0.0;                ///< Initial offset of free points, so the sketch needs solving
+};
+
+/**
+ * @brief Figures and requirements of a generated sketch.
+ */
+struct GeneratedSketch {
+    std::vector<Utils::ID> points;
+    std::vector<Utils::ID> lines;
+    std::vector<Utils::ID> circles;
+    std::vector<Utils::RequirementDescriptor> requirements; ///< Requirements in insertion order
+    std::vector<Utils::ID> requirementIds;                  ///< Their IDs once added; empty otherwise
+    std::vector<Utils::ID> anchors;                         ///< Points held by a fix requirement
+    std::vector<Utils::ID> handles;                         ///< Free points, suitable drag targets
+    std::size_t parts = 0;                                  ///< Independent parts (connected components)
+
+    std::size_t entityCount() const noexcept { return points.size() + lines.size() + circles.size(); }
+};
+
+/// @brief Stable family name, for benchmark and report labels.
+std::string_view sketchFamilyName(SketchFamily family) noexcept;
+
+/// @brief Stable constraint-level name, for benchmark and report labels.
+std::string_view constraintLevelName(ConstraintLevel level) noexcept;
+
+/**
+ * @brief Add the figures of a synthetic sketch and return its requirements without adding them.
+ *
+ * Lets callers time or reorder requirement insertion. Requirement parameters are measured on
+ * the unjittered geometry, so ET_WELL and ET_OVER sketches are always consistent.
+ */
+GeneratedSketch generateFigures(DCMManager& manager, const SketchSpec& spec);
+
+/**
+ * @brief Add a complete synthetic sketch to @p manager.
+ *
+ * Figures are added one by one and requirements in one DCMManager::addRequirements() batch,
+ * so sizes up to millions of entities load in linear time.
+ *
+ * Example:
+ * @code
+ * DCMManager manager;
+ * const auto sketch = generateSketch(manager, {SketchFamily::ET_TRUSS_LATTICE, 100'000, 42});
+ * manager.solve();
+ * @endcode
+ */
+GeneratedSketch generateSketch(DCMManager& manager, const SketchSpec& spec);
+}
+
+#endif // OURPAINTDCM_HEADERS_SKETCHGENERATOR_H
@@ -3,6 +3,7 @@
 
 #include "ID.h"
 
+#include <cstddef>
 #include <unordered_map>
 #include <vector>
 
@@ -67,6 +68,11 @@ public:
      */
     void clear() noexcept;
 
+    /**
+     * @brief Heap bytes of both maps and their ID lists (see Utils::MemoryUsage).
+     */
+    [[nodiscard]] std::size_t heapBytes() const noexcept;
+
 private:
     /** @brief Appends @p id to @p vec if not already present (linear scan). */
     static void pushUnique(std::vector<Utils::ID>& vec, Utils::ID id);
@@ -9,7 +9,10 @@
 #include "ID.h"
 #include "IDGenerator.h"
 #include "Enums.h"
+#include "VarHandle.h"
+#include "Instrumentation.h"
 #include "Graph.h"
+#include "MemoryUsage.h"
 
 #include <cstdint>
 #include <memory>
@@ -166,6 +169,20 @@ public:
      */
     [[nodiscard]] std::optional<FigureEntry> getEntry(ID id) const noexcept;
 
+    /**
+     * @brief Handle of one scalar owned by a figure.
+     * @param id Point or circle ID.
+     * @param component Utils::kPointX / Utils::kPointY for points, Utils::kCircleRadius for circles.
+     * @return std::nullopt if @p id is missing or owns no such scalar (lines and arcs own none).
+     */
+    [[nodiscard]] std::optional<Utils::VarHandle> varHandle(ID id, std::uint8_t component) const noexcept;
+
+    /**
+     * @brief Current address of the scalar named by @p handle.
+     * @return nullptr if the slot is empty, was freed since the handle was made, or the component does not exist.
+     */
+    [[nodiscard]] double* resolve(Utils::VarHandle handle) noexcept;
+
     /**
      * @brief True if @p id is currently a live object in this storage.
      */
@@ -246,6 +263,13 @@ public:
     /** @brief Read-only cache of all arcs. */
     [[nodiscard]] const std::vector<FigureRef<Arc2D>>& arcsWithIds() const noexcept { return m_arcsWithIds; }
 
+    /**
+     * @brief Adds this storage's heap bytes to the geometry fields of @p usage.
+     *
+     * Slots count the pointer vectors plus one object per occupied slot.
+     */
+    void accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept;
+
 #ifndef NDEBUG
     /**
      * @brief Validates index, caches, slot occupancy, and dependency arity in debug builds.
@@ -317,10 +341,12 @@ private:
 
     std::vector<std::unique_ptr<Point2D>> m_pointSlots;
     std::vector<std::size_t>              m_pointFree;
+    std::vector<std::uint32_t>            m_pointGenerations;  ///< Per slot, bumped on free; survives clear()
     std::vector<std::unique_ptr<Line2D>> m_lineSlots;
     std::vector<std::size_t>              m_lineFree;
     std::vector<std::unique_ptr<Circle2D>> m_circleSlots;
     std::vector<std::size_t>              m_circleFree;
+    std::vector<std::uint32_t>            m_circleGenerations; ///< Per slot, bumped on free; survives clear()
     std::vector<std::unique_ptr<Arc2D>> m_arcSlots;
     std::vector<std::size_t>              m_arcFree;
 
@@ -351,6 +377,7 @@ constexpr FigureType GeometryStorage::typeToEnum() noexcept {
 /** @brief Non-const get(); see class GeometryStorage::get. */
 template <SupportedFigure T>
 T* GeometryStorage::get(ID id) noexcept {
+    OURPAINTDCM_PROBE_COUNT(ET_GEOMETRY_GET);
     auto it = m_index.find(id);
     if (it == m_index.end() || it->second.type != typeToEnum<T>()) {
         return nullptr;
@@ -370,6 +397,7 @@ T* GeometryStorage::get(ID id) noexcept {
 /** @brief Const get(); see class GeometryStorage::get. */
 template <SupportedFigure T>
 const T* GeometryStorage::get(ID id) const noexcept {
+    OURPAINTDCM_PROBE_COUNT(ET_GEOMETRY_GET);
     auto it = m_index.find(id);
     if (it == m_index.end() || it->second.type != typeToEnum<T>()) {
         return nullptr;
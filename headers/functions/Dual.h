@@ -0,0 +1,122 @@
+#ifndef OURPAINTDCM_FUNCTION_DUAL_H
+#define OURPAINTDCM_FUNCTION_DUAL_H
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace OurPaintDCM::Function {
+
+/**
+ * @brief Forward-mode dual number with a fixed number of derivative lanes.
+ *
+ * Carries a value and its partial derivatives with respect to N seeded inputs, so one
+ * evaluation of a residual templated on the scalar type yields the full gradient.
+ * Everything is inline and stack-allocated.
+ *
+ * Example:
+ * @code
+ * std::array<Dual<2>, 2> x{Dual<2>::variable(3.0, 0), Dual<2>::variable(4.0, 1)};
+ * const auto r = sqrt(x[0] * x[0] + x[1] * x[1]); // r.value() == 5, r.derivative(0) == 0.6
+ * @endcode
+ */
+template<std::size_t N>
+class Dual {
+    double _value = 0.0;
+    std::array<double, N> _derivatives{};
+
+public:
+    constexpr Dual() = default;
+
+    /// @brief Constant: all derivatives are zero.
+    constexpr Dual(double value) : _value(value) {}
+
+    /// @brief Input @p lane: derivative 1 with respect to itself.
+    static constexpr Dual variable(double value, std::size_t lane) {
+        Dual result(value);
+        result._derivatives[lane] = 1.0;
+        return result;
+    }
+
+    constexpr double value() const noexcept { return _value; }
+    constexpr double derivative(std::size_t lane) const noexcept { return _derivatives[lane]; }
+    constexpr const std::array<double, N>& derivatives() const noexcept { return _derivatives; }
+
+    constexpr Dual operator-() const {
+        Dual result(-_value);
+        for (std::size_t i = 0; i < N; ++i) {
+            result._derivatives[i] = -_derivatives[i];
+        }
+        return result;
+    }
+
+    constexpr Dual& operator+=(const Dual& other) {
+        _value += other._value;
+        for (std::size_t i = 0; i < N; ++i) {
+            _derivatives[i] += other._derivatives[i];
+        }
+        return *this;
+    }
+
+    constexpr Dual& operator-=(const Dual& other) {
+        _value -= other._value;
+        for (std::size_t i = 0; i < N; ++i) {
+            _derivatives[i] -= other._derivatives[i];
+        }
+        return *this;
+    }
+
+    constexpr Dual& operator*=(const Dual& other) {
+        for (std::size_t i = 0; i < N; ++i) {
+            _derivatives[i] = _derivatives[i] * other._value + _value * other._derivatives[i];
+        }
+        _value *= other._value;
+        return *this;
+    }
+
+    constexpr Dual& operator/=(const Dual& other) {
+        const double inverse = 1.0 / other._value;
+        const double quotient = _value * inverse;
+        for (std::size_t i = 0; i < N; ++i) {
+            _derivatives[i] = (_derivatives[i] - quotient * other._derivatives[i]) * inverse;
+        }
+        _value = quotient;
+        return *this;
+    }
+
+    friend constexpr Dual operator+(Dual lhs, const Dual& rhs) { return lhs += rhs; }
+    friend constexpr Dual operator-(Dual lhs, const Dual& rhs) { return lhs -= rhs; }
+    friend constexpr Dual operator*(Dual lhs, const Dual& rhs) { return lhs *= rhs; }
+    friend constexpr Dual operator/(Dual lhs, const Dual& rhs) { return lhs /= rhs; }
+
+    /// @brief Square root; the derivative at 0 is taken as 0 instead of infinity.
+    friend Dual sqrt(const Dual& x) {
+        Dual result(std::sqrt(x._value));
+        const double scale = result._value > 0.0 ? 0.5 / result._value : 0.0;
+        for (std::size_t i = 0; i < N; ++i) {
+            result._derivatives[i] = x._derivatives[i] * scale;
+        }
+        return result;
+    }
+
+    friend Dual cos(const Dual& x) {
+        Dual result(std::cos(x._value));
+        const double slope = -std::sin(x._value);
+        for (std::size_t i = 0; i < N; ++i) {
+            result._derivatives[i] = x._derivatives[i] * slope;
+        }
+        return result;
+    }
+};
+
+/// @brief Value part of a scalar, for branching inside kernels templated on the scalar type.
+constexpr double valueOf(double x) noexcept { return x; }
+
+template<std::size_t N>
+constexpr double valueOf(const Dual<N>& x) noexcept { return x.value(); }
+
+/// @brief Same value with the derivatives dropped.
+template<typename T>
+constexpr T passive(const T& x) { return T(valueOf(x)); }
+}
+
+#endif // OURPAINTDCM_FUNCTION_DUAL_H
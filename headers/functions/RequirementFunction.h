@@ -2,6 +2,8 @@
 #define OURPAINTDCM_FUNCTION_MATHFUNCTION_H
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
+#include <span>
+#include <unordered_map>
 #include <vector>
 #include "Enums.h"
 #include "ID.h"
@@ -21,6 +23,10 @@ namespace OurPaintDCM::Function {
      *  - gradient(): partial derivatives with respect to all variables
      */
     class RequirementFunction {
+    public:
+        /// Largest getVarCount() of any requirement function; sizes gradientInto() buffers.
+        static constexpr std::size_t kMaxVarCount = 8;
+
     protected:
         double _weight = 1.0;                ///< Importance coefficient in the optimization system
         std::vector<VAR> _vars;              ///< List of variable pointers
@@ -38,11 +44,29 @@ namespace OurPaintDCM::Function {
         /// Compute the gradient (first-order derivatives) with respect to variables.
         virtual std::unordered_map<VAR, double> gradient() const = 0;
 
+        /**
+         * @brief Write the partial derivative for each getVars() position into @p partials, without allocating.
+         *
+         * A variable listed twice gets one partial per position; their sum is its gradient() entry.
+         * @p partials must hold getVarCount() values (at most kMaxVarCount).
+         */
+        virtual void gradientInto(std::span<double> partials) const;
+
         /// Return variables involved in this constraint.
         virtual std::vector<VAR> getVars() const {
             return _vars;
         }
 
+        /// Heap bytes of the variable list; the object itself is counted by its owner.
+        std::size_t heapBytes() const noexcept {
+            return _vars.capacity() * sizeof(VAR);
+        }
+
+        /// Size of the most derived object, for memory accounting; heapBytes() is not included.
+        virtual std::size_t objectBytes() const noexcept {
+            return sizeof(RequirementFunction);
+        }
+
         /// Return the number of variables used.
         virtual size_t getVarCount() const = 0;
 
@@ -85,7 +109,9 @@ namespace OurPaintDCM::Function {
         PointLineDistanceFunction(const std::vector<VAR>& vars, double dist);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -98,7 +124,9 @@ namespace OurPaintDCM::Function {
         PointOnLineFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -112,7 +140,9 @@ namespace OurPaintDCM::Function {
         PointPointDistanceFunction(const std::vector<VAR>& vars, double dist);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -125,7 +155,9 @@ namespace OurPaintDCM::Function {
         PointOnPointFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -139,7 +171,9 @@ namespace OurPaintDCM::Function {
         LineCircleDistanceFunction(const std::vector<VAR>& vars, double dist);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -152,7 +186,9 @@ namespace OurPaintDCM::Function {
         LineOnCircleFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -165,7 +201,9 @@ namespace OurPaintDCM::Function {
         LineLineParallelFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -178,7 +216,9 @@ namespace OurPaintDCM::Function {
         LineLinePerpendicularFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -192,7 +232,9 @@ namespace OurPaintDCM::Function {
         LineLineAngleFunction(const std::vector<VAR>& vars, double angle);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -205,7 +247,9 @@ namespace OurPaintDCM::Function {
         VerticalFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -218,7 +262,9 @@ namespace OurPaintDCM::Function {
         HorizontalFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -231,7 +277,9 @@ namespace OurPaintDCM::Function {
         ArcCenterOnPerpendicularFunction(const std::vector<VAR>& vars);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
     };
 
     /**
@@ -248,7 +296,9 @@ namespace OurPaintDCM::Function {
         FixCoordinateFunction(Utils::RequirementType type, const std::vector<VAR>& vars, double target);
         double evaluate() const override;
         std::unordered_map<VAR, double> gradient() const override;
+        void gradientInto(std::span<double> partials) const override;
         size_t getVarCount() const override;
+        std::size_t objectBytes() const noexcept override;
         bool tryGetAssignment(VAR& var, double& value) const override;
     };
 }
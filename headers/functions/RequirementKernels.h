@@ -0,0 +1,136 @@
+#ifndef OURPAINTDCM_FUNCTION_REQUIREMENTKERNELS_H
+#define OURPAINTDCM_FUNCTION_REQUIREMENTKERNELS_H
+#include "Dual.h"
+#include <array>
+#include <cmath>
+
+/**
+ * @file RequirementKernels.h
+ * @brief Constraint residuals written once over the scalar type.
+ *
+ * Each kernel takes the variables of its RequirementFunction in the documented order.
+ * Instantiated with double it gives the residual; with Dual<N> it gives the residual and
+ * its exact gradient. Branches test valueOf() so both instantiations take the same path.
+ */
+namespace OurPaintDCM::Function::Kernels {
+
+/// Lengths below which a segment or distance counts as degenerate.
+inline constexpr double kSegmentEpsilon = 1e-12;
+inline constexpr double kLengthEpsilon = 1e-10;
+
+/// Signed distance from (Px, Py) to the line through (L1, L2). Variables: [Px, Py, L1x, L1y, L2x, L2y]
+template<typename T>
+T pointLineSignedDistance(const std::array<T, 6>& x) {
+    using std::sqrt;
+    const T dx = x[4] - x[2];
+    const T dy = x[5] - x[3];
+    const T lineLen = sqrt(dx * dx + dy * dy);
+    if (valueOf(lineLen) < kSegmentEpsilon) {
+        return T(0.0);
+    }
+    const T cross = (x[0] - x[2]) * dy - (x[1] - x[3]) * dx;
+    return cross / lineLen;
+}
+
+/// Distance between two points; its gradient is zero when they (nearly) coincide. Variables: [P1x, P1y, P2x, P2y]
+template<typename T>
+T pointPointDistance(const std::array<T, 4>& x) {
+    using std::sqrt;
+    const T dx = x[2] - x[0];
+    const T dy = x[3] - x[1];
+    const T dist = sqrt(dx * dx + dy * dy);
+    return valueOf(dist) < kLengthEpsilon ? passive(dist) : dist;
+}
+
+/// Distance from the circle to the closest point of the segment, minus @p distance. Variables: [L1x, L1y, L2x, L2y, Cx, Cy, R]
+template<typename T>
+T lineCircleDistance(const std::array<T, 7>& x, double distance) {
+    using std::sqrt;
+    const T& x1 = x[0];
+    const T& y1 = x[1];
+    const T& cx = x[4];
+    const T& cy = x[5];
+    const T dx = x[2] - x1;
+    const T dy = x[3] - y1;
+    const T lineLen2 = dx * dx + dy * dy;
+
+    T px = x1;
+    T py = y1;
+    if (valueOf(lineLen2) >= kLengthEpsilon) {
+        T t = ((cx - x1) * dx + (cy - y1) * dy) / lineLen2;
+        if (valueOf(t) < 0.0) {
+            t = T(0.0);
+        } else if (valueOf(t) > 1.0) {
+            t = T(1.0);
+        }
+        px = x1 + t * dx;
+        py = y1 + t * dy;
+    }
+
+    const T dist = sqrt((cx - px) * (cx - px) + (cy - py) * (cy - py));
+    const T residual = dist - x[6] - distance;
+    return valueOf(dist) < kLengthEpsilon ? passive(residual) : residual;
+}
+
+/// Sum of both endpoint distances to the circle. Variables: [L1x, L1y, L2x, L2y, Cx, Cy, R]
+template<typename T>
+T lineOnCircle(const std::array<T, 7>& x) {
+    using std::sqrt;
+    const T dx1 = x[0] - x[4];
+    const T dy1 = x[1] - x[5];
+    const T dx2 = x[2] - x[4];
+    const T dy2 = x[3] - x[5];
+    return (sqrt(dx1 * dx1 + dy1 * dy1) - x[6]) + (sqrt(dx2 * dx2 + dy2 * dy2) - x[6]);
+}
+
+/// Cross product of both directions. Variables: [A1x, A1y, A2x, A2y, B1x, B1y, B2x, B2y]
+template<typename T>
+T lineLineParallel(const std::array<T, 8>& x) {
+    return (x[2] - x[0]) * (x[7] - x[5]) - (x[3] - x[1]) * (x[6] - x[4]);
+}
+
+/// Dot product of both directions. Variables: [A1x, A1y, A2x, A2y, B1x, B1y, B2x, B2y]
+template<typename T>
+T lineLinePerpendicular(const std::array<T, 8>& x) {
+    return (x[2] - x[0]) * (x[6] - x[4]) + (x[3] - x[1]) * (x[7] - x[5]);
+}
+
+/// cos of the angle between both directions minus cos(@p angle). Variables: [A1x, A1y, A2x, A2y, B1x, B1y, B2x, B2y]
+template<typename T>
+T lineLineAngle(const std::array<T, 8>& x, double angle) {
+    using std::sqrt;
+    const T dx1 = x[2] - x[0];
+    const T dy1 = x[3] - x[1];
+    const T dx2 = x[6] - x[4];
+    const T dy2 = x[7] - x[5];
+    const T len1 = sqrt(dx1 * dx1 + dy1 * dy1);
+    const T len2 = sqrt(dx2 * dx2 + dy2 * dy2);
+    if (valueOf(len1) < kLengthEpsilon || valueOf(len2) < kLengthEpsilon) {
+        return T(0.0);
+    }
+    return (dx1 * dx2 + dy1 * dy2) / (len1 * len2) - std::cos(angle);
+}
+
+/// Component @p Axis (0 = x, 1 = y) of the unit direction. Variables: [L1x, L1y, L2x, L2y]
+template<int Axis, typename T>
+T lineDirectionComponent(const std::array<T, 4>& x) {
+    using std::sqrt;
+    const T dx = x[2] - x[0];
+    const T dy = x[3] - x[1];
+    const T len = sqrt(dx * dx + dy * dy);
+    if (valueOf(len) < kLengthEpsilon) {
+        return T(0.0);
+    }
+    return (Axis == 0 ? dx : dy) / len;
+}
+
+/// (B − A)·(C − M) with M the midpoint of AB. Variables: [Ax, Ay, Bx, By, Cx, Cy]
+template<typename T>
+T arcCenterOnPerpendicular(const std::array<T, 6>& x) {
+    const T mx = x[4] - 0.5 * (x[0] + x[2]);
+    const T my = x[5] - 0.5 * (x[1] + x[3]);
+    return (x[2] - x[0]) * mx + (x[3] - x[1]) * my;
+}
+}
+
+#endif // OURPAINTDCM_FUNCTION_REQUIREMENTKERNELS_H
@@ -0,0 +1,346 @@
+#ifndef OURPAINTDCM_HEADERS_REQUIREMENTS_REQUIREMENTTRAITS_H
+#define OURPAINTDCM_HEADERS_REQUIREMENTS_REQUIREMENTTRAITS_H
+#include "Enums.h"
+#include "RequirementFunction.h"
+#include "ErrorFunction.h"
+#include "Point2D.h"
+#include "Line.h"
+#include "Circle.h"
+#include "Arc.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace OurPaintDCM::Requirements {
+/**
+ * @brief Kind of geometric object a requirement refers to.
+ *
+ * Each kind contributes a fixed run of variables, in this order:
+ * Point (x, y), Line (p1, p2), Circle (center, radius), Arc (p1, p2, center).
+ */
+enum class ObjectKind : uint8_t {
+    Point,
+    Line,
+    Circle,
+    Arc
+};
+
+/// @brief Number of variables an object of @p kind contributes.
+constexpr std::size_t objectVariableCount(ObjectKind kind) noexcept {
+    switch (kind) {
+        case ObjectKind::Point: return 2;
+        case ObjectKind::Line: return 4;
+        case ObjectKind::Circle: return 3;
+        case ObjectKind::Arc: return 6;
+    }
+    return 0;
+}
+
+/// @brief How a requirement enters the solved system.
+enum class RowKind : uint8_t {
+    Residual,    ///< One residual row over all object variables
+    Coincidence, ///< Handled by point merging, no row
+    Fix          ///< One assignment row per object variable
+};
+
+/**
+ * @brief Object list shared by the trait specializations.
+ * @tparam Kinds Object kinds in RequirementDescriptor::objectIds order.
+ */
+template<ObjectKind... Kinds>
+struct RequirementShape {
+    static constexpr std::array<ObjectKind, sizeof...(Kinds)> objects{Kinds...}; ///< Object kinds
+    static constexpr std::size_t arity = sizeof...(Kinds);                      ///< Number of object IDs
+    static constexpr std::size_t variableCount = (objectVariableCount(Kinds) + ... + 0); ///< Concatenated variables
+    static constexpr RowKind rows = RowKind::Residual;
+    static constexpr bool hasParam = false;   ///< Requires RequirementDescriptor::param
+    static constexpr int axisCoordinate = -1; ///< Line coordinate the linear presolve ties between both end points (0 = x, 1 = y), -1 if none
+};
+
+/**
+ * @brief Compile-time description of a requirement type.
+ *
+ * Every specialization declares the object kinds (and thereby arity and variable layout),
+ * whether a parameter is required, how rows are produced, and the residual kernels:
+ * - Kernel: RequirementFunction subclass evaluated by RequirementFunctionSystem (void if none);
+ * - ErrorKernel: math-library ErrorFunction used by the LM pipeline (void if none).
+ *
+ * Layers dispatch through visitRequirementType() and build with the helpers below, so adding
+ * a requirement type means adding one specialization and one case there. The helpers take
+ * a RequirementTag, which adds the type itself to the traits.
+ */
+template<Utils::RequirementType Type>
+struct RequirementTraits;
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_POINTLINEDIST>
+    : RequirementShape<ObjectKind::Point, ObjectKind::Line> {
+    static constexpr bool hasParam = true;
+    using Kernel = OurPaintDCM::Function::PointLineDistanceFunction;
+    using ErrorKernel = PointSectionDistanceError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_POINTONLINE>
+    : RequirementShape<ObjectKind::Point, ObjectKind::Line> {
+    using Kernel = OurPaintDCM::Function::PointOnLineFunction;
+    using ErrorKernel = PointOnSectionError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_POINTPOINTDIST>
+    : RequirementShape<ObjectKind::Point, ObjectKind::Point> {
+    static constexpr bool hasParam = true;
+    using Kernel = OurPaintDCM::Function::PointPointDistanceFunction;
+    using ErrorKernel = PointPointDistanceError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_POINTONPOINT>
+    : RequirementShape<ObjectKind::Point, ObjectKind::Point> {
+    static constexpr RowKind rows = RowKind::Coincidence;
+    using Kernel = OurPaintDCM::Function::PointOnPointFunction;
+    using ErrorKernel = PointOnPointError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINECIRCLEDIST>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Circle> {
+    static constexpr bool hasParam = true;
+    using Kernel = OurPaintDCM::Function::LineCircleDistanceFunction;
+    using ErrorKernel = SectionCircleDistanceError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINEONCIRCLE>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Circle> {
+    using Kernel = OurPaintDCM::Function::LineOnCircleFunction;
+    using ErrorKernel = SectionOnCircleError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINEINCIRCLE>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Circle> {
+    using Kernel = void;
+    using ErrorKernel = SectionInCircleError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINELINEPARALLEL>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Line> {
+    using Kernel = OurPaintDCM::Function::LineLineParallelFunction;
+    using ErrorKernel = SectionSectionParallelError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINELINEPERPENDICULAR>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Line> {
+    using Kernel = OurPaintDCM::Function::LineLinePerpendicularFunction;
+    using ErrorKernel = SectionSectionPerpendicularError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_LINELINEANGLE>
+    : RequirementShape<ObjectKind::Line, ObjectKind::Line> {
+    static constexpr bool hasParam = true;
+    using Kernel = OurPaintDCM::Function::LineLineAngleFunction;
+    using ErrorKernel = SectionSectionAngleError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_VERTICAL>
+    : RequirementShape<ObjectKind::Line> {
+    static constexpr int axisCoordinate = 0;
+    using Kernel = OurPaintDCM::Function::VerticalFunction;
+    using ErrorKernel = VerticalError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_HORIZONTAL>
+    : RequirementShape<ObjectKind::Line> {
+    static constexpr int axisCoordinate = 1;
+    using Kernel = OurPaintDCM::Function::HorizontalFunction;
+    using ErrorKernel = HorizontalError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_ARCCENTERONPERPENDICULAR>
+    : RequirementShape<ObjectKind::Arc> {
+    using Kernel = OurPaintDCM::Function::ArcCenterOnPerpendicularFunction;
+    using ErrorKernel = ArcCenterOnPerpendicularError;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_FIXPOINT>
+    : RequirementShape<ObjectKind::Point> {
+    static constexpr RowKind rows = RowKind::Fix;
+    using Kernel = OurPaintDCM::Function::FixCoordinateFunction;
+    using ErrorKernel = void;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_FIXLINE>
+    : RequirementShape<ObjectKind::Line> {
+    static constexpr RowKind rows = RowKind::Fix;
+    using Kernel = OurPaintDCM::Function::FixCoordinateFunction;
+    using ErrorKernel = void;
+};
+
+template<>
+struct RequirementTraits<Utils::RequirementType::ET_FIXCIRCLE>
+    : RequirementShape<ObjectKind::Circle> {
+    static constexpr RowKind rows = RowKind::Fix;
+    using Kernel = OurPaintDCM::Function::FixCoordinateFunction;
+    using ErrorKernel = void;
+};
+
+/// @brief Tag passed to visitRequirementType() visitors.
+template<Utils::RequirementType Type>
+struct RequirementTag : RequirementTraits<Type> {
+    static constexpr Utils::RequirementType type = Type;
+};
+
+/**
+ * @brief Call @p visitor with the RequirementTag of @p type.
+ *
+ * This is the single runtime switch over requirement types; the visitor body is
+ * instantiated per type, so trait lookups and kernel construction are resolved at compile time.
+ * @throws std::invalid_argument for a value outside RequirementType.
+ */
+template<typename Visitor>
+decltype(auto) visitRequirementType(Utils::RequirementType type, Visitor&& visitor) {
+    using enum Utils::RequirementType;
+    switch (type) {
+        case ET_POINTLINEDIST: return visitor(RequirementTag<ET_POINTLINEDIST>{});
+        case ET_POINTONLINE: return visitor(RequirementTag<ET_POINTONLINE>{});
+        case ET_POINTPOINTDIST: return visitor(RequirementTag<ET_POINTPOINTDIST>{});
+        case ET_POINTONPOINT: return visitor(RequirementTag<ET_POINTONPOINT>{});
+        case ET_LINECIRCLEDIST: return visitor(RequirementTag<ET_LINECIRCLEDIST>{});
+        case ET_LINEONCIRCLE: return visitor(RequirementTag<ET_LINEONCIRCLE>{});
+        case ET_LINEINCIRCLE: return visitor(RequirementTag<ET_LINEINCIRCLE>{});
+        case ET_LINELINEPARALLEL: return visitor(RequirementTag<ET_LINELINEPARALLEL>{});
+        case ET_LINELINEPERPENDICULAR: return visitor(RequirementTag<ET_LINELINEPERPENDICULAR>{});
+        case ET_LINELINEANGLE: return visitor(RequirementTag<ET_LINELINEANGLE>{});
+        case ET_VERTICAL: return visitor(RequirementTag<ET_VERTICAL>{});
+        case ET_HORIZONTAL: return visitor(RequirementTag<ET_HORIZONTAL>{});
+        case ET_ARCCENTERONPERPENDICULAR: return visitor(RequirementTag<ET_ARCCENTERONPERPENDICULAR>{});
+        case ET_FIXPOINT: return visitor(RequirementTag<ET_FIXPOINT>{});
+        case ET_FIXLINE: return visitor(RequirementTag<ET_FIXLINE>{});
+        case ET_FIXCIRCLE: return visitor(RequirementTag<ET_FIXCIRCLE>{});
+    }
+    throw std::invalid_argument("Unknown requirement type");
+}
+
+/**
+ * @brief Concatenate the variables of a requirement's objects.
+ * @param source Called as source(kind, slot, out) for every object; writes
+ *        objectVariableCount(kind) pointers to @p out.
+ */
+template<typename Traits, typename Source>
+std::array<VAR, Traits::variableCount> gatherVariables(Source&& source) {
+    std::array<VAR, Traits::variableCount> vars{};
+    std::size_t offset = 0;
+    for (std::size_t slot = 0; slot < Traits::arity; ++slot) {
+        source(Traits::objects[slot], slot, vars.data() + offset);
+        offset += objectVariableCount(Traits::objects[slot]);
+    }
+    return vars;
+}
+
+/// @brief Object kind of a figure type.
+template<typename Figure>
+constexpr ObjectKind figureKind() noexcept {
+    if constexpr (std::is_same_v<Figure, Figures::Point2D>) {
+        return ObjectKind::Point;
+    } else if constexpr (std::is_same_v<Figure, Figures::Line<Figures::Point2D>>) {
+        return ObjectKind::Line;
+    } else if constexpr (std::is_same_v<Figure, Figures::Circle<Figures::Point2D>>) {
+        return ObjectKind::Circle;
+    } else {
+        static_assert(std::is_same_v<Figure, Figures::Arc<Figures::Point2D>>, "Unsupported figure type");
+        return ObjectKind::Arc;
+    }
+}
+
+/// @brief Write the variables of @p figure in ObjectKind order.
+inline void figureVariables(Figures::Point2D* point, VAR* out) {
+    out[0] = point->ptrX();
+    out[1] = point->ptrY();
+}
+
+inline void figureVariables(Figures::Line<Figures::Point2D>* line, VAR* out) {
+    figureVariables(line->p1, out);
+    figureVariables(line->p2, out + 2);
+}
+
+inline void figureVariables(Figures::Circle<Figures::Point2D>* circle, VAR* out) {
+    figureVariables(circle->center, out);
+    out[2] = circle->ptrRadius();
+}
+
+inline void figureVariables(Figures::Arc<Figures::Point2D>* arc, VAR* out) {
+    figureVariables(arc->p1, out);
+    figureVariables(arc->p2, out + 2);
+    figureVariables(arc->p_center, out + 4);
+}
+
+/// @brief Variables of a requirement given its figures directly; the figure types must match Traits::objects.
+template<typename Traits, typename... Figures>
+std::array<VAR, Traits::variableCount> collectFigureVariables(Figures*... figures) {
+    static_assert(std::array<ObjectKind, sizeof...(Figures)>{figureKind<Figures>()...} == Traits::objects,
+                  "Figures do not match the requirement's object kinds");
+    std::array<VAR, Traits::variableCount> vars{};
+    VAR* out = vars.data();
+    ((figureVariables(figures, out), out += objectVariableCount(figureKind<Figures>())), ...);
+    return vars;
+}
+
+/// @brief Build the RequirementFunction kernel of a residual requirement.
+template<typename Traits>
+std::shared_ptr<typename Traits::Kernel> makeKernel(const std::array<VAR, Traits::variableCount>& vars,
+                                                    double param = 0.0) {
+    static_assert(Traits::rows == RowKind::Residual || Traits::rows == RowKind::Coincidence);
+    std::vector<VAR> kernelVars(vars.begin(), vars.end());
+    if constexpr (Traits::hasParam) {
+        return std::make_shared<typename Traits::Kernel>(kernelVars, param);
+    } else {
+        return std::make_shared<typename Traits::Kernel>(kernelVars);
+    }
+}
+
+/**
+ * @brief Build the fix rows of a Fix requirement, one per variable.
+ * @param vars Constrained variables.
+ * @param targets Target value of each variable.
+ */
+template<typename Traits>
+std::vector<std::shared_ptr<OurPaintDCM::Function::FixCoordinateFunction>> makeFixKernels(
+    const std::array<VAR, Traits::variableCount>& vars,
+    const std::array<double, Traits::variableCount>& targets) {
+    static_assert(Traits::rows == RowKind::Fix);
+    std::vector<std::shared_ptr<OurPaintDCM::Function::FixCoordinateFunction>> rows;
+    rows.reserve(vars.size());
+    for (std::size_t k = 0; k < vars.size(); ++k) {
+        rows.push_back(std::make_shared<OurPaintDCM::Function::FixCoordinateFunction>(
+            Traits::type, std::vector<VAR>{vars[k]}, targets[k]));
+    }
+    return rows;
+}
+
+/// @brief Build the math-library ErrorFunction of a residual requirement; takes ownership of @p vars.
+template<typename Traits>
+ErrorFunction* makeErrorKernel(std::vector<Variable*> vars, double param = 0.0) {
+    static_assert(!std::is_void_v<typename Traits::ErrorKernel>);
+    if constexpr (Traits::hasParam) {
+        return new typename Traits::ErrorKernel(std::move(vars), param);
+    } else {
+        return new typename Traits::ErrorKernel(std::move(vars));
+    }
+}
+}
+
+#endif //OURPAINTDCM_HEADERS_REQUIREMENTS_REQUIREMENTTRAITS_H
@@ -0,0 +1,243 @@
+#ifndef OURPAINTDCM_HEADERS_SYSTEM_BLOCKSPARSEMATRIX_H
+#define OURPAINTDCM_HEADERS_SYSTEM_BLOCKSPARSEMATRIX_H
+#include "RequirementFunction.h"
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+
+namespace OurPaintDCM::System {
+    /**
+     * @brief Partition of the variables into 2×2 point blocks and 1×1 scalar blocks.
+     *
+     * Block matrices work on "padded" vectors of length 2·blockCount(), where block k owns
+     * entries 2k and 2k+1. A 1×1 block (radius, unpaired coordinate) leaves its second entry as
+     * padding that is never read back. gather()/scatter() convert from and to scalar order.
+     */
+    class BlockLayout {
+        std::vector<std::array<Eigen::Index, 2>> _blocks; ///< Scalar columns per block, -1 for padding
+        std::vector<Eigen::Index> _paddedIndex;           ///< Scalar column -> padded index
+
+    public:
+        /// @brief Empty layout.
+        BlockLayout() = default;
+
+        /**
+         * @brief Build a layout over @p variables.
+         * @param variables Scalar column order.
+         * @param pointBlocks (x, y) pairs forming 2×2 blocks; pairs naming an unknown or already
+         *        paired variable are ignored. Remaining variables become 1×1 blocks.
+         */
+        BlockLayout(const std::vector<VAR>& variables, const std::vector<std::pair<VAR, VAR>>& pointBlocks);
+
+        /**
+         * @brief The same blocks in another order.
+         * @param order Block of this layout placed at each position of the result.
+         * @throws std::invalid_argument if @p order is not a permutation of the blocks.
+         */
+        BlockLayout permuted(const std::vector<std::size_t>& order) const;
+
+        /**
+         * @brief Infer point blocks from function variable lists.
+         *
+         * Requirement functions list their variables as consecutive (x, y) pairs with an
+         * optional trailing radius, which is taken as the pairing here.
+         */
+        static BlockLayout fromFunctions(const std::vector<VAR>& variables,
+                                         const std::vector<std::shared_ptr<Function::RequirementFunction>>& functions);
+
+        /// @brief Number of blocks.
+        std::size_t blockCount() const noexcept { return _blocks.size(); }
+
+        /// @brief Number of scalar variables.
+        std::size_t variableCount() const noexcept { return _paddedIndex.size(); }
+
+        /// @brief Length of padded vectors (2·blockCount()).
+        Eigen::Index paddedSize() const noexcept { return static_cast<Eigen::Index>(2 * _blocks.size()); }
+
+        /// @brief Scalar columns of block @p block; the second is -1 for a 1×1 block.
+        const std::array<Eigen::Index, 2>& columns(std::size_t block) const { return _blocks[block]; }
+
+        /// @brief Padded index of scalar column @p column.
+        Eigen::Index paddedIndex(Eigen::Index column) const { return _paddedIndex[static_cast<std::size_t>(column)]; }
+
+        /// @brief Copy a scalar-ordered vector into padded order (padding set to zero).
+        void gather(const Eigen::VectorXd& scalar, Eigen::VectorXd& padded) const;
+
+        /// @brief Copy a padded vector back into scalar order.
+        void scatter(const Eigen::VectorXd& padded, Eigen::VectorXd& scalar) const;
+
+        /// @brief Heap bytes of the block and index tables.
+        std::size_t heapBytes() const noexcept;
+    };
+
+    /**
+     * @brief Jacobian in block-sparse row form: one row per residual, 1×2 blocks per point.
+     *
+     * The pattern is fixed at construction. assemble() only refills the values from the
+     * function gradients, so repeated assembly does not allocate. Rows own disjoint value
+     * slices, which lets assemble() and multiply() split large row ranges across the pool.
+     */
+    class BlockSparseJacobian {
+        BlockLayout _layout;
+        std::vector<Eigen::Index> _rowStart;                                ///< Block CSR row offsets
+        std::vector<Eigen::Index> _blockColumn;                             ///< Block column per stored block
+        std::vector<double> _values;                                        ///< 2 values per stored block
+        std::vector<std::vector<std::pair<std::size_t, Eigen::Index>>> _rowEntries; ///< Per row: variable position -> value slot
+
+    public:
+        /// @brief Empty Jacobian.
+        BlockSparseJacobian() = default;
+
+        /**
+         * @brief Build the block pattern of the functions' Jacobian.
+         * @param layout Column blocks.
+         * @param functions One residual row each.
+         * @param columnOf Scalar column of every variable that has one; other variables are constants.
+         * @throws std::invalid_argument if a function has more than RequirementFunction::kMaxVarCount variables.
+         */
+        BlockSparseJacobian(BlockLayout layout,
+                            const std::vector<std::shared_ptr<Function::RequirementFunction>>& functions,
+                            const std::unordered_map<VAR, Eigen::Index>& columnOf);
+
+        /// @brief Refill values with gradient·weight of every function.
+        void assemble(const std::vector<std::shared_ptr<Function::RequirementFunction>>& functions);
+
+        /// @brief Number of residual rows.
+        Eigen::Index rows() const noexcept { return static_cast<Eigen::Index>(_rowEntries.size()); }
+
+        /// @brief Number of stored blocks.
+        std::size_t blockNonZeros() const noexcept { return _blockColumn.size(); }
+
+        /// @brief Column layout.
+        const BlockLayout& layout() const noexcept { return _layout; }
+
+        /// @brief y = J·x with x in padded order.
+        void multiply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const;
+
+        /// @brief y = Jᵀ·x with y in padded order.
+        void multiplyTransposed(const Eigen::VectorXd& x, Eigen::VectorXd& y) const;
+
+        /// @brief Padded diagonal of JᵀJ (squared column norms).
+        void columnSquaredNorms(Eigen::VectorXd& norms) const;
+
+        /// @brief 2×2 diagonal blocks of JᵀJ, one per column block.
+        void diagonalBlocks(std::vector<Eigen::Matrix2d>& blocks) const;
+
+        /**
+         * @brief Fill-reducing block order for a Cholesky factorization of JᵀJ.
+         *
+         * Approximate minimum degree on the block graph of JᵀJ, in the form taken by
+         * BlockLayout::permuted().
+         */
+        std::vector<std::size_t> fillReducingOrder() const;
+
+        /// @brief Row and block-column iteration used by the normal-matrix assembly.
+        Eigen::Index rowStart(Eigen::Index row) const { return _rowStart[static_cast<std::size_t>(row)]; }
+        Eigen::Index blockColumn(Eigen::Index block) const { return _blockColumn[static_cast<std::size_t>(block)]; }
+        Eigen::Map<const Eigen::Vector2d> block(Eigen::Index block) const {
+            return Eigen::Map<const Eigen::Vector2d>(_values.data() + 2 * block);
+        }
+
+        /// @brief Scalar-column sparse copy, for diagnostics and tests.
+        Eigen::SparseMatrix<double> toSparse() const;
+
+        /// @brief Heap bytes of the layout, pattern, values and per-row slot tables.
+        std::size_t heapBytes() const noexcept;
+    };
+
+    /**
+     * @brief Symmetric block-sparse matrix storing the upper triangle as 2×2 blocks.
+     *
+     * Built as the normal matrix JᵀJ + diag(d) of a BlockSparseJacobian. The pattern and the
+     * per-row scatter targets are computed once, so reassembly only accumulates values.
+     */
+    class BlockSparseSymmetricMatrix {
+        std::size_t _blockCount = 0;
+        std::vector<Eigen::Index> _rowStart;               ///< Upper block CSR row offsets, diagonal first
+        std::vector<Eigen::Index> _blockColumn;
+        std::vector<double> _values;                       ///< 4 values per block, column-major
+        std::vector<std::vector<Eigen::Index>> _rowTargets; ///< Per Jacobian row: target block per (p, q) pair
+        std::vector<std::vector<double>> _chunkValues;      ///< Per-chunk accumulation buffers of assign()
+
+    public:
+        /// @brief Empty matrix.
+        BlockSparseSymmetricMatrix() = default;
+
+        /// @brief Build the pattern of JᵀJ for @p jacobian.
+        explicit BlockSparseSymmetricMatrix(const BlockSparseJacobian& jacobian);
+
+        /**
+         * @brief Recompute JᵀJ + diag(damping).
+         *
+         * Padding entries get a unit diagonal so the matrix stays positive definite. Large
+         * Jacobians are accumulated over row ranges in parallel and merged in chunk order.
+         * @param jacobian Jacobian whose pattern this matrix was built from.
+         * @param damping Padded diagonal added to JᵀJ.
+         */
+        void assign(const BlockSparseJacobian& jacobian, const Eigen::VectorXd& damping);
+
+        /// @brief Number of block rows.
+        std::size_t blockCount() const noexcept { return _blockCount; }
+
+        /// @brief Number of stored upper-triangle blocks.
+        std::size_t blockNonZeros() const noexcept { return _blockColumn.size(); }
+
+        /// @brief y = A·x in padded order.
+        void multiply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const;
+
+        /// @brief Block pattern of row @p row: [rowStart(row), rowStart(row + 1)).
+        Eigen::Index rowStart(std::size_t row) const { return _rowStart[row]; }
+        Eigen::Index blockColumn(Eigen::Index block) const { return _blockColumn[static_cast<std::size_t>(block)]; }
+        Eigen::Map<const Eigen::Matrix2d> block(Eigen::Index block) const {
+            return Eigen::Map<const Eigen::Matrix2d>(_values.data() + 4 * block);
+        }
+
+        /// @brief Full (both triangles) padded sparse copy, for diagnostics and tests.
+        Eigen::SparseMatrix<double> toSparse() const;
+
+        /// @brief Heap bytes of the pattern, values, scatter targets and chunk buffers.
+        std::size_t heapBytes() const noexcept;
+    };
+
+    /**
+     * @brief Block Cholesky factorization A = UᵀU of a BlockSparseSymmetricMatrix.
+     *
+     * Works on 2×2 blocks in the layout's block order, so lay the blocks out in
+     * BlockSparseJacobian::fillReducingOrder() first. The symbolic fill pattern is computed
+     * once from the elimination tree and reused by later factorize() calls.
+     */
+    class BlockCholesky {
+        std::size_t _blockCount = 0;
+        std::vector<std::vector<Eigen::Index>> _pattern; ///< Upper fill pattern per block row (diagonal excluded)
+        std::vector<std::vector<Eigen::Matrix2d>> _upper; ///< Off-diagonal U blocks per row
+        std::vector<Eigen::Matrix2d> _diagonal;           ///< Diagonal U blocks
+        bool _ready = false;
+
+    public:
+        /// @brief Compute the fill pattern of @p matrix.
+        void analyze(const BlockSparseSymmetricMatrix& matrix);
+
+        /**
+         * @brief Numeric factorization; analyze() must have seen the same pattern.
+         * @return false if the matrix is not positive definite.
+         */
+        bool factorize(const BlockSparseSymmetricMatrix& matrix);
+
+        /// @brief Solve A·x = b in padded order.
+        void solve(const Eigen::VectorXd& b, Eigen::VectorXd& x) const;
+
+        /// @brief Stored blocks of U including fill.
+        std::size_t blockNonZeros() const noexcept;
+
+        /// @brief Heap bytes of the fill pattern and factor blocks.
+        std::size_t heapBytes() const noexcept;
+    };
+}
+
+
+#endif //OURPAINTDCM_HEADERS_SYSTEM_BLOCKSPARSEMATRIX_H
@@ -0,0 +1,140 @@
+#ifndef OURPAINTDCM_HEADERS_SYSTEM_ITERATIVELMSOLVER_H
+#define OURPAINTDCM_HEADERS_SYSTEM_ITERATIVELMSOLVER_H
+#include "RequirementFunction.h"
+#include "BlockSparseMatrix.h"
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+
+namespace OurPaintDCM::System {
+    /**
+     * @brief Levenberg-Marquardt solver with an iterative inner step for very large systems.
+     *
+     * Each step solves the damped normal equations (JᵀJ + λD)δ = -Jᵀr. The Jacobian is kept
+     * in block-sparse form with a 2×2 block per point (1×1 for radii and unpaired coordinates).
+     * By default the step uses conjugate gradients without forming JᵀJ, preconditioned by
+     * the inverse diagonal blocks, so memory grows with the non-zeros of J. Alternatively a
+     * block Cholesky factorization of the assembled normal matrix can be used; its first
+     * solve lays the blocks out in a fill-reducing order.
+     *
+     * Residuals are f(x)·weight, the same scaling as RequirementFunctionSystem::residuals().
+     */
+    class IterativeLMSolver {
+    public:
+        /// @brief Linear solver used for each damped step.
+        enum class InnerSolver {
+            ConjugateGradient, ///< Block-Jacobi preconditioned CG, matrix-free
+            BlockCholesky      ///< Block Cholesky of the assembled JᵀJ + λD
+        };
+
+        /// @brief Iteration limits and tolerances.
+        struct Options {
+            InnerSolver innerSolver = InnerSolver::ConjugateGradient; ///< Linear solver for each step
+            std::size_t maxIterations = 100;      ///< Outer LM iterations
+            std::size_t maxInnerIterations = 250; ///< CG iterations per LM step
+            double tolerance = 1e-9;              ///< Largest |residual| accepted as converged
+            double innerTolerance = 1e-10;        ///< CG stop, relative to ‖Jᵀr‖
+        };
+
+        /**
+         * @brief Build the solver and the fixed sparsity pattern of J.
+         * @param functions Residual functions; variables not listed below are constants.
+         * @param variables Free variables, one Jacobian column each.
+         * @param pointBlocks (x, y) pairs of free variables forming 2×2 blocks.
+         * @param aliases (member, representative) pairs: member follows its representative
+         *        column and is rewritten after every update.
+         */
+        IterativeLMSolver(std::vector<std::shared_ptr<Function::RequirementFunction>> functions,
+                          std::vector<VAR> variables,
+                          const std::vector<std::pair<VAR, VAR>>& pointBlocks = {},
+                          std::vector<std::pair<VAR, VAR>> aliases = {});
+
+        IterativeLMSolver(const IterativeLMSolver&) = delete;
+        IterativeLMSolver& operator=(const IterativeLMSolver&) = delete;
+
+        /**
+         * @brief Run LM from the current variable values.
+         * @return true when every residual is within Options::tolerance.
+         */
+        bool solve();
+
+        /// @brief Result of the last solve().
+        bool isConverged() const noexcept;
+
+        /// @brief Outer iterations performed by the last solve().
+        std::size_t getIterationCount() const noexcept;
+
+        /// @brief CG iterations performed by the last solve(), summed over all steps (0 for BlockCholesky).
+        std::size_t getInnerIterationCount() const noexcept;
+
+        /// @brief Damping λ of each accepted step of the last solve().
+        const std::vector<double>& getDampingHistory() const noexcept;
+
+        /// @brief Replace the iteration limits and tolerances.
+        void setOptions(const Options& options) noexcept;
+
+        /// @brief Get the iteration limits and tolerances.
+        const Options& getOptions() const noexcept;
+
+        /**
+         * @brief Run @p update after every change of the variables, before residuals are evaluated.
+         *
+         * Lets values derived from the variables follow them, like aliases follow their
+         * representatives; e.g. points placed by a rigid transform whose parameters are variables.
+         */
+        void setUpdateHook(std::function<void()> update);
+
+        /// @brief Heap bytes of the pattern, factorization and work vectors; the functions are not owned.
+        std::size_t heapBytes() const noexcept;
+
+    private:
+        std::vector<std::shared_ptr<Function::RequirementFunction>> _functions;
+        std::vector<VAR> _variables;
+        std::vector<std::pair<VAR, VAR>> _aliases;
+        std::function<void()> _updateHook;
+        Options _options;
+
+        BlockSparseJacobian _jacobian;                      ///< Fixed pattern, values refilled
+        std::unique_ptr<BlockSparseSymmetricMatrix> _normal; ///< Built on first BlockCholesky solve
+        BlockCholesky _cholesky;
+        std::vector<Eigen::Matrix2d> _blockInverses;
+
+        // Work vectors of solve() and the CG step, kept so repeated solves do not allocate.
+        Eigen::VectorXd _scalarValues;
+        Eigen::VectorXd _values;
+        Eigen::VectorXd _residuals;
+        Eigen::VectorXd _candidateResiduals;
+        Eigen::VectorXd _candidate;
+        Eigen::VectorXd _gradient;
+        Eigen::VectorXd _scaling;
+        Eigen::VectorXd _damping;
+        Eigen::VectorXd _step;
+        Eigen::VectorXd _cgResidual;
+        Eigen::VectorXd _cgPreconditioned;
+        Eigen::VectorXd _cgDirection;
+        Eigen::VectorXd _cgProduct;
+        Eigen::VectorXd _cgJacobianProduct;
+
+        bool _converged = false;
+        std::size_t _iterations = 0;
+        std::size_t _innerIterations = 0;
+        std::vector<double> _dampingHistory;
+
+        void evaluateResiduals(Eigen::VectorXd& residuals) const;
+        void applyValues(const Eigen::VectorXd& padded) const;
+        void prepareBlockCholesky();
+        void buildPreconditioner(const Eigen::VectorXd& damping);
+        void applyPreconditioner(const Eigen::VectorXd& in, Eigen::VectorXd& out) const;
+        std::size_t solveDampedStep(const Eigen::VectorXd& gradient, const Eigen::VectorXd& damping,
+                                    Eigen::VectorXd& step);
+        std::size_t solveConjugateGradient(const Eigen::VectorXd& gradient, const Eigen::VectorXd& damping,
+                                           Eigen::VectorXd& step);
+    };
+}
+
+
+#endif //OURPAINTDCM_HEADERS_SYSTEM_ITERATIVELMSOLVER_H
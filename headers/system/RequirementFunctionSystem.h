@@ -1,10 +1,12 @@
 #ifndef OURPAINTDCM_HEADERS_SYSTEM_REQUIREMENTFUNCTIONSYSTEM_H
 #define OURPAINTDCM_HEADERS_SYSTEM_REQUIREMENTFUNCTIONSYSTEM_H
 #include "RequirementFunction.h"
+#include "BlockSparseMatrix.h"
 #include "Enums.h"
+#include "MemoryUsage.h"
 #include <vector>
 #include <memory>
-#include <unordered_set>
+#include <unordered_map>
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 
@@ -19,13 +21,31 @@ namespace OurPaintDCM::System {
      * Jacobian matrices, and performing diagnostics of the system.
      */
     class RequirementFunctionSystem {
+    private:
         std::vector<std::shared_ptr<Function::RequirementFunction>> _functions; ///< All constraint functions
         std::vector<VAR> _allVars;                                              ///< Unique variable pointers
-        std::unordered_set<VAR> _allVarsSet;                                    ///< Fast lookup for uniqueness
-        mutable Eigen::SparseMatrix<double> _jacobian;                          ///< Cached Jacobian
+        std::unordered_map<VAR, Eigen::Index> _columnOf;                        ///< Variable -> Jacobian column
+        mutable Eigen::SparseMatrix<double, Eigen::RowMajor> _jacobian;         ///< Cached Jacobian (CSR), one row per function
+        mutable Eigen::SparseMatrix<double> _jacobianColumns;                   ///< Column-major copy handed out by J(), same pattern
+        std::vector<Eigen::Index> _columnSlots;                                 ///< Per _jacobian value: slot in _jacobianColumns
+        mutable bool _jacobianColumnsDirty = true;
         mutable bool _jacobianDirty = false;
+        mutable bool _jacobianPatternDirty = true;                              ///< Functions added since last pattern build
+        std::vector<Eigen::Index> _jacobianSlots;                               ///< Per function variable position: slot in _jacobian
+        std::vector<size_t> _jacobianSlotOffset;                                ///< First _jacobianSlots entry per row
+        mutable Eigen::SparseMatrix<double> _normalUpper;                       ///< Cached upper triangle of JᵀJ
+        std::vector<Eigen::Index> _normalTargets;                               ///< Per row pair (p ≤ q): slot in _normalUpper
+        std::vector<size_t> _normalRowOffset;                                   ///< First _normalTargets entry per row
+        mutable std::vector<std::vector<double>> _normalChunkValues;            ///< Per-chunk JᵀJ accumulation buffers
+        mutable bool _normalDirty = true;
+        mutable BlockSparseJacobian _blockJacobian;                             ///< Cached block Jacobian
+        mutable bool _blockPatternDirty = true;
+        mutable bool _blockValuesDirty = true;
 
         void ensureJacobian() const;
+        void rebuildJacobianPattern();
+        void rebuildNormalPattern();
+        void updateNormalMatrix() const;
 
     public:
         /// @brief Default constructor
@@ -40,19 +60,47 @@ namespace OurPaintDCM::System {
         /**
          * @brief Update the cached Jacobian matrix (sparse).
          *
-         * Recomputes the full Jacobian from all active functions and their gradients.
+         * Recomputes the values of all rows from the function gradients. The CSR pattern
+         * (one entry per function variable) is rebuilt only after functions were added, and
+         * large systems fill disjoint row ranges in parallel on Utils::ThreadPool::shared().
          */
         void updateJ();
 
         /**
          * @brief Get the current sparse Jacobian matrix.
-         * @return The most recently computed Jacobian.
+         *
+         * The system assembles the Jacobian row-major internally; this column-major copy keeps
+         * the same fixed pattern and only has its values refreshed on the first call after they
+         * change. The pattern holds one entry per (function, variable) pair, so partials that
+         * are currently zero are stored as explicit zeros and count towards nonZeros().
+         * @return Reference to the cached Jacobian, valid until the next updateJ() or addFunction().
+         */
+        const Eigen::SparseMatrix<double>& J() const;
+
+        /**
+         * @brief Get the Jacobian in 2×2 block-sparse form.
+         *
+         * Columns follow getAllVars(). Variables that the functions list as consecutive
+         * (x, y) pairs share a block, the rest (radii) get 1×1 blocks. The pattern is rebuilt
+         * only when functions are added; values are refreshed together with J().
+         * @return Cached block Jacobian.
+         */
+        const BlockSparseJacobian& blockJ() const;
+
+        /**
+         * @brief Get the upper triangle of the normal matrix JᵀJ.
+         *
+         * The sparsity pattern is built together with the Jacobian pattern; the values are
+         * recomputed only after the Jacobian changed. Large systems accumulate row ranges
+         * into per-chunk buffers in parallel and merge them in chunk order.
+         * Use selfadjointView<Eigen::Upper>() for products and factorizations.
+         * @return Reference to the cached upper triangle, valid until the next updateJ() or addFunction().
          */
-        Eigen::SparseMatrix<double> J() const;
+        const Eigen::SparseMatrix<double>& JTJUpper() const;
 
         /**
          * @brief Compute the normal matrix JᵀJ used in LM and Dogleg solvers.
-         * @return Sparse matrix JᵀJ.
+         * @return Full symmetric copy of JTJUpper().
          */
         Eigen::SparseMatrix<double> JTJ() const;
 
@@ -62,6 +110,15 @@ namespace OurPaintDCM::System {
          */
         Eigen::VectorXd residuals() const;
 
+        /**
+         * @brief Write the residuals f(x)·weight into a caller-owned buffer.
+         *
+         * Large systems evaluate row ranges in parallel.
+         * @param out Buffer with one entry per function.
+         * @throws std::invalid_argument if @p out has the wrong size.
+         */
+        void residualsInto(Eigen::Ref<Eigen::VectorXd> out) const;
+
         /**
          * @brief Get the list of all unique variable pointers in the system.
          * @return Vector of VAR (double*).
@@ -74,6 +131,12 @@ namespace OurPaintDCM::System {
          */
         Utils::SystemStatus diagnose() const;
 
+        /**
+         * @brief Add the function objects and variable maps to usage.requirementFunctions
+         * and the cached Jacobian and JᵀJ data to usage.jacobian.
+         */
+        void accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept;
+
         /// @brief Get all constraint functions.
         const std::vector<std::shared_ptr<Function::RequirementFunction>>& getFunctions() const { return _functions; }
 
@@ -3,11 +3,14 @@
 
 #include "RequirementFunctionSystem.h"
 #include "RequirementFunctionFactory.h"
+#include "RequirementTraits.h"
 #include "GeometryStorage.h"
 #include "Enums.h"
 #include "IDGenerator.h"
 #include "utils/RequirementDescriptor.h"
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 namespace OurPaintDCM {
 class DCMManager;
@@ -48,9 +51,28 @@ class RequirementSystem : public RequirementFunctionSystem {
     std::unordered_map<Utils::ID, std::vector<Utils::ID>> _coincidentPointGroups;
 
     void rebuildFunctionsAndAliases();
+    /// @brief IDs addRequirement() would give @p descriptors one after another; the generator is not advanced.
+    std::vector<Utils::ID> assignRequirementIds(std::span<const Utils::RequirementDescriptor> descriptors) const;
     Utils::ID resolvePointRepresentative(Utils::ID pointId) const noexcept;
     Figures::Point2D* resolvePoint(Utils::ID pointId) const;
+
+    /**
+     * @brief Write the variables of one object in Requirements::ObjectKind order.
+     * @param mergeCoincident Use the representatives of merged points instead of the object's own points.
+     */
+    void objectVariables(Requirements::ObjectKind kind, Utils::ID objectId, VAR* out, bool mergeCoincident) const;
+
+    /// @brief Variables of a requirement's objects, laid out as its RequirementTraits declare.
+    template<typename Tag>
+    std::array<VAR, Tag::variableCount> requirementVariables(const std::vector<Utils::ID>& objectIds,
+                                                             bool mergeCoincident = true) const {
+        return Requirements::gatherVariables<Tag>([&](Requirements::ObjectKind kind, std::size_t slot, VAR* out) {
+            objectVariables(kind, objectIds[slot], out, mergeCoincident);
+        });
+    }
     std::vector<Utils::ID> getCoincidentPoints(Utils::ID pointId) const;
+    /// @brief Points merged with @p pointId, representative included; empty if it is not merged.
+    std::span<const Utils::ID> coincidentGroup(Utils::ID pointId) const noexcept;
     void applyDirectAssignments() const;
     void synchronizeCoincidentPoints() const noexcept;
 
@@ -91,6 +113,20 @@ public:
      */
     Utils::ID addRequirement(const Utils::RequirementDescriptor& descriptor);
 
+    /**
+     * @brief Add several requirements with a single rebuild of the function layer.
+     *
+     * Equivalent to calling addRequirement() for each descriptor in order, but linear in the
+     * system size instead of quadratic. Either every descriptor is added or none is.
+     *
+     * @param descriptors Requirement descriptors, added in order.
+     * @return IDs of the created requirements, in the same order.
+     * @throws std::invalid_argument if any descriptor fails validation, or if an explicit id
+     *         repeats an id given earlier in the batch, explicit or generated.
+     * @throws std::runtime_error if object IDs are not found in storage.
+     */
+    std::vector<Utils::ID> addRequirements(std::span<const Utils::RequirementDescriptor> descriptors);
+
     /**
      * @brief Get all stored requirement entries (read-only).
      * @return Const reference to the vector of requirement entries.
@@ -192,6 +228,13 @@ public:
      */
     void clear();
 
+    /**
+     * @brief Base accounting plus requirement entries and coincident point groups.
+     *
+     * Hides the base class version, like clear().
+     */
+    void accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept;
+
     Figures::ObjectGraph buildDependencyGraph() const;
 };
 
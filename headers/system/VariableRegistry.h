@@ -0,0 +1,46 @@
+#ifndef OURPAINTDCM_HEADERS_SYSTEM_VARIABLEREGISTRY_H
+#define OURPAINTDCM_HEADERS_SYSTEM_VARIABLEREGISTRY_H
+#include "Function.h"
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+
+namespace OurPaintDCM::System {
+    /**
+     * @brief Free coordinates of a solve pipeline, each interned once.
+     *
+     * Maps every coordinate to a dense index and owns the single math Variable that the
+     * solve tasks differentiate against. Variables live in a deque, so interning never moves
+     * them and they are allocated in chunks rather than one by one.
+     *
+     * The leaf Variables inside math-library expression trees are not shared: the trees own
+     * and delete their leaves.
+     */
+    class VariableRegistry {
+        std::unordered_map<double*, std::size_t> _indexOf;
+        std::vector<double*> _refs;
+        std::deque<Variable> _variables;
+
+    public:
+        /// @brief Dense index of @p valueRef, interning it on first use.
+        std::size_t intern(double* valueRef);
+
+        bool contains(double* valueRef) const;
+        std::size_t indexOf(double* valueRef) const;
+        std::size_t size() const noexcept;
+        bool empty() const noexcept;
+
+        /// @brief Interned coordinates in index order.
+        const std::vector<double*>& refs() const noexcept;
+
+        /// @brief The canonical Variable of the coordinate at @p index.
+        Variable* variable(std::size_t index);
+
+        /// @brief Map nodes, the ref vector and the variables; deque chunk slack is not counted.
+        std::size_t heapBytes() const noexcept;
+    };
+}
+
+#endif //OURPAINTDCM_HEADERS_SYSTEM_VARIABLEREGISTRY_H
@@ -0,0 +1,127 @@
+#ifndef HEADERS_UTILS_INSTRUMENTATION_H
+#define HEADERS_UTILS_INSTRUMENTATION_H
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file Instrumentation.h
+ * @brief Hot-path timers and counters, compiled in only with OURPAINTDCM_INSTRUMENTATION.
+ *
+ * The library marks its hot paths with OURPAINTDCM_PROBE_SCOPE (a timer for the rest of
+ * the scope) and OURPAINTDCM_PROBE_COUNT (one more call). Without the CMake option both
+ * macros expand to nothing, so release builds pay nothing for them. With it, every thread
+ * accumulates into its own slots; instrumentationSnapshot() sums them.
+ *
+ * Example:
+ * @code
+ * Utils::resetInstrumentation();
+ * manager.solve();
+ * const auto snapshot = Utils::instrumentationSnapshot();
+ * const auto& optimize = snapshot[Utils::Probe::ET_OPTIMIZE]; // count, total, max
+ * @endcode
+ */
+namespace OurPaintDCM::Utils {
+/// True when the library was built with OURPAINTDCM_INSTRUMENTATION.
+#ifdef OURPAINTDCM_INSTRUMENTATION
+inline constexpr bool kInstrumentationEnabled = true;
+#else
+inline constexpr bool kInstrumentationEnabled = false;
+#endif
+
+/**
+ * @brief Instrumented hot paths.
+ */
+enum class Probe : std::uint8_t {
+    ET_GEOMETRY_GET,          ///< GeometryStorage::get() calls (counter only)
+    ET_REBUILD_FUNCTIONS,     ///< RequirementSystem::rebuildFunctionsAndAliases()
+    ET_BUILD_SUBSYSTEM,       ///< DCMManager::buildSubsystem()
+    ET_BUILD_PIPELINE,        ///< Presolve, variable interning and LM task assembly
+    ET_OPTIMIZE,              ///< One SparseLMSolver::optimize() call
+    ET_MERGE_COMPONENTS,      ///< DCMManager::mergeComponents()
+    ET_REBUILD_COMPONENTS,    ///< DCMManager::rebuildComponents()
+    ET_COUNT
+};
+
+inline constexpr std::size_t kProbeCount = static_cast<std::size_t>(Probe::ET_COUNT);
+
+/// @brief Stable name of a probe, for reports and trace files.
+std::string_view probeName(Probe probe) noexcept;
+
+/**
+ * @brief Aggregate of one probe.
+ *
+ * Counter probes only advance count; timed probes also add their latency.
+ */
+struct ProbeStats {
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds max{};
+};
+
+/**
+ * @brief Per-probe aggregates summed over all threads.
+ */
+struct InstrumentationSnapshot {
+    std::array<ProbeStats, kProbeCount> probes{};
+
+    const ProbeStats& operator[](Probe probe) const noexcept {
+        return probes[static_cast<std::size_t>(probe)];
+    }
+};
+
+/// @brief Add one timed call of @p probe on the calling thread.
+void recordProbe(Probe probe, std::chrono::nanoseconds elapsed) noexcept;
+
+/// @brief Add one untimed call of @p probe on the calling thread.
+void countProbe(Probe probe) noexcept;
+
+/**
+ * @brief Sum of every thread's slots, including threads that have exited.
+ *
+ * Safe to call while other threads record; their in-flight updates may or may not be seen.
+ */
+InstrumentationSnapshot instrumentationSnapshot();
+
+/// @brief Zero every slot. Call while no instrumented code is running.
+void resetInstrumentation();
+
+/**
+ * @brief Records the lifetime of the enclosing scope into a probe.
+ */
+class ScopedProbeTimer {
+    Probe _probe;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    explicit ScopedProbeTimer(Probe probe) noexcept
+        : _probe(probe), _start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedProbeTimer() {
+        recordProbe(_probe, std::chrono::steady_clock::now() - _start);
+    }
+
+    ScopedProbeTimer(const ScopedProbeTimer&) = delete;
+    ScopedProbeTimer& operator=(const ScopedProbeTimer&) = delete;
+};
+}
+
+#define OURPAINTDCM_PROBE_CONCAT_IMPL(a, b) a##b
+#define OURPAINTDCM_PROBE_CONCAT(a, b) OURPAINTDCM_PROBE_CONCAT_IMPL(a, b)
+
+#ifdef OURPAINTDCM_INSTRUMENTATION
+/// Time the rest of the enclosing scope under Utils::Probe::probe.
+#define OURPAINTDCM_PROBE_SCOPE(probe) \
+    const ::OurPaintDCM::Utils::ScopedProbeTimer OURPAINTDCM_PROBE_CONCAT(probeTimer_, __LINE__)( \
+        ::OurPaintDCM::Utils::Probe::probe)
+/// Count one call under Utils::Probe::probe.
+#define OURPAINTDCM_PROBE_COUNT(probe) \
+    ::OurPaintDCM::Utils::countProbe(::OurPaintDCM::Utils::Probe::probe)
+#else
+#define OURPAINTDCM_PROBE_SCOPE(probe) static_cast<void>(0)
+#define OURPAINTDCM_PROBE_COUNT(probe) static_cast<void>(0)
+#endif
+
+#endif // HEADERS_UTILS_INSTRUMENTATION_H
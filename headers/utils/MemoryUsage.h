@@ -0,0 +1,86 @@
+#ifndef OURPAINTDCM_HEADERS_UTILS_MEMORYUSAGE_H
+#define OURPAINTDCM_HEADERS_UTILS_MEMORYUSAGE_H
+
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace OurPaintDCM::Utils {
+
+/**
+ * @brief Heap bytes held by a DCMManager, per subsystem.
+ *
+ * Computed from container capacities, so reserved but unused space counts. Vectors are
+ * exact (capacity × element size). Hash containers count their bucket array plus one node
+ * per element holding the value, a next pointer and the cached hash, which is the libstdc++
+ * and MSVC layout. Allocator bookkeeping and objects owned by the math library
+ * (SparseLSMTask, SparseLMSolver) are not included.
+ */
+struct MemoryUsage {
+    std::size_t geometrySlots = 0;        ///< GeometryStorage slot pools, their generations and the figures they own
+    std::size_t geometryFreeLists = 0;    ///< Free slot lists of the pools
+    std::size_t geometryIndex = 0;        ///< ID -> slot map, per-type iteration caches and their position maps
+    std::size_t geometryDependencies = 0; ///< Point <-> figure dependency index
+    std::size_t figureRecords = 0;        ///< Figure descriptors kept by the manager
+    std::size_t requirementRecords = 0;   ///< Requirement descriptors, their order and recorded fix targets
+    std::size_t components = 0;           ///< Component sets, figure -> component map and dirty flags
+    std::size_t requirementFunctions = 0; ///< Requirement entries, function objects, variables, coincident groups
+    std::size_t jacobian = 0;             ///< Cached Jacobians (CSR and block), JᵀJ pattern and buffers
+    std::size_t solveCache = 0;           ///< Every solve cache entry: subsystem, pipeline, solver workspaces
+    std::size_t solveCacheEntries = 0;    ///< Cached component and relaxation-region entries (a count, not bytes)
+
+    /// @brief Sum of every byte field.
+    std::size_t total() const noexcept {
+        return geometrySlots + geometryFreeLists + geometryIndex + geometryDependencies + figureRecords +
+               requirementRecords + components + requirementFunctions + jacobian + solveCache;
+    }
+};
+
+namespace Detail {
+template<typename T>
+struct IsVector : std::false_type {};
+
+template<typename T, typename Allocator>
+struct IsVector<std::vector<T, Allocator>> : std::true_type {};
+}
+
+/// @brief Bytes reserved by @p values, including nested vectors.
+template<typename T, typename Allocator>
+std::size_t heapBytes(const std::vector<T, Allocator>& values) noexcept {
+    std::size_t bytes = values.capacity() * sizeof(T);
+    if constexpr (Detail::IsVector<T>::value) {
+        for (const auto& inner : values) {
+            bytes += heapBytes(inner);
+        }
+    }
+    return bytes;
+}
+
+/// @brief Bucket array and nodes of a hash container; heap memory of the values is not followed.
+template<typename HashContainer>
+std::size_t hashNodeBytes(const HashContainer& container) noexcept {
+    return container.bucket_count() * sizeof(void*) +
+           container.size() * (sizeof(typename HashContainer::value_type) + 2 * sizeof(void*));
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Allocator>
+std::size_t heapBytes(const std::unordered_map<Key, Value, Hash, Equal, Allocator>& map) noexcept {
+    std::size_t bytes = hashNodeBytes(map);
+    if constexpr (Detail::IsVector<Value>::value) {
+        for (const auto& entry : map) {
+            bytes += heapBytes(entry.second);
+        }
+    }
+    return bytes;
+}
+
+template<typename Key, typename Hash, typename Equal, typename Allocator>
+std::size_t heapBytes(const std::unordered_set<Key, Hash, Equal, Allocator>& set) noexcept {
+    return hashNodeBytes(set);
+}
+
+}
+
+#endif // OURPAINTDCM_HEADERS_UTILS_MEMORYUSAGE_H
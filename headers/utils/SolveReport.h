@@ -0,0 +1,118 @@
+#ifndef OURPAINTDCM_HEADERS_UTILS_SOLVEREPORT_H
+#define OURPAINTDCM_HEADERS_UTILS_SOLVEREPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OurPaintDCM::Utils {
+
+/**
+ * @brief Why a solve stopped, ordered from best to worst outcome.
+ */
+enum class SolveTermination : std::uint8_t {
+    /// Nothing was solved (no requirements, or no solve has run yet).
+    ET_NONE,
+    /// Every requirement already held; the optimizer was skipped.
+    ET_ALREADY_SATISFIED,
+    /// The optimizer (or direct assignment) reached the tolerance.
+    ET_CONVERGED,
+    /// The optimizer stopped with residuals above the tolerance.
+    ET_NOT_CONVERGED
+};
+
+/**
+ * @brief Wall time spent in each solve phase.
+ */
+struct SolvePhaseTimes {
+    using Duration = std::chrono::nanoseconds;
+
+    Duration subsystemBuild{};   ///< Building the requirement subsystem of a component
+    Duration pipelineBuild{};    ///< Presolve, construction plan and LM task assembly
+    Duration fixedAssignment{};  ///< Writing fixed coordinates and constructed points
+    Duration optimize{};         ///< Levenberg-Marquardt iterations
+    Duration coincidentSync{};   ///< Propagating merged coordinates back to every point
+
+    SolvePhaseTimes& operator+=(const SolvePhaseTimes& other) noexcept {
+        subsystemBuild += other.subsystemBuild;
+        pipelineBuild += other.pipelineBuild;
+        fixedAssignment += other.fixedAssignment;
+        optimize += other.optimize;
+        coincidentSync += other.coincidentSync;
+        return *this;
+    }
+
+    /// @brief Sum of all phases.
+    Duration total() const noexcept {
+        return subsystemBuild + pipelineBuild + fixedAssignment + optimize + coincidentSync;
+    }
+};
+
+/**
+ * @brief Telemetry of the most recent solve call.
+ *
+ * Filled by every DCMManager solve (solve(), solveDirty() and drag updates) and kept
+ * until the next one. A call that solves several components reports their sum: counts
+ * and times add up, residual norms combine as one stacked vector, and the termination is
+ * the worst of the parts.
+ *
+ * Collecting it costs a few clock reads and one residual evaluation before and after
+ * the optimizer, so it stays enabled in release builds.
+ */
+struct SolveReport {
+    SolveTermination termination = SolveTermination::ET_NONE;
+
+    std::size_t components = 0;       ///< Solve entries (components, regions) run
+    std::size_t cacheHits = 0;        ///< Entries whose cached subsystem was reused
+    std::size_t cacheMisses = 0;      ///< Entries whose subsystem was (re)built
+    std::size_t requirements = 0;     ///< Requirements in the solved systems
+    std::size_t residuals = 0;        ///< Residual rows in the solved systems
+    std::size_t freeVariables = 0;    ///< Variables left to the optimizer
+    std::size_t blocks = 0;           ///< Independent blocks the free variables were split into
+
+    std::size_t iterations = 0;       ///< Outer iterations of the iterative LM solver
+    std::size_t innerIterations = 0;  ///< Its conjugate-gradient iterations
+    double initialResidualNorm = 0.0; ///< ‖r‖ before the solve
+    double finalResidualNorm = 0.0;   ///< ‖r‖ after the solve
+    std::vector<double> damping;      ///< λ accepted at each outer iteration of the iterative LM solver
+
+    SolvePhaseTimes phases;           ///< Wall time per phase
+
+    /// @brief Forget the previous solve, keeping allocated capacity.
+    void reset() noexcept {
+        auto keep = std::move(damping);
+        keep.clear();
+        *this = SolveReport{};
+        damping = std::move(keep);
+    }
+
+    /// @brief Fold the report of one more solve entry into this one.
+    void merge(const SolveReport& other) {
+        termination = std::max(termination, other.termination);
+        components += other.components;
+        cacheHits += other.cacheHits;
+        cacheMisses += other.cacheMisses;
+        requirements += other.requirements;
+        residuals += other.residuals;
+        freeVariables += other.freeVariables;
+        blocks += other.blocks;
+        iterations += other.iterations;
+        innerIterations += other.innerIterations;
+        initialResidualNorm = std::hypot(initialResidualNorm, other.initialResidualNorm);
+        finalResidualNorm = std::hypot(finalResidualNorm, other.finalResidualNorm);
+        damping.insert(damping.end(), other.damping.begin(), other.damping.end());
+        phases += other.phases;
+    }
+
+    /// @brief True if the solve ended satisfied (converged or nothing to do).
+    bool succeeded() const noexcept {
+        return termination != SolveTermination::ET_NOT_CONVERGED;
+    }
+};
+
+}
+
+#endif // OURPAINTDCM_HEADERS_UTILS_SOLVEREPORT_H
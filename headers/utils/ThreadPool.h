@@ -0,0 +1,114 @@
+#ifndef HEADERS_UTILS_THREADPOOL_H
+#define HEADERS_UTILS_THREADPOOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace OurPaintDCM::Utils {
+/// @brief Rows per chunk below which row loops are not worth dispatching to the pool.
+inline constexpr std::size_t kParallelRowGrain = 1024;
+
+/**
+ * @brief Persistent worker pool for data-parallel loops.
+ *
+ * Workers are started once and sleep between jobs, so a parallel loop costs one wake-up
+ * instead of a thread spawn. The calling thread takes part in every job.
+ *
+ * Only one job runs at a time. A call made while the pool is busy, or from inside a job,
+ * runs its chunks inline on the calling thread, so nested and concurrent callers never block
+ * each other.
+ *
+ * Example:
+ * @code
+ * Utils::ThreadPool::shared().parallelFor(rows, Utils::kParallelRowGrain,
+ *     [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+ *         for (std::size_t i = begin; i < end; ++i) { out[i] = f(i); }
+ *     });
+ * @endcode
+ */
+class ThreadPool {
+    using Task = void (*)(void*, std::size_t);
+
+    std::vector<std::thread> _workers;
+    std::mutex _submitMutex;          ///< Held by the caller of the running job
+    std::mutex _mutex;                ///< Guards the job fields below
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    Task _task = nullptr;
+    void* _context = nullptr;
+    std::size_t _chunkCount = 0;
+    std::atomic<std::size_t> _nextChunk{0};
+    std::size_t _activeWorkers = 0;
+    std::size_t _generation = 0;
+    bool _stop = false;
+    std::exception_ptr _failure;
+
+    void workerLoop();
+    void runChunks(Task task, void* context, std::size_t chunkCount);
+    void run(Task task, void* context, std::size_t chunkCount);
+
+public:
+    /**
+     * @brief Start the pool.
+     * @param threadCount Threads taking part in a job, including the caller; 0 or 1 makes
+     *        every job run inline.
+     */
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+
+    /// @brief Stop and join the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Process-wide pool sized to the hardware concurrency.
+    static ThreadPool& shared();
+
+    /// @brief Threads taking part in a job, including the caller.
+    [[nodiscard]] std::size_t threadCount() const noexcept { return _workers.size() + 1; }
+
+    /**
+     * @brief Split [0, count) into contiguous chunks and run them in parallel.
+     *
+     * The chunk count is at most threadCount() and every chunk holds at least @p grain
+     * items, so small loops run inline. Chunk boundaries depend only on @p count, @p grain
+     * and threadCount(), which lets callers keep per-chunk buffers and merge them in a fixed
+     * order. The first exception thrown by @p body is rethrown after all chunks finish.
+     * @param count Number of items.
+     * @param grain Minimum items per chunk.
+     * @param body Called as body(chunk, begin, end).
+     */
+    template<typename Body>
+    void parallelFor(std::size_t count, std::size_t grain, Body&& body) {
+        const std::size_t chunks = chunkCount(count, grain);
+        if (chunks == 0) {
+            return;
+        }
+        struct Context {
+            Body* body;
+            std::size_t count;
+            std::size_t chunks;
+        } context{&body, count, chunks};
+        run([](void* raw, std::size_t chunk) {
+            const auto& job = *static_cast<Context*>(raw);
+            (*job.body)(chunk, job.count * chunk / job.chunks, job.count * (chunk + 1) / job.chunks);
+        }, &context, chunks);
+    }
+
+    /// @brief Number of chunks parallelFor() uses for @p count items of at least @p grain each.
+    [[nodiscard]] std::size_t chunkCount(std::size_t count, std::size_t grain) const noexcept {
+        if (count == 0) {
+            return 0;
+        }
+        return std::clamp<std::size_t>(count / std::max<std::size_t>(grain, 1), 1, threadCount());
+    }
+};
+}
+
+#endif // HEADERS_UTILS_THREADPOOL_H
@@ -0,0 +1,139 @@
+#ifndef HEADERS_UTILS_TRACERECORDER_H
+#define HEADERS_UTILS_TRACERECORDER_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OurPaintDCM::Utils {
+/**
+ * @brief Kind of a trace event, mapped to the Chrome trace "ph" field.
+ */
+enum class TracePhase : std::uint8_t {
+    ET_BEGIN,   ///< Start of a span ("B")
+    ET_END,     ///< End of the innermost open span on the thread ("E")
+    ET_INSTANT  ///< Point in time ("i")
+};
+
+/**
+ * @brief One recorded event.
+ */
+struct TraceEvent {
+    const char* name = nullptr;          ///< Static string naming the span
+    TracePhase phase = TracePhase::ET_BEGIN;
+    std::uint32_t thread = 0;            ///< Small per-thread number, stable for the thread's lifetime
+    std::chrono::nanoseconds timestamp{};///< Time since start()
+};
+
+/**
+ * @brief Lock-free ring buffer of begin/end events, exported as Chrome trace JSON.
+ *
+ * Disabled until start(). While disabled, recording costs one relaxed atomic load. While
+ * enabled, each event claims a slot with one fetch_add and never blocks; once the buffer is
+ * full the oldest events are overwritten, so the export always holds the most recent
+ * capacity() events.
+ *
+ * DCMManager records a span for each public call that edits or solves, a span for each solve
+ * phase, and instant events for solve cache invalidations and misses, all into shared().
+ *
+ * Example:
+ * @code
+ * auto& trace = Utils::TraceRecorder::shared();
+ * trace.start();
+ * // ... drag session ...
+ * trace.stop();
+ * trace.writeChromeTrace("drag.json"); // open in chrome://tracing or Perfetto
+ * @endcode
+ */
+class TraceRecorder {
+    struct Slot {
+        std::atomic<std::uint64_t> sequence{0};  ///< Event index + 1 once written, 0 while writing
+        std::atomic<const char*> name{nullptr};
+        std::atomic<std::int64_t> timestamp{0};
+        std::atomic<std::uint32_t> thread{0};
+        std::atomic<TracePhase> phase{TracePhase::ET_BEGIN};
+    };
+
+    std::unique_ptr<Slot[]> _slots;
+    std::size_t _capacity;
+    std::atomic<std::uint64_t> _next{0};
+    std::atomic<bool> _enabled{false};
+    std::atomic<std::int64_t> _epoch{0};
+
+public:
+    static constexpr std::size_t kDefaultCapacity = std::size_t{1} << 16;
+
+    /// @param capacity Events kept; at least 1.
+    explicit TraceRecorder(std::size_t capacity = kDefaultCapacity);
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /// @brief Recorder DCMManager writes to.
+    static TraceRecorder& shared();
+
+    /// @brief Drop previous events, reset the time origin and begin recording.
+    void start() noexcept;
+
+    /// @brief Stop recording; recorded events stay available.
+    void stop() noexcept;
+
+    [[nodiscard]] bool enabled() const noexcept { return _enabled.load(std::memory_order_relaxed); }
+
+    /// @brief Append an event if recording. @p name must outlive the recorder (a string literal).
+    void record(const char* name, TracePhase phase) noexcept;
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+    /// @brief Events recorded since start(), including overwritten ones.
+    [[nodiscard]] std::uint64_t recordedCount() const noexcept { return _next.load(std::memory_order_relaxed); }
+
+    /// @brief Surviving events, oldest first. Events being written concurrently are skipped.
+    [[nodiscard]] std::vector<TraceEvent> events() const;
+
+    /// @brief Write events() as a Chrome trace JSON object.
+    void writeChromeTrace(std::ostream& out) const;
+
+    /// @brief Write events() to @p path. @throws std::runtime_error if the file cannot be written.
+    void writeChromeTrace(const std::string& path) const;
+};
+
+/**
+ * @brief Records a begin event now and the matching end event at scope exit.
+ *
+ * Whether the span is recorded is decided at construction, so toggling the recorder inside
+ * the scope never leaves an unmatched event.
+ */
+class TraceScope {
+    TraceRecorder* _recorder;
+    const char* _name;
+
+public:
+    explicit TraceScope(const char* name, TraceRecorder& recorder = TraceRecorder::shared()) noexcept
+        : _recorder(recorder.enabled() ? &recorder : nullptr), _name(name) {
+        if (_recorder != nullptr) {
+            _recorder->record(_name, TracePhase::ET_BEGIN);
+        }
+    }
+
+    ~TraceScope() {
+        if (_recorder != nullptr) {
+            _recorder->record(_name, TracePhase::ET_END);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+/// @brief Record an instant event in the shared recorder.
+inline void traceInstant(const char* name) noexcept {
+    TraceRecorder::shared().record(name, TracePhase::ET_INSTANT);
+}
+}
+
+#endif // HEADERS_UTILS_TRACERECORDER_H
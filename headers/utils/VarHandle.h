@@ -0,0 +1,58 @@
+#ifndef HEADERS_UTILS_VARHANDLE_H
+#define HEADERS_UTILS_VARHANDLE_H
+#include "Enums.h"
+#include <compare>
+#include <cstdint>
+#include <functional>
+
+namespace OurPaintDCM::Utils {
+/// Component indices of the scalars a figure owns.
+inline constexpr std::uint8_t kPointX = 0;
+inline constexpr std::uint8_t kPointY = 1;
+inline constexpr std::uint8_t kCircleRadius = 0;
+
+/**
+ * @brief Storage-independent reference to one scalar of a figure.
+ *
+ * Names the figure's slot in its per-type pool and the scalar within the figure
+ * (kPointX / kPointY for points, kCircleRadius for circles). Unlike a raw double*,
+ * a handle stays meaningful when coordinates move; it is turned into an address only
+ * when needed, through GeometryStorage::resolve(). The slot's generation, bumped whenever
+ * the slot is freed, keeps a handle to a removed figure from resolving to a reused slot.
+ */
+struct VarHandle {
+    FigureType type{};          ///< Pool the slot belongs to
+    std::uint32_t slot{};       ///< Index in the pool
+    std::uint8_t component{};   ///< Scalar within the figure
+    std::uint32_t generation{}; ///< Generation of the slot when the handle was made
+
+    /// @brief Type, slot and component in one integer, ordered by type, slot, component.
+    constexpr std::uint64_t packed() const noexcept {
+        return (static_cast<std::uint64_t>(type) << 40) |
+               (static_cast<std::uint64_t>(slot) << 8) |
+               component;
+    }
+
+    friend constexpr bool operator==(const VarHandle& lhs, const VarHandle& rhs) noexcept {
+        return lhs.packed() == rhs.packed() && lhs.generation == rhs.generation;
+    }
+
+    friend constexpr auto operator<=>(const VarHandle& lhs, const VarHandle& rhs) noexcept {
+        if (const auto order = lhs.packed() <=> rhs.packed(); order != 0) {
+            return order;
+        }
+        return lhs.generation <=> rhs.generation;
+    }
+};
+}
+
+namespace std {
+template<>
+struct hash<OurPaintDCM::Utils::VarHandle> {
+    std::size_t operator()(const OurPaintDCM::Utils::VarHandle& handle) const noexcept {
+        return std::hash<std::uint64_t>{}(handle.packed() ^ (static_cast<std::uint64_t>(handle.generation) << 48));
+    }
+};
+}
+
+#endif //HEADERS_UTILS_VARHANDLE_H
@@ -1,10 +1,23 @@
 #include "DCMManager.h"
 #include "ErrorFunction.h"
+#include "Instrumentation.h"
+#include "IterativeLMSolver.h"
+#include "RequirementTraits.h"
 #include "SparseLSMTask.h"
+#include "TraceRecorder.h"
+#include "ThreadPool.h"
+#include "VariableRegistry.h"
 #include "sparse/SparseLevenbergMarquardtSolver.h"
+#include <Eigen/SVD>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <exception>
 #include <memory>
+#include <span>
 #include <stdexcept>
 
 namespace {
@@ -13,15 +26,77 @@ void eraseRequirementId(std::vector<OurPaintDCM::Utils::ID>& ids, OurPaintDCM::U
     ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
 }
 
-std::vector<Variable*> makeMathVariables(std::initializer_list<double*> refs) {
+using CoordinateAliasMap = std::unordered_map<double*, double*>;
+
+/// Leaf Variables for one math-library expression tree, which takes ownership of them.
+std::vector<Variable*> makeMathVariables(const CoordinateAliasMap& aliases, std::span<double* const> refs) {
     std::vector<Variable*> vars;
     vars.reserve(refs.size());
     for (double* ref : refs) {
-        vars.push_back(new Variable(ref));
+        const auto aliasIt = aliases.find(ref);
+        vars.push_back(new Variable(aliasIt != aliases.end() ? aliasIt->second : ref));
     }
     return vars;
 }
 
+using OurPaintDCM::System::VariableRegistry;
+
+/// Free variables grouped into blocks that no residual couples, e.g. the x and y halves of conflicting axis-aligned lines.
+struct BlockSplit {
+    std::vector<std::size_t> blockOfVariable;
+    std::vector<std::size_t> blockOfFunction; ///< Residuals without free variables go to block 0
+    std::size_t blockCount = 0;
+};
+
+/**
+ * @brief Split free variables into independent blocks.
+ *
+ * Blocks are numbered in order of their first variable. A residual without free variables
+ * stays in block 0 so that an unsatisfiable constant residual still prevents convergence.
+ * @param freeIndices Free variable indices of function f are freeIndices[freeStart[f], freeStart[f + 1]).
+ */
+BlockSplit splitIntoBlocks(std::size_t variableCount,
+                           const std::vector<std::size_t>& freeIndices,
+                           const std::vector<std::size_t>& freeStart) {
+    std::vector<std::size_t> parent(variableCount);
+    for (std::size_t i = 0; i < parent.size(); ++i) {
+        parent[i] = i;
+    }
+    const auto findRoot = [&](std::size_t index) {
+        while (parent[index] != index) {
+            parent[index] = parent[parent[index]];
+            index = parent[index];
+        }
+        return index;
+    };
+    for (std::size_t f = 0; f + 1 < freeStart.size(); ++f) {
+        for (std::size_t k = freeStart[f] + 1; k < freeStart[f + 1]; ++k) {
+            const std::size_t firstRoot = findRoot(freeIndices[freeStart[f]]);
+            const std::size_t otherRoot = findRoot(freeIndices[k]);
+            if (firstRoot != otherRoot) {
+                parent[otherRoot] = firstRoot;
+            }
+        }
+    }
+
+    BlockSplit split;
+    std::unordered_map<std::size_t, std::size_t> blockOfRoot;
+    split.blockOfVariable.reserve(variableCount);
+    for (std::size_t i = 0; i < variableCount; ++i) {
+        const auto [it, inserted] = blockOfRoot.try_emplace(findRoot(i), split.blockCount);
+        if (inserted) {
+            ++split.blockCount;
+        }
+        split.blockOfVariable.push_back(it->second);
+    }
+    split.blockOfFunction.reserve(freeStart.size() - 1);
+    for (std::size_t f = 0; f + 1 < freeStart.size(); ++f) {
+        const bool hasFree = freeStart[f] != freeStart[f + 1];
+        split.blockOfFunction.push_back(hasFree ? split.blockOfVariable[freeIndices[freeStart[f]]] : 0);
+    }
+    return split;
+}
+
 std::unique_ptr<::Function> makeFixResidual(double* valueRef, double target) {
     return std::unique_ptr<::Function>(
         new Subtraction(new Variable(valueRef), new Constant(target)));
@@ -33,21 +108,64 @@ void hashCombine(std::size_t& seed, std::size_t value) {
 
 struct SolveCacheKey {
     std::optional<OurPaintDCM::ComponentID> componentId;
-    std::vector<double*> lockedVars;
+    std::vector<OurPaintDCM::Utils::VarHandle> lockedVars; ///< Sorted
 
     bool operator==(const SolveCacheKey& other) const noexcept {
         return componentId == other.componentId && lockedVars == other.lockedVars;
     }
 };
 
+/// Non-owning SolveCacheKey, so a lookup neither copies nor sorts the locked handles.
+struct SolveCacheKeyView {
+    std::optional<OurPaintDCM::ComponentID> componentId;
+    std::span<const OurPaintDCM::Utils::VarHandle> lockedVars; ///< Sorted
+
+    SolveCacheKeyView(std::optional<OurPaintDCM::ComponentID> component,
+                      std::span<const OurPaintDCM::Utils::VarHandle> handles) noexcept
+        : componentId(component), lockedVars(handles) {}
+    SolveCacheKeyView(const SolveCacheKey& key) noexcept
+        : componentId(key.componentId), lockedVars(key.lockedVars) {}
+};
+
 struct SolveCacheKeyHasher {
-    std::size_t operator()(const SolveCacheKey& key) const noexcept {
+    using is_transparent = void;
+
+    std::size_t operator()(const SolveCacheKeyView& key) const noexcept {
         std::size_t seed = 0;
         hashCombine(seed,
                     std::hash<std::size_t>{}(
                         key.componentId.value_or(static_cast<OurPaintDCM::ComponentID>(-1))));
-        for (double* valueRef : key.lockedVars) {
-            hashCombine(seed, std::hash<std::uintptr_t>{}(reinterpret_cast<std::uintptr_t>(valueRef)));
+        for (const auto& handle : key.lockedVars) {
+            hashCombine(seed, std::hash<OurPaintDCM::Utils::VarHandle>{}(handle));
+        }
+        return seed;
+    }
+};
+
+struct SolveCacheKeyEqual {
+    using is_transparent = void;
+
+    bool operator()(const SolveCacheKeyView& lhs, const SolveCacheKeyView& rhs) const noexcept {
+        return lhs.componentId == rhs.componentId && std::ranges::equal(lhs.lockedVars, rhs.lockedVars);
+    }
+};
+
+/// Relaxation region of a k-hop drag solve: the figures it owns and the drag locks.
+struct RelaxedRegionKey {
+    std::vector<OurPaintDCM::Utils::ID> region;            ///< Sorted
+    std::vector<OurPaintDCM::Utils::VarHandle> lockedVars; ///< Sorted
+
+    bool operator==(const RelaxedRegionKey& other) const noexcept = default;
+};
+
+struct RelaxedRegionKeyHasher {
+    std::size_t operator()(const RelaxedRegionKey& key) const noexcept {
+        std::size_t seed = 0;
+        for (const auto& id : key.region) {
+            hashCombine(seed, std::hash<OurPaintDCM::Utils::ID>{}(id));
+        }
+        for (const auto& handle : key.lockedVars) {
+            hashCombine(seed, std::hash<OurPaintDCM::Utils::VarHandle>{}(handle));
         }
         return seed;
     }
@@ -55,35 +173,806 @@ struct SolveCacheKeyHasher {
 
 using FixedAssignmentMap = std::unordered_map<double*, double>;
 
+/// Largest |f_i| at which a constraint counts as already satisfied.
+constexpr double kSatisfiedResidualTolerance = 1e-9;
+
+bool isFixRequirement(OurPaintDCM::Utils::RequirementType type) {
+    return OurPaintDCM::Requirements::visitRequirementType(type, [](auto tag) {
+        return decltype(tag)::rows == OurPaintDCM::Requirements::RowKind::Fix;
+    });
+}
+
+std::size_t fixedCoordinateCount(OurPaintDCM::Utils::RequirementType type) {
+    return OurPaintDCM::Requirements::visitRequirementType(type, [](auto tag) -> std::size_t {
+        using Tag = decltype(tag);
+        return Tag::rows == OurPaintDCM::Requirements::RowKind::Fix ? Tag::variableCount : 0;
+    });
+}
+
+/// Targets of a fix requirement: the recorded ones when present, the current values otherwise.
+template<std::size_t N>
+std::array<double, N> fixTargetsFor(const std::array<double*, N>& refs,
+                                    const std::unordered_map<OurPaintDCM::Utils::ID, std::vector<double>>& fixedTargets,
+                                    OurPaintDCM::Utils::ID requirementId) {
+    std::array<double, N> targets{};
+    const auto targetIt = fixedTargets.find(requirementId);
+    const bool recorded = targetIt != fixedTargets.end() && targetIt->second.size() == N;
+    for (std::size_t k = 0; k < N; ++k) {
+        targets[k] = recorded ? targetIt->second[k] : *refs[k];
+    }
+    return targets;
+}
+
+/**
+ * @brief Call @p visit(coordinate, target) for every coordinate pinned by a fix requirement of @p system.
+ *
+ * Fix functions of a RequirementSystem capture coordinates when the system is built,
+ * so targets recorded by the manager take precedence. Fix requirements emit one
+ * FixCoordinateFunction per pinned scalar, in requirement order, which lets the targets
+ * be matched positionally without resolving geometry again.
+ */
+template<typename Visitor>
+void forEachFixTarget(const OurPaintDCM::System::RequirementSystem& system,
+                      const std::unordered_map<OurPaintDCM::Utils::ID, std::vector<double>>& fixedTargets,
+                      Visitor&& visit) {
+    const auto& functions = system.getFunctions();
+    std::size_t nextFixFunction = 0;
+
+    for (const auto& entry : system.getRequirements()) {
+        if (!isFixRequirement(entry.type)) {
+            continue;
+        }
+        const std::size_t coordinateCount = fixedCoordinateCount(entry.type);
+        const auto targetIt = fixedTargets.find(entry.id);
+        const bool hasTargets = targetIt != fixedTargets.end() && targetIt->second.size() == coordinateCount;
+        for (std::size_t i = 0; i < coordinateCount; ++i) {
+            while (nextFixFunction < functions.size() && !isFixRequirement(functions[nextFixFunction]->getType())) {
+                ++nextFixFunction;
+            }
+            if (nextFixFunction == functions.size()) {
+                return;
+            }
+            double* valueRef = nullptr;
+            double capturedTarget = 0.0;
+            if (!functions[nextFixFunction++]->tryGetAssignment(valueRef, capturedTarget) || valueRef == nullptr) {
+                continue;
+            }
+            visit(valueRef, hasTargets ? targetIt->second[i] : capturedTarget);
+        }
+    }
+}
+
+/// forEachFixTarget() collected into pairs, for callers that index the targets.
+std::vector<std::pair<double*, double>> collectFixTargets(
+    const OurPaintDCM::System::RequirementSystem& system,
+    const std::unordered_map<OurPaintDCM::Utils::ID, std::vector<double>>& fixedTargets) {
+    std::vector<std::pair<double*, double>> result;
+    forEachFixTarget(system, fixedTargets, [&result](double* valueRef, double target) {
+        result.emplace_back(valueRef, target);
+    });
+    return result;
+}
+
+/// Check every requirement of @p system against current geometry and recorded fix targets.
+bool requirementsSatisfied(const OurPaintDCM::System::RequirementSystem& system,
+                           const std::unordered_map<OurPaintDCM::Utils::ID, std::vector<double>>& fixedTargets) {
+    for (const auto& function : system.getFunctions()) {
+        if (!isFixRequirement(function->getType()) &&
+            std::abs(function->evaluate() * function->getWeight()) > kSatisfiedResidualTolerance) {
+            return false;
+        }
+    }
+
+    bool satisfied = true;
+    forEachFixTarget(system, fixedTargets, [&satisfied](const double* valueRef, double target) {
+        satisfied = satisfied && std::abs(*valueRef - target) <= kSatisfiedResidualTolerance;
+    });
+    return satisfied;
+}
+
+/// ‖r‖ over the residuals requirementsSatisfied() checks.
+double residualNorm(const OurPaintDCM::System::RequirementSystem& system,
+                    const std::unordered_map<OurPaintDCM::Utils::ID, std::vector<double>>& fixedTargets) {
+    double sum = 0.0;
+    for (const auto& function : system.getFunctions()) {
+        if (!isFixRequirement(function->getType())) {
+            const double residual = function->evaluate() * function->getWeight();
+            sum += residual * residual;
+        }
+    }
+    forEachFixTarget(system, fixedTargets, [&sum](const double* valueRef, double target) {
+        sum += (*valueRef - target) * (*valueRef - target);
+    });
+    return std::sqrt(sum);
+}
+
+using SolveClock = std::chrono::steady_clock;
+
+std::chrono::nanoseconds elapsedSince(SolveClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(SolveClock::now() - start);
+}
+
+/**
+ * @brief Locus of a point to be placed: a circle around a known centre or a line through two known points.
+ */
+struct ConstructionLocus {
+    bool circle = true;
+    const double* ax = nullptr; ///< Circle centre or first line point
+    const double* ay = nullptr;
+    const double* bx = nullptr; ///< Second line point (unused for circles)
+    const double* by = nullptr;
+    double radius = 0.0;
+};
+
+/**
+ * @brief Ruler-and-compass placement of one point as the intersection of two loci.
+ *
+ * Of the two intersections the one closest to the current position is taken, so repeated
+ * solves stay on the same branch.
+ */
+struct ConstructionStep {
+    ConstructionLocus first;
+    ConstructionLocus second;
+    double* x = nullptr;
+    double* y = nullptr;
+};
+
+/// Below this length a locus is treated as degenerate.
+constexpr double kConstructionEpsilon = 1e-12;
+
+/// Place @p step.x/@p step.y; an empty intersection degrades to the closest point between the loci.
+void placeConstructedPoint(const ConstructionStep& step) {
+    const Eigen::Vector2d current(*step.x, *step.y);
+    const auto pointA = [](const ConstructionLocus& locus) { return Eigen::Vector2d(*locus.ax, *locus.ay); };
+    const auto pointB = [](const ConstructionLocus& locus) { return Eigen::Vector2d(*locus.bx, *locus.by); };
+    const auto projectOnCircle = [&](const ConstructionLocus& locus) -> Eigen::Vector2d {
+        const Eigen::Vector2d centre = pointA(locus);
+        const Eigen::Vector2d offset = current - centre;
+        const double length = offset.norm();
+        return length < kConstructionEpsilon ? Eigen::Vector2d(centre.x() + locus.radius, centre.y())
+                                             : Eigen::Vector2d(centre + offset * (locus.radius / length));
+    };
+    const auto projectOnLine = [&](const ConstructionLocus& locus) -> Eigen::Vector2d {
+        const Eigen::Vector2d a = pointA(locus);
+        const Eigen::Vector2d direction = pointB(locus) - a;
+        const double lengthSquared = direction.squaredNorm();
+        return lengthSquared < kConstructionEpsilon ? a : Eigen::Vector2d(a + direction * (direction.dot(current - a) / lengthSquared));
+    };
+    const auto nearest = [&](const Eigen::Vector2d& lhs, const Eigen::Vector2d& rhs) {
+        return (lhs - current).squaredNorm() <= (rhs - current).squaredNorm() ? lhs : rhs;
+    };
+
+    Eigen::Vector2d placed;
+    if (step.first.circle && step.second.circle) {
+        const Eigen::Vector2d c1 = pointA(step.first);
+        const Eigen::Vector2d c2 = pointA(step.second);
+        const Eigen::Vector2d between = c2 - c1;
+        const double distance = between.norm();
+        if (distance < kConstructionEpsilon) {
+            placed = projectOnCircle(step.first);
+        } else {
+            const double r1 = step.first.radius;
+            const double r2 = step.second.radius;
+            const double along = (r1 * r1 - r2 * r2 + distance * distance) / (2.0 * distance);
+            const double across = std::sqrt(std::max(0.0, r1 * r1 - along * along));
+            const Eigen::Vector2d unit = between / distance;
+            const Eigen::Vector2d base = c1 + along * unit;
+            const Eigen::Vector2d normal(-unit.y(), unit.x());
+            placed = nearest(base + across * normal, base - across * normal);
+        }
+    } else if (!step.first.circle && !step.second.circle) {
+        const Eigen::Vector2d a1 = pointA(step.first);
+        const Eigen::Vector2d d1 = pointB(step.first) - a1;
+        const Eigen::Vector2d a2 = pointA(step.second);
+        const Eigen::Vector2d d2 = pointB(step.second) - a2;
+        const double cross = d1.x() * d2.y() - d1.y() * d2.x();
+        if (std::abs(cross) < kConstructionEpsilon) {
+            placed = projectOnLine(step.first);
+        } else {
+            const Eigen::Vector2d delta = a2 - a1;
+            placed = a1 + d1 * ((delta.x() * d2.y() - delta.y() * d2.x()) / cross);
+        }
+    } else {
+        const auto& circle = step.first.circle ? step.first : step.second;
+        const auto& line = step.first.circle ? step.second : step.first;
+        const Eigen::Vector2d a = pointA(line);
+        const Eigen::Vector2d direction = pointB(line) - a;
+        const double length = direction.norm();
+        if (length < kConstructionEpsilon) {
+            placed = projectOnCircle(circle);
+        } else {
+            const Eigen::Vector2d unit = direction / length;
+            const Eigen::Vector2d centre = pointA(circle);
+            const Eigen::Vector2d foot = a + unit * unit.dot(centre - a);
+            const double half = std::sqrt(std::max(0.0, circle.radius * circle.radius - (centre - foot).squaredNorm()));
+            placed = nearest(foot + half * unit, foot - half * unit);
+        }
+    }
+
+    *step.x = placed.x();
+    *step.y = placed.y();
+}
+
 struct BuiltSolvePipeline {
     FixedAssignmentMap fixedAssignments;
-    std::vector<std::unique_ptr<Variable>> variableOwners;
-    std::unique_ptr<SparseLSMTask> task;
+    std::vector<std::pair<double*, double*>> coordinateAliases;
+    std::vector<ConstructionStep> constructionSteps;
+    VariableRegistry variables;
+    std::vector<std::unique_ptr<SparseLSMTask>> tasks;
+    std::vector<std::unique_ptr<OurPaintDCM::System::IterativeLMSolver>> iterativeSolvers;
     bool hasFunctions = false;
     bool hasFreeVariables = false;
 };
 
-} // anonymous namespace
+/// Requirements preserved by every rigid motion of the figures they constrain.
+bool isMotionInvariant(OurPaintDCM::Utils::RequirementType type) noexcept {
+    switch (type) {
+        case OurPaintDCM::Utils::RequirementType::ET_POINTLINEDIST:
+        case OurPaintDCM::Utils::RequirementType::ET_POINTONLINE:
+        case OurPaintDCM::Utils::RequirementType::ET_POINTPOINTDIST:
+        case OurPaintDCM::Utils::RequirementType::ET_POINTONPOINT:
+        case OurPaintDCM::Utils::RequirementType::ET_LINECIRCLEDIST:
+        case OurPaintDCM::Utils::RequirementType::ET_LINEONCIRCLE:
+        case OurPaintDCM::Utils::RequirementType::ET_LINEINCIRCLE:
+        case OurPaintDCM::Utils::RequirementType::ET_LINELINEPARALLEL:
+        case OurPaintDCM::Utils::RequirementType::ET_LINELINEPERPENDICULAR:
+        case OurPaintDCM::Utils::RequirementType::ET_LINELINEANGLE:
+        case OurPaintDCM::Utils::RequirementType::ET_ARCCENTERONPERPENDICULAR:
+            return true;
+        default:
+            return false;
+    }
+}
 
-struct OurPaintDCM::DCMManager::SolveCache {
-    struct Entry {
-        std::size_t version = 0;
-        std::unique_ptr<System::RequirementSystem> subsystem;
-        FixedAssignmentMap fixedAssignments;
-        std::vector<std::unique_ptr<Variable>> variableOwners;
-        std::unique_ptr<SparseLSMTask> task;
-        std::unique_ptr<SparseLMSolver> solver;
-        bool hasFunctions = false;
-        bool hasFreeVariables = false;
+/// Requirements preserved by translations but not by rotations.
+bool isTranslationInvariant(OurPaintDCM::Utils::RequirementType type) noexcept {
+    return type == OurPaintDCM::Utils::RequirementType::ET_HORIZONTAL ||
+           type == OurPaintDCM::Utils::RequirementType::ET_VERTICAL;
+}
+
+using PointCoordinates = std::pair<double*, double*>;
+
+/**
+ * @brief Subsketch determined by its own requirements up to a rigid motion.
+ *
+ * Internal requirements are invariant under that motion, so while they hold the whole
+ * cluster can be moved by (tx, ty, θ), or by (tx, ty) when its orientation is pinned.
+ */
+struct RigidCluster {
+    std::vector<PointCoordinates> points;       ///< Representative points moved by the transform
+    std::vector<double*> scalars;               ///< Radii fixed by the cluster, unchanged by motion
+    std::vector<std::size_t> internalFunctions; ///< Function indices absorbed by the transform
+    bool rotates = true;                        ///< false when orientation is pinned
+};
+
+/// Relative singular-value threshold used by the rigidity rank tests.
+constexpr double kRigidityRankTolerance = 1e-9;
+
+std::size_t numericRank(const Eigen::MatrixXd& matrix) {
+    if (matrix.size() == 0) {
+        return 0;
+    }
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(matrix);
+    const auto& values = svd.singularValues();
+    const double threshold = kRigidityRankTolerance * std::max(1.0, values.size() > 0 ? values[0] : 0.0);
+    return static_cast<std::size_t>((values.array() > threshold).count());
+}
+
+/**
+ * @brief Grow rigid clusters over the motion-invariant requirements of @p system.
+ *
+ * Clusters grow one element (point or radius) at a time. An element joins when the
+ * requirements between it and the cluster leave the union with no more freedom than a
+ * rigid body: 3 DOF, or 2 once a horizontal/vertical requirement pins the orientation.
+ * The test only needs the element's own variables plus the cluster's motion basis, so
+ * each step ranks a matrix with at most five columns. Rigid bodies that cannot be built
+ * element by element are left to the regular solve.
+ */
+std::vector<RigidCluster> detectRigidClusters(
+    const OurPaintDCM::System::RequirementFunctionSystem& system,
+    const std::unordered_map<double*, PointCoordinates>& pointOfVar) {
+    const auto& functions = system.getFunctions();
+
+    struct Element {
+        std::array<double*, 2> vars{};
+        std::size_t dim = 0;
     };
+    std::vector<Element> elements;
+    std::unordered_map<double*, std::size_t> elementOfVar;
+    std::vector<std::vector<double*>> functionVars(functions.size());
+    std::unordered_map<std::size_t, std::vector<std::size_t>> functionsOfElement;
+
+    for (std::size_t index = 0; index < functions.size(); ++index) {
+        const auto type = functions[index]->getType();
+        if (!isMotionInvariant(type) && !isTranslationInvariant(type)) {
+            continue;
+        }
+        functionVars[index] = functions[index]->getVars();
+        for (double* var : functionVars[index]) {
+            if (elementOfVar.contains(var)) {
+                continue;
+            }
+            Element element;
+            if (const auto pointIt = pointOfVar.find(var); pointIt != pointOfVar.end()) {
+                element.vars = {pointIt->second.first, pointIt->second.second};
+                element.dim = 2;
+            } else {
+                element.vars = {var, nullptr};
+                element.dim = 1;
+            }
+            for (std::size_t i = 0; i < element.dim; ++i) {
+                elementOfVar.emplace(element.vars[i], elements.size());
+            }
+            elements.push_back(element);
+        }
+        std::unordered_set<std::size_t> touched;
+        for (double* var : functionVars[index]) {
+            if (touched.insert(elementOfVar.at(var)).second) {
+                functionsOfElement[elementOfVar.at(var)].push_back(index);
+            }
+        }
+    }
 
-    std::size_t version = 0;
-    std::unordered_map<SolveCacheKey, Entry, SolveCacheKeyHasher> entries;
+    std::vector<RigidCluster> clusters;
+    std::vector<char> assigned(elements.size(), 0);
+    std::vector<char> functionUsed(functions.size(), 0);
+
+    for (std::size_t seed = 0; seed < elements.size(); ++seed) {
+        if (assigned[seed] || elements[seed].dim != 2) {
+            continue;
+        }
+
+        std::unordered_set<std::size_t> members = {seed};
+        std::unordered_set<double*> memberVars = {elements[seed].vars[0], elements[seed].vars[1]};
+        std::vector<std::size_t> internal;
+        std::size_t freedom = 2;
+        bool rotationInvariant = true;
+
+        std::vector<std::size_t> queue;
+        const auto enqueueNeighbours = [&](std::size_t element) {
+            const auto it = functionsOfElement.find(element);
+            if (it == functionsOfElement.end()) {
+                return;
+            }
+            for (const std::size_t index : it->second) {
+                for (double* var : functionVars[index]) {
+                    const std::size_t other = elementOfVar.at(var);
+                    if (!assigned[other] && !members.contains(other)) {
+                        queue.push_back(other);
+                    }
+                }
+            }
+        };
+        enqueueNeighbours(seed);
+
+        while (!queue.empty()) {
+            const std::size_t candidate = queue.back();
+            queue.pop_back();
+            if (members.contains(candidate)) {
+                continue;
+            }
+            const auto& element = elements[candidate];
+
+            std::vector<std::size_t> rows;
+            bool rowsRotationInvariant = rotationInvariant;
+            for (const std::size_t index : functionsOfElement[candidate]) {
+                const bool inside = std::all_of(functionVars[index].begin(), functionVars[index].end(),
+                    [&](double* var) {
+                        return memberVars.contains(var) || elementOfVar.at(var) == candidate;
+                    });
+                if (inside && !functionUsed[index]) {
+                    rows.push_back(index);
+                    rowsRotationInvariant = rowsRotationInvariant && isMotionInvariant(functions[index]->getType());
+                }
+            }
+            if (rows.empty()) {
+                continue;
+            }
+
+            // Columns: the element's own variables, then the cluster motion (tx, ty[, θ]).
+            const bool clusterRotates = freedom == 3;
+            const std::size_t columns = element.dim + (clusterRotates ? 3 : 2);
+            Eigen::MatrixXd jacobian = Eigen::MatrixXd::Zero(static_cast<Eigen::Index>(rows.size()),
+                                                             static_cast<Eigen::Index>(columns));
+            for (std::size_t row = 0; row < rows.size(); ++row) {
+                for (const auto& [var, derivative] : functions[rows[row]]->gradient()) {
+                    if (elementOfVar.contains(var) && elementOfVar.at(var) == candidate) {
+                        const std::size_t axis = var == element.vars[0] ? 0 : 1;
+                        jacobian(row, axis) += derivative;
+                        continue;
+                    }
+                    const auto pointIt = pointOfVar.find(var);
+                    if (pointIt == pointOfVar.end()) {
+                        continue;
+                    }
+                    const bool isX = var == pointIt->second.first;
+                    jacobian(row, element.dim + (isX ? 0 : 1)) += derivative;
+                    if (clusterRotates) {
+                        // Infinitesimal rotation about the origin: (x, y) -> (-y, x).
+                        jacobian(row, element.dim + 2) +=
+                            derivative * (isX ? -*pointIt->second.second : *pointIt->second.first);
+                    }
+                }
+            }
+
+            const std::size_t rank = numericRank(jacobian);
+            const std::size_t newFreedom = columns - std::min(rank, columns);
+            if (newFreedom > (rowsRotationInvariant ? 3u : 2u)) {
+                continue;
+            }
+
+            members.insert(candidate);
+            for (std::size_t i = 0; i < element.dim; ++i) {
+                memberVars.insert(element.vars[i]);
+            }
+            for (const std::size_t index : rows) {
+                functionUsed[index] = 1;
+                internal.push_back(index);
+            }
+            freedom = newFreedom;
+            rotationInvariant = rowsRotationInvariant;
+            enqueueNeighbours(candidate);
+        }
+
+        std::size_t pointCount = 0;
+        for (const std::size_t member : members) {
+            pointCount += elements[member].dim == 2 ? 1 : 0;
+        }
+        // A lone bar saves a single DOF; leave it to the regular solve.
+        if (pointCount < 2 || members.size() < 3) {
+            for (const std::size_t index : internal) {
+                functionUsed[index] = 0;
+            }
+            continue;
+        }
+
+        RigidCluster cluster;
+        cluster.rotates = freedom == 3;
+        cluster.internalFunctions = std::move(internal);
+        for (const std::size_t member : members) {
+            assigned[member] = 1;
+            if (elements[member].dim == 2) {
+                cluster.points.emplace_back(elements[member].vars[0], elements[member].vars[1]);
+            } else {
+                cluster.scalars.push_back(elements[member].vars[0]);
+            }
+        }
+        clusters.push_back(std::move(cluster));
+    }
+
+    return clusters;
+}
+
+/// Placement of a rigid cluster: point i sits at centroid + R(θ)·offsets[i] + (tx, ty).
+struct ClusterPose {
+    Eigen::Vector2d centroid = Eigen::Vector2d::Zero();
+    std::vector<Eigen::Vector2d> offsets; ///< Per cluster point, taken from the geometry every frame
+    std::array<double, 3> parameters{};   ///< tx, ty, θ; solver variables (θ only if the cluster rotates)
+    bool rotates = true;
 };
 
-struct OurPaintDCM::DCMManager::BatchUpdateContext {
-    std::unordered_map<ComponentID, std::unordered_set<double*>> lockedVarsByComponent;
-    bool needsCoincidentSync = false;
+/// coordinate - target, where the target may change between solves.
+class PinnedCoordinateFunction final : public OurPaintDCM::Function::RequirementFunction {
+    const double* _target;
+
+public:
+    PinnedCoordinateFunction(VAR var, const double* target)
+        : RequirementFunction(OurPaintDCM::Utils::RequirementType::ET_FIXPOINT, {var}), _target(target) {}
+
+    double evaluate() const override { return *_vars[0] - *_target; }
+    std::unordered_map<VAR, double> gradient() const override { return {{_vars[0], 1.0}}; }
+    void gradientInto(std::span<double> partials) const override { partials[0] = 1.0; }
+    size_t getVarCount() const override { return 1; }
+    std::size_t objectBytes() const noexcept override { return sizeof(PinnedCoordinateFunction); }
+};
+
+/**
+ * @brief A horizontal or vertical row kept by the linear presolve, as the equality it stands for.
+ *
+ * Only classes with conflicting pinned values keep these rows. Written as a coordinate difference
+ * they leave the other axis out, so the x and y halves of the conflict solve as separate blocks.
+ */
+class CoordinateDifferenceFunction final : public OurPaintDCM::Function::RequirementFunction {
+public:
+    CoordinateDifferenceFunction(OurPaintDCM::Utils::RequirementType type, VAR first, VAR second)
+        : RequirementFunction(type, {first, second}) {}
+
+    double evaluate() const override { return *_vars[1] - *_vars[0]; }
+    std::unordered_map<VAR, double> gradient() const override {
+        std::unordered_map<VAR, double> result{{_vars[0], -1.0}};
+        result[_vars[1]] += 1.0;
+        return result;
+    }
+    void gradientInto(std::span<double> partials) const override {
+        partials[0] = -1.0;
+        partials[1] = 1.0;
+    }
+    size_t getVarCount() const override { return 2; }
+    std::size_t objectBytes() const noexcept override { return sizeof(CoordinateDifferenceFunction); }
+};
+
+/**
+ * @brief A requirement function seen through the rigid transforms of the clusters it touches.
+ *
+ * Its variables are the free variables of the wrapped function and the pose parameters of
+ * those clusters. The clustered coordinates themselves are kept current by the solver's update
+ * hook, so evaluate() is the wrapped function's; gradientInto() applies the chain rule.
+ */
+class RigidClusterFunction final : public OurPaintDCM::Function::RequirementFunction {
+public:
+    static constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+    /// How one variable of the wrapped function depends on this function's variables.
+    struct Dependency {
+        const ClusterPose* pose = nullptr; ///< Cluster placing the variable, nullptr if it is free or constant
+        std::size_t point = 0;             ///< Index of the point in the cluster
+        std::size_t axis = 0;              ///< 0 for x, 1 for y
+        std::array<std::size_t, 3> positions{kNone, kNone, kNone}; ///< Free variable, or tx, ty, θ of the pose
+    };
+
+private:
+    std::shared_ptr<RequirementFunction> _inner;
+    std::vector<Dependency> _dependencies; ///< One per variable of the wrapped function
+
+public:
+    RigidClusterFunction(std::shared_ptr<RequirementFunction> inner, const std::vector<VAR>& vars,
+                         std::vector<Dependency> dependencies)
+        : RequirementFunction(inner->getType(), vars), _inner(std::move(inner)),
+          _dependencies(std::move(dependencies)) {
+        setWeight(_inner->getWeight());
+    }
+
+    double evaluate() const override { return _inner->evaluate(); }
+
+    std::unordered_map<VAR, double> gradient() const override {
+        std::array<double, kMaxVarCount> partials{};
+        gradientInto(std::span(partials.data(), _vars.size()));
+        std::unordered_map<VAR, double> result;
+        for (std::size_t position = 0; position < _vars.size(); ++position) {
+            result[_vars[position]] += partials[position];
+        }
+        return result;
+    }
+
+    void gradientInto(std::span<double> partials) const override {
+        std::array<double, kMaxVarCount> inner{};
+        _inner->gradientInto(std::span(inner.data(), _dependencies.size()));
+        std::fill(partials.begin(), partials.begin() + static_cast<std::ptrdiff_t>(_vars.size()), 0.0);
+        for (std::size_t k = 0; k < _dependencies.size(); ++k) {
+            const auto& dependency = _dependencies[k];
+            if (dependency.pose == nullptr) {
+                if (dependency.positions[0] != kNone) {
+                    partials[dependency.positions[0]] += inner[k];
+                }
+                continue;
+            }
+            partials[dependency.positions[dependency.axis]] += inner[k];
+            if (dependency.pose->rotates) {
+                const double angle = dependency.pose->parameters[2];
+                const double c = std::cos(angle);
+                const double s = std::sin(angle);
+                const auto& offset = dependency.pose->offsets[dependency.point];
+                const double dAngle = dependency.axis == 0 ? -s * offset.x() - c * offset.y()
+                                                           : c * offset.x() - s * offset.y();
+                partials[dependency.positions[2]] += inner[k] * dAngle;
+            }
+        }
+    }
+
+    size_t getVarCount() const override { return _vars.size(); }
+    std::size_t objectBytes() const noexcept override { return sizeof(RigidClusterFunction); }
+};
+
+/**
+ * @brief Reduced drag problem of a component's rigid clusters for one set of drag locks.
+ *
+ * Built when the locked handles change and reused by the following frames, which only refresh
+ * the lock targets, the snapshot values and the cluster poses before solving.
+ */
+struct RigidClusterSolve {
+    struct Pin {
+        double* var = nullptr;
+        bool locked = false;    ///< Drag lock: pinned to its value at the start of the frame
+        bool clustered = false; ///< Placed by a cluster, so pinned by a residual rather than assigned
+    };
+
+    std::vector<OurPaintDCM::Utils::VarHandle> lockHandles; ///< Sorted; the locks this solve was built for
+    std::vector<Pin> pins;
+    std::vector<double> pinTargets;                         ///< Parallel to pins; residuals point into it
+    std::vector<ClusterPose> poses;                         ///< Parallel to the clusters; never reallocated
+    std::vector<std::pair<double*, double>> snapshot;       ///< Everything a solve writes, restored on failure
+    std::unique_ptr<OurPaintDCM::System::IterativeLMSolver> solver;
+    bool usable = true; ///< false when a row would couple more than kMaxVarCount variables
+};
+
+std::unique_ptr<RigidClusterSolve> makeRigidClusterSolve(
+    const std::vector<RigidCluster>& clusters,
+    const OurPaintDCM::System::RequirementSystem& system,
+    const std::vector<std::pair<double*, double>>& fixTargets,
+    std::vector<OurPaintDCM::Utils::VarHandle> lockHandles,
+    std::span<double* const> lockedVars) {
+    using OurPaintDCM::Function::RequirementFunction;
+    auto solve = std::make_unique<RigidClusterSolve>();
+    solve->lockHandles = std::move(lockHandles);
+    const auto& functions = system.getFunctions();
+
+    std::vector<char> internal(functions.size(), 0);
+    struct ClusterCoordinate {
+        std::size_t cluster;
+        std::size_t point;
+        std::size_t axis;
+    };
+    std::unordered_map<double*, ClusterCoordinate> clusterCoordinates;
+    std::unordered_set<double*> clusterScalars;
+    solve->poses.resize(clusters.size());
+    for (std::size_t k = 0; k < clusters.size(); ++k) {
+        for (const std::size_t index : clusters[k].internalFunctions) {
+            internal[index] = 1;
+        }
+        auto& pose = solve->poses[k];
+        pose.rotates = clusters[k].rotates;
+        pose.offsets.resize(clusters[k].points.size());
+        for (std::size_t i = 0; i < clusters[k].points.size(); ++i) {
+            clusterCoordinates[clusters[k].points[i].first] = {k, i, 0};
+            clusterCoordinates[clusters[k].points[i].second] = {k, i, 1};
+        }
+        clusterScalars.insert(clusters[k].scalars.begin(), clusters[k].scalars.end());
+    }
+    const auto isClustered = [&](double* var) {
+        return clusterCoordinates.contains(var) || clusterScalars.contains(var);
+    };
+
+    // Fixed and dragged coordinates: constants outside clusters, residuals inside them.
+    std::unordered_map<double*, std::size_t> pinOf;
+    const auto addPin = [&](double* var, double target, bool locked) {
+        if (pinOf.try_emplace(var, solve->pins.size()).second) {
+            solve->pins.push_back({var, locked, isClustered(var)});
+            solve->pinTargets.push_back(target);
+        }
+    };
+    for (const auto& [valueRef, target] : fixTargets) {
+        addPin(valueRef, target, false);
+    }
+    for (double* var : lockedVars) {
+        addPin(var, *var, true);
+    }
+
+    std::vector<double*> freeVars;
+    std::unordered_map<double*, std::size_t> freeIndexOf;
+    std::vector<std::shared_ptr<RequirementFunction>> rows;
+    std::vector<std::pair<VAR, VAR>> pointBlocks;
+    std::vector<VAR> rowVars;
+    std::vector<RigidClusterFunction::Dependency> dependencies;
+    const auto positionOf = [&](VAR var) {
+        const auto it = std::find(rowVars.begin(), rowVars.end(), var);
+        if (it != rowVars.end()) {
+            return static_cast<std::size_t>(it - rowVars.begin());
+        }
+        rowVars.push_back(var);
+        return rowVars.size() - 1;
+    };
+    const auto addRow = [&](std::shared_ptr<RequirementFunction> function) {
+        const auto vars = function->getVars();
+        rowVars.clear();
+        dependencies.assign(vars.size(), {});
+        for (std::size_t position = 0; position < vars.size(); ++position) {
+            double* var = vars[position];
+            auto& dependency = dependencies[position];
+            if (const auto coordIt = clusterCoordinates.find(var); coordIt != clusterCoordinates.end()) {
+                const auto& [cluster, point, axis] = coordIt->second;
+                auto& pose = solve->poses[cluster];
+                dependency.pose = &pose;
+                dependency.point = point;
+                dependency.axis = axis;
+                for (std::size_t p = 0; p < (pose.rotates ? 3U : 2U); ++p) {
+                    dependency.positions[p] = positionOf(&pose.parameters[p]);
+                }
+            } else if (!pinOf.contains(var) && !isClustered(var)) {
+                if (freeIndexOf.try_emplace(var, freeVars.size()).second) {
+                    freeVars.push_back(var);
+                }
+                dependency.positions[0] = positionOf(var);
+            }
+        }
+        // Requirement functions list their points as consecutive (x, y) pairs.
+        for (std::size_t position = 0; position + 1 < vars.size(); position += 2) {
+            if (freeIndexOf.contains(vars[position]) && freeIndexOf.contains(vars[position + 1])) {
+                pointBlocks.emplace_back(vars[position], vars[position + 1]);
+            }
+        }
+        if (rowVars.size() > RequirementFunction::kMaxVarCount) {
+            solve->usable = false;
+            return;
+        }
+        rows.push_back(std::make_shared<RigidClusterFunction>(std::move(function), rowVars, dependencies));
+    };
+
+    for (std::size_t index = 0; index < functions.size(); ++index) {
+        if (!internal[index] && !isFixRequirement(functions[index]->getType())) {
+            addRow(functions[index]);
+        }
+    }
+    for (std::size_t p = 0; p < solve->pins.size(); ++p) {
+        if (solve->pins[p].clustered) {
+            addRow(std::make_shared<PinnedCoordinateFunction>(solve->pins[p].var, &solve->pinTargets[p]));
+        }
+    }
+
+    std::vector<VAR> variables = freeVars;
+    for (auto& pose : solve->poses) {
+        variables.push_back(&pose.parameters[0]);
+        variables.push_back(&pose.parameters[1]);
+        pointBlocks.emplace_back(&pose.parameters[0], &pose.parameters[1]);
+        if (pose.rotates) {
+            variables.push_back(&pose.parameters[2]);
+        }
+    }
+
+    for (const auto& pin : solve->pins) {
+        solve->snapshot.emplace_back(pin.var, 0.0);
+    }
+    for (double* var : freeVars) {
+        solve->snapshot.emplace_back(var, 0.0);
+    }
+    for (const auto& [var, dependency] : clusterCoordinates) {
+        if (!pinOf.contains(var)) {
+            solve->snapshot.emplace_back(var, 0.0);
+        }
+    }
+
+    solve->solver = std::make_unique<OurPaintDCM::System::IterativeLMSolver>(std::move(rows), std::move(variables),
+                                                                             pointBlocks);
+    OurPaintDCM::System::IterativeLMSolver::Options options;
+    options.innerSolver = OurPaintDCM::System::IterativeLMSolver::InnerSolver::BlockCholesky;
+    options.maxIterations = 50;
+    options.tolerance = kSatisfiedResidualTolerance;
+    solve->solver->setOptions(options);
+    solve->solver->setUpdateHook([&clusters, poses = solve->poses.data()]() {
+        for (std::size_t k = 0; k < clusters.size(); ++k) {
+            const auto& pose = poses[k];
+            const double angle = pose.rotates ? pose.parameters[2] : 0.0;
+            const double c = std::cos(angle);
+            const double s = std::sin(angle);
+            for (std::size_t i = 0; i < clusters[k].points.size(); ++i) {
+                const auto& offset = pose.offsets[i];
+                *clusters[k].points[i].first = pose.centroid.x() + c * offset.x() - s * offset.y() + pose.parameters[0];
+                *clusters[k].points[i].second = pose.centroid.y() + s * offset.x() + c * offset.y() + pose.parameters[1];
+            }
+        }
+    });
+    return solve;
+}
+
+} // anonymous namespace
+
+struct OurPaintDCM::DCMManager::RigidClusterSet {
+    std::unique_ptr<System::RequirementSystem> subsystem;
+    std::vector<RigidCluster> clusters;
+    std::unordered_map<double*, Utils::ID> pointIdOfVar;
+    std::unique_ptr<RigidClusterSolve> solve; ///< Reduced problem for the most recent drag locks
+};
+
+/**
+ * @brief Cached solve of one component under one set of drag locks. Only the key is handle-based:
+ * the subsystem and the pipeline hold coordinate addresses resolved when they were built, so
+ * every edit that may move or free geometry invalidates the whole cache.
+ */
+struct OurPaintDCM::DCMManager::SolveCacheEntry {
+    std::size_t version = 0;
+    std::unique_ptr<System::RequirementSystem> subsystem;
+    FixedAssignmentMap fixedAssignments;
+    std::vector<std::pair<double*, double*>> coordinateAliases;
+    std::vector<ConstructionStep> constructionSteps;
+    VariableRegistry variables;
+    std::vector<std::unique_ptr<SparseLSMTask>> tasks;
+    std::vector<std::unique_ptr<SparseLMSolver>> solvers;
+    std::vector<std::unique_ptr<System::IterativeLMSolver>> iterativeSolvers;
+    std::unordered_set<double*> lockedVars;
+    bool hasFunctions = false;
+    bool hasFreeVariables = false;
+    bool constructionEnabled = true;
+    bool pipelineReady = false;
+    Utils::SolveReport report; ///< Telemetry of the current solve of this entry
 };
 
 struct OurPaintDCM::DCMManager::FixedGeometry {
@@ -91,6 +980,69 @@ struct OurPaintDCM::DCMManager::FixedGeometry {
     std::unordered_set<Utils::ID> circleIds;
 };
 
+struct OurPaintDCM::DCMManager::SolveCache {
+    using Entry = SolveCacheEntry;
+
+    std::size_t version = 0;
+    std::unordered_map<SolveCacheKey, Entry, SolveCacheKeyHasher, SolveCacheKeyEqual> entries;
+    std::unordered_map<OurPaintDCM::Utils::ID, std::vector<OurPaintDCM::Utils::ID>> figureRequirements;
+    bool figureRequirementsReady = false;
+    FixedGeometry fixedGeometry;
+    bool fixedGeometryReady = false;
+    std::unordered_map<ComponentID, RigidClusterSet> rigidClusters;
+    std::unordered_map<RelaxedRegionKey, Entry, RelaxedRegionKeyHasher> relaxedEntries;
+};
+
+/**
+ * @brief Drag locks and edited figures of one update batch, grouped by component.
+ *
+ * The manager keeps a single context and reset()s it per batch: edits past `touched` and
+ * their vectors stay allocated, so steady drag frames reuse them instead of allocating.
+ */
+struct OurPaintDCM::DCMManager::BatchUpdateContext {
+    struct ComponentEdits {
+        ComponentID componentId = 0;
+        std::vector<Utils::VarHandle> lockedVars; ///< Sorted
+        std::vector<Utils::ID> editedFigures;
+    };
+
+    static constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+
+    std::vector<ComponentEdits> edits;        ///< The first `touched` belong to this batch
+    std::size_t touched = 0;
+    std::vector<std::size_t> slotOfComponent; ///< ComponentID -> index into edits, or kNoSlot
+    bool needsCoincidentSync = false;
+
+    ComponentEdits& editsFor(ComponentID componentId) {
+        if (componentId >= slotOfComponent.size()) {
+            slotOfComponent.resize(componentId + 1, kNoSlot);
+        }
+        auto& slot = slotOfComponent[componentId];
+        if (slot == kNoSlot) {
+            slot = touched++;
+            if (slot == edits.size()) {
+                edits.emplace_back();
+            }
+            edits[slot].componentId = componentId;
+            edits[slot].lockedVars.clear();
+            edits[slot].editedFigures.clear();
+        }
+        return edits[slot];
+    }
+
+    std::span<const ComponentEdits> touchedEdits() const noexcept {
+        return {edits.data(), touched};
+    }
+
+    void reset() noexcept {
+        for (std::size_t i = 0; i < touched; ++i) {
+            slotOfComponent[edits[i].componentId] = kNoSlot;
+        }
+        touched = 0;
+        needsCoincidentSync = false;
+    }
+};
+
 namespace OurPaintDCM {
 
 DCMManager::DCMManager()
@@ -103,11 +1055,19 @@ void DCMManager::invalidateSolveCache() noexcept {
     if (_solveCache == nullptr) {
         return;
     }
+    Utils::traceInstant("solveCacheInvalidated");
     ++_solveCache->version;
     _solveCache->entries.clear();
+    _solveCache->figureRequirements.clear();
+    _solveCache->figureRequirementsReady = false;
+    _solveCache->fixedGeometry = {};
+    _solveCache->fixedGeometryReady = false;
+    _solveCache->rigidClusters.clear();
+    _solveCache->relaxedEntries.clear();
 }
 
 Utils::ID DCMManager::addFigure(const Utils::FigureDescriptor& descriptor) {
+    const Utils::TraceScope trace("DCMManager::addFigure");
     descriptor.validate();
 
     Utils::ID figureId;
@@ -218,11 +1178,13 @@ Utils::ID DCMManager::addFigure(const Utils::FigureDescriptor& descriptor) {
         mergeComponents(relatedFigures);
     }
 
+    markFigureDirty(figureId);
     invalidateSolveCache();
     return figureId;
 }
 
 void DCMManager::removeFigure(Utils::ID figureId, bool forceCascade) {
+    const Utils::TraceScope trace("DCMManager::removeFigure");
     if (!_storage.contains(figureId)) {
         throw std::runtime_error("Figure not found");
     }
@@ -272,8 +1234,16 @@ void DCMManager::removeFigure(Utils::ID figureId, bool forceCascade) {
     invalidateSolveCache();
 }
 
-DCMManager::FixedGeometry DCMManager::collectFixedGeometry() const {
-    FixedGeometry fixed;
+const DCMManager::FixedGeometry& DCMManager::collectFixedGeometry() {
+    if (_solveCache == nullptr) {
+        _solveCache = std::make_unique<SolveCache>();
+    }
+    if (_solveCache->fixedGeometryReady) {
+        return _solveCache->fixedGeometry;
+    }
+
+    auto& fixed = _solveCache->fixedGeometry;
+    fixed = {};
 
     for (const auto& reqId : _requirementOrder) {
         const auto it = _requirementRecords.find(reqId);
@@ -304,23 +1274,24 @@ DCMManager::FixedGeometry DCMManager::collectFixedGeometry() const {
         }
     }
 
+    _solveCache->fixedGeometryReady = true;
     return fixed;
 }
 
 bool DCMManager::pointGroupHasFixConstraint(
     Utils::ID pointId,
     const std::unordered_set<Utils::ID>& fixedPointIds) const {
-    const auto coincidentPoints = _reqSystem.getCoincidentPoints(pointId);
-    for (const auto& coincidentPointId : coincidentPoints) {
-        if (fixedPointIds.contains(coincidentPointId)) {
-            return true;
-        }
+    const auto group = _reqSystem.coincidentGroup(pointId);
+    if (group.empty()) {
+        return fixedPointIds.contains(pointId);
     }
-    return false;
+    return std::any_of(group.begin(), group.end(), [&fixedPointIds](Utils::ID coincidentPointId) {
+        return fixedPointIds.contains(coincidentPointId);
+    });
 }
 
 void DCMManager::addDragLocks(Utils::ID figureId,
-                              std::initializer_list<double*> vars,
+                              std::initializer_list<std::optional<Utils::VarHandle>> handles,
                               BatchUpdateContext& context) {
     if (_solveMode != Utils::SolveMode::DRAG) {
         return;
@@ -331,12 +1302,22 @@ void DCMManager::addDragLocks(Utils::ID figureId,
         return;
     }
 
-    auto& lockedVars = context.lockedVarsByComponent[comp.value()];
-    for (double* var : vars) {
-        if (var != nullptr) {
-            lockedVars.insert(var);
+    auto& edits = context.editsFor(comp.value());
+    for (const auto& handle : handles) {
+        if (handle.has_value()) {
+            edits.lockedVars.insert(std::lower_bound(edits.lockedVars.begin(), edits.lockedVars.end(), *handle),
+                                    *handle);
         }
     }
+    edits.editedFigures.push_back(figureId);
+}
+
+DCMManager::BatchUpdateContext& DCMManager::beginBatchUpdate() {
+    if (_batchUpdate == nullptr) {
+        _batchUpdate = std::make_unique<BatchUpdateContext>();
+    }
+    _batchUpdate->reset();
+    return *_batchUpdate;
 }
 
 void DCMManager::solveDragUpdates(const BatchUpdateContext& context) {
@@ -344,8 +1325,26 @@ void DCMManager::solveDragUpdates(const BatchUpdateContext& context) {
         return;
     }
 
-    for (const auto& [componentId, lockedVars] : context.lockedVarsByComponent) {
-        if (!lockedVars.empty()) {
+    _lastSolveReport.reset();
+    for (const auto& [componentId, lockedVars, editedFigures] : context.touchedEdits()) {
+        if (lockedVars.empty()) {
+            continue;
+        }
+        const auto rigidStart = SolveClock::now();
+        if (_rigidClustersEnabled && solveWithRigidClusters(componentId, lockedVars)) {
+            Utils::SolveReport rigid;
+            rigid.termination = Utils::SolveTermination::ET_CONVERGED;
+            rigid.components = 1;
+            const auto& solver = *rigidClustersFor(componentId).solve->solver;
+            rigid.iterations = solver.getIterationCount();
+            rigid.innerIterations = solver.getInnerIterationCount();
+            rigid.phases.optimize = elapsedSince(rigidStart);
+            _lastSolveReport.merge(rigid);
+            continue;
+        }
+        if (_relaxationHops > 0) {
+            solveRelaxed(componentId, editedFigures, lockedVars);
+        } else {
             solveWithLockedVars(componentId, lockedVars);
         }
     }
@@ -447,9 +1446,14 @@ void DCMManager::applyPointUpdateNoSolve(const Utils::PointUpdateDescriptor& des
     if (descriptor.newY.has_value()) {
         solvePoint->y() = descriptor.newY.value();
     }
+    if (descriptor.newX.has_value() || descriptor.newY.has_value()) {
+        markFigureDirty(descriptor.pointId);
+    }
 
     context.needsCoincidentSync = true;
-    addDragLocks(descriptor.pointId, {solvePoint->ptrX(), solvePoint->ptrY()}, context);
+    addDragLocks(descriptor.pointId,
+                 {_storage.varHandle(solvePointId, Utils::kPointX), _storage.varHandle(solvePointId, Utils::kPointY)},
+                 context);
 }
 
 void DCMManager::applyLineUpdateNoSolve(const Utils::LineUpdateDescriptor& descriptor,
@@ -494,7 +1498,8 @@ void DCMManager::applyCircleUpdateNoSolve(const Utils::CircleUpdateDescriptor& d
     }
 
     circle->radius = descriptor.newRadius;
-    addDragLocks(descriptor.circleId, {circle->ptrRadius()}, context);
+    markFigureDirty(descriptor.circleId);
+    addDragLocks(descriptor.circleId, {_storage.varHandle(descriptor.circleId, Utils::kCircleRadius)}, context);
 }
 
 void DCMManager::applyArcUpdateNoSolve(const Utils::ArcUpdateDescriptor& descriptor,
@@ -576,17 +1581,22 @@ void DCMManager::applyFigureUpdateNoSolve(const Utils::FigureUpdateDescriptor& d
 }
 
 void DCMManager::updatePoint(const Utils::PointUpdateDescriptor& descriptor) {
-    updatePoints({descriptor});
+    updatePointBatch(std::span(&descriptor, 1));
 }
 
 void DCMManager::updatePoints(const std::vector<Utils::PointUpdateDescriptor>& descriptors) {
+    updatePointBatch(descriptors);
+}
+
+void DCMManager::updatePointBatch(std::span<const Utils::PointUpdateDescriptor> descriptors) {
+    const Utils::TraceScope trace("DCMManager::updatePoints");
     for (const auto& descriptor : descriptors) {
         validatePointUpdate(descriptor);
     }
 
     syncRequirementSystemIfNeeded();
-    const auto fixedGeometry = collectFixedGeometry();
-    BatchUpdateContext context;
+    const auto& fixedGeometry = collectFixedGeometry();
+    auto& context = beginBatchUpdate();
     for (const auto& descriptor : descriptors) {
         applyPointUpdateNoSolve(descriptor, fixedGeometry, context);
     }
@@ -602,13 +1612,14 @@ void DCMManager::updateLine(const Utils::LineUpdateDescriptor& descriptor) {
 }
 
 void DCMManager::updateLines(const std::vector<Utils::LineUpdateDescriptor>& descriptors) {
+    const Utils::TraceScope trace("DCMManager::updateLines");
     for (const auto& descriptor : descriptors) {
         validateLineUpdate(descriptor);
     }
 
     syncRequirementSystemIfNeeded();
-    const auto fixedGeometry = collectFixedGeometry();
-    BatchUpdateContext context;
+    const auto& fixedGeometry = collectFixedGeometry();
+    auto& context = beginBatchUpdate();
     for (const auto& descriptor : descriptors) {
         applyLineUpdateNoSolve(descriptor, fixedGeometry, context);
     }
@@ -624,6 +1635,7 @@ void DCMManager::updateCircle(const Utils::CircleUpdateDescriptor& descriptor) {
 }
 
 void DCMManager::updateCircles(const std::vector<Utils::CircleUpdateDescriptor>& descriptors) {
+    const Utils::TraceScope trace("DCMManager::updateCircles");
     bool needsPointResolution = false;
     for (const auto& descriptor : descriptors) {
         validateCircleUpdate(descriptor);
@@ -634,8 +1646,8 @@ void DCMManager::updateCircles(const std::vector<Utils::CircleUpdateDescriptor>&
         syncRequirementSystemIfNeeded();
     }
 
-    const auto fixedGeometry = collectFixedGeometry();
-    BatchUpdateContext context;
+    const auto& fixedGeometry = collectFixedGeometry();
+    auto& context = beginBatchUpdate();
     for (const auto& descriptor : descriptors) {
         applyCircleUpdateNoSolve(descriptor, fixedGeometry, context);
     }
@@ -651,13 +1663,14 @@ void DCMManager::updateArc(const Utils::ArcUpdateDescriptor& descriptor) {
 }
 
 void DCMManager::updateArcs(const std::vector<Utils::ArcUpdateDescriptor>& descriptors) {
+    const Utils::TraceScope trace("DCMManager::updateArcs");
     for (const auto& descriptor : descriptors) {
         validateArcUpdate(descriptor);
     }
 
     syncRequirementSystemIfNeeded();
-    const auto fixedGeometry = collectFixedGeometry();
-    BatchUpdateContext context;
+    const auto& fixedGeometry = collectFixedGeometry();
+    auto& context = beginBatchUpdate();
     for (const auto& descriptor : descriptors) {
         applyArcUpdateNoSolve(descriptor, fixedGeometry, context);
     }
@@ -673,6 +1686,7 @@ void DCMManager::updateFigure(const Utils::FigureUpdateDescriptor& descriptor) {
 }
 
 void DCMManager::updateFigures(const std::vector<Utils::FigureUpdateDescriptor>& descriptors) {
+    const Utils::TraceScope trace("DCMManager::updateFigures");
     bool needsPointResolution = false;
     for (const auto& descriptor : descriptors) {
         validateFigureUpdate(descriptor);
@@ -687,8 +1701,8 @@ void DCMManager::updateFigures(const std::vector<Utils::FigureUpdateDescriptor>&
         syncRequirementSystemIfNeeded();
     }
 
-    const auto fixedGeometry = collectFixedGeometry();
-    BatchUpdateContext context;
+    const auto& fixedGeometry = collectFixedGeometry();
+    auto& context = beginBatchUpdate();
     for (const auto& descriptor : descriptors) {
         applyFigureUpdateNoSolve(descriptor, fixedGeometry, context);
     }
@@ -870,21 +1884,56 @@ std::vector<Utils::FigureDescriptor> DCMManager::getAllArcs() const {
 }
 
 Utils::ID DCMManager::addRequirement(const Utils::RequirementDescriptor& descriptor) {
-    descriptor.validate();
+    const Utils::TraceScope trace("DCMManager::addRequirement");
+    validateNewRequirement(descriptor);
 
-    if (descriptor.id.has_value()) {
-        if (descriptor.id->id == 0ULL) {
-            throw std::invalid_argument("Requirement id must not be 0");
-        }
-        if (_requirementRecords.contains(*descriptor.id)) {
-            throw std::invalid_argument("Requirement id already exists");
-        }
+    syncRequirementSystemIfNeeded();
+
+    Utils::ID reqId = _reqSystem.addRequirement(descriptor);
+    recordRequirement(reqId, descriptor);
+    invalidateSolveCache();
+
+    return reqId;
+}
+
+std::vector<Utils::ID> DCMManager::addRequirements(const std::vector<Utils::RequirementDescriptor>& descriptors) {
+    const Utils::TraceScope trace("DCMManager::addRequirements");
+    for (const auto& descriptor : descriptors) {
+        validateNewRequirement(descriptor);
+    }
+    if (descriptors.empty()) {
+        return {};
     }
 
     syncRequirementSystemIfNeeded();
 
-    Utils::ID reqId = _reqSystem.addRequirement(descriptor);
+    // Assigns the generated ids too and rejects an explicit id that repeats any earlier one
+    // before anything is added.
+    auto reqIds = _reqSystem.addRequirements(descriptors);
+    _requirementRecords.reserve(_requirementRecords.size() + descriptors.size());
+    _requirementOrder.reserve(_requirementOrder.size() + descriptors.size());
+    for (std::size_t i = 0; i < descriptors.size(); ++i) {
+        recordRequirement(reqIds[i], descriptors[i]);
+    }
+    invalidateSolveCache();
+
+    return reqIds;
+}
+
+void DCMManager::validateNewRequirement(const Utils::RequirementDescriptor& descriptor) const {
+    descriptor.validate();
+
+    if (descriptor.id.has_value()) {
+        if (descriptor.id->id == 0ULL) {
+            throw std::invalid_argument("Requirement id must not be 0");
+        }
+        if (_requirementRecords.contains(*descriptor.id)) {
+            throw std::invalid_argument("Requirement id already exists");
+        }
+    }
+}
 
+void DCMManager::recordRequirement(Utils::ID reqId, const Utils::RequirementDescriptor& descriptor) {
     Utils::RequirementDescriptor storedDesc = descriptor;
     storedDesc.id = reqId;
     _requirementRecords[reqId] = storedDesc;
@@ -930,12 +1979,11 @@ Utils::ID DCMManager::addRequirement(const Utils::RequirementDescriptor& descrip
     _requirementOrder.push_back(reqId);
 
     mergeComponents(descriptor.objectIds);
-    invalidateSolveCache();
-
-    return reqId;
+    markFigureDirty(descriptor.objectIds.front());
 }
 
 void DCMManager::removeRequirement(Utils::ID reqId) {
+    const Utils::TraceScope trace("DCMManager::removeRequirement");
     auto it = _requirementRecords.find(reqId);
     if (it == _requirementRecords.end()) {
         throw std::runtime_error("Requirement not found");
@@ -950,6 +1998,7 @@ void DCMManager::removeRequirement(Utils::ID reqId) {
 }
 
 void DCMManager::updateRequirementParam(Utils::ID reqId, double newParam) {
+    const Utils::TraceScope trace("DCMManager::updateRequirementParam");
     auto it = _requirementRecords.find(reqId);
     if (it == _requirementRecords.end()) {
         throw std::runtime_error("Requirement not found");
@@ -960,6 +2009,9 @@ void DCMManager::updateRequirementParam(Utils::ID reqId, double newParam) {
     }
 
     it->second.param = newParam;
+    if (!it->second.objectIds.empty()) {
+        markFigureDirty(it->second.objectIds.front());
+    }
     _reqSystemSyncedWithRecords = false;
     invalidateSolveCache();
 }
@@ -1071,6 +2123,7 @@ std::size_t DCMManager::requirementCount() const noexcept {
 }
 
 void DCMManager::clear() {
+    const Utils::TraceScope trace("DCMManager::clear");
     _reqSystem.clear();
     _storage.clear();
     _requirementRecords.clear();
@@ -1079,6 +2132,7 @@ void DCMManager::clear() {
     _figureRecords.clear();
     _figureToComponent.clear();
     _components.clear();
+    _dirtyComponents.clear();
     _nextComponentId = 0;
     _activeComponentCount = 0;
     _reqSystemSyncedWithRecords = true;
@@ -1089,63 +2143,425 @@ void DCMManager::setSolveMode(Utils::SolveMode mode) noexcept {
     _solveMode = mode;
 }
 
+void DCMManager::setRelaxationHops(std::size_t hops) noexcept {
+    _relaxationHops = hops;
+}
+
+std::size_t DCMManager::getRelaxationHops() const noexcept {
+    return _relaxationHops;
+}
+
+void DCMManager::setIterativeSolveThreshold(std::size_t variables) {
+    const Utils::TraceScope trace("DCMManager::setIterativeSolveThreshold");
+    if (_iterativeSolveThreshold != variables) {
+        _iterativeSolveThreshold = variables;
+        invalidateSolveCache();
+    }
+}
+
+std::size_t DCMManager::getIterativeSolveThreshold() const noexcept {
+    return _iterativeSolveThreshold;
+}
+
+void DCMManager::setConstructiveSolveEnabled(bool enabled) {
+    const Utils::TraceScope trace("DCMManager::setConstructiveSolveEnabled");
+    if (_constructiveSolveEnabled != enabled) {
+        _constructiveSolveEnabled = enabled;
+        invalidateSolveCache();
+    }
+}
+
+bool DCMManager::getConstructiveSolveEnabled() const noexcept {
+    return _constructiveSolveEnabled;
+}
+
+void DCMManager::setExpressionTreeSolveEnabled(bool enabled) {
+    const Utils::TraceScope trace("DCMManager::setExpressionTreeSolveEnabled");
+    if (_expressionTreeSolveEnabled != enabled) {
+        _expressionTreeSolveEnabled = enabled;
+        invalidateSolveCache();
+    }
+}
+
+bool DCMManager::getExpressionTreeSolveEnabled() const noexcept {
+    return _expressionTreeSolveEnabled;
+}
+
+void DCMManager::setRigidClustersEnabled(bool enabled) noexcept {
+    _rigidClustersEnabled = enabled;
+}
+
+bool DCMManager::getRigidClustersEnabled() const noexcept {
+    return _rigidClustersEnabled;
+}
+
+std::vector<std::vector<Utils::ID>> DCMManager::getRigidClusters(ComponentID componentId) {
+    const Utils::TraceScope trace("DCMManager::getRigidClusters");
+    if (componentId >= _components.size() || _components[componentId].empty()) {
+        return {};
+    }
+
+    const auto& clusterSet = rigidClustersFor(componentId);
+    std::vector<std::vector<Utils::ID>> result;
+    result.reserve(clusterSet.clusters.size());
+    for (const auto& cluster : clusterSet.clusters) {
+        std::vector<Utils::ID> pointIds;
+        for (const auto& [x, y] : cluster.points) {
+            const auto coincident = clusterSet.subsystem->getCoincidentPoints(clusterSet.pointIdOfVar.at(x));
+            pointIds.insert(pointIds.end(), coincident.begin(), coincident.end());
+        }
+        std::sort(pointIds.begin(), pointIds.end(), [](Utils::ID lhs, Utils::ID rhs) {
+            return lhs.id < rhs.id;
+        });
+        result.push_back(std::move(pointIds));
+    }
+    return result;
+}
+
 Utils::SolveMode DCMManager::getSolveMode() const noexcept {
     return _solveMode;
 }
 
 bool DCMManager::solve(std::optional<ComponentID> componentId) {
-    const std::unordered_set<double*> noLockedVars;
-    return solveWithLockedVars(componentId, noLockedVars);
+    const Utils::TraceScope trace("DCMManager::solve");
+    _lastSolveReport.reset();
+    return solveWithLockedVars(componentId, {});
 }
 
-bool DCMManager::solveWithLockedVars(std::optional<ComponentID> componentId,
-                                     const std::unordered_set<double*>& lockedVars) {
+const Utils::SolveReport& DCMManager::getLastSolveReport() const noexcept {
+    return _lastSolveReport;
+}
+
+bool DCMManager::solveDirty() {
+    const Utils::TraceScope trace("DCMManager::solveDirty");
+    _lastSolveReport.reset();
     if (_requirementRecords.empty()) {
+        _dirtyComponents.clear();
         return true;
     }
 
-    if (_solveCache == nullptr) {
-        _solveCache = std::make_unique<SolveCache>();
+    std::vector<ComponentID> targets;
+    for (const ComponentID componentId : getDirtyComponents()) {
+        if (componentId < _components.size() && !_components[componentId].empty()) {
+            targets.push_back(componentId);
+        } else {
+            markSolved(componentId);
+        }
+    }
+    if (targets.empty()) {
+        return true;
+    }
+
+    // Cache lookups and pipeline builds share manager state, so they run here;
+    // components own disjoint geometry, so only the optimizations run concurrently.
+    const std::unordered_set<double*> noLockedVars;
+    std::vector<SolveCacheEntry*> entries;
+    entries.reserve(targets.size());
+    std::vector<ComponentID> pendingTargets;
+    // A target stays dirty until its entry is ready, so a throwing build leaves the rest for the next call.
+    for (const ComponentID componentId : targets) {
+        auto& entry = prepareSolveEntry(componentId, {});
+        auto& system = solveEntrySystem(entry);
+        if (requirementsSatisfied(system, _fixedRequirementTargets)) {
+            finishSatisfiedEntry(entry);
+            markSolved(componentId);
+            continue;
+        }
+        buildSolvePipeline(entry, noLockedVars);
+        markSolved(componentId);
+        pendingTargets.push_back(componentId);
+        entries.push_back(&entry);
+    }
+    if (entries.empty()) {
+        return true;
+    }
+
+    std::vector<SolveEntryOutcome> outcomes(entries.size(), SolveEntryOutcome::ET_NOT_CONVERGED);
+    std::exception_ptr failure;
+    std::atomic<bool> failed{false};
+    std::atomic<std::size_t> nextEntry{0};
+    const auto worker = [&]() {
+        for (std::size_t i = nextEntry++; i < entries.size(); i = nextEntry++) {
+            try {
+                outcomes[i] = runSolveEntryPipeline(*entries[i]);
+            } catch (...) {
+                if (!failed.exchange(true)) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // One pool chunk per thread, each pulling entries until none are left, so a large component
+    // does not hold back the rest. Row loops inside a solve then run inline on that thread.
+    Utils::ThreadPool::shared().parallelFor(entries.size(), 1, [&](std::size_t, std::size_t, std::size_t) {
+        worker();
+    });
+
+    // Numeric rebuilds read manager state, so they and their second run happen here.
+    std::vector<char> converged(entries.size(), 0);
+    for (std::size_t i = 0; i < entries.size() && !failure; ++i) {
+        try {
+            converged[i] = finishSolveEntry(*entries[i], outcomes[i]) ? 1 : 0;
+        } catch (...) {
+            failure = std::current_exception();
+        }
+    }
+    for (const auto* entry : entries) {
+        _lastSolveReport.merge(entry->report);
+    }
+
+    bool allConverged = true;
+    for (std::size_t i = 0; i < pendingTargets.size(); ++i) {
+        if (converged[i] == 0) {
+            markComponentDirty(pendingTargets[i]);
+            allConverged = false;
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return allConverged;
+}
+
+std::vector<ComponentID> DCMManager::getDirtyComponents() const {
+    std::vector<ComponentID> result;
+    for (ComponentID componentId = 0; componentId < _dirtyComponents.size(); ++componentId) {
+        if (_dirtyComponents[componentId] != 0) {
+            result.push_back(componentId);
+        }
     }
+    return result;
+}
+
+Utils::MemoryUsage DCMManager::memoryUsage() const {
+    Utils::MemoryUsage usage;
+    _storage.accumulateMemoryUsage(usage);
+
+    usage.figureRecords = Utils::heapBytes(_figureRecords);
+    for (const auto& [id, descriptor] : _figureRecords) {
+        usage.figureRecords += Utils::heapBytes(descriptor.pointIds) + Utils::heapBytes(descriptor.coords);
+    }
+
+    usage.requirementRecords = Utils::heapBytes(_requirementRecords) + Utils::heapBytes(_fixedRequirementTargets) +
+                               Utils::heapBytes(_requirementOrder);
+    for (const auto& [id, descriptor] : _requirementRecords) {
+        usage.requirementRecords += Utils::heapBytes(descriptor.objectIds);
+    }
+
+    usage.components = Utils::heapBytes(_components) + Utils::heapBytes(_figureToComponent) +
+                       Utils::heapBytes(_dirtyComponents);
+    for (const auto& component : _components) {
+        usage.components += Utils::heapBytes(component);
+    }
+
+    _reqSystem.accumulateMemoryUsage(usage);
+
+    // Subsystems count in full towards the solve cache, their Jacobians included.
+    const auto subsystemBytes = [](const std::unique_ptr<System::RequirementSystem>& subsystem) -> std::size_t {
+        if (subsystem == nullptr) {
+            return 0;
+        }
+        Utils::MemoryUsage inner;
+        subsystem->accumulateMemoryUsage(inner);
+        return sizeof(System::RequirementSystem) + inner.requirementFunctions + inner.jacobian;
+    };
 
-    SolveCacheKey cacheKey;
+    if (_solveCache != nullptr) {
+        std::size_t bytes = sizeof(SolveCache) + Utils::hashNodeBytes(_solveCache->entries) +
+                            Utils::heapBytes(_solveCache->figureRequirements) +
+                            Utils::heapBytes(_solveCache->fixedGeometry.pointIds) +
+                            Utils::heapBytes(_solveCache->fixedGeometry.circleIds) +
+                            Utils::hashNodeBytes(_solveCache->rigidClusters);
+        const auto entryBytes = [&](const SolveCacheEntry& entry) {
+            std::size_t entryTotal = subsystemBytes(entry.subsystem) + Utils::heapBytes(entry.fixedAssignments) +
+                                     Utils::heapBytes(entry.coordinateAliases) +
+                                     Utils::heapBytes(entry.constructionSteps) + entry.variables.heapBytes() +
+                                     Utils::heapBytes(entry.tasks) + Utils::heapBytes(entry.solvers) +
+                                     Utils::heapBytes(entry.iterativeSolvers) + Utils::heapBytes(entry.lockedVars) +
+                                     Utils::heapBytes(entry.report.damping);
+            for (const auto& solver : entry.iterativeSolvers) {
+                entryTotal += sizeof(System::IterativeLMSolver) + solver->heapBytes();
+            }
+            return entryTotal;
+        };
+        for (const auto& [key, entry] : _solveCache->entries) {
+            bytes += Utils::heapBytes(key.lockedVars) + entryBytes(entry);
+        }
+        bytes += Utils::hashNodeBytes(_solveCache->relaxedEntries);
+        for (const auto& [key, entry] : _solveCache->relaxedEntries) {
+            bytes += Utils::heapBytes(key.region) + Utils::heapBytes(key.lockedVars) + entryBytes(entry);
+        }
+        for (const auto& [componentId, clusterSet] : _solveCache->rigidClusters) {
+            bytes += subsystemBytes(clusterSet.subsystem) + Utils::heapBytes(clusterSet.clusters) +
+                     Utils::heapBytes(clusterSet.pointIdOfVar);
+            for (const auto& cluster : clusterSet.clusters) {
+                bytes += Utils::heapBytes(cluster.points) + Utils::heapBytes(cluster.scalars) +
+                         Utils::heapBytes(cluster.internalFunctions);
+            }
+        }
+        usage.solveCache = bytes;
+        usage.solveCacheEntries = _solveCache->entries.size() + _solveCache->relaxedEntries.size();
+    }
+    if (_batchUpdate != nullptr) {
+        usage.solveCache += sizeof(BatchUpdateContext) + Utils::heapBytes(_batchUpdate->edits) +
+                            Utils::heapBytes(_batchUpdate->slotOfComponent);
+        for (const auto& edits : _batchUpdate->edits) {
+            usage.solveCache += Utils::heapBytes(edits.lockedVars) + Utils::heapBytes(edits.editedFigures);
+        }
+    }
+    return usage;
+}
+
+std::optional<ComponentID> DCMManager::resolveSolveTarget(std::optional<ComponentID> componentId) const {
     switch (_solveMode) {
         case Utils::SolveMode::GLOBAL:
-            cacheKey.componentId = std::nullopt;
-            break;
+            return std::nullopt;
         case Utils::SolveMode::LOCAL:
             if (!componentId.has_value()) {
                 throw std::runtime_error("LOCAL mode requires a componentID");
             }
-            cacheKey.componentId = componentId;
-            break;
+            return componentId;
         case Utils::SolveMode::DRAG:
-            cacheKey.componentId = componentId;
-            break;
+            return componentId;
+    }
+    return componentId;
+}
+
+bool DCMManager::solveWithLockedVars(std::optional<ComponentID> componentId,
+                                     const std::vector<Utils::VarHandle>& lockHandles) {
+    if (_requirementRecords.empty()) {
+        return true;
+    }
+
+    const auto target = resolveSolveTarget(componentId);
+    auto& entry = prepareSolveEntry(target, lockHandles);
+
+    // Already-satisfied components (no-op edits, reloaded sketches) skip the LM pipeline entirely.
+    auto& system = solveEntrySystem(entry);
+    if (requirementsSatisfied(system, _fixedRequirementTargets)) {
+        finishSatisfiedEntry(entry);
+        markSolved(target);
+        return true;
+    }
+
+    // A cached pipeline already holds its resolved locks.
+    if (!entry.pipelineReady) {
+        buildSolvePipeline(entry, resolveLocks(lockHandles));
+    }
+    if (entry.hasFunctions && !entry.hasFreeVariables && entry.constructionSteps.empty() &&
+        !entry.lockedVars.empty()) {
+        // If temporary drag locks consume all remaining DOF, retry without locks.
+        // This keeps fixed/eliminated vars constant, but allows the solver
+        // to satisfy constraints by moving the dragged point to a feasible position.
+        _lastSolveReport.phases += entry.report.phases;
+        return solveWithLockedVars(componentId, {});
+    }
+
+    const bool converged = runSolveEntry(entry);
+    _lastSolveReport.merge(entry.report);
+    if (converged) {
+        markSolved(target);
+    }
+    return converged;
+}
+
+std::unordered_set<double*> DCMManager::resolveLocks(const std::vector<Utils::VarHandle>& lockHandles) {
+    std::unordered_set<double*> lockedVars;
+    lockedVars.reserve(lockHandles.size());
+    for (const auto& handle : lockHandles) {
+        if (double* valueRef = _storage.resolve(handle)) {
+            lockedVars.insert(valueRef);
+        }
     }
+    return lockedVars;
+}
+
+DCMManager::SolveCacheEntry& DCMManager::prepareSolveEntry(std::optional<ComponentID> target,
+                                                           const std::vector<Utils::VarHandle>& lockHandles) {
+    if (_solveCache == nullptr) {
+        _solveCache = std::make_unique<SolveCache>();
+    }
+
+    // Drag locks arrive sorted, so steady drag frames look the entry up without copying the handles.
+    std::vector<Utils::VarHandle> sortedHandles;
+    std::span<const Utils::VarHandle> handles = lockHandles;
+    if (!std::is_sorted(handles.begin(), handles.end())) {
+        sortedHandles.assign(handles.begin(), handles.end());
+        std::sort(sortedHandles.begin(), sortedHandles.end());
+        handles = sortedHandles;
+    }
+    const SolveCacheKeyView lookupKey(target, handles);
 
-    cacheKey.lockedVars.assign(lockedVars.begin(), lockedVars.end());
-    std::sort(cacheKey.lockedVars.begin(), cacheKey.lockedVars.end());
+    const Utils::TraceScope trace("solve.subsystemBuild");
+    const auto start = SolveClock::now();
+    auto entryIt = _solveCache->entries.find(lookupKey);
+    const bool hit = entryIt != _solveCache->entries.end() && entryIt->second.version == _solveCache->version;
+    if (!hit) {
+        Utils::traceInstant("solveCacheMiss");
+        SolveCache::Entry entry;
+        entry.version = _solveCache->version;
+        if (target.has_value()) {
+            entry.subsystem = buildSubsystem(target.value());
+        }
+        SolveCacheKey cacheKey{target, {handles.begin(), handles.end()}};
+        entryIt = _solveCache->entries.insert_or_assign(std::move(cacheKey), std::move(entry)).first;
+    }
+    auto& entry = entryIt->second;
+    solveEntrySystem(entry);
 
+    entry.report.reset();
+    entry.report.components = 1;
+    (hit ? entry.report.cacheHits : entry.report.cacheMisses) = 1;
+    entry.report.phases.subsystemBuild = elapsedSince(start);
+    return entry;
+}
+
+System::RequirementSystem& DCMManager::solveEntrySystem(SolveCacheEntry& entry) {
+    if (entry.subsystem != nullptr) {
+        return *entry.subsystem;
+    }
+    syncRequirementSystemIfNeeded();
+    return _reqSystem;
+}
+
+void DCMManager::buildSolvePipeline(SolveCacheEntry& entry, const std::unordered_set<double*>& lockedVars) {
+    if (entry.pipelineReady) {
+        return;
+    }
+    const Utils::TraceScope trace("solve.pipelineBuild");
+    const auto start = SolveClock::now();
+
+    const bool constructive = _constructiveSolveEnabled && entry.constructionEnabled;
     const auto buildPipeline = [&](System::RequirementSystem& system) {
+        OURPAINTDCM_PROBE_SCOPE(ET_BUILD_PIPELINE);
         BuiltSolvePipeline pipeline;
         std::vector<std::unique_ptr<::Function>> mathFunctionOwners;
-        std::vector<double*> mathVariableRefs;
-        std::unordered_set<double*> mathVariableRefSet;
+        auto& variables = pipeline.variables;
+        // Free variable indices of function i are freeIndices[freeStart[i], freeStart[i + 1]).
+        std::vector<std::size_t> freeIndices;
+        std::vector<std::size_t> freeStart{0};
+        CoordinateAliasMap coordinateAliasOf;
+        std::unordered_set<double*> constructedRefs;
 
         const auto rememberVariable = [&](double* valueRef) {
-            if (valueRef != nullptr &&
-                !lockedVars.contains(valueRef) &&
-                !pipeline.fixedAssignments.contains(valueRef) &&
-                mathVariableRefSet.insert(valueRef).second) {
-                mathVariableRefs.push_back(valueRef);
+            if (const auto aliasIt = coordinateAliasOf.find(valueRef); aliasIt != coordinateAliasOf.end()) {
+                valueRef = aliasIt->second;
+            }
+            if (valueRef == nullptr ||
+                lockedVars.contains(valueRef) ||
+                pipeline.fixedAssignments.contains(valueRef) ||
+                constructedRefs.contains(valueRef)) {
+                return;
             }
+            freeIndices.push_back(variables.intern(valueRef));
         };
 
-        const auto appendFunction = [&](std::unique_ptr<::Function> function, std::initializer_list<double*> refs) {
+        const auto appendFunction = [&](std::unique_ptr<::Function> function, std::span<double* const> refs) {
             for (double* ref : refs) {
                 rememberVariable(ref);
             }
+            freeStart.push_back(freeIndices.size());
             mathFunctionOwners.push_back(std::move(function));
         };
 
@@ -1157,399 +2573,798 @@ bool DCMManager::solveWithLockedVars(std::optional<ComponentID> componentId,
             return std::pair{system.resolvePoint(dependencies[0]), system.resolvePoint(dependencies[1])};
         };
 
-        const auto resolveCircleData = [&](Utils::ID circleId) {
-            auto* circle = _storage.get<Figures::Circle2D>(circleId);
-            const auto dependencies = _storage.getDependencies(circleId);
-            if (circle == nullptr || dependencies.size() != 1) {
-                throw std::runtime_error("Circle dependencies are inconsistent");
+        for (const auto& entry : system.getRequirements()) {
+            Requirements::visitRequirementType(entry.type, [&](auto tag) {
+                using Tag = decltype(tag);
+                if constexpr (Tag::rows == Requirements::RowKind::Fix) {
+                    const auto refs = system.requirementVariables<Tag>(entry.objectIds);
+                    const auto targets = fixTargetsFor(refs, _fixedRequirementTargets, entry.id);
+                    for (std::size_t k = 0; k < refs.size(); ++k) {
+                        pipeline.fixedAssignments[refs[k]] = targets[k];
+                    }
+                }
+            });
+        }
+
+        // Linear presolve. Horizontal and vertical lines are equalities between single
+        // coordinates, so every class they connect collapses onto one variable: a fixed
+        // target or a drag-locked value when the class has one, any member otherwise.
+        // Classes with contradicting pinned values keep their residuals so the solve
+        // still reports the conflict.
+        std::unordered_map<double*, double*> coordinateParent;
+        const auto findCoordinateRoot = [&](double* valueRef) {
+            for (auto it = coordinateParent.find(valueRef);
+                 it != coordinateParent.end() && it->second != valueRef;
+                 it = coordinateParent.find(valueRef)) {
+                valueRef = it->second;
             }
-            return std::pair{system.resolvePoint(dependencies[0]), circle->ptrRadius()};
+            return valueRef;
         };
-
-        const auto resolveArcPoints = [&](Utils::ID arcId) {
-            const auto dependencies = _storage.getDependencies(arcId);
-            if (dependencies.size() != 3) {
-                throw std::runtime_error("Arc dependencies are inconsistent");
+        const auto uniteCoordinates = [&](double* first, double* second) {
+            coordinateParent.try_emplace(first, first);
+            coordinateParent.try_emplace(second, second);
+            double* firstRoot = findCoordinateRoot(first);
+            double* secondRoot = findCoordinateRoot(second);
+            if (firstRoot != secondRoot) {
+                coordinateParent[secondRoot] = firstRoot;
             }
-            return std::tuple{
-                system.resolvePoint(dependencies[0]),
-                system.resolvePoint(dependencies[1]),
-                system.resolvePoint(dependencies[2])};
         };
 
         for (const auto& entry : system.getRequirements()) {
-            const auto& ids = entry.objectIds;
-            switch (entry.type) {
-                case Utils::RequirementType::ET_FIXPOINT: {
-                    auto* point = system.resolvePoint(ids[0]);
-                    std::vector<double> targets = {point->x(), point->y()};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 2) {
-                        targets = targetIt->second;
-                    }
-                    pipeline.fixedAssignments[point->ptrX()] = targets[0];
-                    pipeline.fixedAssignments[point->ptrY()] = targets[1];
-                    break;
+            Requirements::visitRequirementType(entry.type, [&](auto tag) {
+                using Tag = decltype(tag);
+                if constexpr (Tag::axisCoordinate >= 0) {
+                    const auto refs = system.requirementVariables<Tag>(entry.objectIds);
+                    uniteCoordinates(refs[Tag::axisCoordinate], refs[Tag::axisCoordinate + 2]);
                 }
-                case Utils::RequirementType::ET_FIXLINE: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    std::vector<double> targets = {lineP1->x(), lineP1->y(), lineP2->x(), lineP2->y()};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 4) {
-                        targets = targetIt->second;
-                    }
-                    pipeline.fixedAssignments[lineP1->ptrX()] = targets[0];
-                    pipeline.fixedAssignments[lineP1->ptrY()] = targets[1];
-                    pipeline.fixedAssignments[lineP2->ptrX()] = targets[2];
-                    pipeline.fixedAssignments[lineP2->ptrY()] = targets[3];
+            });
+        }
+
+        std::unordered_map<double*, std::vector<double*>> coordinateClasses;
+        for (const auto& [valueRef, _] : coordinateParent) {
+            coordinateClasses[findCoordinateRoot(valueRef)].push_back(valueRef);
+        }
+
+        std::unordered_set<double*> conflictedCoordinateRoots;
+        for (const auto& [root, members] : coordinateClasses) {
+            double* pinned = nullptr;
+            std::optional<double> fixedTarget;
+            bool conflict = false;
+            for (double* member : members) {
+                const auto fixedIt = pipeline.fixedAssignments.find(member);
+                const bool isFixed = fixedIt != pipeline.fixedAssignments.end();
+                if (!isFixed && !lockedVars.contains(member)) {
+                    continue;
+                }
+                const double value = isFixed ? fixedIt->second : *member;
+                // Pinned values that agree up to rounding (e.g. recomputed fix targets) are not a conflict.
+                if (pinned != nullptr &&
+                    std::abs(value - (fixedTarget.has_value() ? fixedTarget.value() : *pinned)) >
+                        kSatisfiedResidualTolerance) {
+                    conflict = true;
                     break;
                 }
-                case Utils::RequirementType::ET_FIXCIRCLE: {
-                    const auto [center, radius] = resolveCircleData(ids[0]);
-                    std::vector<double> targets = {center->x(), center->y(), *radius};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 3) {
-                        targets = targetIt->second;
+                if (pinned == nullptr || isFixed) {
+                    pinned = member;
+                    if (isFixed) {
+                        fixedTarget = value;
                     }
-                    pipeline.fixedAssignments[center->ptrX()] = targets[0];
-                    pipeline.fixedAssignments[center->ptrY()] = targets[1];
-                    pipeline.fixedAssignments[radius] = targets[2];
-                    break;
                 }
-                default:
-                    break;
+            }
+
+            if (conflict) {
+                conflictedCoordinateRoots.insert(root);
+                continue;
+            }
+
+            double* representative = pinned != nullptr ? pinned : members.front();
+            for (double* member : members) {
+                if (fixedTarget.has_value()) {
+                    pipeline.fixedAssignments[member] = fixedTarget.value();
+                } else if (member != representative) {
+                    coordinateAliasOf[member] = representative;
+                    pipeline.coordinateAliases.emplace_back(member, representative);
+                }
             }
         }
 
+        const auto eliminatedByPresolve = [&](double* valueRef) {
+            return !conflictedCoordinateRoots.contains(findCoordinateRoot(valueRef));
+        };
+
         for (const auto& [valueRef, target] : pipeline.fixedAssignments) {
             *valueRef = target;
         }
 
-        for (const auto& entry : system.getRequirements()) {
-            const auto& ids = entry.objectIds;
-
-            switch (entry.type) {
-                case Utils::RequirementType::ET_POINTLINEDIST: {
-                    auto* point = system.resolvePoint(ids[0]);
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new PointSectionDistanceError(
-                            makeMathVariables({
-                                point->ptrX(), point->ptrY(),
-                                lineP1->ptrX(), lineP1->ptrY(),
-                                lineP2->ptrX(), lineP2->ptrY()}),
-                            entry.param.value())),
-                        {
-                            point->ptrX(), point->ptrY(),
-                            lineP1->ptrX(), lineP1->ptrY(),
-                            lineP2->ptrX(), lineP2->ptrY()});
-                    break;
+        // Constructive stage. Starting from fixed and locked points, a point with two
+        // requirements on known geometry (distances from known points, incidence with known
+        // lines) is placed in closed form and becomes a constant for the numeric solve, which
+        // then only sees the cyclic cores. Coordinates tied by the linear presolve stay numeric.
+        if (constructive) {
+            using Point = Figures::Point2D;
+            const auto coordinateKnown = [&](double* valueRef) {
+                if (const auto aliasIt = coordinateAliasOf.find(valueRef); aliasIt != coordinateAliasOf.end()) {
+                    valueRef = aliasIt->second;
                 }
-                case Utils::RequirementType::ET_POINTONLINE: {
-                    auto* point = system.resolvePoint(ids[0]);
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new PointOnSectionError(
-                            makeMathVariables({
-                                point->ptrX(), point->ptrY(),
-                                lineP1->ptrX(), lineP1->ptrY(),
-                                lineP2->ptrX(), lineP2->ptrY()}))),
-                        {
-                            point->ptrX(), point->ptrY(),
-                            lineP1->ptrX(), lineP1->ptrY(),
-                            lineP2->ptrX(), lineP2->ptrY()});
-                    break;
+                return lockedVars.contains(valueRef) ||
+                       pipeline.fixedAssignments.contains(valueRef) ||
+                       constructedRefs.contains(valueRef);
+            };
+            const auto pointKnown = [&](Point* point) {
+                return coordinateKnown(point->ptrX()) && coordinateKnown(point->ptrY());
+            };
+            const auto placeable = [&](Point* point) {
+                return !coordinateParent.contains(point->ptrX()) && !coordinateParent.contains(point->ptrY()) &&
+                       !coordinateKnown(point->ptrX()) && !coordinateKnown(point->ptrY());
+            };
+
+            struct PendingLocus {
+                ConstructionLocus locus;
+                Point* first;
+                Point* second;
+            };
+            std::unordered_map<Point*, std::vector<PendingLocus>> lociOf;
+            std::unordered_map<Point*, std::vector<Point*>> dependentsOf;
+            std::vector<Point*> queue;
+            const auto addLocus = [&](Point* point, PendingLocus pending) {
+                if (!placeable(point)) {
+                    return;
                 }
-                case Utils::RequirementType::ET_POINTPOINTDIST: {
-                    auto* p1 = system.resolvePoint(ids[0]);
-                    auto* p2 = system.resolvePoint(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new PointPointDistanceError(
-                            makeMathVariables({p1->ptrX(), p1->ptrY(), p2->ptrX(), p2->ptrY()}),
-                            entry.param.value())),
-                        {p1->ptrX(), p1->ptrY(), p2->ptrX(), p2->ptrY()});
-                    break;
+                auto& loci = lociOf[point];
+                if (loci.empty()) {
+                    queue.push_back(point);
                 }
-                case Utils::RequirementType::ET_POINTONPOINT:
-                    break;
-                case Utils::RequirementType::ET_LINECIRCLEDIST: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    const auto [center, radius] = resolveCircleData(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionCircleDistanceError(
-                            makeMathVariables({
-                                lineP1->ptrX(), lineP1->ptrY(),
-                                lineP2->ptrX(), lineP2->ptrY(),
-                                center->ptrX(), center->ptrY(),
-                                radius}),
-                            entry.param.value())),
-                        {
-                            lineP1->ptrX(), lineP1->ptrY(),
-                            lineP2->ptrX(), lineP2->ptrY(),
-                            center->ptrX(), center->ptrY(),
-                            radius});
-                    break;
+                dependentsOf[pending.first].push_back(point);
+                if (pending.second != nullptr) {
+                    dependentsOf[pending.second].push_back(point);
                 }
-                case Utils::RequirementType::ET_LINEONCIRCLE: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    const auto [center, radius] = resolveCircleData(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionOnCircleError(
-                            makeMathVariables({
-                                lineP1->ptrX(), lineP1->ptrY(),
-                                lineP2->ptrX(), lineP2->ptrY(),
-                                center->ptrX(), center->ptrY(),
-                                radius}))),
-                        {
-                            lineP1->ptrX(), lineP1->ptrY(),
-                            lineP2->ptrX(), lineP2->ptrY(),
-                            center->ptrX(), center->ptrY(),
-                            radius});
-                    break;
-                }
-                case Utils::RequirementType::ET_LINEINCIRCLE: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    const auto [center, radius] = resolveCircleData(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionInCircleError(
-                            makeMathVariables({
-                                lineP1->ptrX(), lineP1->ptrY(),
-                                lineP2->ptrX(), lineP2->ptrY(),
-                                center->ptrX(), center->ptrY(),
-                                radius}))),
-                        {
-                            lineP1->ptrX(), lineP1->ptrY(),
-                            lineP2->ptrX(), lineP2->ptrY(),
-                            center->ptrX(), center->ptrY(),
-                            radius});
-                    break;
-                }
-                case Utils::RequirementType::ET_LINELINEPARALLEL: {
-                    const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                    const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionSectionParallelError(
-                            makeMathVariables({
-                                l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                                l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()}))),
-                        {
-                            l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                            l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()});
-                    break;
-                }
-                case Utils::RequirementType::ET_LINELINEPERPENDICULAR: {
-                    const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                    const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionSectionPerpendicularError(
-                            makeMathVariables({
-                                l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                                l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()}))),
-                        {
-                            l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                            l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()});
-                    break;
-                }
-                case Utils::RequirementType::ET_LINELINEANGLE: {
-                    const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                    const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new SectionSectionAngleError(
-                            makeMathVariables({
-                                l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                                l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()}),
-                            entry.param.value())),
-                        {
-                            l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-                            l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()});
-                    break;
-                }
-                case Utils::RequirementType::ET_VERTICAL: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new VerticalError(
-                            makeMathVariables({lineP1->ptrX(), lineP1->ptrY(), lineP2->ptrX(), lineP2->ptrY()}))),
-                        {lineP1->ptrX(), lineP1->ptrY(), lineP2->ptrX(), lineP2->ptrY()});
-                    break;
+                loci.push_back(pending);
+            };
+
+            for (const auto& entry : system.getRequirements()) {
+                if (entry.type == Utils::RequirementType::ET_POINTPOINTDIST) {
+                    auto* p1 = system.resolvePoint(entry.objectIds[0]);
+                    auto* p2 = system.resolvePoint(entry.objectIds[1]);
+                    if (p1 == p2) {
+                        continue;
+                    }
+                    const double distance = entry.param.value();
+                    addLocus(p1, {{true, p2->ptrX(), p2->ptrY(), nullptr, nullptr, distance}, p2, nullptr});
+                    addLocus(p2, {{true, p1->ptrX(), p1->ptrY(), nullptr, nullptr, distance}, p1, nullptr});
+                } else if (entry.type == Utils::RequirementType::ET_POINTONLINE) {
+                    auto* point = system.resolvePoint(entry.objectIds[0]);
+                    const auto [lineP1, lineP2] = resolveLinePoints(entry.objectIds[1]);
+                    if (point == lineP1 || point == lineP2) {
+                        continue;
+                    }
+                    addLocus(point, {{false, lineP1->ptrX(), lineP1->ptrY(), lineP2->ptrX(), lineP2->ptrY(), 0.0},
+                                     lineP1, lineP2});
                 }
-                case Utils::RequirementType::ET_HORIZONTAL: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new HorizontalError(
-                            makeMathVariables({lineP1->ptrX(), lineP1->ptrY(), lineP2->ptrX(), lineP2->ptrY()}))),
-                        {lineP1->ptrX(), lineP1->ptrY(), lineP2->ptrX(), lineP2->ptrY()});
-                    break;
+            }
+
+            const auto sameLocus = [](const PendingLocus& lhs, const PendingLocus& rhs) {
+                if (lhs.locus.circle != rhs.locus.circle) {
+                    return false;
                 }
-                case Utils::RequirementType::ET_ARCCENTERONPERPENDICULAR: {
-                    const auto [arcP1, arcP2, center] = resolveArcPoints(ids[0]);
-                    appendFunction(
-                        std::unique_ptr<::Function>(new ArcCenterOnPerpendicularError(
-                            makeMathVariables({
-                                arcP1->ptrX(), arcP1->ptrY(),
-                                arcP2->ptrX(), arcP2->ptrY(),
-                                center->ptrX(), center->ptrY()}))),
-                        {
-                            arcP1->ptrX(), arcP1->ptrY(),
-                            arcP2->ptrX(), arcP2->ptrY(),
-                            center->ptrX(), center->ptrY()});
-                    break;
+                return lhs.locus.circle ? lhs.first == rhs.first
+                                        : (lhs.first == rhs.first && lhs.second == rhs.second) ||
+                                              (lhs.first == rhs.second && lhs.second == rhs.first);
+            };
+
+            while (!queue.empty()) {
+                Point* point = queue.back();
+                queue.pop_back();
+                if (!placeable(point)) {
+                    continue;
                 }
-                case Utils::RequirementType::ET_FIXPOINT: {
-                    auto* point = system.resolvePoint(ids[0]);
-                    std::vector<double> targets = {point->x(), point->y()};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 2) {
-                        targets = targetIt->second;
+
+                const PendingLocus* first = nullptr;
+                const PendingLocus* second = nullptr;
+                for (const auto& pending : lociOf[point]) {
+                    if (!pointKnown(pending.first) || (pending.second != nullptr && !pointKnown(pending.second))) {
+                        continue;
                     }
-                    appendFunction(makeFixResidual(point->ptrX(), targets[0]), {point->ptrX()});
-                    appendFunction(makeFixResidual(point->ptrY(), targets[1]), {point->ptrY()});
-                    break;
-                }
-                case Utils::RequirementType::ET_FIXLINE: {
-                    const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                    std::vector<double> targets = {lineP1->x(), lineP1->y(), lineP2->x(), lineP2->y()};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 4) {
-                        targets = targetIt->second;
+                    if (first == nullptr) {
+                        first = &pending;
+                    } else if (!sameLocus(*first, pending)) {
+                        second = &pending;
+                        break;
                     }
-                    appendFunction(makeFixResidual(lineP1->ptrX(), targets[0]), {lineP1->ptrX()});
-                    appendFunction(makeFixResidual(lineP1->ptrY(), targets[1]), {lineP1->ptrY()});
-                    appendFunction(makeFixResidual(lineP2->ptrX(), targets[2]), {lineP2->ptrX()});
-                    appendFunction(makeFixResidual(lineP2->ptrY(), targets[3]), {lineP2->ptrY()});
-                    break;
                 }
-                case Utils::RequirementType::ET_FIXCIRCLE: {
-                    const auto [center, radius] = resolveCircleData(ids[0]);
-                    std::vector<double> targets = {center->x(), center->y(), *radius};
-                    const auto targetIt = _fixedRequirementTargets.find(entry.id);
-                    if (targetIt != _fixedRequirementTargets.end() && targetIt->second.size() == 3) {
-                        targets = targetIt->second;
-                    }
-                    appendFunction(makeFixResidual(center->ptrX(), targets[0]), {center->ptrX()});
-                    appendFunction(makeFixResidual(center->ptrY(), targets[1]), {center->ptrY()});
-                    appendFunction(makeFixResidual(radius, targets[2]), {radius});
-                    break;
+                if (second == nullptr) {
+                    continue;
                 }
+
+                pipeline.constructionSteps.push_back({first->locus, second->locus, point->ptrX(), point->ptrY()});
+                constructedRefs.insert(point->ptrX());
+                constructedRefs.insert(point->ptrY());
+                if (const auto dependentsIt = dependentsOf.find(point); dependentsIt != dependentsOf.end()) {
+                    queue.insert(queue.end(), dependentsIt->second.begin(), dependentsIt->second.end());
+                }
+            }
+        }
+
+        // Residual rows of the in-tree solver: the system's requirement functions without the
+        // fix rows, whose targets are assigned above, and without the rows the presolve removed.
+        std::vector<std::shared_ptr<Function::RequirementFunction>> residualFunctions;
+        residualFunctions.reserve(system.getFunctions().size());
+        bool hasFixRows = false;
+        for (const auto& function : system.getFunctions()) {
+            if (isFixRequirement(function->getType())) {
+                hasFixRows = true;
+                continue;
+            }
+            const auto vars = function->getVars();
+            int axisCoordinate = -1;
+            Requirements::visitRequirementType(function->getType(), [&](auto tag) {
+                axisCoordinate = decltype(tag)::axisCoordinate;
+            });
+            if (axisCoordinate >= 0) {
+                if (eliminatedByPresolve(vars[axisCoordinate])) {
+                    continue;
+                }
+                VAR first = vars[axisCoordinate];
+                VAR second = vars[axisCoordinate + 2];
+                rememberVariable(first);
+                rememberVariable(second);
+                freeStart.push_back(freeIndices.size());
+                residualFunctions.push_back(
+                    std::make_shared<CoordinateDifferenceFunction>(function->getType(), first, second));
+                continue;
+            }
+            for (double* ref : vars) {
+                rememberVariable(ref);
             }
+            freeStart.push_back(freeIndices.size());
+            residualFunctions.push_back(function);
         }
 
-        pipeline.hasFunctions = !mathFunctionOwners.empty();
+        pipeline.hasFunctions = hasFixRows || !residualFunctions.empty();
         if (!pipeline.hasFunctions) {
             return pipeline;
         }
 
-        pipeline.hasFreeVariables = !mathVariableRefs.empty();
+        pipeline.hasFreeVariables = !variables.empty();
         if (!pipeline.hasFreeVariables) {
             return pipeline;
         }
 
-        std::vector<::Function*> mathFuncs;
-        mathFuncs.reserve(mathFunctionOwners.size());
-        for (auto& owner : mathFunctionOwners) {
-            mathFuncs.push_back(owner.release());
+        if (_expressionTreeSolveEnabled && variables.size() < _iterativeSolveThreshold) {
+            freeIndices.clear();
+            freeStart.assign(1, 0);
+            for (const auto& entry : system.getRequirements()) {
+                Requirements::visitRequirementType(entry.type, [&](auto tag) {
+                    using Tag = decltype(tag);
+                    if constexpr (Tag::rows == Requirements::RowKind::Coincidence) {
+                        return;
+                    } else if constexpr (Tag::rows == Requirements::RowKind::Fix) {
+                        const auto refs = system.requirementVariables<Tag>(entry.objectIds);
+                        const auto targets = fixTargetsFor(refs, _fixedRequirementTargets, entry.id);
+                        for (std::size_t k = 0; k < refs.size(); ++k) {
+                            appendFunction(makeFixResidual(refs[k], targets[k]), std::span(&refs[k], 1));
+                        }
+                    } else {
+                        const auto refs = system.requirementVariables<Tag>(entry.objectIds);
+                        if constexpr (Tag::axisCoordinate >= 0) {
+                            if (eliminatedByPresolve(refs[Tag::axisCoordinate])) {
+                                return;
+                            }
+                        }
+                        appendFunction(
+                            std::unique_ptr<::Function>(Requirements::makeErrorKernel<Tag>(
+                                makeMathVariables(coordinateAliasOf, refs),
+                                Tag::hasParam ? entry.param.value() : 0.0)),
+                            refs);
+                    }
+                });
+            }
+
+            const auto split = splitIntoBlocks(variables.size(), freeIndices, freeStart);
+            std::vector<std::vector<::Function*>> blockFuncs(split.blockCount);
+            std::vector<std::vector<Variable*>> blockVars(split.blockCount);
+            for (std::size_t i = 0; i < variables.size(); ++i) {
+                blockVars[split.blockOfVariable[i]].push_back(variables.variable(i));
+            }
+            for (std::size_t i = 0; i < mathFunctionOwners.size(); ++i) {
+                blockFuncs[split.blockOfFunction[i]].push_back(mathFunctionOwners[i].release());
+            }
+
+            pipeline.tasks.reserve(split.blockCount);
+            for (std::size_t block = 0; block < split.blockCount; ++block) {
+                pipeline.tasks.push_back(
+                    std::make_unique<SparseLSMTask>(std::move(blockFuncs[block]), std::move(blockVars[block])));
+            }
+            return pipeline;
         }
 
-        std::vector<Variable*> mathVars;
-        pipeline.variableOwners.reserve(mathVariableRefs.size());
-        mathVars.reserve(mathVariableRefs.size());
-        for (double* valueRef : mathVariableRefs) {
-            pipeline.variableOwners.push_back(std::make_unique<Variable>(valueRef));
-            mathVars.push_back(pipeline.variableOwners.back().get());
+        // One Levenberg-Marquardt solve per block, evaluating residuals and the Jacobian on the
+        // thread pool: block Cholesky steps, or matrix-free conjugate gradients for very large systems.
+        const auto split = splitIntoBlocks(variables.size(), freeIndices, freeStart);
+        std::vector<std::vector<std::shared_ptr<Function::RequirementFunction>>> blockFunctions(split.blockCount);
+        std::vector<std::vector<VAR>> blockVariables(split.blockCount);
+        std::vector<std::vector<std::pair<VAR, VAR>>> blockPoints(split.blockCount);
+        std::vector<std::vector<std::pair<VAR, VAR>>> blockAliases(split.blockCount);
+        for (std::size_t i = 0; i < variables.size(); ++i) {
+            blockVariables[split.blockOfVariable[i]].push_back(variables.refs()[i]);
+        }
+        for (std::size_t i = 0; i < residualFunctions.size(); ++i) {
+            const std::size_t block = split.blockOfFunction[i];
+            // Requirement functions list their points as consecutive (x, y) pairs.
+            const auto vars = residualFunctions[i]->getVars();
+            for (std::size_t k = 0; k + 1 < vars.size(); k += 2) {
+                blockPoints[block].emplace_back(vars[k], vars[k + 1]);
+            }
+            blockFunctions[block].push_back(std::move(residualFunctions[i]));
+        }
+        // Members of constant representatives are written once per solve by executeSolvePipeline().
+        for (const auto& alias : pipeline.coordinateAliases) {
+            if (variables.contains(alias.second)) {
+                blockAliases[split.blockOfVariable[variables.indexOf(alias.second)]].push_back(alias);
+            }
         }
 
-        pipeline.task = std::make_unique<SparseLSMTask>(std::move(mathFuncs), std::move(mathVars));
+        System::IterativeLMSolver::Options options;
+        options.innerSolver = variables.size() >= _iterativeSolveThreshold
+                                  ? System::IterativeLMSolver::InnerSolver::ConjugateGradient
+                                  : System::IterativeLMSolver::InnerSolver::BlockCholesky;
+        options.tolerance = kSatisfiedResidualTolerance;
+        pipeline.iterativeSolvers.reserve(split.blockCount);
+        for (std::size_t block = 0; block < split.blockCount; ++block) {
+            auto solver = std::make_unique<System::IterativeLMSolver>(std::move(blockFunctions[block]),
+                                                                      std::move(blockVariables[block]),
+                                                                      blockPoints[block],
+                                                                      std::move(blockAliases[block]));
+            solver->setOptions(options);
+            pipeline.iterativeSolvers.push_back(std::move(solver));
+        }
         return pipeline;
     };
 
-    auto entryIt = _solveCache->entries.find(cacheKey);
-    if (entryIt == _solveCache->entries.end() || entryIt->second.version != _solveCache->version) {
-        SolveCache::Entry entry;
-        entry.version = _solveCache->version;
-
-        System::RequirementSystem* buildSystem = nullptr;
-        if (cacheKey.componentId.has_value()) {
-            entry.subsystem = buildSubsystem(cacheKey.componentId.value());
-            buildSystem = entry.subsystem.get();
-        } else {
-            syncRequirementSystemIfNeeded();
-            buildSystem = &_reqSystem;
-        }
+    auto pipeline = buildPipeline(solveEntrySystem(entry));
+    entry.fixedAssignments = std::move(pipeline.fixedAssignments);
+    entry.coordinateAliases = std::move(pipeline.coordinateAliases);
+    entry.constructionSteps = std::move(pipeline.constructionSteps);
+    entry.lockedVars = lockedVars;
+    entry.variables = std::move(pipeline.variables);
+    entry.tasks = std::move(pipeline.tasks);
+    entry.iterativeSolvers = std::move(pipeline.iterativeSolvers);
+    entry.hasFunctions = pipeline.hasFunctions;
+    entry.hasFreeVariables = pipeline.hasFreeVariables;
+    entry.solvers.clear();
+    for (std::size_t i = 0; i < entry.tasks.size(); ++i) {
+        entry.solvers.push_back(std::make_unique<SparseLMSolver>());
+    }
+    entry.pipelineReady = true;
+    entry.report.phases.pipelineBuild += elapsedSince(start);
+}
+
+void DCMManager::finishSatisfiedEntry(SolveCacheEntry& entry) {
+    auto& system = solveEntrySystem(entry);
+    auto& report = entry.report;
+    report.termination = Utils::SolveTermination::ET_ALREADY_SATISFIED;
+    report.requirements = system.getRequirements().size();
+    report.residuals = system.getFunctions().size();
+    report.initialResidualNorm = residualNorm(system, _fixedRequirementTargets);
+    report.finalResidualNorm = report.initialResidualNorm;
+
+    const auto start = SolveClock::now();
+    system.synchronizeCoincidentPoints();
+    report.phases.coincidentSync += elapsedSince(start);
+    _lastSolveReport.merge(report);
+}
 
-        auto pipeline = buildPipeline(*buildSystem);
-        entry.fixedAssignments = std::move(pipeline.fixedAssignments);
-        entry.variableOwners = std::move(pipeline.variableOwners);
-        entry.task = std::move(pipeline.task);
-        entry.hasFunctions = pipeline.hasFunctions;
-        entry.hasFreeVariables = pipeline.hasFreeVariables;
-        if (entry.task != nullptr) {
-            entry.solver = std::make_unique<SparseLMSolver>();
-        }
+bool DCMManager::runSolveEntry(SolveCacheEntry& entry) {
+    return finishSolveEntry(entry, runSolveEntryPipeline(entry));
+}
 
-        entryIt = _solveCache->entries.insert_or_assign(std::move(cacheKey), std::move(entry)).first;
+DCMManager::SolveEntryOutcome DCMManager::runSolveEntryPipeline(SolveCacheEntry& entry) {
+    auto& system = solveEntrySystem(entry);
+    auto& report = entry.report;
+    report.requirements = system.getRequirements().size();
+    report.residuals = system.getFunctions().size();
+    if (system.getRequirements().empty()) {
+        system.synchronizeCoincidentPoints();
+        return SolveEntryOutcome::ET_CONVERGED;
     }
+    report.initialResidualNorm = residualNorm(system, _fixedRequirementTargets);
 
-    auto& entry = entryIt->second;
-    System::RequirementSystem* systemPtr = nullptr;
-    if (entry.subsystem != nullptr) {
-        systemPtr = entry.subsystem.get();
-    } else {
-        syncRequirementSystemIfNeeded();
-        systemPtr = &_reqSystem;
+    if (executeSolvePipeline(entry)) {
+        return SolveEntryOutcome::ET_CONVERGED;
     }
+    return entry.constructionSteps.empty() ? SolveEntryOutcome::ET_NOT_CONVERGED
+                                           : SolveEntryOutcome::ET_NEEDS_NUMERIC_REBUILD;
+}
 
-    auto& system = *systemPtr;
-    if (system.getRequirements().empty() || !entry.hasFunctions) {
-        system.synchronizeCoincidentPoints();
+bool DCMManager::finishSolveEntry(SolveCacheEntry& entry, SolveEntryOutcome outcome) {
+    auto& system = solveEntrySystem(entry);
+    if (system.getRequirements().empty()) {
         return true;
     }
 
-    for (const auto& [valueRef, target] : entry.fixedAssignments) {
-        *valueRef = target;
+    bool converged = outcome == SolveEntryOutcome::ET_CONVERGED;
+    if (outcome == SolveEntryOutcome::ET_NEEDS_NUMERIC_REBUILD) {
+        // A branch choice or an empty intersection left the constructed points off their
+        // requirements; solve this entry fully numerically from now on.
+        entry.constructionEnabled = false;
+        entry.pipelineReady = false;
+        const auto lockedVars = entry.lockedVars;
+        buildSolvePipeline(entry, lockedVars);
+        converged = executeSolvePipeline(entry);
     }
 
-    if (!entry.hasFreeVariables) {
-        // If temporary drag locks consume all remaining DOF, retry without locks.
-        // This keeps fixed/eliminated vars constant, but allows the solver
-        // to satisfy constraints by moving the dragged point to a feasible position.
-        if (!lockedVars.empty()) {
-            const std::unordered_set<double*> noLockedVars;
-            return solveWithLockedVars(componentId, noLockedVars);
+    auto& report = entry.report;
+    report.finalResidualNorm = residualNorm(system, _fixedRequirementTargets);
+    report.termination = converged ? Utils::SolveTermination::ET_CONVERGED
+                                   : Utils::SolveTermination::ET_NOT_CONVERGED;
+    return converged;
+}
+
+bool DCMManager::executeSolvePipeline(SolveCacheEntry& entry) {
+    auto& system = solveEntrySystem(entry);
+    auto& report = entry.report;
+
+    const auto applyCoordinateAliases = [&entry]() {
+        for (const auto& [member, representative] : entry.coordinateAliases) {
+            *member = *representative;
         }
+    };
+    const auto synchronize = [&]() {
+        const Utils::TraceScope trace("solve.coincidentSync");
+        const auto start = SolveClock::now();
+        applyCoordinateAliases();
         system.synchronizeCoincidentPoints();
-        return true;
+        report.phases.coincidentSync += elapsedSince(start);
+    };
+
+    {
+        const Utils::TraceScope trace("solve.fixedAssignment");
+        const auto assignStart = SolveClock::now();
+        for (const auto& [valueRef, target] : entry.fixedAssignments) {
+            *valueRef = target;
+        }
+
+        if (!entry.constructionSteps.empty()) {
+            applyCoordinateAliases();
+            for (const auto& step : entry.constructionSteps) {
+                placeConstructedPoint(step);
+            }
+        }
+        report.phases.fixedAssignment += elapsedSince(assignStart);
     }
 
-    entry.solver->setTask(entry.task.get());
-    entry.solver->optimize();
-    const bool converged = entry.solver->isConverged();
-    system.synchronizeCoincidentPoints();
+    if (!entry.hasFreeVariables) {
+        synchronize();
+        // Constructed points are checked here; without them nothing can be moved anyway.
+        return entry.constructionSteps.empty() || requirementsSatisfied(system, _fixedRequirementTargets);
+    }
 
+    bool converged = true;
+    {
+        const Utils::TraceScope trace("solve.optimize");
+        const auto optimizeStart = SolveClock::now();
+        if (!entry.iterativeSolvers.empty()) {
+            applyCoordinateAliases();
+        }
+        for (const auto& solver : entry.iterativeSolvers) {
+            {
+                OURPAINTDCM_PROBE_SCOPE(ET_OPTIMIZE);
+                converged = solver->solve() && converged;
+            }
+            report.iterations += solver->getIterationCount();
+            report.innerIterations += solver->getInnerIterationCount();
+            const auto& damping = solver->getDampingHistory();
+            report.damping.insert(report.damping.end(), damping.begin(), damping.end());
+        }
+        report.freeVariables = entry.variables.size();
+        report.blocks = entry.iterativeSolvers.size() + entry.tasks.size();
+        for (std::size_t i = 0; i < entry.tasks.size(); ++i) {
+            entry.solvers[i]->setTask(entry.tasks[i].get());
+            {
+                OURPAINTDCM_PROBE_SCOPE(ET_OPTIMIZE);
+                entry.solvers[i]->optimize();
+            }
+            converged = entry.solvers[i]->isConverged() && converged;
+        }
+        report.phases.optimize += elapsedSince(optimizeStart);
+    }
+    synchronize();
     return converged;
 }
 
+bool DCMManager::solveRelaxed(ComponentID componentId,
+                              const std::vector<Utils::ID>& seeds,
+                              const std::vector<Utils::VarHandle>& lockHandles) {
+    const std::size_t componentSize =
+        componentId < _components.size() ? _components[componentId].size() : 0;
+    std::vector<Utils::VarHandle> sortedHandles(lockHandles.begin(), lockHandles.end());
+    std::sort(sortedHandles.begin(), sortedHandles.end());
+
+    std::size_t previousRegionSize = 0;
+    for (std::size_t hops = _relaxationHops; hops > 0; hops *= 2) {
+        const auto region = collectRelaxationRegion(seeds, hops);
+        if (region.size() >= componentSize || region.size() == previousRegionSize) {
+            break;
+        }
+        previousRegionSize = region.size();
+
+        // Regions are cached like component entries, so steady k-hop drag frames reuse the
+        // subsystem and pipeline until the topology changes.
+        const auto buildStart = SolveClock::now();
+        RelaxedRegionKey key{{region.begin(), region.end()}, sortedHandles};
+        std::sort(key.region.begin(), key.region.end());
+        auto [entryIt, inserted] = _solveCache->relaxedEntries.try_emplace(std::move(key));
+        auto& entry = entryIt->second;
+        if (inserted) {
+            Utils::traceInstant("solveCacheMiss");
+            const Utils::TraceScope trace("solve.subsystemBuild");
+            // The region system holds every requirement touching the region, so boundary
+            // requirements are solved too, but only against variables owned by the region.
+            std::vector<Utils::ID> reqIds;
+            std::unordered_set<Utils::ID> seenReqIds;
+            for (const Utils::ID figureId : region) {
+                const auto it = _solveCache->figureRequirements.find(figureId);
+                if (it == _solveCache->figureRequirements.end()) {
+                    continue;
+                }
+                for (const Utils::ID reqId : it->second) {
+                    if (seenReqIds.insert(reqId).second) {
+                        reqIds.push_back(reqId);
+                    }
+                }
+            }
+            std::sort(reqIds.begin(), reqIds.end(), [](Utils::ID lhs, Utils::ID rhs) {
+                return lhs.id < rhs.id;
+            });
+            std::vector<Utils::RequirementDescriptor> descriptors;
+            descriptors.reserve(reqIds.size());
+            for (const Utils::ID reqId : reqIds) {
+                descriptors.push_back(_requirementRecords.at(reqId));
+            }
+            entry.version = _solveCache->version;
+            entry.subsystem = std::make_unique<System::RequirementSystem>(&_storage);
+            entry.subsystem->addRequirements(descriptors);
+        }
+        auto& system = *entry.subsystem;
+        entry.report.reset();
+        entry.report.components = 1;
+        (inserted ? entry.report.cacheMisses : entry.report.cacheHits) = 1;
+        entry.report.phases.subsystemBuild = elapsedSince(buildStart);
+
+        if (requirementsSatisfied(system, _fixedRequirementTargets)) {
+            finishSatisfiedEntry(entry);
+            return true;
+        }
+
+        if (!entry.pipelineReady) {
+            std::unordered_set<double*> regionVars;
+            for (const Utils::ID figureId : region) {
+                if (const auto type = _storage.getType(figureId); type == Utils::FigureType::ET_POINT2D) {
+                    auto* point = system.resolvePoint(figureId);
+                    regionVars.insert(&point->x());
+                    regionVars.insert(&point->y());
+                } else if (type == Utils::FigureType::ET_CIRCLE) {
+                    regionVars.insert(_storage.get<Figures::Circle2D>(figureId)->ptrRadius());
+                }
+            }
+
+            std::unordered_set<double*> boundaryLocks = resolveLocks(lockHandles);
+            for (VAR var : system.getAllVars()) {
+                if (!regionVars.contains(var)) {
+                    boundaryLocks.insert(var);
+                }
+            }
+            buildSolvePipeline(entry, boundaryLocks);
+        }
+        if (!entry.hasFreeVariables && entry.constructionSteps.empty()) {
+            _lastSolveReport.phases += entry.report.phases;
+            continue;
+        }
+        const bool converged = runSolveEntry(entry);
+        _lastSolveReport.merge(entry.report);
+        if (converged) {
+            return true;
+        }
+    }
+
+    return solveWithLockedVars(componentId, lockHandles);
+}
+
+std::unordered_set<Utils::ID> DCMManager::collectRelaxationRegion(const std::vector<Utils::ID>& seeds,
+                                                                  std::size_t hops) {
+    syncRequirementSystemIfNeeded();
+    if (!_solveCache->figureRequirementsReady) {
+        for (const auto& reqId : _requirementOrder) {
+            const auto it = _requirementRecords.find(reqId);
+            if (it == _requirementRecords.end()) {
+                continue;
+            }
+            for (const auto& objId : it->second.objectIds) {
+                _solveCache->figureRequirements[objId].push_back(reqId);
+            }
+        }
+        _solveCache->figureRequirementsReady = true;
+    }
+
+    std::unordered_set<Utils::ID> region;
+    std::vector<Utils::ID> frontier;
+    const auto visit = [&](Utils::ID figureId, std::vector<Utils::ID>& next) {
+        // Coincident points share one set of solver variables, so they enter together.
+        for (const Utils::ID id : _reqSystem.getCoincidentPoints(figureId)) {
+            if (region.insert(id).second) {
+                next.push_back(id);
+            }
+        }
+        if (region.insert(figureId).second) {
+            next.push_back(figureId);
+        }
+    };
+
+    for (const Utils::ID seed : seeds) {
+        visit(seed, frontier);
+    }
+
+    for (std::size_t hop = 0; hop < hops && !frontier.empty(); ++hop) {
+        std::vector<Utils::ID> next;
+        for (const Utils::ID figureId : frontier) {
+            for (const Utils::ID pointId : _storage.getDependencies(figureId)) {
+                visit(pointId, next);
+            }
+            for (const Utils::ID dependentId : _storage.getDependents(figureId)) {
+                visit(dependentId, next);
+            }
+            const auto reqIt = _solveCache->figureRequirements.find(figureId);
+            if (reqIt == _solveCache->figureRequirements.end()) {
+                continue;
+            }
+            for (const Utils::ID reqId : reqIt->second) {
+                for (const Utils::ID objId : _requirementRecords.at(reqId).objectIds) {
+                    visit(objId, next);
+                }
+            }
+        }
+        frontier = std::move(next);
+    }
+
+    return region;
+}
+
+DCMManager::RigidClusterSet& DCMManager::rigidClustersFor(ComponentID componentId) {
+    const auto [it, inserted] = _solveCache->rigidClusters.try_emplace(componentId);
+    auto& clusterSet = it->second;
+    if (!inserted) {
+        return clusterSet;
+    }
+
+    clusterSet.subsystem = buildSubsystem(componentId);
+    std::unordered_map<double*, PointCoordinates> pointOfVar;
+    for (const Utils::ID figureId : _components[componentId]) {
+        auto* point = _storage.get<Figures::Point2D>(figureId);
+        if (point == nullptr) {
+            continue;
+        }
+        pointOfVar[&point->x()] = {&point->x(), &point->y()};
+        pointOfVar[&point->y()] = {&point->x(), &point->y()};
+        clusterSet.pointIdOfVar[&point->x()] = figureId;
+    }
+    clusterSet.clusters = detectRigidClusters(*clusterSet.subsystem, pointOfVar);
+    return clusterSet;
+}
+
+bool DCMManager::solveWithRigidClusters(ComponentID componentId,
+                                        const std::vector<Utils::VarHandle>& lockHandles) {
+    if (componentId >= _components.size() || _components[componentId].empty()) {
+        return false;
+    }
+
+    auto& clusterSet = rigidClustersFor(componentId);
+    const auto& clusters = clusterSet.clusters;
+    if (clusters.empty()) {
+        return false;
+    }
+
+    auto& system = *clusterSet.subsystem;
+    const auto& functions = system.getFunctions();
+
+    // A transform only preserves internal requirements that already hold.
+    for (const auto& cluster : clusters) {
+        for (const std::size_t index : cluster.internalFunctions) {
+            if (std::abs(functions[index]->evaluate() * functions[index]->getWeight()) > kSatisfiedResidualTolerance) {
+                return false;
+            }
+        }
+    }
+
+    // The reduced problem depends only on which scalars are locked, so steady drag frames reuse it.
+    if (clusterSet.solve == nullptr || clusterSet.solve->lockHandles != lockHandles) {
+        std::vector<double*> lockedVars;
+        lockedVars.reserve(lockHandles.size());
+        for (const auto& handle : lockHandles) {
+            if (double* valueRef = _storage.resolve(handle)) {
+                lockedVars.push_back(valueRef);
+            }
+        }
+        clusterSet.solve = makeRigidClusterSolve(clusters, system, collectFixTargets(system, _fixedRequirementTargets),
+                                                 lockHandles, lockedVars);
+    }
+    auto& solve = *clusterSet.solve;
+    if (!solve.usable) {
+        return false;
+    }
+
+    // Everything this attempt writes, so a failed attempt leaves the geometry to the fallback untouched.
+    for (auto& [valueRef, value] : solve.snapshot) {
+        value = *valueRef;
+    }
+    const auto restoreSnapshot = [&solve]() {
+        for (const auto& [valueRef, value] : solve.snapshot) {
+            *valueRef = value;
+        }
+    };
+
+    for (std::size_t p = 0; p < solve.pins.size(); ++p) {
+        const auto& pin = solve.pins[p];
+        if (pin.locked) {
+            solve.pinTargets[p] = *pin.var;
+        } else if (!pin.clustered) {
+            *pin.var = solve.pinTargets[p];
+        }
+    }
+
+    // Each cluster moves about its current centroid, starting from the identity transform.
+    for (std::size_t k = 0; k < clusters.size(); ++k) {
+        auto& pose = solve.poses[k];
+        pose.centroid.setZero();
+        for (const auto& [x, y] : clusters[k].points) {
+            pose.centroid += Eigen::Vector2d(*x, *y);
+        }
+        pose.centroid /= static_cast<double>(clusters[k].points.size());
+        for (std::size_t i = 0; i < clusters[k].points.size(); ++i) {
+            pose.offsets[i] = Eigen::Vector2d(*clusters[k].points[i].first, *clusters[k].points[i].second) -
+                              pose.centroid;
+        }
+        pose.parameters.fill(0.0);
+    }
+
+    if (!solve.solver->solve()) {
+        restoreSnapshot();
+        return false;
+    }
+
+    system.synchronizeCoincidentPoints();
+    markSolved(componentId);
+    return true;
+}
+
 std::unique_ptr<System::RequirementSystem> DCMManager::buildSubsystem(ComponentID componentId) const {
+    OURPAINTDCM_PROBE_SCOPE(ET_BUILD_SUBSYSTEM);
     auto subsystem = std::make_unique<System::RequirementSystem>(
         &const_cast<DCMManager*>(this)->_storage);
 
-    auto reqIds = getRequirementsInComponent(componentId);
+    const auto reqIds = getRequirementsInComponent(componentId);
+    std::vector<Utils::RequirementDescriptor> descriptors;
+    descriptors.reserve(reqIds.size());
     for (const auto& reqId : reqIds) {
         auto it = _requirementRecords.find(reqId);
         if (it != _requirementRecords.end()) {
-            subsystem->addRequirement(it->second);
+            descriptors.push_back(it->second);
         }
     }
+    subsystem->addRequirements(descriptors);
 
     return subsystem;
 }
 
 void DCMManager::rebuildRequirementSystem() {
     _reqSystem.clear();
+    std::vector<Utils::RequirementDescriptor> descriptors;
+    descriptors.reserve(_requirementOrder.size());
     for (const auto& reqId : _requirementOrder) {
         const auto it = _requirementRecords.find(reqId);
         if (it != _requirementRecords.end()) {
-            _reqSystem.addRequirement(it->second);
+            descriptors.push_back(it->second);
         }
     }
+    _reqSystem.addRequirements(descriptors);
     _reqSystemSyncedWithRecords = true;
 }
 
@@ -1589,6 +3404,17 @@ void DCMManager::pruneRequirementsWithMissingObjects() {
 }
 
 void DCMManager::rebuildComponents() {
+    OURPAINTDCM_PROBE_SCOPE(ET_REBUILD_COMPONENTS);
+    std::vector<Utils::ID> dirtyFigures;
+    for (const ComponentID componentId : getDirtyComponents()) {
+        if (componentId < _components.size()) {
+            dirtyFigures.insert(dirtyFigures.end(),
+                                _components[componentId].begin(),
+                                _components[componentId].end());
+        }
+    }
+    _dirtyComponents.clear();
+
     _figureToComponent.clear();
     _components.clear();
     _nextComponentId = 0;
@@ -1602,9 +3428,14 @@ void DCMManager::rebuildComponents() {
     for (const auto& entry : _requirementRecords) {
         mergeComponents(entry.second.objectIds);
     }
+
+    for (const Utils::ID figureId : dirtyFigures) {
+        markFigureDirty(figureId);
+    }
 }
 
 void DCMManager::mergeComponents(const std::vector<Utils::ID>& figureIds) {
+    OURPAINTDCM_PROBE_SCOPE(ET_MERGE_COMPONENTS);
     if (figureIds.empty()) {
         return;
     }
@@ -1634,6 +3465,10 @@ void DCMManager::mergeComponents(const std::vector<Utils::ID>& figureIds) {
         }
         _components[srcCompId].clear();
         --_activeComponentCount;
+        if (isComponentDirty(srcCompId)) {
+            _dirtyComponents[srcCompId] = 0;
+            markComponentDirty(targetCompId);
+        }
 
         ++targetIt;
     }
@@ -1667,11 +3502,40 @@ void DCMManager::removeFigureFromComponent(Utils::ID figureId) {
         _components[compId].erase(figureId);
         if (_components[compId].empty()) {
             --_activeComponentCount;
+            if (isComponentDirty(compId)) {
+                _dirtyComponents[compId] = 0;
+            }
         }
         _figureToComponent.erase(it);
     }
 }
 
+void DCMManager::markFigureDirty(Utils::ID figureId) {
+    const auto it = _figureToComponent.find(figureId);
+    if (it != _figureToComponent.end()) {
+        markComponentDirty(it->second);
+    }
+}
+
+void DCMManager::markComponentDirty(ComponentID componentId) {
+    if (componentId >= _dirtyComponents.size()) {
+        _dirtyComponents.resize(componentId + 1, 0);
+    }
+    _dirtyComponents[componentId] = 1;
+}
+
+bool DCMManager::isComponentDirty(ComponentID componentId) const noexcept {
+    return componentId < _dirtyComponents.size() && _dirtyComponents[componentId] != 0;
+}
+
+void DCMManager::markSolved(std::optional<ComponentID> target) noexcept {
+    if (!target.has_value()) {
+        _dirtyComponents.clear();
+    } else if (isComponentDirty(target.value())) {
+        _dirtyComponents[target.value()] = 0;
+    }
+}
+
 std::vector<Utils::ID> DCMManager::getRequirementsForFigure(Utils::ID figureId) const {
     std::vector<Utils::ID> result;
     for (const auto& reqId : _requirementOrder) {
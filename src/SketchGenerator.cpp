@@ -0,0 +1,425 @@
+#include "SketchGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+using namespace OurPaintDCM;
+using Utils::ID;
+using Utils::RequirementDescriptor;
+
+namespace {
+/// Parts per row when laying out independent parts on a grid.
+constexpr std::size_t kPartsPerRow = 1000;
+
+/**
+ * @brief SplitMix64: tiny, fast and, unlike the std distributions, identical on every platform.
+ */
+class SplitMix64 {
+    std::uint64_t _state;
+
+public:
+    explicit SplitMix64(std::uint64_t seed) : _state(seed) {}
+
+    std::uint64_t next() noexcept {
+        std::uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// @brief Uniform in [lo, hi).
+    double uniform(double lo, double hi) noexcept {
+        return lo + (hi - lo) * static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+    /// @brief Uniform in [0, count).
+    std::size_t index(std::size_t count) noexcept {
+        return count == 0 ? 0 : static_cast<std::size_t>(next() % count);
+    }
+
+    bool chance(double probability) noexcept { return uniform(0.0, 1.0) < probability; }
+};
+
+double distance(double ax, double ay, double bx, double by) {
+    return std::hypot(bx - ax, by - ay);
+}
+
+/// Angle between directions (ax, ay) and (bx, by), as measured by the line-line angle requirement.
+double angleBetween(double ax, double ay, double bx, double by) {
+    const double cosine = (ax * bx + ay * by) / (std::hypot(ax, ay) * std::hypot(bx, by));
+    return std::acos(std::clamp(cosine, -1.0, 1.0));
+}
+
+/**
+ * @brief Adds figures to the manager and collects requirements, applying jitter and level.
+ */
+class SketchBuilder {
+    DCMManager& _manager;
+    const SketchSpec& _spec;
+    SplitMix64 _rng;
+    GeneratedSketch _sketch;
+
+public:
+    SketchBuilder(DCMManager& manager, const SketchSpec& spec)
+        : _manager(manager), _spec(spec), _rng(spec.seed) {}
+
+    SplitMix64& rng() noexcept { return _rng; }
+    GeneratedSketch& sketch() noexcept { return _sketch; }
+    bool reached() const noexcept { return _sketch.entityCount() >= _spec.targetEntities; }
+
+    /**
+     * @brief Point at (x, y).
+     * @param anchored Held in place by a fix requirement the caller adds; never jittered.
+     *        Free points start off by up to ±jitter per coordinate.
+     */
+    ID point(double x, double y, bool anchored = false) {
+        if (!anchored && _spec.jitter > 0.0) {
+            x += _rng.uniform(-_spec.jitter, _spec.jitter);
+            y += _rng.uniform(-_spec.jitter, _spec.jitter);
+        }
+        const ID id = _manager.addFigure(Utils::FigureDescriptor::point(x, y));
+        _sketch.points.push_back(id);
+        (anchored ? _sketch.anchors : _sketch.handles).push_back(id);
+        return id;
+    }
+
+    /// @brief Point at (x, y) held by a fix-point requirement.
+    ID anchor(double x, double y) {
+        const ID id = point(x, y, true);
+        require(RequirementDescriptor::fixPoint(id));
+        return id;
+    }
+
+    ID line(ID p1, ID p2) {
+        const ID id = _manager.addFigure(Utils::FigureDescriptor::line(p1, p2));
+        _sketch.lines.push_back(id);
+        return id;
+    }
+
+    ID circle(ID center, double radius) {
+        const ID id = _manager.addFigure(Utils::FigureDescriptor::circle(center, radius));
+        _sketch.circles.push_back(id);
+        return id;
+    }
+
+    void require(RequirementDescriptor descriptor) {
+        _sketch.requirements.push_back(std::move(descriptor));
+    }
+
+    /// @brief Whether to drop a degree-removing requirement (ET_UNDER only).
+    bool dropped() noexcept {
+        return _spec.level == ConstraintLevel::ET_UNDER && _rng.chance(_spec.variantRatio);
+    }
+
+    /// @brief Whether to add a redundant requirement (ET_OVER only).
+    bool redundant() noexcept {
+        return _spec.level == ConstraintLevel::ET_OVER && _rng.chance(_spec.variantRatio);
+    }
+};
+
+std::array<double, 2> partOrigin(std::size_t part) {
+    return {static_cast<double>(part % kPartsPerRow) * 40.0, static_cast<double>(part / kPartsPerRow) * 40.0};
+}
+
+/// Points (n+1)², lines 2n(n+1). Every side is horizontal or vertical; the bottom row and
+/// left column carry the dimension chains.
+void rectangleGrid(SketchBuilder& b, std::size_t target) {
+    auto& rng = b.rng();
+    const auto n = std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(std::sqrt(static_cast<double>(target) / 3.0))));
+    std::vector<double> xs(n + 1, 0.0);
+    std::vector<double> ys(n + 1, 0.0);
+    for (std::size_t i = 1; i <= n; ++i) {
+        xs[i] = xs[i - 1] + rng.uniform(1.0, 3.0);
+        ys[i] = ys[i - 1] + rng.uniform(1.0, 3.0);
+    }
+
+    std::vector<ID> p((n + 1) * (n + 1));
+    const auto at = [n](std::size_t row, std::size_t col) { return row * (n + 1) + col; };
+    for (std::size_t row = 0; row <= n; ++row) {
+        for (std::size_t col = 0; col <= n; ++col) {
+            p[at(row, col)] = row == 0 && col == 0 ? b.anchor(xs[col], ys[row]) : b.point(xs[col], ys[row]);
+        }
+    }
+    for (std::size_t row = 0; row <= n; ++row) {
+        for (std::size_t col = 0; col < n; ++col) {
+            b.require(RequirementDescriptor::horizontal(b.line(p[at(row, col)], p[at(row, col + 1)])));
+        }
+    }
+    for (std::size_t col = 0; col <= n; ++col) {
+        for (std::size_t row = 0; row < n; ++row) {
+            b.require(RequirementDescriptor::vertical(b.line(p[at(row, col)], p[at(row + 1, col)])));
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!b.dropped()) {
+            b.require(RequirementDescriptor::pointPointDist(p[at(0, i)], p[at(0, i + 1)], xs[i + 1] - xs[i]));
+        }
+        if (!b.dropped()) {
+            b.require(RequirementDescriptor::pointPointDist(p[at(i, 0)], p[at(i + 1, 0)], ys[i + 1] - ys[i]));
+        }
+        if (b.redundant()) {
+            b.require(RequirementDescriptor::pointPointDist(p[at(n, i)], p[at(n, i + 1)], xs[i + 1] - xs[i]));
+        }
+        if (b.redundant()) {
+            b.require(RequirementDescriptor::pointPointDist(p[at(i, n)], p[at(i + 1, n)], ys[i + 1] - ys[i]));
+        }
+    }
+    b.sketch().parts = 1;
+}
+
+/// Rod lattice of rows × cols panels, about eight times wider than tall. Braces in the bottom
+/// row and left column make it minimally rigid (the grid bracing theorem).
+void trussLattice(SketchBuilder& b, std::size_t target) {
+    auto& rng = b.rng();
+    const double nodes = std::max(4.0, static_cast<double>(target) / 3.0);
+    const auto rows = std::max<std::size_t>(1, static_cast<std::size_t>(std::sqrt(nodes / 8.0)));
+    const auto cols = std::max<std::size_t>(1, static_cast<std::size_t>(nodes / static_cast<double>(rows + 1)) - 1);
+    const double panel = rng.uniform(1.5, 2.5);
+    const double height = rng.uniform(1.0, 2.0);
+
+    std::vector<ID> p((rows + 1) * (cols + 1));
+    const auto at = [cols](std::size_t row, std::size_t col) { return row * (cols + 1) + col; };
+    for (std::size_t row = 0; row <= rows; ++row) {
+        for (std::size_t col = 0; col <= cols; ++col) {
+            const double x = static_cast<double>(col) * panel;
+            const double y = static_cast<double>(row) * height;
+            p[at(row, col)] = row == 0 && col == 0 ? b.anchor(x, y) : b.point(x, y);
+        }
+    }
+
+    const auto member = [&](ID a, ID c, double length) {
+        const ID rod = b.line(a, c);
+        b.require(RequirementDescriptor::pointPointDist(a, c, length));
+        return rod;
+    };
+    const double diagonal = std::hypot(panel, height);
+    for (std::size_t row = 0; row <= rows; ++row) {
+        for (std::size_t col = 0; col < cols; ++col) {
+            const ID rod = member(p[at(row, col)], p[at(row, col + 1)], panel);
+            if (row == 0 && col == 0) {
+                b.require(RequirementDescriptor::horizontal(rod));
+            }
+        }
+    }
+    for (std::size_t col = 0; col <= cols; ++col) {
+        for (std::size_t row = 0; row < rows; ++row) {
+            member(p[at(row, col)], p[at(row + 1, col)], height);
+        }
+    }
+    for (std::size_t row = 0; row < rows; ++row) {
+        for (std::size_t col = 0; col < cols; ++col) {
+            const bool required = row == 0 || col == 0;
+            if (required ? !b.dropped() : b.redundant()) {
+                member(p[at(row, col)], p[at(row + 1, col + 1)], diagonal);
+            }
+        }
+    }
+    b.sketch().parts = 1;
+}
+
+/// Flanges (fixed circle) with k holes on a pitch circle: a distance from the flange center to
+/// every hole, chord distances between neighbours and a horizontal spoke to the first hole.
+/// Hole radii stay free: no requirement constrains a radius alone.
+void boltCircles(SketchBuilder& b) {
+    auto& rng = b.rng();
+    std::size_t pattern = 0;
+    do {
+        const auto [ox, oy] = partOrigin(pattern++);
+        const std::size_t holes = 3 + rng.index(10);
+        const double flangeRadius = rng.uniform(8.0, 12.0);
+        const double pitch = flangeRadius * rng.uniform(0.55, 0.75);
+        const double chord = 2.0 * pitch * std::sin(std::numbers::pi / static_cast<double>(holes));
+        const double holeRadius = std::min(0.3 * chord, 0.15 * flangeRadius);
+
+        const ID center = b.point(ox, oy, true);
+        const ID flange = b.circle(center, flangeRadius);
+        b.require(RequirementDescriptor::fixCircle(flange));
+
+        std::vector<ID> h(holes);
+        for (std::size_t i = 0; i < holes; ++i) {
+            const double angle = 2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(holes);
+            h[i] = b.point(ox + pitch * std::cos(angle), oy + pitch * std::sin(angle));
+            b.circle(h[i], holeRadius);
+            b.require(RequirementDescriptor::pointPointDist(center, h[i], pitch));
+        }
+        b.require(RequirementDescriptor::horizontal(b.line(center, h[0])));
+        for (std::size_t i = 0; i + 1 < holes; ++i) {
+            if (!b.dropped()) {
+                b.require(RequirementDescriptor::pointPointDist(h[i], h[i + 1], chord));
+            }
+        }
+        if (b.redundant()) {
+            b.require(RequirementDescriptor::pointPointDist(h[holes - 1], h[0], chord));
+        }
+        if (holes % 2 == 0 && b.redundant()) {
+            b.require(RequirementDescriptor::pointPointDist(h[0], h[holes / 2], 2.0 * pitch));
+        }
+    } while (!b.reached());
+    b.sketch().parts = pattern;
+}
+
+/// One chain of (target - 1) / 2 links: a random walk with fixed link lengths and joint angles,
+/// anchored at its first point with a horizontal first link.
+void openLinkage(SketchBuilder& b, std::size_t target) {
+    auto& rng = b.rng();
+    const std::size_t links = std::max<std::size_t>(1, (target > 0 ? target - 1 : 0) / 2);
+
+    std::array<double, 2> before{};
+    std::array<double, 2> current{};
+    ID beforePoint{};
+    ID currentPoint = b.anchor(current[0], current[1]);
+    ID previousLink{};
+    double heading = 0.0;
+    for (std::size_t i = 0; i < links; ++i) {
+        if (i > 0) {
+            const double turn = rng.uniform(std::numbers::pi / 12.0, std::numbers::pi / 3.0);
+            heading += rng.chance(0.5) ? turn : -turn;
+        }
+        const double length = rng.uniform(1.0, 2.0);
+        const std::array<double, 2> next{current[0] + length * std::cos(heading),
+                                         current[1] + length * std::sin(heading)};
+
+        const ID nextPoint = b.point(next[0], next[1]);
+        const ID link = b.line(currentPoint, nextPoint);
+        b.require(RequirementDescriptor::pointPointDist(currentPoint, nextPoint, length));
+        if (i == 0) {
+            b.require(RequirementDescriptor::horizontal(link));
+        } else {
+            if (!b.dropped()) {
+                const double angle = angleBetween(current[0] - before[0], current[1] - before[1],
+                                                  next[0] - current[0], next[1] - current[1]);
+                b.require(RequirementDescriptor::lineLineAngle(previousLink, link, angle));
+            }
+            if (b.redundant()) {
+                b.require(RequirementDescriptor::pointPointDist(
+                    beforePoint, nextPoint, distance(before[0], before[1], next[0], next[1])));
+            }
+        }
+        before = current;
+        current = next;
+        beforePoint = currentPoint;
+        currentPoint = nextPoint;
+        previousLink = link;
+    }
+    b.sketch().parts = 1;
+}
+
+/// Independent triangles, rectangles and fixed circles, each anchored at one point.
+void disconnectedParts(SketchBuilder& b) {
+    auto& rng = b.rng();
+    std::size_t part = 0;
+    do {
+        const auto [ox, oy] = partOrigin(part++);
+        switch (rng.index(3)) {
+            case 0: {
+                const double base = rng.uniform(2.0, 4.0);
+                const double apexX = rng.uniform(0.5, base - 0.5);
+                const double apexY = rng.uniform(1.0, 3.0);
+                const ID p0 = b.anchor(ox, oy);
+                const ID p1 = b.point(ox + base, oy);
+                const ID p2 = b.point(ox + apexX, oy + apexY);
+                const ID l0 = b.line(p0, p1);
+                b.line(p1, p2);
+                const ID l2 = b.line(p2, p0);
+                b.require(RequirementDescriptor::horizontal(l0));
+                b.require(RequirementDescriptor::pointPointDist(p0, p1, base));
+                b.require(RequirementDescriptor::pointPointDist(p1, p2, distance(base, 0.0, apexX, apexY)));
+                if (!b.dropped()) {
+                    b.require(RequirementDescriptor::pointPointDist(p2, p0, std::hypot(apexX, apexY)));
+                }
+                if (b.redundant()) {
+                    b.require(RequirementDescriptor::lineLineAngle(l0, l2, angleBetween(base, 0.0, -apexX, -apexY)));
+                }
+                break;
+            }
+            case 1: {
+                const double width = rng.uniform(2.0, 5.0);
+                const double height = rng.uniform(1.0, 4.0);
+                const std::array<ID, 4> p{b.anchor(ox, oy), b.point(ox + width, oy),
+                                          b.point(ox + width, oy + height), b.point(ox, oy + height)};
+                for (std::size_t i = 0; i < 4; ++i) {
+                    const ID side = b.line(p[i], p[(i + 1) % 4]);
+                    b.require(i % 2 == 0 ? RequirementDescriptor::horizontal(side)
+                                         : RequirementDescriptor::vertical(side));
+                }
+                b.require(RequirementDescriptor::pointPointDist(p[0], p[1], width));
+                if (!b.dropped()) {
+                    b.require(RequirementDescriptor::pointPointDist(p[1], p[2], height));
+                }
+                if (b.redundant()) {
+                    b.require(RequirementDescriptor::pointPointDist(p[0], p[2], std::hypot(width, height)));
+                }
+                break;
+            }
+            default: {
+                const bool fixed = !b.dropped();
+                const ID center = b.point(ox, oy, fixed);
+                const ID circle = b.circle(center, rng.uniform(0.5, 3.0));
+                if (fixed) {
+                    b.require(RequirementDescriptor::fixCircle(circle));
+                }
+                break;
+            }
+        }
+    } while (!b.reached());
+    b.sketch().parts = part;
+}
+}
+
+std::string_view OurPaintDCM::sketchFamilyName(SketchFamily family) noexcept {
+    switch (family) {
+        case SketchFamily::ET_RECTANGLE_GRID:
+            return "rectangleGrid";
+        case SketchFamily::ET_TRUSS_LATTICE:
+            return "trussLattice";
+        case SketchFamily::ET_BOLT_CIRCLE:
+            return "boltCircle";
+        case SketchFamily::ET_OPEN_LINKAGE:
+            return "openLinkage";
+        case SketchFamily::ET_DISCONNECTED_PARTS:
+            return "disconnectedParts";
+    }
+    return "unknown";
+}
+
+std::string_view OurPaintDCM::constraintLevelName(ConstraintLevel level) noexcept {
+    switch (level) {
+        case ConstraintLevel::ET_WELL:
+            return "well";
+        case ConstraintLevel::ET_UNDER:
+            return "under";
+        case ConstraintLevel::ET_OVER:
+            return "over";
+    }
+    return "unknown";
+}
+
+GeneratedSketch OurPaintDCM::generateFigures(DCMManager& manager, const SketchSpec& spec) {
+    SketchBuilder builder(manager, spec);
+    switch (spec.family) {
+        case SketchFamily::ET_RECTANGLE_GRID:
+            rectangleGrid(builder, spec.targetEntities);
+            break;
+        case SketchFamily::ET_TRUSS_LATTICE:
+            trussLattice(builder, spec.targetEntities);
+            break;
+        case SketchFamily::ET_BOLT_CIRCLE:
+            boltCircles(builder);
+            break;
+        case SketchFamily::ET_OPEN_LINKAGE:
+            openLinkage(builder, spec.targetEntities);
+            break;
+        case SketchFamily::ET_DISCONNECTED_PARTS:
+            disconnectedParts(builder);
+            break;
+    }
+    return std::move(builder.sketch());
+}
+
+GeneratedSketch OurPaintDCM::generateSketch(DCMManager& manager, const SketchSpec& spec) {
+    auto sketch = generateFigures(manager, spec);
+    sketch.requirementIds = manager.addRequirements(sketch.requirements);
+    return sketch;
+}
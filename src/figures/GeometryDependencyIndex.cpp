@@ -1,4 +1,5 @@
 #include "GeometryDependencyIndex.h"
+#include "MemoryUsage.h"
 
 #include <algorithm>
 
@@ -81,4 +82,8 @@ void GeometryDependencyIndex::clear() noexcept {
     figureToPoints_.clear();
 }
 
+std::size_t GeometryDependencyIndex::heapBytes() const noexcept {
+    return Utils::heapBytes(pointToFigures_) + Utils::heapBytes(figureToPoints_);
+}
+
 } // namespace OurPaintDCM::Figures
@@ -49,6 +49,9 @@ std::size_t GeometryStorage::allocPoint(double x, double y) {
         return i;
     }
     m_pointSlots.push_back(std::make_unique<Point2D>(x, y));
+    if (m_pointGenerations.size() < m_pointSlots.size()) {
+        m_pointGenerations.push_back(0);
+    }
     return m_pointSlots.size() - 1;
 }
 
@@ -71,6 +74,9 @@ std::size_t GeometryStorage::allocCircle(Point2D* c, double r) {
         return i;
     }
     m_circleSlots.push_back(std::make_unique<Circle2D>(c, r));
+    if (m_circleGenerations.size() < m_circleSlots.size()) {
+        m_circleGenerations.push_back(0);
+    }
     return m_circleSlots.size() - 1;
 }
 
@@ -87,6 +93,7 @@ std::size_t GeometryStorage::allocArc(Point2D* p1, Point2D* p2, Point2D* c) {
 
 void GeometryStorage::freePoint(std::size_t slot) {
     m_pointSlots[slot].reset();
+    ++m_pointGenerations[slot];
     m_pointFree.push_back(slot);
 }
 
@@ -97,6 +104,7 @@ void GeometryStorage::freeLine(std::size_t slot) {
 
 void GeometryStorage::freeCircle(std::size_t slot) {
     m_circleSlots[slot].reset();
+    ++m_circleGenerations[slot];
     m_circleFree.push_back(slot);
 }
 
@@ -240,8 +248,7 @@ RemoveResult GeometryStorage::removeFigureOnly(ID id) noexcept {
             break;
         case FigureType::ET_CIRCLE:
             eraseCircleCache(id);
-            m_circleSlots[ent.slot].reset();
-            m_circleFree.push_back(ent.slot);
+            freeCircle(ent.slot);
             break;
         case FigureType::ET_ARC:
             eraseArcCache(id);
@@ -290,6 +297,13 @@ void GeometryStorage::clear() noexcept {
     m_lineSlots.clear();
     m_circleSlots.clear();
     m_arcSlots.clear();
+    // Slots restart from 0, so outstanding handles must not match the new occupants.
+    for (auto& generation : m_pointGenerations) {
+        ++generation;
+    }
+    for (auto& generation : m_circleGenerations) {
+        ++generation;
+    }
     m_pointFree.clear();
     m_lineFree.clear();
     m_circleFree.clear();
@@ -323,6 +337,41 @@ std::optional<FigureEntry> GeometryStorage::getEntry(ID id) const noexcept {
     return it->second;
 }
 
+std::optional<Utils::VarHandle> GeometryStorage::varHandle(ID id, std::uint8_t component) const noexcept {
+    const auto it = m_index.find(id);
+    if (it == m_index.end()) {
+        return std::nullopt;
+    }
+    const FigureEntry& entry = it->second;
+    const bool owned = (entry.type == FigureType::ET_POINT2D && component <= Utils::kPointY) ||
+                       (entry.type == FigureType::ET_CIRCLE && component == Utils::kCircleRadius);
+    if (!owned) {
+        return std::nullopt;
+    }
+    const auto& generations = entry.type == FigureType::ET_POINT2D ? m_pointGenerations : m_circleGenerations;
+    return Utils::VarHandle{entry.type, entry.slot, component, generations[entry.slot]};
+}
+
+double* GeometryStorage::resolve(Utils::VarHandle handle) noexcept {
+    switch (handle.type) {
+        case FigureType::ET_POINT2D:
+            if (handle.slot < m_pointSlots.size() && m_pointSlots[handle.slot] &&
+                m_pointGenerations[handle.slot] == handle.generation && handle.component <= Utils::kPointY) {
+                return handle.component == Utils::kPointX ? m_pointSlots[handle.slot]->ptrX()
+                                                          : m_pointSlots[handle.slot]->ptrY();
+            }
+            return nullptr;
+        case FigureType::ET_CIRCLE:
+            if (handle.slot < m_circleSlots.size() && m_circleSlots[handle.slot] &&
+                m_circleGenerations[handle.slot] == handle.generation && handle.component == Utils::kCircleRadius) {
+                return m_circleSlots[handle.slot]->ptrRadius();
+            }
+            return nullptr;
+        default:
+            return nullptr;
+    }
+}
+
 bool GeometryStorage::contains(ID id) const noexcept {
     return m_index.contains(id);
 }
@@ -418,6 +467,31 @@ std::optional<ObjectGraph> GeometryStorage::buildObjectSubgraph(ID id) const {
     return GeometryGraphBuilder::buildObjectSubgraph(*this, id);
 }
 
+namespace {
+template <typename T>
+std::size_t slotPoolBytes(const std::vector<std::unique_ptr<T>>& slots) noexcept {
+    std::size_t bytes = Utils::heapBytes(slots);
+    for (const auto& slot : slots) {
+        bytes += slot != nullptr ? sizeof(T) : 0;
+    }
+    return bytes;
+}
+}
+
+void GeometryStorage::accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept {
+    usage.geometrySlots += slotPoolBytes(m_pointSlots) + slotPoolBytes(m_lineSlots) +
+                           slotPoolBytes(m_circleSlots) + slotPoolBytes(m_arcSlots) +
+                           Utils::heapBytes(m_pointGenerations) + Utils::heapBytes(m_circleGenerations);
+    usage.geometryFreeLists += Utils::heapBytes(m_pointFree) + Utils::heapBytes(m_lineFree) +
+                               Utils::heapBytes(m_circleFree) + Utils::heapBytes(m_arcFree);
+    usage.geometryIndex += Utils::heapBytes(m_index) +
+                           Utils::heapBytes(m_pointsWithIds) + Utils::heapBytes(m_linesWithIds) +
+                           Utils::heapBytes(m_circlesWithIds) + Utils::heapBytes(m_arcsWithIds) +
+                           Utils::heapBytes(m_pointWithIdPos) + Utils::heapBytes(m_lineWithIdPos) +
+                           Utils::heapBytes(m_circleWithIdPos) + Utils::heapBytes(m_arcWithIdPos);
+    usage.geometryDependencies += m_deps.heapBytes();
+}
+
 #ifndef NDEBUG
 bool GeometryStorage::validate() const noexcept {
     const std::size_t totalCached =
@@ -1,72 +1,66 @@
 #include "functions/RequirementFunction.h"
+#include "functions/RequirementKernels.h"
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 
 namespace {
 
-constexpr double kGeometryEpsilon = 1e-12;
+using OurPaintDCM::Function::Dual;
+namespace Kernels = OurPaintDCM::Function::Kernels;
 
-std::unordered_map<VAR, double> makeZeroGradient(const std::vector<VAR>& vars) {
-    std::unordered_map<VAR, double> grad;
-    for (VAR var : vars) {
-        grad[var] = 0.0;
+/// Residual of @p kernel at the current values of @p vars.
+template<std::size_t N, typename Kernel>
+double evaluateKernel(const std::vector<VAR>& vars, Kernel&& kernel) {
+    std::array<double, N> x;
+    for (std::size_t i = 0; i < N; ++i) {
+        x[i] = *vars[i];
     }
-    return grad;
+    return kernel(x);
 }
 
-double pointLineSignedDistance(const std::vector<VAR>& vars) {
-    const double px = *vars[0];
-    const double py = *vars[1];
-    const double x1 = *vars[2];
-    const double y1 = *vars[3];
-    const double x2 = *vars[4];
-    const double y2 = *vars[5];
-
-    const double dx = x2 - x1;
-    const double dy = y2 - y1;
-    const double lineLen = std::sqrt(dx * dx + dy * dy);
-    if (lineLen < kGeometryEpsilon) {
-        return 0.0;
-    }
-
-    const double wx = px - x1;
-    const double wy = py - y1;
-    const double cross = wx * dy - wy * dx;
-    return cross / lineLen;
-}
-
-std::unordered_map<VAR, double> pointLineSignedDistanceGradient(const std::vector<VAR>& vars) {
-    const double px = *vars[0];
-    const double py = *vars[1];
-    const double x1 = *vars[2];
-    const double y1 = *vars[3];
-    const double x2 = *vars[4];
-    const double y2 = *vars[5];
-
-    const double dx = x2 - x1;
-    const double dy = y2 - y1;
-    const double lineLen = std::sqrt(dx * dx + dy * dy);
-    if (lineLen < kGeometryEpsilon) {
-        return makeZeroGradient(vars);
+/// Gradient of @p kernel by one forward-mode pass; repeated variables accumulate.
+template<std::size_t N, typename Kernel>
+std::unordered_map<VAR, double> kernelGradient(const std::vector<VAR>& vars, Kernel&& kernel) {
+    std::array<Dual<N>, N> x;
+    for (std::size_t i = 0; i < N; ++i) {
+        x[i] = Dual<N>::variable(*vars[i], i);
     }
-
-    const double wx = px - x1;
-    const double wy = py - y1;
-    const double cross = wx * dy - wy * dx;
-    const double lineLen3 = lineLen * lineLen * lineLen;
+    const Dual<N> result = kernel(x);
 
     std::unordered_map<VAR, double> grad;
-    grad[vars[0]] = dy / lineLen;
-    grad[vars[1]] = -dx / lineLen;
-    grad[vars[2]] = (py - y2) / lineLen + cross * dx / lineLen3;
-    grad[vars[3]] = (x2 - px) / lineLen + cross * dy / lineLen3;
-    grad[vars[4]] = (y1 - py) / lineLen - cross * dx / lineLen3;
-    grad[vars[5]] = (px - x1) / lineLen - cross * dy / lineLen3;
+    grad.reserve(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        grad[vars[i]] += result.derivative(i);
+    }
     return grad;
 }
 
+/// Gradient of @p kernel by one forward-mode pass, one partial per variable position.
+template<std::size_t N, typename Kernel>
+void kernelPartials(const std::vector<VAR>& vars, std::span<double> partials, Kernel&& kernel) {
+    std::array<Dual<N>, N> x;
+    for (std::size_t i = 0; i < N; ++i) {
+        x[i] = Dual<N>::variable(*vars[i], i);
+    }
+    const Dual<N> result = kernel(x);
+    for (std::size_t i = 0; i < N; ++i) {
+        partials[i] = result.derivative(i);
+    }
+}
+
 } // namespace
 
+void OurPaintDCM::Function::RequirementFunction::gradientInto(std::span<double> partials) const {
+    const auto grad = gradient();
+    for (std::size_t i = 0; i < _vars.size() && i < partials.size(); ++i) {
+        const bool repeated = std::find(_vars.begin(), _vars.begin() + static_cast<std::ptrdiff_t>(i), _vars[i]) !=
+                              _vars.begin() + static_cast<std::ptrdiff_t>(i);
+        const auto it = grad.find(_vars[i]);
+        partials[i] = repeated || it == grad.end() ? 0.0 : it->second;
+    }
+}
+
 //PointLineDistanceFunction Requirement
 OurPaintDCM::Function::PointLineDistanceFunction::PointLineDistanceFunction(
     const std::vector<VAR> &vars, double dist) : RequirementFunction(
@@ -78,17 +72,25 @@ OurPaintDCM::Function::PointLineDistanceFunction::PointLineDistanceFunction(
 }
 
 double OurPaintDCM::Function::PointLineDistanceFunction::evaluate() const {
-    return pointLineSignedDistance(_vars) - _distance;
+    return evaluateKernel<6>(_vars, [this](const auto& x) { return Kernels::pointLineSignedDistance(x) - _distance; });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::PointLineDistanceFunction::gradient() const {
-    return pointLineSignedDistanceGradient(_vars);
+    return kernelGradient<6>(_vars, [this](const auto& x) { return Kernels::pointLineSignedDistance(x) - _distance; });
+}
+
+void OurPaintDCM::Function::PointLineDistanceFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<6>(_vars, partials, [this](const auto& x) { return Kernels::pointLineSignedDistance(x) - _distance; });
 }
 
 size_t OurPaintDCM::Function::PointLineDistanceFunction::getVarCount() const {
     return 6;
 }
 
+std::size_t OurPaintDCM::Function::PointLineDistanceFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 //PointOnLineFunction Requirement
 
 OurPaintDCM::Function::PointOnLineFunction::PointOnLineFunction(const std::vector<VAR> &vars) : RequirementFunction(
@@ -99,17 +101,25 @@ OurPaintDCM::Function::PointOnLineFunction::PointOnLineFunction(const std::vecto
 }
 
 double OurPaintDCM::Function::PointOnLineFunction::evaluate() const {
-    return pointLineSignedDistance(_vars);
+    return evaluateKernel<6>(_vars, [](const auto& x) { return Kernels::pointLineSignedDistance(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::PointOnLineFunction::gradient() const {
-    return pointLineSignedDistanceGradient(_vars);
+    return kernelGradient<6>(_vars, [](const auto& x) { return Kernels::pointLineSignedDistance(x); });
+}
+
+void OurPaintDCM::Function::PointOnLineFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<6>(_vars, partials, [](const auto& x) { return Kernels::pointLineSignedDistance(x); });
 }
 
 size_t OurPaintDCM::Function::PointOnLineFunction::getVarCount() const {
     return 6;
 }
 
+std::size_t OurPaintDCM::Function::PointOnLineFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // PointPointDistanceFunction Requirement
 OurPaintDCM::Function::PointPointDistanceFunction::PointPointDistanceFunction(
     const std::vector<VAR> &vars, double dist) : RequirementFunction(
@@ -121,52 +131,23 @@ OurPaintDCM::Function::PointPointDistanceFunction::PointPointDistanceFunction(
 }
 
 double OurPaintDCM::Function::PointPointDistanceFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double dist = std::sqrt(dx * dx + dy * dy);
-
-    return dist - _distance;
+    return evaluateKernel<4>(_vars, [this](const auto& x) { return Kernels::pointPointDistance(x) - _distance; });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::PointPointDistanceFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double dist = std::sqrt(dx * dx + dy * dy);
-
-    if (dist < 1e-10) {
-        grad[_vars[0]] = 0.0;
-        grad[_vars[1]] = 0.0;
-        grad[_vars[2]] = 0.0;
-        grad[_vars[3]] = 0.0;
-        return grad;
-    }
-
-    // df/dx1 = -(x2 - x1)/dist
-    grad[_vars[0]] = -dx / dist;
-    // df/dy1 = -(y2 - y1)/dist
-    grad[_vars[1]] = -dy / dist;
-    // df/dx2 =  (x2 - x1)/dist
-    grad[_vars[2]] = dx / dist;
-    // df/dy2 =  (y2 - y1)/dist
-    grad[_vars[3]] = dy / dist;
+    return kernelGradient<4>(_vars, [this](const auto& x) { return Kernels::pointPointDistance(x) - _distance; });
+}
 
-    return grad;
+void OurPaintDCM::Function::PointPointDistanceFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<4>(_vars, partials, [this](const auto& x) { return Kernels::pointPointDistance(x) - _distance; });
 }
 size_t OurPaintDCM::Function::PointPointDistanceFunction::getVarCount() const {
     return 4;
 }
+
+std::size_t OurPaintDCM::Function::PointPointDistanceFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
 //PointOnPointFunction Requirement
 OurPaintDCM::Function::PointOnPointFunction::PointOnPointFunction(const std::vector<VAR> &vars) : RequirementFunction(
     Utils::RequirementType::ET_POINTONPOINT, vars) {
@@ -176,48 +157,25 @@ OurPaintDCM::Function::PointOnPointFunction::PointOnPointFunction(const std::vec
 }
 
 double OurPaintDCM::Function::PointOnPointFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double dist = std::sqrt(dx * dx + dy * dy);
-
-    return dist;
+    return evaluateKernel<4>(_vars, [](const auto& x) { return Kernels::pointPointDistance(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::PointOnPointFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-    double dx = *_vars[2] - *_vars[0];
-    double dy = *_vars[3] - *_vars[1];
-    double dist = std::sqrt(dx * dx + dy * dy);
-
-    if (dist < 1e-10) {
-        grad[_vars[0]] = 0.0;
-        grad[_vars[1]] = 0.0;
-        grad[_vars[2]] = 0.0;
-        grad[_vars[3]] = 0.0;
-        return grad;
-    }
-
-    // df/dx1 = -(x2 - x1)/dist
-    grad[_vars[0]] = -dx / dist;
-    // df/dy1 = -(y2 - y1)/dist
-    grad[_vars[1]] = -dy / dist;
-    // df/dx2 =  (x2 - x1)/dist
-    grad[_vars[2]] = dx / dist;
-    // df/dy2 =  (y2 - y1)/dist
-    grad[_vars[3]] = dy / dist;
+    return kernelGradient<4>(_vars, [](const auto& x) { return Kernels::pointPointDistance(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::PointOnPointFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<4>(_vars, partials, [](const auto& x) { return Kernels::pointPointDistance(x); });
 }
 
 size_t OurPaintDCM::Function::PointOnPointFunction::getVarCount() const {
     return 4;
 }
 
+std::size_t OurPaintDCM::Function::PointOnPointFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // LineCircleDistanceFunction Requirement
 
 OurPaintDCM::Function::LineCircleDistanceFunction::LineCircleDistanceFunction(
@@ -230,114 +188,26 @@ OurPaintDCM::Function::LineCircleDistanceFunction::LineCircleDistanceFunction(
 }
 
 double OurPaintDCM::Function::LineCircleDistanceFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double cx = *_vars[4];
-    double cy = *_vars[5];
-    double r = *_vars[6];
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double line_len2 = dx * dx + dy * dy;
-
-    if (line_len2 < 1e-10) {
-        double dist = std::sqrt((cx - x1) * (cx - x1) + (cy - y1) * (cy - y1));
-        return dist - r;
-    }
-
-    double t = ((cx - x1) * dx + (cy - y1) * dy) / line_len2;
-
-    t = std::max(0.0, std::min(1.0, t));
-
-    double px = x1 + t * dx;
-    double py = y1 + t * dy;
-
-    double dist = std::sqrt((cx - px) * (cx - px) + (cy - py) * (cy - py));
-
-    return dist - r;
+    return evaluateKernel<7>(_vars, [this](const auto& x) { return Kernels::lineCircleDistance(x, _distance); });
 }
 
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::LineCircleDistanceFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double cx = *_vars[4];
-    double cy = *_vars[5];
-    double r = *_vars[6];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double line_len2 = dx * dx + dy * dy;
-
-    double px, py;
-    double t;
-
-    if (line_len2 < 1e-10) {
-        px = x1;
-        py = y1;
-        t = 0.0;
-    } else {
-        t = ((cx - x1) * dx + (cy - y1) * dy) / line_len2;
-        t = std::max(0.0, std::min(1.0, t));
-        px = x1 + t * dx;
-        py = y1 + t * dy;
-    }
-
-    double diff_x = px - cx;
-    double diff_y = py - cy;
-    double dist = std::sqrt(diff_x * diff_x + diff_y * diff_y);
-
-    if (dist < 1e-10) {
-        grad[_vars[0]] = 0.0;
-        grad[_vars[1]] = 0.0;
-        grad[_vars[2]] = 0.0;
-        grad[_vars[3]] = 0.0;
-        grad[_vars[4]] = 0.0;
-        grad[_vars[5]] = 0.0;
-        grad[_vars[6]] = 0.0;
-        return grad;
-    }
-
-    double dfdpx = diff_x / dist;
-    double dfdpy = diff_y / dist;
-
-    double dt_dx1 = (t == 0.0) ? 0.0 : ((cx - x1) * (-1) - dx * t) / line_len2;
-    double dt_dy1 = (t == 0.0) ? 0.0 : ((cy - y1) * (-1) - dy * t) / line_len2;
-    double dt_dx2 = (t == 1.0) ? 0.0 : (dx * (1 - t)) / line_len2;
-    double dt_dy2 = (t == 1.0) ? 0.0 : (dy * (1 - t)) / line_len2;
-
-    double dpx_dx1 = (t < 1.0 && t > 0.0) ? 1.0 + dt_dx1 * dx - t : 1.0;
-    double dpx_dy1 = dt_dy1 * dx;
-    double dpx_dx2 = dt_dx2 * dx + t;
-    double dpx_dy2 = dt_dy2 * dx;
-
-    double dpy_dx1 = dt_dx1 * dy;
-    double dpy_dy1 = 1.0 + dt_dy1 * dy - t;
-    double dpy_dx2 = dt_dx2 * dy;
-    double dpy_dy2 = dt_dy2 * dy + t;
-
-    grad[_vars[0]] = dfdpx * dpx_dx1 + dfdpy * dpy_dx1; // L1x
-    grad[_vars[1]] = dfdpx * dpx_dy1 + dfdpy * dpy_dy1; // L1y
-    grad[_vars[2]] = dfdpx * dpx_dx2 + dfdpy * dpy_dx2; // L2x
-    grad[_vars[3]] = dfdpx * dpx_dy2 + dfdpy * dpy_dy2; // L2y
-
-    grad[_vars[4]] = -dfdpx; // Cx
-    grad[_vars[5]] = -dfdpy; // Cy
-
-    grad[_vars[6]] = -1.0; // df/dR = -1
+    return kernelGradient<7>(_vars, [this](const auto& x) { return Kernels::lineCircleDistance(x, _distance); });
+}
 
-    return grad;
+void OurPaintDCM::Function::LineCircleDistanceFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<7>(_vars, partials, [this](const auto& x) { return Kernels::lineCircleDistance(x, _distance); });
 }
 
 size_t OurPaintDCM::Function::LineCircleDistanceFunction::getVarCount() const {
     return 7;
 }
 
+std::size_t OurPaintDCM::Function::LineCircleDistanceFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 //LineOnCircleFunction Requirement
 OurPaintDCM::Function::LineOnCircleFunction::LineOnCircleFunction(
     const std::vector<VAR> &vars) : RequirementFunction(
@@ -348,65 +218,25 @@ OurPaintDCM::Function::LineOnCircleFunction::LineOnCircleFunction(
 }
 
 double OurPaintDCM::Function::LineOnCircleFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double cx = *_vars[4];
-    double cy = *_vars[5];
-    double r = *_vars[6];
-
-    double dx1 = x1 - cx;
-    double dy1 = y1 - cy;
-    double dx2 = x2 - cx;
-    double dy2 = y2 - cy;
-
-    double dist1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
-    double dist2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
-
-    return (dist1 - r) + (dist2 - r);
+    return evaluateKernel<7>(_vars, [](const auto& x) { return Kernels::lineOnCircle(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::LineOnCircleFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double cx = *_vars[4];
-    double cy = *_vars[5];
-    double r = *_vars[6];
-
-    double dx1 = x1 - cx;
-    double dy1 = y1 - cy;
-    double dist1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
-
-    double dx2 = x2 - cx;
-    double dy2 = y2 - cy;
-    double dist2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
-
-    if (dist1 < 1e-10) dist1 = 1e-10;
-    if (dist2 < 1e-10) dist2 = 1e-10;
-
-    grad[_vars[0]] = dx1 / dist1; // d/dL1x
-    grad[_vars[1]] = dy1 / dist1; // d/dL1y
-
-    grad[_vars[2]] = dx2 / dist2; // d/dL2x
-    grad[_vars[3]] = dy2 / dist2; // d/dL2y
-
-    grad[_vars[4]] = -(dx1 / dist1 + dx2 / dist2); // d/dCx
-    grad[_vars[5]] = -(dy1 / dist1 + dy2 / dist2); // d/dCy
-
-    grad[_vars[6]] = -2.0;
+    return kernelGradient<7>(_vars, [](const auto& x) { return Kernels::lineOnCircle(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::LineOnCircleFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<7>(_vars, partials, [](const auto& x) { return Kernels::lineOnCircle(x); });
 }
 
 size_t OurPaintDCM::Function::LineOnCircleFunction::getVarCount() const {
     return 7;
 }
 
+std::size_t OurPaintDCM::Function::LineOnCircleFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 //LineLineParallelFunction Requirement
 OurPaintDCM::Function::LineLineParallelFunction::LineLineParallelFunction(
     const std::vector<VAR> &vars) : RequirementFunction(
@@ -417,59 +247,25 @@ OurPaintDCM::Function::LineLineParallelFunction::LineLineParallelFunction(
 }
 
 double OurPaintDCM::Function::LineLineParallelFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    double cross = dx1 * dy2 - dy1 * dx2;
-
-    return cross;
+    return evaluateKernel<8>(_vars, [](const auto& x) { return Kernels::lineLineParallel(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::LineLineParallelFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    grad[_vars[0]] = -dy2;
-    grad[_vars[1]] = dx2;
-    grad[_vars[2]] = dy2;
-    grad[_vars[3]] = -dx2;
-
-    grad[_vars[4]] = dy1;
-    grad[_vars[5]] = -dx1;
-    grad[_vars[6]] = -dy1;
-    grad[_vars[7]] = dx1;
+    return kernelGradient<8>(_vars, [](const auto& x) { return Kernels::lineLineParallel(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::LineLineParallelFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<8>(_vars, partials, [](const auto& x) { return Kernels::lineLineParallel(x); });
 }
 
 size_t OurPaintDCM::Function::LineLineParallelFunction::getVarCount() const {
     return 8;
 }
 
+std::size_t OurPaintDCM::Function::LineLineParallelFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // LineLinePerpendicularFunction Requirement
 OurPaintDCM::Function::LineLinePerpendicularFunction::LineLinePerpendicularFunction(
     const std::vector<VAR> &vars) : RequirementFunction(
@@ -480,57 +276,25 @@ OurPaintDCM::Function::LineLinePerpendicularFunction::LineLinePerpendicularFunct
 }
 
 double OurPaintDCM::Function::LineLinePerpendicularFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    return dx1 * dx2 + dy1 * dy2;
+    return evaluateKernel<8>(_vars, [](const auto& x) { return Kernels::lineLinePerpendicular(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::LineLinePerpendicularFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    grad[_vars[0]] = -dx2; // A1x
-    grad[_vars[1]] = -dy2; // A1y
-    grad[_vars[2]] = dx2; // A2x
-    grad[_vars[3]] = dy2; // A2y
-
-    grad[_vars[4]] = -dx1; // B1x
-    grad[_vars[5]] = -dy1; // B1y
-    grad[_vars[6]] = dx1; // B2x
-    grad[_vars[7]] = dy1; // B2y
+    return kernelGradient<8>(_vars, [](const auto& x) { return Kernels::lineLinePerpendicular(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::LineLinePerpendicularFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<8>(_vars, partials, [](const auto& x) { return Kernels::lineLinePerpendicular(x); });
 }
 
 size_t OurPaintDCM::Function::LineLinePerpendicularFunction::getVarCount() const {
     return 8;
 }
 
+std::size_t OurPaintDCM::Function::LineLinePerpendicularFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // LineLineAngleFunction Requirement
 OurPaintDCM::Function::LineLineAngleFunction::LineLineAngleFunction(const std::vector<VAR> &vars,
                                                                     double angle) : RequirementFunction(
@@ -541,78 +305,23 @@ OurPaintDCM::Function::LineLineAngleFunction::LineLineAngleFunction(const std::v
 }
 
 double OurPaintDCM::Function::LineLineAngleFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    double dot = dx1 * dx2 + dy1 * dy2;
-    double len1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
-    double len2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
-
-    if (len1 < 1e-10 || len2 < 1e-10) return 0.0;
-
-    double cos_theta = dot / (len1 * len2);
-    return cos_theta - std::cos(_angle);
+    return evaluateKernel<8>(_vars, [this](const auto& x) { return Kernels::lineLineAngle(x, _angle); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::LineLineAngleFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-    double x3 = *_vars[4];
-    double y3 = *_vars[5];
-    double x4 = *_vars[6];
-    double y4 = *_vars[7];
-
-    double dx1 = x2 - x1;
-    double dy1 = y2 - y1;
-    double dx2 = x4 - x3;
-    double dy2 = y4 - y3;
-
-    double len1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
-    double len2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
-
-    if (len1 < 1e-10 || len2 < 1e-10) {
-        for (VAR v: _vars) grad[v] = 0.0;
-        return grad;
-    }
-
-    double dot = dx1 * dx2 + dy1 * dy2;
-    double len1_3 = len1 * len1 * len1;
-    double len2_3 = len2 * len2 * len2;
-
-    const double dCosDdx1 = dx2 / (len1 * len2) - dx1 * dot / (len1_3 * len2);
-    const double dCosDdy1 = dy2 / (len1 * len2) - dy1 * dot / (len1_3 * len2);
-    const double dCosDdx2 = dx1 / (len1 * len2) - dx2 * dot / (len1 * len2_3);
-    const double dCosDdy2 = dy1 / (len1 * len2) - dy2 * dot / (len1 * len2_3);
-
-    grad[_vars[0]] = -dCosDdx1;
-    grad[_vars[1]] = -dCosDdy1;
-    grad[_vars[2]] = dCosDdx1;
-    grad[_vars[3]] = dCosDdy1;
-    grad[_vars[4]] = -dCosDdx2;
-    grad[_vars[5]] = -dCosDdy2;
-    grad[_vars[6]] = dCosDdx2;
-    grad[_vars[7]] = dCosDdy2;
+    return kernelGradient<8>(_vars, [this](const auto& x) { return Kernels::lineLineAngle(x, _angle); });
+}
 
-    return grad;
+void OurPaintDCM::Function::LineLineAngleFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<8>(_vars, partials, [this](const auto& x) { return Kernels::lineLineAngle(x, _angle); });
 }
 size_t OurPaintDCM::Function::LineLineAngleFunction::getVarCount() const {
     return 8;
 }
+
+std::size_t OurPaintDCM::Function::LineLineAngleFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
 // VerticalFunction Requirement
 OurPaintDCM::Function::VerticalFunction::VerticalFunction(const std::vector<VAR> &vars) : RequirementFunction(
     Utils::RequirementType::ET_VERTICAL, vars) {
@@ -622,53 +331,25 @@ OurPaintDCM::Function::VerticalFunction::VerticalFunction(const std::vector<VAR>
 }
 
 double OurPaintDCM::Function::VerticalFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double len = std::sqrt(dx * dx + dy * dy); // normalize
-
-    if (len < 1e-10)
-        return 0.0;
-
-    return dx / len;
+    return evaluateKernel<4>(_vars, [](const auto& x) { return Kernels::lineDirectionComponent<0>(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::VerticalFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double len2 = dx * dx + dy * dy;
-    double len = std::sqrt(len2);
-
-    if (len < 1e-10) {
-        for (auto v: _vars) grad[v] = 0.0;
-        return grad;
-    }
-
-    double len3 = len2 * len;
-
-    grad[_vars[0]] = -1.0 / len + dx * dx / len3; // df/dx1
-    grad[_vars[1]] = dx * dy / len3; // df/dy1
-    grad[_vars[2]] = 1.0 / len - dx * dx / len3; // df/dx2
-    grad[_vars[3]] = -dx * dy / len3; // df/dy2
+    return kernelGradient<4>(_vars, [](const auto& x) { return Kernels::lineDirectionComponent<0>(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::VerticalFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<4>(_vars, partials, [](const auto& x) { return Kernels::lineDirectionComponent<0>(x); });
 }
 
 size_t OurPaintDCM::Function::VerticalFunction::getVarCount() const {
     return 4;
 }
 
+std::size_t OurPaintDCM::Function::VerticalFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // HorizontalFunction Requirement
 OurPaintDCM::Function::HorizontalFunction::HorizontalFunction(const std::vector<VAR> &vars) : RequirementFunction(
     Utils::RequirementType::ET_HORIZONTAL, vars) {
@@ -678,48 +359,15 @@ OurPaintDCM::Function::HorizontalFunction::HorizontalFunction(const std::vector<
 }
 
 double OurPaintDCM::Function::HorizontalFunction::evaluate() const {
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double len = std::sqrt(dx * dx + dy * dy); // normalize
-
-    if (len < 1e-10)
-        return 0.0;
-
-    return dy / len;
+    return evaluateKernel<4>(_vars, [](const auto& x) { return Kernels::lineDirectionComponent<1>(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::HorizontalFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double x1 = *_vars[0];
-    double y1 = *_vars[1];
-    double x2 = *_vars[2];
-    double y2 = *_vars[3];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double len2 = dx * dx + dy * dy;
-    double len = std::sqrt(len2);
-
-    if (len < 1e-10) {
-        for (auto v: _vars) grad[v] = 0.0;
-        return grad;
-    }
-
-    double len3 = len2 * len;
-
-    // f = dy / len
-    grad[_vars[0]] = dx * dy / len3; // df/dx1
-    grad[_vars[1]] = -1.0 / len + dy * dy / len3; // df/dy1
-    grad[_vars[2]] = -dx * dy / len3; // df/dx2
-    grad[_vars[3]] = 1.0 / len - dy * dy / len3; // df/dy2
+    return kernelGradient<4>(_vars, [](const auto& x) { return Kernels::lineDirectionComponent<1>(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::HorizontalFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<4>(_vars, partials, [](const auto& x) { return Kernels::lineDirectionComponent<1>(x); });
 }
 
 
@@ -727,6 +375,10 @@ size_t OurPaintDCM::Function::HorizontalFunction::getVarCount() const {
     return 4;
 }
 
+std::size_t OurPaintDCM::Function::HorizontalFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 // ArcCenterOnPerpendicularFunction Requirement
 OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::ArcCenterOnPerpendicularFunction(
     const std::vector<VAR> &vars) : RequirementFunction(
@@ -737,60 +389,25 @@ OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::ArcCenterOnPerpendicula
 }
 
 double OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::evaluate() const {
-    double Ax = *_vars[0];
-    double Ay = *_vars[1];
-    double Bx = *_vars[2];
-    double By = *_vars[3];
-    double Cx = *_vars[4];
-    double Cy = *_vars[5];
-
-    // midpoint M
-    double Mx = 0.5 * (Ax + Bx);
-    double My = 0.5 * (Ay + By);
-
-    // AB vector
-    double dx = Bx - Ax;
-    double dy = By - Ay;
-
-    // MC vector
-    double mx = Cx - Mx;
-    double my = Cy - My;
-
-    // Perpendicular condition: (AB · MC) = 0
-    double dot = dx * mx + dy * my;
-
-    return dot;
+    return evaluateKernel<6>(_vars, [](const auto& x) { return Kernels::arcCenterOnPerpendicular(x); });
 }
 
 std::unordered_map<VAR, double> OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::gradient() const {
-    std::unordered_map<VAR, double> grad;
-
-    double Ax = *_vars[0];
-    double Ay = *_vars[1];
-    double Bx = *_vars[2];
-    double By = *_vars[3];
-    double Cx = *_vars[4];
-    double Cy = *_vars[5];
-
-    double dx = Bx - Ax;
-    double dy = By - Ay;
-    double mx = Cx - 0.5 * (Ax + Bx);
-    double my = Cy - 0.5 * (Ay + By);
-
-    grad[_vars[0]] = -mx - 0.5 * dx; // df/dAx
-    grad[_vars[1]] = -my - 0.5 * dy; // df/dAy
-    grad[_vars[2]] = mx - 0.5 * dx; // df/dBx
-    grad[_vars[3]] = my - 0.5 * dy; // df/dBy
-    grad[_vars[4]] = dx; // df/dCx
-    grad[_vars[5]] = dy; // df/dCy
+    return kernelGradient<6>(_vars, [](const auto& x) { return Kernels::arcCenterOnPerpendicular(x); });
+}
 
-    return grad;
+void OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::gradientInto(std::span<double> partials) const {
+    kernelPartials<6>(_vars, partials, [](const auto& x) { return Kernels::arcCenterOnPerpendicular(x); });
 }
 
 size_t OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::getVarCount() const {
     return 6;
 }
 
+std::size_t OurPaintDCM::Function::ArcCenterOnPerpendicularFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 OurPaintDCM::Function::FixCoordinateFunction::FixCoordinateFunction(
     Utils::RequirementType type, const std::vector<VAR>& vars, double target)
     : RequirementFunction(type, vars), _target(target) {
@@ -807,10 +424,18 @@ std::unordered_map<VAR, double> OurPaintDCM::Function::FixCoordinateFunction::gr
     return {{_vars[0], 1.0}};
 }
 
+void OurPaintDCM::Function::FixCoordinateFunction::gradientInto(std::span<double> partials) const {
+    partials[0] = 1.0;
+}
+
 size_t OurPaintDCM::Function::FixCoordinateFunction::getVarCount() const {
     return 1;
 }
 
+std::size_t OurPaintDCM::Function::FixCoordinateFunction::objectBytes() const noexcept {
+    return sizeof(*this);
+}
+
 bool OurPaintDCM::Function::FixCoordinateFunction::tryGetAssignment(VAR& var, double& value) const {
     var = _vars[0];
     value = _target;
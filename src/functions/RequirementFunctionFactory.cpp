@@ -1,30 +1,44 @@
 #include "RequirementFunctionFactory.h"
+#include "RequirementTraits.h"
 
 namespace OurPaintDCM::Function {
 
+namespace {
+
+using Utils::RequirementType;
+
+template<RequirementType Type, typename... Figures>
+auto createKernel(double param, Figures*... figures) {
+    using Tag = Requirements::RequirementTag<Type>;
+    return Requirements::makeKernel<Tag>(Requirements::collectFigureVariables<Tag>(figures...), param);
+}
+
+template<RequirementType Type, typename Figure>
+std::vector<std::shared_ptr<FixCoordinateFunction>> createFix(Figure* figure) {
+    using Tag = Requirements::RequirementTag<Type>;
+    const auto vars = Requirements::collectFigureVariables<Tag>(figure);
+    std::array<double, Tag::variableCount> targets{};
+    for (std::size_t k = 0; k < vars.size(); ++k) {
+        targets[k] = *vars[k];
+    }
+    return Requirements::makeFixKernels<Tag>(vars, targets);
+}
+
+} // namespace
+
 std::shared_ptr<PointLineDistanceFunction> RequirementFunctionFactory::createPointLineDist(
     Figures::Point2D* point,
     Figures::Line<Figures::Point2D>* line,
     double distance
 ) {
-    std::vector<VAR> vars = {
-        point->ptrX(), point->ptrY(),
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY()
-    };
-    return std::make_shared<PointLineDistanceFunction>(vars, distance);
+    return createKernel<RequirementType::ET_POINTLINEDIST>(distance, point, line);
 }
 
 std::shared_ptr<PointOnLineFunction> RequirementFunctionFactory::createPointOnLine(
     Figures::Point2D* point,
     Figures::Line<Figures::Point2D>* line
 ) {
-    std::vector<VAR> vars = {
-        point->ptrX(), point->ptrY(),
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY()
-    };
-    return std::make_shared<PointOnLineFunction>(vars);
+    return createKernel<RequirementType::ET_POINTONLINE>(0.0, point, line);
 }
 
 std::shared_ptr<PointPointDistanceFunction> RequirementFunctionFactory::createPointPointDist(
@@ -32,22 +46,14 @@ std::shared_ptr<PointPointDistanceFunction> RequirementFunctionFactory::createPo
     Figures::Point2D* p2,
     double distance
 ) {
-    std::vector<VAR> vars = {
-        p1->ptrX(), p1->ptrY(),
-        p2->ptrX(), p2->ptrY()
-    };
-    return std::make_shared<PointPointDistanceFunction>(vars, distance);
+    return createKernel<RequirementType::ET_POINTPOINTDIST>(distance, p1, p2);
 }
 
 std::shared_ptr<PointOnPointFunction> RequirementFunctionFactory::createPointOnPoint(
     Figures::Point2D* p1,
     Figures::Point2D* p2
 ) {
-    std::vector<VAR> vars = {
-        p1->ptrX(), p1->ptrY(),
-        p2->ptrX(), p2->ptrY()
-    };
-    return std::make_shared<PointOnPointFunction>(vars);
+    return createKernel<RequirementType::ET_POINTONPOINT>(0.0, p1, p2);
 }
 
 std::shared_ptr<LineCircleDistanceFunction> RequirementFunctionFactory::createLineCircleDist(
@@ -55,52 +61,28 @@ std::shared_ptr<LineCircleDistanceFunction> RequirementFunctionFactory::createLi
     Figures::Circle<Figures::Point2D>* circle,
     double distance
 ) {
-    std::vector<VAR> vars = {
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY(),
-        circle->center->ptrX(), circle->center->ptrY(),
-        circle->ptrRadius()
-    };
-    return std::make_shared<LineCircleDistanceFunction>(vars, distance);
+    return createKernel<RequirementType::ET_LINECIRCLEDIST>(distance, line, circle);
 }
 
 std::shared_ptr<LineOnCircleFunction> RequirementFunctionFactory::createLineOnCircle(
     Figures::Line<Figures::Point2D>* line,
     Figures::Circle<Figures::Point2D>* circle
 ) {
-    std::vector<VAR> vars = {
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY(),
-        circle->center->ptrX(), circle->center->ptrY(),
-        circle->ptrRadius()
-    };
-    return std::make_shared<LineOnCircleFunction>(vars);
+    return createKernel<RequirementType::ET_LINEONCIRCLE>(0.0, line, circle);
 }
 
 std::shared_ptr<LineLineParallelFunction> RequirementFunctionFactory::createLineLineParallel(
     Figures::Line<Figures::Point2D>* l1,
     Figures::Line<Figures::Point2D>* l2
 ) {
-    std::vector<VAR> vars = {
-        l1->p1->ptrX(), l1->p1->ptrY(),
-        l1->p2->ptrX(), l1->p2->ptrY(),
-        l2->p1->ptrX(), l2->p1->ptrY(),
-        l2->p2->ptrX(), l2->p2->ptrY()
-    };
-    return std::make_shared<LineLineParallelFunction>(vars);
+    return createKernel<RequirementType::ET_LINELINEPARALLEL>(0.0, l1, l2);
 }
 
 std::shared_ptr<LineLinePerpendicularFunction> RequirementFunctionFactory::createLineLinePerpendicular(
     Figures::Line<Figures::Point2D>* l1,
     Figures::Line<Figures::Point2D>* l2
 ) {
-    std::vector<VAR> vars = {
-        l1->p1->ptrX(), l1->p1->ptrY(),
-        l1->p2->ptrX(), l1->p2->ptrY(),
-        l2->p1->ptrX(), l2->p1->ptrY(),
-        l2->p2->ptrX(), l2->p2->ptrY()
-    };
-    return std::make_shared<LineLinePerpendicularFunction>(vars);
+    return createKernel<RequirementType::ET_LINELINEPERPENDICULAR>(0.0, l1, l2);
 }
 
 std::shared_ptr<LineLineAngleFunction> RequirementFunctionFactory::createLineLineAngle(
@@ -108,82 +90,43 @@ std::shared_ptr<LineLineAngleFunction> RequirementFunctionFactory::createLineLin
     Figures::Line<Figures::Point2D>* l2,
     double angle
 ) {
-    std::vector<VAR> vars = {
-        l1->p1->ptrX(), l1->p1->ptrY(),
-        l1->p2->ptrX(), l1->p2->ptrY(),
-        l2->p1->ptrX(), l2->p1->ptrY(),
-        l2->p2->ptrX(), l2->p2->ptrY()
-    };
-    return std::make_shared<LineLineAngleFunction>(vars, angle);
+    return createKernel<RequirementType::ET_LINELINEANGLE>(angle, l1, l2);
 }
 
 std::shared_ptr<VerticalFunction> RequirementFunctionFactory::createVertical(
     Figures::Line<Figures::Point2D>* line
 ) {
-    std::vector<VAR> vars = {
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY()
-    };
-    return std::make_shared<VerticalFunction>(vars);
+    return createKernel<RequirementType::ET_VERTICAL>(0.0, line);
 }
 
 std::shared_ptr<HorizontalFunction> RequirementFunctionFactory::createHorizontal(
     Figures::Line<Figures::Point2D>* line
 ) {
-    std::vector<VAR> vars = {
-        line->p1->ptrX(), line->p1->ptrY(),
-        line->p2->ptrX(), line->p2->ptrY()
-    };
-    return std::make_shared<HorizontalFunction>(vars);
+    return createKernel<RequirementType::ET_HORIZONTAL>(0.0, line);
 }
 
 std::shared_ptr<ArcCenterOnPerpendicularFunction> RequirementFunctionFactory::createArcCenterOnPerpendicular(
     Figures::Arc<Figures::Point2D>* arc
 ) {
-    std::vector<VAR> vars = {
-        arc->p1->ptrX(), arc->p1->ptrY(),
-        arc->p2->ptrX(), arc->p2->ptrY(),
-        arc->p_center->ptrX(), arc->p_center->ptrY()
-    };
-    return std::make_shared<ArcCenterOnPerpendicularFunction>(vars);
+    return createKernel<RequirementType::ET_ARCCENTERONPERPENDICULAR>(0.0, arc);
 }
+
 std::vector<std::shared_ptr<FixCoordinateFunction>> RequirementFunctionFactory::createFixPoint(
     Figures::Point2D* point
 ) {
-    return {
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXPOINT, std::vector<VAR>{point->ptrX()}, point->x()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXPOINT, std::vector<VAR>{point->ptrY()}, point->y())
-    };
+    return createFix<RequirementType::ET_FIXPOINT>(point);
 }
 
 std::vector<std::shared_ptr<FixCoordinateFunction>> RequirementFunctionFactory::createFixLine(
     Figures::Line<Figures::Point2D>* line
 ) {
-    return {
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXLINE, std::vector<VAR>{line->p1->ptrX()}, line->p1->x()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXLINE, std::vector<VAR>{line->p1->ptrY()}, line->p1->y()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXLINE, std::vector<VAR>{line->p2->ptrX()}, line->p2->x()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXLINE, std::vector<VAR>{line->p2->ptrY()}, line->p2->y())
-    };
+    return createFix<RequirementType::ET_FIXLINE>(line);
 }
 
 std::vector<std::shared_ptr<FixCoordinateFunction>> RequirementFunctionFactory::createFixCircle(
     Figures::Circle<Figures::Point2D>* circle
 ) {
-    return {
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXCIRCLE, std::vector<VAR>{circle->center->ptrX()}, circle->center->x()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXCIRCLE, std::vector<VAR>{circle->center->ptrY()}, circle->center->y()),
-        std::make_shared<FixCoordinateFunction>(
-            Utils::RequirementType::ET_FIXCIRCLE, std::vector<VAR>{circle->ptrRadius()}, circle->radius)
-    };
+    return createFix<RequirementType::ET_FIXCIRCLE>(circle);
 }
 
-} // namespace OurPaintDCM::Function
\ No newline at end of file
+} // namespace OurPaintDCM::Function
@@ -1,6 +1,19 @@
 #include "Requirements.h"
+#include "RequirementTraits.h"
 
 namespace OurPaintDCM::Requirements {
+namespace {
+template<Utils::RequirementType Type, typename... Figures>
+ErrorFunction* buildErrorFunction(double param, Figures*... figures) {
+    using Tag = RequirementTag<Type>;
+    std::vector<Variable*> x;
+    for (VAR var : collectFigureVariables<Tag>(figures...)) {
+        x.push_back(new Variable(var));
+    }
+    return makeErrorKernel<Tag>(std::move(x), param);
+}
+}
+
 // ----------------------------------------------------------------
 PointLineDist::PointLineDist(Figures::Point2D* p, Figures::Line<Figures::Point2D>* l, double dist)
     : Requirement(Utils::RequirementType::ET_POINTLINEDIST),
@@ -10,20 +23,7 @@ PointLineDist::PointLineDist(Figures::Point2D* p, Figures::Line<Figures::Point2D
 }
 
 ErrorFunction* PointLineDist::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  p_x      = new Variable(_p->ptrX());
-    auto*                  p_y      = new Variable(_p->ptrY());
-    auto*                  l_startx = new Variable(_l->p1->ptrX());
-    auto*                  l_starty = new Variable(_l->p1->ptrY());
-    auto*                  l_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l_endy   = new Variable(_l->p2->ptrY());
-    x.push_back(p_x);
-    x.push_back(p_y);
-    x.push_back(l_startx);
-    x.push_back(l_starty);
-    x.push_back(l_endx);
-    x.push_back(l_endy);
-    return new PointSectionDistanceError(x, _dist);
+    return buildErrorFunction<Utils::RequirementType::ET_POINTLINEDIST>(_dist, _p, _l);
 }
 
 //-----------------------------------------------------------------
@@ -34,20 +34,7 @@ PointOnLine::PointOnLine(Figures::Point2D* p, Figures::Line<Figures::Point2D>* l
 }
 
 ErrorFunction* PointOnLine::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  p_x      = new Variable(_p->ptrX());
-    auto*                  p_y      = new Variable(_p->ptrY());
-    auto*                  l_startx = new Variable(_l->p1->ptrX());
-    auto*                  l_starty = new Variable(_l->p1->ptrY());
-    auto*                  l_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l_endy   = new Variable(_l->p2->ptrY());
-    x.push_back(p_x);
-    x.push_back(p_y);
-    x.push_back(l_startx);
-    x.push_back(l_starty);
-    x.push_back(l_endx);
-    x.push_back(l_endy);
-    return new PointOnSectionError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_POINTONLINE>(0.0, _p, _l);
 }
 
 //-----------------------------------------------------------------
@@ -59,16 +46,7 @@ PointPointDist::PointPointDist(Figures::Point2D* p1, Figures::Point2D* p2, doubl
 }
 
 ErrorFunction* PointPointDist::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  p1_x = new Variable(_p1->ptrX());
-    auto*                  p1_y = new Variable(_p1->ptrY());
-    auto*                  p2_x = new Variable(_p2->ptrX());
-    auto*                  p2_y = new Variable(_p2->ptrY());
-    x.push_back(p1_x);
-    x.push_back(p1_y);
-    x.push_back(p2_x);
-    x.push_back(p2_y);
-    return new PointPointDistanceError(x, _dist);
+    return buildErrorFunction<Utils::RequirementType::ET_POINTPOINTDIST>(_dist, _p1, _p2);
 }
 
 // -----------------------------------------------------------------
@@ -79,16 +57,7 @@ PointOnPoint::PointOnPoint(Figures::Point2D* p1, Figures::Point2D* p2)
 }
 
 ErrorFunction* PointOnPoint::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  p1_x = new Variable(_p1->ptrX());
-    auto*                  p1_y = new Variable(_p1->ptrY());
-    auto*                  p2_x = new Variable(_p2->ptrX());
-    auto*                  p2_y = new Variable(_p2->ptrY());
-    x.push_back(p1_x);
-    x.push_back(p1_y);
-    x.push_back(p2_x);
-    x.push_back(p2_y);
-    return new PointOnPointError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_POINTONPOINT>(0.0, _p1, _p2);
 }
 
 // ----------------------------------------------------------------
@@ -102,22 +71,7 @@ LineCircleDist::LineCircleDist(Figures::Line<Figures::Point2D>*   line,
 }
 
 ErrorFunction* LineCircleDist::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l_startx = new Variable(_l->p1->ptrX());
-    auto*                  l_starty = new Variable(_l->p1->ptrY());
-    auto*                  l_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l_endy   = new Variable(_l->p2->ptrY());
-    auto*                  centerx  = new Variable(_c->center->ptrX());
-    auto*                  centery  = new Variable(_c->center->ptrY());
-    auto*                  radius   = new Variable(&_c->radius);
-    x.push_back(l_startx);
-    x.push_back(l_starty);
-    x.push_back(l_endx);
-    x.push_back(l_endy);
-    x.push_back(centerx);
-    x.push_back(centery);
-    x.push_back(radius);
-    return new SectionCircleDistanceError(x, _dist);
+    return buildErrorFunction<Utils::RequirementType::ET_LINECIRCLEDIST>(_dist, _l, _c);
 }
 
 // ------------------------------------------------------------------
@@ -128,22 +82,7 @@ LineOnCircle::LineOnCircle(Figures::Line<Figures::Point2D>* line, Figures::Circl
 }
 
 ErrorFunction* LineOnCircle::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l_startx = new Variable(_l->p1->ptrX());
-    auto*                  l_starty = new Variable(_l->p1->ptrY());
-    auto*                  l_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l_endy   = new Variable(_l->p2->ptrY());
-    auto*                  centerx  = new Variable(_c->center->ptrX());
-    auto*                  centery  = new Variable(_c->center->ptrY());
-    auto*                  radius   = new Variable(&_c->radius);
-    x.push_back(l_startx);
-    x.push_back(l_starty);
-    x.push_back(l_endx);
-    x.push_back(l_endy);
-    x.push_back(centerx);
-    x.push_back(centery);
-    x.push_back(radius);
-    return new SectionOnCircleError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_LINEONCIRCLE>(0.0, _l, _c);
 }
 
 // ----------------------------------------------------------------
@@ -154,22 +93,7 @@ LineInCircle::LineInCircle(Figures::Line<Figures::Point2D>* line, Figures::Circl
 }
 
 ErrorFunction* LineInCircle::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l_startx = new Variable(_l->p1->ptrX());
-    auto*                  l_starty = new Variable(_l->p1->ptrY());
-    auto*                  l_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l_endy   = new Variable(_l->p2->ptrY());
-    auto*                  centerx  = new Variable(_c->center->ptrX());
-    auto*                  centery  = new Variable(_c->center->ptrY());
-    auto*                  radius   = new Variable(&_c->radius);
-    x.push_back(l_startx);
-    x.push_back(l_starty);
-    x.push_back(l_endx);
-    x.push_back(l_endy);
-    x.push_back(centerx);
-    x.push_back(centery);
-    x.push_back(radius);
-    return new SectionInCircleError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_LINEINCIRCLE>(0.0, _l, _c);
 }
 
 // -----------------------------------------------------------------
@@ -181,24 +105,7 @@ LineLineParallel::LineLineParallel(Figures::Line<Figures::Point2D>* l1, Figures:
 }
 
 ErrorFunction* LineLineParallel::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l1_startx = new Variable(_l1->p1->ptrX());
-    auto*                  l1_starty = new Variable(_l1->p1->ptrY());
-    auto*                  l1_endx   = new Variable(_l1->p2->ptrX());
-    auto*                  l1_endy   = new Variable(_l1->p2->ptrY());
-    auto*                  l2_startx = new Variable(_l2->p1->ptrX());
-    auto*                  l2_starty = new Variable(_l2->p1->ptrY());
-    auto*                  l2_endx   = new Variable(_l2->p2->ptrX());
-    auto*                  l2_endy   = new Variable(_l2->p2->ptrY());
-    x.push_back(l1_startx);
-    x.push_back(l1_starty);
-    x.push_back(l1_endx);
-    x.push_back(l1_endy);
-    x.push_back(l2_startx);
-    x.push_back(l2_starty);
-    x.push_back(l2_endx);
-    x.push_back(l2_endy);
-    return new SectionSectionParallelError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_LINELINEPARALLEL>(0.0, _l1, _l2);
 }
 
 // -------------------------------------------------------------------
@@ -209,24 +116,7 @@ LineLinePerpendicular::LineLinePerpendicular(Figures::Line<Figures::Point2D>* l1
 }
 
 ErrorFunction* LineLinePerpendicular::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l1_startx = new Variable(_l1->p1->ptrX());
-    auto*                  l1_starty = new Variable(_l1->p1->ptrY());
-    auto*                  l1_endx   = new Variable(_l1->p2->ptrX());
-    auto*                  l1_endy   = new Variable(_l1->p2->ptrY());
-    auto*                  l2_startx = new Variable(_l2->p1->ptrX());
-    auto*                  l2_starty = new Variable(_l2->p1->ptrY());
-    auto*                  l2_endx   = new Variable(_l2->p2->ptrX());
-    auto*                  l2_endy   = new Variable(_l2->p2->ptrY());
-    x.push_back(l1_startx);
-    x.push_back(l1_starty);
-    x.push_back(l1_endx);
-    x.push_back(l1_endy);
-    x.push_back(l2_startx);
-    x.push_back(l2_starty);
-    x.push_back(l2_endx);
-    x.push_back(l2_endy);
-    return new SectionSectionPerpendicularError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_LINELINEPERPENDICULAR>(0.0, _l1, _l2);
 }
 
 // -----------------------------------------------------------------------
@@ -238,54 +128,19 @@ LineLineAngle::LineLineAngle(Figures::Line<Figures::Point2D>* l1, Figures::Line<
 }
 
 ErrorFunction* LineLineAngle::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l1_startx = new Variable(_l1->p1->ptrX());
-    auto*                  l1_starty = new Variable(_l1->p1->ptrY());
-    auto*                  l1_endx   = new Variable(_l1->p2->ptrX());
-    auto*                  l1_endy   = new Variable(_l1->p2->ptrY());
-    auto*                  l2_startx = new Variable(_l2->p1->ptrX());
-    auto*                  l2_starty = new Variable(_l2->p1->ptrY());
-    auto*                  l2_endx   = new Variable(_l2->p2->ptrX());
-    auto*                  l2_endy   = new Variable(_l2->p2->ptrY());
-    x.push_back(l1_startx);
-    x.push_back(l1_starty);
-    x.push_back(l1_endx);
-    x.push_back(l1_endy);
-    x.push_back(l2_startx);
-    x.push_back(l2_starty);
-    x.push_back(l2_endx);
-    x.push_back(l2_endy);
-    return new SectionSectionAngleError(x, _angle);
+    return buildErrorFunction<Utils::RequirementType::ET_LINELINEANGLE>(_angle, _l1, _l2);
 }
 
 // ---------------------------------------------------------------------
 LineHorizontal::LineHorizontal(Figures::Line<Figures::Point2D>* l) : Requirement(Utils::RequirementType::ET_HORIZONTAL),
 _l(l){}
 ErrorFunction* LineHorizontal::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l1_startx = new Variable(_l->p1->ptrX());
-    auto*                  l1_starty = new Variable(_l->p1->ptrY());
-    auto*                  l1_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l1_endy   = new Variable(_l->p2->ptrY());
-    x.push_back(l1_startx);
-    x.push_back(l1_starty);
-    x.push_back(l1_endx);
-    x.push_back(l1_endy);
-    return new HorizontalError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_HORIZONTAL>(0.0, _l);
 }
 // ---------------------------------------------------------------------
 LineVertical::LineVertical(Figures::Line<Figures::Point2D>* l) : Requirement(Utils::RequirementType::ET_VERTICAL),
 _l(l){}
 ErrorFunction* LineVertical::toFunction() {
-    std::vector<Variable*> x;
-    auto*                  l1_startx = new Variable(_l->p1->ptrX());
-    auto*                  l1_starty = new Variable(_l->p1->ptrY());
-    auto*                  l1_endx   = new Variable(_l->p2->ptrX());
-    auto*                  l1_endy   = new Variable(_l->p2->ptrY());
-    x.push_back(l1_startx);
-    x.push_back(l1_starty);
-    x.push_back(l1_endx);
-    x.push_back(l1_endy);
-    return new VerticalError(x);
+    return buildErrorFunction<Utils::RequirementType::ET_VERTICAL>(0.0, _l);
 }
 }
\ No newline at end of file
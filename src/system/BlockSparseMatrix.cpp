@@ -0,0 +1,490 @@
+#include "system/BlockSparseMatrix.h"
+#include "utils/MemoryUsage.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <Eigen/OrderingMethods>
+
+using namespace OurPaintDCM::System;
+using namespace OurPaintDCM::Function;
+
+BlockLayout::BlockLayout(const std::vector<VAR>& variables, const std::vector<std::pair<VAR, VAR>>& pointBlocks) {
+    std::unordered_map<VAR, Eigen::Index> columnOf;
+    columnOf.reserve(variables.size());
+    for (std::size_t j = 0; j < variables.size(); ++j) {
+        columnOf.emplace(variables[j], static_cast<Eigen::Index>(j));
+    }
+
+    _paddedIndex.assign(variables.size(), -1);
+    for (const auto& [x, y] : pointBlocks) {
+        const auto xIt = columnOf.find(x);
+        const auto yIt = columnOf.find(y);
+        if (xIt == columnOf.end() || yIt == columnOf.end() || xIt->second == yIt->second ||
+            _paddedIndex[static_cast<std::size_t>(xIt->second)] >= 0 ||
+            _paddedIndex[static_cast<std::size_t>(yIt->second)] >= 0) {
+            continue;
+        }
+        const auto block = static_cast<Eigen::Index>(_blocks.size());
+        _paddedIndex[static_cast<std::size_t>(xIt->second)] = 2 * block;
+        _paddedIndex[static_cast<std::size_t>(yIt->second)] = 2 * block + 1;
+        _blocks.push_back({xIt->second, yIt->second});
+    }
+    for (std::size_t j = 0; j < variables.size(); ++j) {
+        if (_paddedIndex[j] < 0) {
+            _paddedIndex[j] = static_cast<Eigen::Index>(2 * _blocks.size());
+            _blocks.push_back({static_cast<Eigen::Index>(j), -1});
+        }
+    }
+}
+
+BlockLayout BlockLayout::permuted(const std::vector<std::size_t>& order) const {
+    if (order.size() != _blocks.size()) {
+        throw std::invalid_argument("Block order must list every block once");
+    }
+    BlockLayout result;
+    result._blocks.reserve(_blocks.size());
+    result._paddedIndex.assign(_paddedIndex.size(), -1);
+    for (const std::size_t block : order) {
+        if (block >= _blocks.size() || result._paddedIndex[static_cast<std::size_t>(_blocks[block][0])] >= 0) {
+            throw std::invalid_argument("Block order must list every block once");
+        }
+        const auto& columns = _blocks[block];
+        const auto position = static_cast<Eigen::Index>(result._blocks.size());
+        for (Eigen::Index slot = 0; slot < 2; ++slot) {
+            if (columns[static_cast<std::size_t>(slot)] >= 0) {
+                result._paddedIndex[static_cast<std::size_t>(columns[static_cast<std::size_t>(slot)])] =
+                    2 * position + slot;
+            }
+        }
+        result._blocks.push_back(columns);
+    }
+    return result;
+}
+
+BlockLayout BlockLayout::fromFunctions(const std::vector<VAR>& variables,
+                                       const std::vector<std::shared_ptr<RequirementFunction>>& functions) {
+    std::vector<std::pair<VAR, VAR>> pointBlocks;
+    for (const auto& function : functions) {
+        const auto vars = function->getVars();
+        for (std::size_t i = 0; i + 1 < vars.size(); i += 2) {
+            pointBlocks.emplace_back(vars[i], vars[i + 1]);
+        }
+    }
+    return BlockLayout(variables, pointBlocks);
+}
+
+void BlockLayout::gather(const Eigen::VectorXd& scalar, Eigen::VectorXd& padded) const {
+    padded.setZero(paddedSize());
+    for (std::size_t j = 0; j < _paddedIndex.size(); ++j) {
+        padded[_paddedIndex[j]] = scalar[static_cast<Eigen::Index>(j)];
+    }
+}
+
+void BlockLayout::scatter(const Eigen::VectorXd& padded, Eigen::VectorXd& scalar) const {
+    scalar.resize(static_cast<Eigen::Index>(_paddedIndex.size()));
+    for (std::size_t j = 0; j < _paddedIndex.size(); ++j) {
+        scalar[static_cast<Eigen::Index>(j)] = padded[_paddedIndex[j]];
+    }
+}
+
+std::size_t BlockLayout::heapBytes() const noexcept {
+    return Utils::heapBytes(_blocks) + Utils::heapBytes(_paddedIndex);
+}
+
+BlockSparseJacobian::BlockSparseJacobian(BlockLayout layout,
+                                         const std::vector<std::shared_ptr<RequirementFunction>>& functions,
+                                         const std::unordered_map<VAR, Eigen::Index>& columnOf)
+    : _layout(std::move(layout)) {
+    _rowStart.reserve(functions.size() + 1);
+    _rowStart.push_back(0);
+    _rowEntries.resize(functions.size());
+
+    std::vector<std::pair<std::size_t, Eigen::Index>> rowPadded;
+    std::vector<Eigen::Index> rowBlocks;
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        rowPadded.clear();
+        rowBlocks.clear();
+        const auto vars = functions[i]->getVars();
+        if (vars.size() > RequirementFunction::kMaxVarCount) {
+            throw std::invalid_argument("Requirement function has more variables than kMaxVarCount");
+        }
+        for (std::size_t position = 0; position < vars.size(); ++position) {
+            if (const auto it = columnOf.find(vars[position]); it != columnOf.end()) {
+                const Eigen::Index padded = _layout.paddedIndex(it->second);
+                rowPadded.emplace_back(position, padded);
+                rowBlocks.push_back(padded / 2);
+            }
+        }
+        std::sort(rowBlocks.begin(), rowBlocks.end());
+        rowBlocks.erase(std::unique(rowBlocks.begin(), rowBlocks.end()), rowBlocks.end());
+
+        const auto rowOffset = static_cast<Eigen::Index>(_blockColumn.size());
+        _blockColumn.insert(_blockColumn.end(), rowBlocks.begin(), rowBlocks.end());
+        _rowStart.push_back(static_cast<Eigen::Index>(_blockColumn.size()));
+        for (const auto& [position, padded] : rowPadded) {
+            const auto slot = std::lower_bound(rowBlocks.begin(), rowBlocks.end(), padded / 2) - rowBlocks.begin();
+            _rowEntries[i].emplace_back(position, 2 * (rowOffset + slot) + padded % 2);
+        }
+    }
+    _values.assign(2 * _blockColumn.size(), 0.0);
+}
+
+void BlockSparseJacobian::assemble(const std::vector<std::shared_ptr<RequirementFunction>>& functions) {
+    // Row slots are disjoint, so row ranges fill in parallel without synchronisation.
+    Utils::ThreadPool::shared().parallelFor(_rowEntries.size(), Utils::kParallelRowGrain,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+            std::fill(_values.begin() + 2 * _rowStart[begin], _values.begin() + 2 * _rowStart[end], 0.0);
+            std::array<double, RequirementFunction::kMaxVarCount> partials{};
+            for (std::size_t i = begin; i < end; ++i) {
+                if (_rowEntries[i].empty()) {
+                    continue;
+                }
+                const double weight = functions[i]->getWeight();
+                functions[i]->gradientInto(partials);
+                for (const auto& [position, slot] : _rowEntries[i]) {
+                    _values[static_cast<std::size_t>(slot)] += partials[position] * weight;
+                }
+            }
+        });
+}
+
+void BlockSparseJacobian::multiply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const {
+    y.resize(rows());
+    Utils::ThreadPool::shared().parallelFor(static_cast<std::size_t>(rows()), Utils::kParallelRowGrain,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto row = static_cast<Eigen::Index>(begin); row < static_cast<Eigen::Index>(end); ++row) {
+                double sum = 0.0;
+                for (Eigen::Index b = rowStart(row); b < rowStart(row + 1); ++b) {
+                    sum += block(b).dot(x.segment<2>(2 * blockColumn(b)));
+                }
+                y[row] = sum;
+            }
+        });
+}
+
+void BlockSparseJacobian::multiplyTransposed(const Eigen::VectorXd& x, Eigen::VectorXd& y) const {
+    y.setZero(_layout.paddedSize());
+    for (Eigen::Index row = 0; row < rows(); ++row) {
+        const double value = x[row];
+        for (Eigen::Index b = rowStart(row); b < rowStart(row + 1); ++b) {
+            y.segment<2>(2 * blockColumn(b)) += block(b) * value;
+        }
+    }
+}
+
+void BlockSparseJacobian::columnSquaredNorms(Eigen::VectorXd& norms) const {
+    norms.setZero(_layout.paddedSize());
+    for (std::size_t b = 0; b < _blockColumn.size(); ++b) {
+        const auto index = static_cast<Eigen::Index>(b);
+        norms.segment<2>(2 * blockColumn(index)) += block(index).cwiseAbs2();
+    }
+}
+
+void BlockSparseJacobian::diagonalBlocks(std::vector<Eigen::Matrix2d>& blocks) const {
+    blocks.assign(_layout.blockCount(), Eigen::Matrix2d::Zero());
+    for (std::size_t b = 0; b < _blockColumn.size(); ++b) {
+        const auto index = static_cast<Eigen::Index>(b);
+        const Eigen::Vector2d value = block(index);
+        blocks[static_cast<std::size_t>(blockColumn(index))] += value * value.transpose();
+    }
+}
+
+std::vector<std::size_t> BlockSparseJacobian::fillReducingOrder() const {
+    const auto blockCount = static_cast<Eigen::Index>(_layout.blockCount());
+    if (blockCount == 0) {
+        return {};
+    }
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(_layout.blockCount());
+    for (Eigen::Index k = 0; k < blockCount; ++k) {
+        triplets.emplace_back(k, k, 1.0);
+    }
+    for (Eigen::Index row = 0; row < rows(); ++row) {
+        for (Eigen::Index p = rowStart(row); p < rowStart(row + 1); ++p) {
+            for (Eigen::Index q = p + 1; q < rowStart(row + 1); ++q) {
+                triplets.emplace_back(blockColumn(p), blockColumn(q), 1.0);
+                triplets.emplace_back(blockColumn(q), blockColumn(p), 1.0);
+            }
+        }
+    }
+    Eigen::SparseMatrix<double> graph(blockCount, blockCount);
+    graph.setFromTriplets(triplets.begin(), triplets.end());
+
+    // AMD reports, for each position of the ordered matrix, the block that moves there.
+    Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> permutation;
+    Eigen::AMDOrdering<int>()(graph, permutation);
+    std::vector<std::size_t> order(_layout.blockCount());
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        order[k] = static_cast<std::size_t>(permutation.indices()[static_cast<Eigen::Index>(k)]);
+    }
+    return order;
+}
+
+Eigen::SparseMatrix<double> BlockSparseJacobian::toSparse() const {
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(_values.size());
+    for (Eigen::Index row = 0; row < rows(); ++row) {
+        for (Eigen::Index b = rowStart(row); b < rowStart(row + 1); ++b) {
+            const auto& columns = _layout.columns(static_cast<std::size_t>(blockColumn(b)));
+            for (int slot = 0; slot < 2; ++slot) {
+                if (columns[slot] >= 0 && block(b)[slot] != 0.0) {
+                    triplets.emplace_back(row, columns[slot], block(b)[slot]);
+                }
+            }
+        }
+    }
+    Eigen::SparseMatrix<double> result(rows(), static_cast<Eigen::Index>(_layout.variableCount()));
+    result.setFromTriplets(triplets.begin(), triplets.end());
+    return result;
+}
+
+std::size_t BlockSparseJacobian::heapBytes() const noexcept {
+    return _layout.heapBytes() + Utils::heapBytes(_rowStart) + Utils::heapBytes(_blockColumn) +
+           Utils::heapBytes(_values) + Utils::heapBytes(_rowEntries);
+}
+
+BlockSparseSymmetricMatrix::BlockSparseSymmetricMatrix(const BlockSparseJacobian& jacobian)
+    : _blockCount(jacobian.layout().blockCount()) {
+    std::vector<std::vector<Eigen::Index>> rowColumns(_blockCount);
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        rowColumns[k].push_back(static_cast<Eigen::Index>(k));
+    }
+    for (Eigen::Index row = 0; row < jacobian.rows(); ++row) {
+        for (Eigen::Index p = jacobian.rowStart(row); p < jacobian.rowStart(row + 1); ++p) {
+            for (Eigen::Index q = p + 1; q < jacobian.rowStart(row + 1); ++q) {
+                rowColumns[static_cast<std::size_t>(jacobian.blockColumn(p))].push_back(jacobian.blockColumn(q));
+            }
+        }
+    }
+
+    _rowStart.reserve(_blockCount + 1);
+    _rowStart.push_back(0);
+    for (auto& columns : rowColumns) {
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        _blockColumn.insert(_blockColumn.end(), columns.begin(), columns.end());
+        _rowStart.push_back(static_cast<Eigen::Index>(_blockColumn.size()));
+    }
+    _values.assign(4 * _blockColumn.size(), 0.0);
+
+    // Row blocks are sorted by block column, so every (p, q ≥ p) pair lands in the upper triangle.
+    _rowTargets.resize(static_cast<std::size_t>(jacobian.rows()));
+    for (Eigen::Index row = 0; row < jacobian.rows(); ++row) {
+        auto& targets = _rowTargets[static_cast<std::size_t>(row)];
+        for (Eigen::Index p = jacobian.rowStart(row); p < jacobian.rowStart(row + 1); ++p) {
+            const auto blockRow = static_cast<std::size_t>(jacobian.blockColumn(p));
+            const auto first = _blockColumn.begin() + _rowStart[blockRow];
+            const auto last = _blockColumn.begin() + _rowStart[blockRow + 1];
+            for (Eigen::Index q = p; q < jacobian.rowStart(row + 1); ++q) {
+                targets.push_back(std::lower_bound(first, last, jacobian.blockColumn(q)) - _blockColumn.begin());
+            }
+        }
+    }
+}
+
+void BlockSparseSymmetricMatrix::assign(const BlockSparseJacobian& jacobian, const Eigen::VectorXd& damping) {
+    // Different Jacobian rows hit the same normal blocks, so each chunk of rows accumulates
+    // into its own buffer; chunk 0 writes _values directly and the rest are merged in order.
+    auto& pool = Utils::ThreadPool::shared();
+    const auto rows = static_cast<std::size_t>(jacobian.rows());
+    const std::size_t chunks = std::max<std::size_t>(pool.chunkCount(rows, Utils::kParallelRowGrain), 1);
+    if (_chunkValues.size() < chunks - 1) {
+        _chunkValues.resize(chunks - 1);
+    }
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+        _chunkValues[chunk - 1].resize(_values.size());
+    }
+    std::fill(_values.begin(), _values.end(), 0.0);
+    pool.parallelFor(rows, Utils::kParallelRowGrain, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        std::vector<double>& values = chunk == 0 ? _values : _chunkValues[chunk - 1];
+        if (chunk != 0) {
+            std::fill(values.begin(), values.end(), 0.0);
+        }
+        for (auto row = static_cast<Eigen::Index>(begin); row < static_cast<Eigen::Index>(end); ++row) {
+            const auto& targets = _rowTargets[static_cast<std::size_t>(row)];
+            std::size_t target = 0;
+            for (Eigen::Index p = jacobian.rowStart(row); p < jacobian.rowStart(row + 1); ++p) {
+                const Eigen::Vector2d lhs = jacobian.block(p);
+                for (Eigen::Index q = p; q < jacobian.rowStart(row + 1); ++q) {
+                    Eigen::Map<Eigen::Matrix2d>(values.data() + 4 * targets[target++]) +=
+                        lhs * jacobian.block(q).transpose();
+                }
+            }
+        }
+    });
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+        const auto& values = _chunkValues[chunk - 1];
+        std::transform(_values.begin(), _values.end(), values.begin(), _values.begin(), std::plus<>());
+    }
+
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        Eigen::Map<Eigen::Matrix2d> diagonal(_values.data() + 4 * _rowStart[k]);
+        const auto index = static_cast<Eigen::Index>(2 * k);
+        diagonal(0, 0) += damping[index];
+        if (jacobian.layout().columns(k)[1] < 0) {
+            diagonal(1, 1) = 1.0;
+        } else {
+            diagonal(1, 1) += damping[index + 1];
+        }
+    }
+}
+
+void BlockSparseSymmetricMatrix::multiply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const {
+    y.setZero(static_cast<Eigen::Index>(2 * _blockCount));
+    for (std::size_t i = 0; i < _blockCount; ++i) {
+        const auto row = static_cast<Eigen::Index>(i);
+        for (Eigen::Index b = _rowStart[i]; b < _rowStart[i + 1]; ++b) {
+            const Eigen::Index column = blockColumn(b);
+            y.segment<2>(2 * row).noalias() += block(b) * x.segment<2>(2 * column);
+            if (column != row) {
+                y.segment<2>(2 * column).noalias() += block(b).transpose() * x.segment<2>(2 * row);
+            }
+        }
+    }
+}
+
+Eigen::SparseMatrix<double> BlockSparseSymmetricMatrix::toSparse() const {
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(2 * _values.size());
+    for (std::size_t i = 0; i < _blockCount; ++i) {
+        const auto row = static_cast<Eigen::Index>(i);
+        for (Eigen::Index b = _rowStart[i]; b < _rowStart[i + 1]; ++b) {
+            const Eigen::Index column = blockColumn(b);
+            for (int r = 0; r < 2; ++r) {
+                for (int c = 0; c < 2; ++c) {
+                    const double value = block(b)(r, c);
+                    if (value == 0.0) {
+                        continue;
+                    }
+                    triplets.emplace_back(2 * row + r, 2 * column + c, value);
+                    if (column != row) {
+                        triplets.emplace_back(2 * column + c, 2 * row + r, value);
+                    }
+                }
+            }
+        }
+    }
+    const auto size = static_cast<Eigen::Index>(2 * _blockCount);
+    Eigen::SparseMatrix<double> result(size, size);
+    result.setFromTriplets(triplets.begin(), triplets.end());
+    return result;
+}
+
+std::size_t BlockSparseSymmetricMatrix::heapBytes() const noexcept {
+    return Utils::heapBytes(_rowStart) + Utils::heapBytes(_blockColumn) + Utils::heapBytes(_values) +
+           Utils::heapBytes(_rowTargets) + Utils::heapBytes(_chunkValues);
+}
+
+void BlockCholesky::analyze(const BlockSparseSymmetricMatrix& matrix) {
+    _blockCount = matrix.blockCount();
+    _pattern.assign(_blockCount, {});
+
+    // Row k of U holds A's upper row k plus the fill inherited from its elimination-tree children.
+    std::vector<std::vector<std::size_t>> children(_blockCount);
+    std::vector<Eigen::Index> merged;
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        auto& pattern = _pattern[k];
+        for (Eigen::Index b = matrix.rowStart(k); b < matrix.rowStart(k + 1); ++b) {
+            if (matrix.blockColumn(b) != static_cast<Eigen::Index>(k)) {
+                pattern.push_back(matrix.blockColumn(b));
+            }
+        }
+        for (const std::size_t child : children[k]) {
+            merged.clear();
+            std::set_union(pattern.begin(), pattern.end(), _pattern[child].begin(), _pattern[child].end(),
+                           std::back_inserter(merged));
+            pattern.swap(merged);
+        }
+        pattern.erase(std::remove(pattern.begin(), pattern.end(), static_cast<Eigen::Index>(k)), pattern.end());
+        if (!pattern.empty()) {
+            children[static_cast<std::size_t>(pattern.front())].push_back(k);
+        }
+    }
+
+    _upper.resize(_blockCount);
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        _upper[k].resize(_pattern[k].size());
+    }
+    _diagonal.resize(_blockCount);
+    _ready = false;
+}
+
+bool BlockCholesky::factorize(const BlockSparseSymmetricMatrix& matrix) {
+    _ready = false;
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        std::fill(_upper[k].begin(), _upper[k].end(), Eigen::Matrix2d::Zero());
+        for (Eigen::Index b = matrix.rowStart(k); b < matrix.rowStart(k + 1); ++b) {
+            const Eigen::Index column = matrix.blockColumn(b);
+            if (column == static_cast<Eigen::Index>(k)) {
+                _diagonal[k] = matrix.block(b);
+            } else {
+                const auto slot = std::lower_bound(_pattern[k].begin(), _pattern[k].end(), column) - _pattern[k].begin();
+                _upper[k][static_cast<std::size_t>(slot)] = matrix.block(b);
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        Eigen::LLT<Eigen::Matrix2d> llt(_diagonal[k]);
+        if (llt.info() != Eigen::Success) {
+            return false;
+        }
+        _diagonal[k] = llt.matrixU();
+        const auto diagonalTransposed = _diagonal[k].transpose().triangularView<Eigen::Lower>();
+        for (auto& block : _upper[k]) {
+            block = diagonalTransposed.solve(block);
+        }
+
+        const auto& pattern = _pattern[k];
+        for (std::size_t a = 0; a < pattern.size(); ++a) {
+            const auto i = static_cast<std::size_t>(pattern[a]);
+            _diagonal[i].noalias() -= _upper[k][a].transpose() * _upper[k][a];
+            for (std::size_t b = a + 1; b < pattern.size(); ++b) {
+                const auto slot = std::lower_bound(_pattern[i].begin(), _pattern[i].end(), pattern[b]) - _pattern[i].begin();
+                _upper[i][static_cast<std::size_t>(slot)].noalias() -= _upper[k][a].transpose() * _upper[k][b];
+            }
+        }
+    }
+
+    _ready = true;
+    return true;
+}
+
+void BlockCholesky::solve(const Eigen::VectorXd& b, Eigen::VectorXd& x) const {
+    x = b;
+    if (!_ready) {
+        return;
+    }
+
+    // Uᵀz = b, then Ux = z.
+    for (std::size_t k = 0; k < _blockCount; ++k) {
+        const auto row = static_cast<Eigen::Index>(2 * k);
+        x.segment<2>(row) = _diagonal[k].transpose().triangularView<Eigen::Lower>().solve(x.segment<2>(row));
+        for (std::size_t a = 0; a < _pattern[k].size(); ++a) {
+            x.segment<2>(2 * _pattern[k][a]).noalias() -= _upper[k][a].transpose() * x.segment<2>(row);
+        }
+    }
+    for (std::size_t k = _blockCount; k-- > 0;) {
+        const auto row = static_cast<Eigen::Index>(2 * k);
+        Eigen::Vector2d value = x.segment<2>(row);
+        for (std::size_t a = 0; a < _pattern[k].size(); ++a) {
+            value.noalias() -= _upper[k][a] * x.segment<2>(2 * _pattern[k][a]);
+        }
+        x.segment<2>(row) = _diagonal[k].triangularView<Eigen::Upper>().solve(value);
+    }
+}
+
+std::size_t BlockCholesky::blockNonZeros() const noexcept {
+    std::size_t count = _blockCount;
+    for (const auto& pattern : _pattern) {
+        count += pattern.size();
+    }
+    return count;
+}
+
+std::size_t BlockCholesky::heapBytes() const noexcept {
+    return Utils::heapBytes(_pattern) + Utils::heapBytes(_upper) + Utils::heapBytes(_diagonal);
+}
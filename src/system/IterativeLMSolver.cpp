@@ -0,0 +1,279 @@
+#include "system/IterativeLMSolver.h"
+#include "utils/MemoryUsage.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+using namespace OurPaintDCM::System;
+using namespace OurPaintDCM::Function;
+
+namespace {
+/// Marquardt scaling floor for columns that no residual currently constrains.
+constexpr double kMinimumDamping = 1e-12;
+/// Marquardt scaling floor relative to the largest column, for columns that are almost unconstrained.
+constexpr double kRelativeScalingFloor = 1e-6;
+constexpr double kInitialLambda = 1e-3;
+constexpr double kMaximumLambda = 1e12;
+
+std::unordered_map<VAR, Eigen::Index> makeColumnMap(const std::vector<VAR>& variables,
+                                                    const std::vector<std::pair<VAR, VAR>>& aliases) {
+    std::unordered_map<VAR, Eigen::Index> columnOf;
+    columnOf.reserve(variables.size() + aliases.size());
+    for (std::size_t j = 0; j < variables.size(); ++j) {
+        columnOf.emplace(variables[j], static_cast<Eigen::Index>(j));
+    }
+    // Aliased variables share their representative's column.
+    for (const auto& [member, representative] : aliases) {
+        if (const auto it = columnOf.find(representative); it != columnOf.end()) {
+            columnOf.emplace(member, it->second);
+        }
+    }
+    return columnOf;
+}
+}
+
+IterativeLMSolver::IterativeLMSolver(std::vector<std::shared_ptr<RequirementFunction>> functions,
+                                     std::vector<VAR> variables,
+                                     const std::vector<std::pair<VAR, VAR>>& pointBlocks,
+                                     std::vector<std::pair<VAR, VAR>> aliases)
+    : _functions(std::move(functions)),
+      _variables(std::move(variables)),
+      _aliases(std::move(aliases)),
+      _jacobian(BlockLayout(_variables, pointBlocks), _functions, makeColumnMap(_variables, _aliases)) {
+    _blockInverses.resize(_jacobian.layout().blockCount());
+}
+
+bool IterativeLMSolver::solve() {
+    _iterations = 0;
+    _innerIterations = 0;
+    _dampingHistory.clear();
+    _dampingHistory.reserve(_options.maxIterations);
+    if (_options.innerSolver == InnerSolver::BlockCholesky && _normal == nullptr) {
+        prepareBlockCholesky();
+    }
+
+    // Work vectors are members, so after the first solve repeated solves do not allocate.
+    const auto n = static_cast<Eigen::Index>(_variables.size());
+    _scalarValues.resize(n);
+    for (Eigen::Index j = 0; j < n; ++j) {
+        _scalarValues[j] = *_variables[static_cast<std::size_t>(j)];
+    }
+    auto& values = _values;
+    _jacobian.layout().gather(_scalarValues, values);
+    applyValues(values);
+
+    auto& residuals = _residuals;
+    auto& candidateResiduals = _candidateResiduals;
+    residuals.resize(static_cast<Eigen::Index>(_functions.size()));
+    candidateResiduals.resize(residuals.size());
+    _candidate.resize(values.size());
+    _gradient.resize(values.size());
+    _scaling.setZero(values.size());
+    _damping.resize(values.size());
+    _step.resize(values.size());
+    evaluateResiduals(residuals);
+
+    const auto withinTolerance = [this](const Eigen::VectorXd& r) {
+        return r.size() == 0 || r.cwiseAbs().maxCoeff() <= _options.tolerance;
+    };
+
+    double lambda = kInitialLambda;
+    _converged = withinTolerance(residuals);
+    while (!_converged && n > 0 && _iterations < _options.maxIterations) {
+        ++_iterations;
+        _jacobian.assemble(_functions);
+        _jacobian.multiplyTransposed(residuals, _gradient);
+        // Moré's scaling: every column keeps the largest norm it had during this solve. A column
+        // whose partials vanish near the solution (a point sliding along its only requirement)
+        // would otherwise be left almost undamped and send the step far along it.
+        _jacobian.columnSquaredNorms(_damping);
+        _scaling = _scaling.cwiseMax(_damping);
+        const double scalingFloor = std::max(kMinimumDamping, kRelativeScalingFloor * _scaling.maxCoeff());
+
+        bool improved = false;
+        while (!improved && lambda < kMaximumLambda) {
+            _damping = lambda * _scaling.cwiseMax(scalingFloor);
+            _innerIterations += solveDampedStep(_gradient, _damping, _step);
+            _candidate = values - _step;
+            applyValues(_candidate);
+            evaluateResiduals(candidateResiduals);
+            if (candidateResiduals.squaredNorm() < residuals.squaredNorm()) {
+                values.swap(_candidate);
+                residuals.swap(candidateResiduals);
+                _dampingHistory.push_back(lambda);
+                lambda = std::max(lambda * 0.1, kMinimumDamping);
+                improved = true;
+            } else {
+                lambda *= 10.0;
+            }
+        }
+        if (!improved) {
+            applyValues(values);
+            break;
+        }
+        _converged = withinTolerance(residuals);
+    }
+
+    return _converged;
+}
+
+bool IterativeLMSolver::isConverged() const noexcept {
+    return _converged;
+}
+
+std::size_t IterativeLMSolver::getIterationCount() const noexcept {
+    return _iterations;
+}
+
+std::size_t IterativeLMSolver::getInnerIterationCount() const noexcept {
+    return _innerIterations;
+}
+
+const std::vector<double>& IterativeLMSolver::getDampingHistory() const noexcept {
+    return _dampingHistory;
+}
+
+void IterativeLMSolver::setOptions(const Options& options) noexcept {
+    _options = options;
+}
+
+const IterativeLMSolver::Options& IterativeLMSolver::getOptions() const noexcept {
+    return _options;
+}
+
+void IterativeLMSolver::setUpdateHook(std::function<void()> update) {
+    _updateHook = std::move(update);
+}
+
+std::size_t IterativeLMSolver::heapBytes() const noexcept {
+    std::size_t bytes = Utils::heapBytes(_functions) + Utils::heapBytes(_variables) + Utils::heapBytes(_aliases) +
+                        _jacobian.heapBytes() + _cholesky.heapBytes() + Utils::heapBytes(_blockInverses) +
+                        Utils::heapBytes(_dampingHistory);
+    if (_normal != nullptr) {
+        bytes += sizeof(BlockSparseSymmetricMatrix) + _normal->heapBytes();
+    }
+    for (const Eigen::VectorXd* work : {&_scalarValues, &_values, &_residuals, &_candidateResiduals, &_candidate,
+                                        &_gradient, &_scaling, &_damping, &_step, &_cgResidual, &_cgPreconditioned,
+                                        &_cgDirection, &_cgProduct, &_cgJacobianProduct}) {
+        bytes += static_cast<std::size_t>(work->size()) * sizeof(double);
+    }
+    return bytes;
+}
+
+void IterativeLMSolver::evaluateResiduals(Eigen::VectorXd& residuals) const {
+    Utils::ThreadPool::shared().parallelFor(_functions.size(), Utils::kParallelRowGrain,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                residuals[static_cast<Eigen::Index>(i)] = _functions[i]->evaluate() * _functions[i]->getWeight();
+            }
+        });
+}
+
+void IterativeLMSolver::applyValues(const Eigen::VectorXd& padded) const {
+    const auto& layout = _jacobian.layout();
+    for (std::size_t j = 0; j < _variables.size(); ++j) {
+        *_variables[j] = padded[layout.paddedIndex(static_cast<Eigen::Index>(j))];
+    }
+    for (const auto& [member, representative] : _aliases) {
+        *member = *representative;
+    }
+    if (_updateHook) {
+        _updateHook();
+    }
+}
+
+void IterativeLMSolver::buildPreconditioner(const Eigen::VectorXd& damping) {
+    _jacobian.diagonalBlocks(_blockInverses);
+    for (std::size_t k = 0; k < _blockInverses.size(); ++k) {
+        auto& block = _blockInverses[k];
+        const auto index = static_cast<Eigen::Index>(2 * k);
+        block(0, 0) += damping[index];
+        if (_jacobian.layout().columns(k)[1] < 0) {
+            block = Eigen::Vector2d(1.0 / block(0, 0), 0.0).asDiagonal();
+            continue;
+        }
+        block(1, 1) += damping[index + 1];
+        const double determinant = block.determinant();
+        if (std::abs(determinant) <= kMinimumDamping * block.cwiseAbs().maxCoeff()) {
+            block = Eigen::Vector2d(1.0 / block(0, 0), 1.0 / block(1, 1)).asDiagonal();
+        } else {
+            block = block.inverse().eval();
+        }
+    }
+}
+
+void IterativeLMSolver::applyPreconditioner(const Eigen::VectorXd& in, Eigen::VectorXd& out) const {
+    for (std::size_t k = 0; k < _blockInverses.size(); ++k) {
+        const auto index = static_cast<Eigen::Index>(2 * k);
+        out.segment<2>(index).noalias() = _blockInverses[k] * in.segment<2>(index);
+    }
+}
+
+std::size_t IterativeLMSolver::solveDampedStep(const Eigen::VectorXd& gradient, const Eigen::VectorXd& damping,
+                                               Eigen::VectorXd& step) {
+    if (_options.innerSolver == InnerSolver::ConjugateGradient) {
+        buildPreconditioner(damping);
+        return solveConjugateGradient(gradient, damping, step);
+    }
+
+    _normal->assign(_jacobian, damping);
+    if (!_cholesky.factorize(*_normal)) {
+        step.setZero(gradient.size());
+        return 0;
+    }
+    _cholesky.solve(gradient, step);
+    return 0;
+}
+
+void IterativeLMSolver::prepareBlockCholesky() {
+    // The blocks are reordered once, before any padded vector of a solve exists, so that
+    // the factorization fills in as little as possible; the pattern is reused afterwards.
+    _jacobian = BlockSparseJacobian(_jacobian.layout().permuted(_jacobian.fillReducingOrder()), _functions,
+                                    makeColumnMap(_variables, _aliases));
+    _normal = std::make_unique<BlockSparseSymmetricMatrix>(_jacobian);
+    _cholesky.analyze(*_normal);
+}
+
+std::size_t IterativeLMSolver::solveConjugateGradient(const Eigen::VectorXd& gradient, const Eigen::VectorXd& damping,
+                                                      Eigen::VectorXd& step) {
+    // Preconditioned CG on (JᵀJ + diag(damping)) step = gradient; the caller subtracts the step.
+    // Padding entries have a zero gradient and never leave zero.
+    const Eigen::Index n = gradient.size();
+    auto& residual = _cgResidual;
+    auto& preconditioned = _cgPreconditioned;
+    auto& direction = _cgDirection;
+    auto& product = _cgProduct;
+    residual = gradient;
+    preconditioned.resize(n);
+    direction.resize(n);
+    product.resize(n);
+    step.setZero(n);
+
+    const double stopNorm = _options.innerTolerance * gradient.norm();
+    applyPreconditioner(residual, preconditioned);
+    direction = preconditioned;
+    double rho = residual.dot(preconditioned);
+
+    std::size_t iteration = 0;
+    while (iteration < _options.maxInnerIterations && residual.norm() > stopNorm) {
+        ++iteration;
+        _jacobian.multiply(direction, _cgJacobianProduct);
+        _jacobian.multiplyTransposed(_cgJacobianProduct, product);
+        product += damping.cwiseProduct(direction);
+
+        const double curvature = direction.dot(product);
+        if (curvature <= 0.0) {
+            break;
+        }
+        const double alpha = rho / curvature;
+        step += alpha * direction;
+        residual -= alpha * product;
+
+        applyPreconditioner(residual, preconditioned);
+        const double nextRho = residual.dot(preconditioned);
+        direction = preconditioned + (nextRho / rho) * direction;
+        rho = nextRho;
+    }
+    return iteration;
+}
@@ -1,5 +1,10 @@
 #include "system/RequirementFunctionSystem.h"
+#include "utils/ThreadPool.h"
 #include <algorithm>
+#include <array>
+#include <functional>
+#include <span>
+#include <stdexcept>
 #include <Eigen/SVD>
 
 using namespace OurPaintDCM::System;
@@ -10,32 +15,156 @@ RequirementFunctionSystem::RequirementFunctionSystem() = default;
 void RequirementFunctionSystem::addFunction(std::shared_ptr<RequirementFunction> func) {
     _functions.push_back(func);
     for (auto v : func->getVars()) {
-        if (_allVarsSet.insert(v).second) {
+        if (_columnOf.emplace(v, static_cast<Eigen::Index>(_allVars.size())).second) {
             _allVars.push_back(v);
         }
     }
     _jacobianDirty = true;
+    _jacobianPatternDirty = true;
+    _blockPatternDirty = true;
 }
 
-void RequirementFunctionSystem::updateJ() {
-    const size_t m = _functions.size();
-    const size_t n = _allVars.size();
+void RequirementFunctionSystem::rebuildJacobianPattern() {
     std::vector<Eigen::Triplet<double>> triplets;
-    triplets.reserve(m * 6);
-
-    for (size_t i = 0; i < m; ++i) {
-        auto grad = _functions[i]->gradient();
-        for (size_t j = 0; j < n; ++j) {
-            VAR v = _allVars[j];
-            double val = grad.contains(v) ? grad[v] : 0.0;
-            if (val != 0.0)
-                triplets.emplace_back(i, j, val);
+    triplets.reserve(_functions.size() * 4);
+    for (size_t i = 0; i < _functions.size(); ++i) {
+        for (auto v : _functions[i]->getVars()) {
+            triplets.emplace_back(static_cast<Eigen::Index>(i), _columnOf.at(v), 0.0);
         }
     }
-
-    _jacobian.resize(m, n);
+    _jacobian.resize(static_cast<Eigen::Index>(_functions.size()), static_cast<Eigen::Index>(_allVars.size()));
     _jacobian.setFromTriplets(triplets.begin(), triplets.end());
+    _jacobian.makeCompressed();
+
+    const auto* rowStart = _jacobian.outerIndexPtr();
+    const auto* columns = _jacobian.innerIndexPtr();
+    _jacobianSlots.clear();
+    _jacobianSlotOffset.assign(1, 0);
+    _jacobianSlotOffset.reserve(_functions.size() + 1);
+    for (size_t i = 0; i < _functions.size(); ++i) {
+        for (auto v : _functions[i]->getVars()) {
+            const auto* slot = std::lower_bound(columns + rowStart[i], columns + rowStart[i + 1], _columnOf.at(v));
+            _jacobianSlots.push_back(slot - columns);
+        }
+        _jacobianSlotOffset.push_back(_jacobianSlots.size());
+    }
+
+    // The column-major copy shares the pattern; J() then only copies values slot by slot.
+    _jacobianColumns = _jacobian;
+    _jacobianColumns.makeCompressed();
+    const auto* columnStart = _jacobianColumns.outerIndexPtr();
+    const auto* rows = _jacobianColumns.innerIndexPtr();
+    _columnSlots.resize(static_cast<size_t>(_jacobian.nonZeros()));
+    for (Eigen::Index column = 0; column < _jacobianColumns.cols(); ++column) {
+        for (auto k = columnStart[column]; k < columnStart[column + 1]; ++k) {
+            const auto row = rows[k];
+            const auto* slot = std::lower_bound(columns + rowStart[row], columns + rowStart[row + 1], column);
+            _columnSlots[static_cast<size_t>(slot - columns)] = k;
+        }
+    }
+    _jacobianPatternDirty = false;
+    rebuildNormalPattern();
+}
+
+void RequirementFunctionSystem::rebuildNormalPattern() {
+    // Row columns are sorted, so every pair (p ≤ q) of a row lands in the upper triangle.
+    const auto* rowStart = _jacobian.outerIndexPtr();
+    const auto* columns = _jacobian.innerIndexPtr();
+    std::vector<Eigen::Triplet<double>> triplets;
+    _normalRowOffset.assign(1, 0);
+    _normalRowOffset.reserve(static_cast<size_t>(_jacobian.rows()) + 1);
+    for (Eigen::Index i = 0; i < _jacobian.rows(); ++i) {
+        for (auto p = rowStart[i]; p < rowStart[i + 1]; ++p) {
+            for (auto q = p; q < rowStart[i + 1]; ++q) {
+                triplets.emplace_back(columns[p], columns[q], 0.0);
+            }
+        }
+        _normalRowOffset.push_back(triplets.size());
+    }
+    _normalUpper.resize(_jacobian.cols(), _jacobian.cols());
+    _normalUpper.setFromTriplets(triplets.begin(), triplets.end());
+    _normalUpper.makeCompressed();
+
+    const auto* columnStart = _normalUpper.outerIndexPtr();
+    const auto* normalRows = _normalUpper.innerIndexPtr();
+    _normalTargets.resize(triplets.size());
+    for (size_t t = 0; t < triplets.size(); ++t) {
+        const auto column = triplets[t].col();
+        const auto* slot = std::lower_bound(normalRows + columnStart[column], normalRows + columnStart[column + 1],
+                                            triplets[t].row());
+        _normalTargets[t] = slot - normalRows;
+    }
+    _normalDirty = true;
+}
+
+void RequirementFunctionSystem::updateNormalMatrix() const {
+    auto& pool = Utils::ThreadPool::shared();
+    const auto rows = static_cast<size_t>(_jacobian.rows());
+    const size_t chunks = std::max<size_t>(pool.chunkCount(rows, Utils::kParallelRowGrain), 1);
+    const auto valueCount = static_cast<size_t>(_normalUpper.nonZeros());
+    if (_normalChunkValues.size() < chunks - 1) {
+        _normalChunkValues.resize(chunks - 1);
+    }
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        _normalChunkValues[chunk - 1].resize(valueCount);
+    }
+
+    // Different rows hit the same entries, so chunk 0 accumulates in place and the other
+    // chunks into their own buffers, merged below in chunk order.
+    double* normalValues = _normalUpper.valuePtr();
+    std::fill(normalValues, normalValues + valueCount, 0.0);
+    const auto* rowStart = _jacobian.outerIndexPtr();
+    const double* values = _jacobian.valuePtr();
+    pool.parallelFor(rows, Utils::kParallelRowGrain, [&](size_t chunk, size_t begin, size_t end) {
+        double* target = normalValues;
+        if (chunk != 0) {
+            auto& buffer = _normalChunkValues[chunk - 1];
+            std::fill(buffer.begin(), buffer.end(), 0.0);
+            target = buffer.data();
+        }
+        for (size_t i = begin; i < end; ++i) {
+            size_t slot = _normalRowOffset[i];
+            for (auto p = rowStart[i]; p < rowStart[i + 1]; ++p) {
+                for (auto q = p; q < rowStart[i + 1]; ++q) {
+                    target[_normalTargets[slot++]] += values[p] * values[q];
+                }
+            }
+        }
+    });
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        const auto& buffer = _normalChunkValues[chunk - 1];
+        std::transform(normalValues, normalValues + valueCount, buffer.begin(), normalValues, std::plus<>());
+    }
+    _normalDirty = false;
+}
+
+void RequirementFunctionSystem::updateJ() {
+    if (_jacobianPatternDirty) {
+        rebuildJacobianPattern();
+    }
+
+    // Each row owns a fixed slice of the CSR values, so row ranges fill independently.
+    // A variable listed twice in a function gets one partial per position, summed into its slot.
+    const auto* rowStart = _jacobian.outerIndexPtr();
+    double* values = _jacobian.valuePtr();
+    Utils::ThreadPool::shared().parallelFor(_functions.size(), Utils::kParallelRowGrain,
+        [&](size_t, size_t begin, size_t end) {
+            std::fill(values + rowStart[begin], values + rowStart[end], 0.0);
+            std::array<double, RequirementFunction::kMaxVarCount> partials{};
+            for (size_t i = begin; i < end; ++i) {
+                const size_t first = _jacobianSlotOffset[i];
+                const size_t count = _jacobianSlotOffset[i + 1] - first;
+                _functions[i]->gradientInto(std::span(partials.data(), count));
+                for (size_t k = 0; k < count; ++k) {
+                    values[_jacobianSlots[first + k]] += partials[k];
+                }
+            }
+        });
+
     _jacobianDirty = false;
+    _jacobianColumnsDirty = true;
+    _normalDirty = true;
+    _blockValuesDirty = true;
 }
 
 void RequirementFunctionSystem::ensureJacobian() const {
@@ -45,24 +174,62 @@ void RequirementFunctionSystem::ensureJacobian() const {
 }
 
 
-Eigen::SparseMatrix<double> RequirementFunctionSystem::J() const {
+const Eigen::SparseMatrix<double>& RequirementFunctionSystem::J() const {
     ensureJacobian();
-    return _jacobian;
+    if (_jacobianColumnsDirty) {
+        const double* values = _jacobian.valuePtr();
+        double* columnValues = _jacobianColumns.valuePtr();
+        for (size_t k = 0; k < _columnSlots.size(); ++k) {
+            columnValues[_columnSlots[k]] = values[k];
+        }
+        _jacobianColumnsDirty = false;
+    }
+    return _jacobianColumns;
 }
 
-Eigen::SparseMatrix<double> RequirementFunctionSystem::JTJ() const {
+const BlockSparseJacobian& RequirementFunctionSystem::blockJ() const {
+    ensureJacobian();
+    if (_blockPatternDirty) {
+        _blockJacobian = BlockSparseJacobian(BlockLayout::fromFunctions(_allVars, _functions), _functions, _columnOf);
+        _blockPatternDirty = false;
+        _blockValuesDirty = true;
+    }
+    if (_blockValuesDirty) {
+        _blockJacobian.assemble(_functions);
+        _blockValuesDirty = false;
+    }
+    return _blockJacobian;
+}
+
+const Eigen::SparseMatrix<double>& RequirementFunctionSystem::JTJUpper() const {
     ensureJacobian();
-    Eigen::SparseMatrix<double> JT = _jacobian.transpose();
-    return JT * _jacobian;
+    if (_normalDirty) {
+        updateNormalMatrix();
+    }
+    return _normalUpper;
+}
+
+Eigen::SparseMatrix<double> RequirementFunctionSystem::JTJ() const {
+    return JTJUpper().selfadjointView<Eigen::Upper>();
 }
 
 Eigen::VectorXd RequirementFunctionSystem::residuals() const {
     Eigen::VectorXd r(_functions.size());
-    for (size_t i = 0; i < _functions.size(); ++i)
-        r[i] = _functions[i]->evaluate() * _functions[i]->getWeight();
+    residualsInto(r);
     return r;
 }
 
+void RequirementFunctionSystem::residualsInto(Eigen::Ref<Eigen::VectorXd> out) const {
+    if (static_cast<size_t>(out.size()) != _functions.size()) {
+        throw std::invalid_argument("Residual buffer size does not match the number of functions");
+    }
+    Utils::ThreadPool::shared().parallelFor(_functions.size(), Utils::kParallelRowGrain,
+        [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                out[static_cast<Eigen::Index>(i)] = _functions[i]->evaluate() * _functions[i]->getWeight();
+        });
+}
+
 std::vector<VAR> RequirementFunctionSystem::getAllVars() const {
     return _allVars;
 }
@@ -89,10 +256,58 @@ OurPaintDCM::Utils::SystemStatus RequirementFunctionSystem::diagnose() const {
     return Utils::SystemStatus::UNKNOWN;
 }
 
+namespace {
+/// Compressed or uncompressed Eigen sparse storage, from its allocated sizes.
+template<typename Matrix>
+std::size_t sparseBytes(const Matrix& matrix) noexcept {
+    using StorageIndex = typename Matrix::StorageIndex;
+    std::size_t bytes = static_cast<std::size_t>(matrix.data().allocatedSize()) *
+                        (sizeof(typename Matrix::Scalar) + sizeof(StorageIndex));
+    if (matrix.outerIndexPtr() != nullptr) {
+        bytes += static_cast<std::size_t>(matrix.outerSize() + 1) * sizeof(StorageIndex);
+    }
+    if (matrix.innerNonZeroPtr() != nullptr) {
+        bytes += static_cast<std::size_t>(matrix.outerSize()) * sizeof(StorageIndex);
+    }
+    return bytes;
+}
+
+/// make_shared allocation of @p function: its dynamic type plus the shared-count header.
+std::size_t functionObjectBytes(const RequirementFunction& function) noexcept {
+    return function.objectBytes() + 2 * sizeof(void*) + function.heapBytes();
+}
+}
+
+void RequirementFunctionSystem::accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept {
+    usage.requirementFunctions += Utils::heapBytes(_functions) + Utils::heapBytes(_allVars) +
+                                  Utils::heapBytes(_columnOf);
+    for (const auto& function : _functions) {
+        usage.requirementFunctions += functionObjectBytes(*function);
+    }
+    usage.jacobian += sparseBytes(_jacobian) + sparseBytes(_jacobianColumns) + sparseBytes(_normalUpper) +
+                      Utils::heapBytes(_jacobianSlots) + Utils::heapBytes(_jacobianSlotOffset) +
+                      Utils::heapBytes(_columnSlots) + Utils::heapBytes(_normalTargets) +
+                      Utils::heapBytes(_normalRowOffset) + Utils::heapBytes(_normalChunkValues) +
+                      _blockJacobian.heapBytes();
+}
+
 void RequirementFunctionSystem::clear() {
     _functions.clear();
     _allVars.clear();
-    _allVarsSet.clear();
+    _columnOf.clear();
     _jacobian.resize(0, 0);
+    _jacobianColumns.resize(0, 0);
+    _columnSlots.clear();
+    _jacobianColumnsDirty = true;
     _jacobianDirty = false;
+    _jacobianPatternDirty = true;
+    _jacobianSlots.clear();
+    _jacobianSlotOffset.clear();
+    _normalUpper.resize(0, 0);
+    _normalTargets.clear();
+    _normalRowOffset.clear();
+    _normalDirty = true;
+    _blockJacobian = BlockSparseJacobian();
+    _blockPatternDirty = true;
+    _blockValuesDirty = true;
 }
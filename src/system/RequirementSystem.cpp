@@ -1,10 +1,13 @@
 #include "RequirementSystem.h"
+#include "Instrumentation.h"
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <stdexcept>
-#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace {
@@ -17,39 +20,6 @@ T* requireGeometry(T* ptr) {
     return ptr;
 }
 
-std::vector<VAR> makePointVars(OurPaintDCM::Figures::Point2D* point) {
-    return {point->ptrX(), point->ptrY()};
-}
-
-std::vector<VAR> makeTwoPointVars(OurPaintDCM::Figures::Point2D* p1,
-                                  OurPaintDCM::Figures::Point2D* p2) {
-    return {p1->ptrX(), p1->ptrY(), p2->ptrX(), p2->ptrY()};
-}
-
-std::vector<VAR> makePointLineVars(OurPaintDCM::Figures::Point2D* point,
-                                   OurPaintDCM::Figures::Point2D* l1,
-                                   OurPaintDCM::Figures::Point2D* l2) {
-    return {point->ptrX(), point->ptrY(), l1->ptrX(), l1->ptrY(), l2->ptrX(), l2->ptrY()};
-}
-
-std::vector<VAR> makeLineLineVars(OurPaintDCM::Figures::Point2D* l1p1,
-                                  OurPaintDCM::Figures::Point2D* l1p2,
-                                  OurPaintDCM::Figures::Point2D* l2p1,
-                                  OurPaintDCM::Figures::Point2D* l2p2) {
-    return {
-        l1p1->ptrX(), l1p1->ptrY(), l1p2->ptrX(), l1p2->ptrY(),
-        l2p1->ptrX(), l2p1->ptrY(), l2p2->ptrX(), l2p2->ptrY()};
-}
-
-std::vector<VAR> makeLineCircleVars(OurPaintDCM::Figures::Point2D* l1,
-                                    OurPaintDCM::Figures::Point2D* l2,
-                                    OurPaintDCM::Figures::Point2D* center,
-                                    double* radius) {
-    return {
-        l1->ptrX(), l1->ptrY(), l2->ptrX(), l2->ptrY(),
-        center->ptrX(), center->ptrY(), radius};
-}
-
 } // namespace
 
 namespace OurPaintDCM::System {
@@ -87,7 +57,63 @@ Utils::ID RequirementSystem::addRequirement(const Utils::RequirementDescriptor&
     return reqId;
 }
 
+std::vector<Utils::ID> RequirementSystem::addRequirements(std::span<const Utils::RequirementDescriptor> descriptors) {
+    for (const auto& descriptor : descriptors) {
+        descriptor.validate();
+    }
+
+    auto reqIds = assignRequirementIds(descriptors);
+    const Utils::ID previousGeneratorState = _reqIdGen.current();
+    const std::size_t previousSize = _requirements.size();
+
+    _requirements.reserve(previousSize + descriptors.size());
+    for (std::size_t i = 0; i < descriptors.size(); ++i) {
+        const auto& descriptor = descriptors[i];
+        _requirements.push_back({reqIds[i], descriptor.type, descriptor.objectIds, descriptor.param});
+        const unsigned long long nextMin = reqIds[i].id + 1ULL;
+        if (nextMin > _reqIdGen.current().id) {
+            _reqIdGen.set(Utils::ID(nextMin));
+        }
+    }
+
+    try {
+        rebuildFunctionsAndAliases();
+    } catch (...) {
+        _requirements.erase(_requirements.begin() + static_cast<std::ptrdiff_t>(previousSize), _requirements.end());
+        _reqIdGen.set(previousGeneratorState);
+        rebuildFunctionsAndAliases();
+        throw;
+    }
+
+    return reqIds;
+}
+
+std::vector<Utils::ID> RequirementSystem::assignRequirementIds(
+    std::span<const Utils::RequirementDescriptor> descriptors) const {
+    std::vector<Utils::ID> reqIds;
+    reqIds.reserve(descriptors.size());
+    std::unordered_set<Utils::ID> batchIds;
+    batchIds.reserve(descriptors.size());
+    unsigned long long next = _reqIdGen.current().id;
+    for (const auto& descriptor : descriptors) {
+        Utils::ID reqId;
+        if (descriptor.id.has_value()) {
+            reqId = *descriptor.id;
+            next = std::max(next, reqId.id + 1ULL);
+        } else {
+            reqId = Utils::ID(next++);
+        }
+        // Generated ids only grow past explicit ones, so only an explicit id can repeat.
+        if (!batchIds.insert(reqId).second) {
+            throw std::invalid_argument("Requirement id already exists");
+        }
+        reqIds.push_back(reqId);
+    }
+    return reqIds;
+}
+
 void RequirementSystem::rebuildFunctionsAndAliases() {
+    OURPAINTDCM_PROBE_SCOPE(ET_REBUILD_FUNCTIONS);
     RequirementFunctionSystem::clear();
     _pointRepresentative.clear();
     _coincidentPointGroups.clear();
@@ -147,188 +173,30 @@ void RequirementSystem::rebuildFunctionsAndAliases() {
         });
     }
 
-    const auto resolveLinePoints = [&](Utils::ID lineId) {
-        requireGeometry(_storage->get<Figures::Line2D>(lineId));
-        const auto dependencies = _storage->getDependencies(lineId);
-        if (dependencies.size() != 2) {
-            throw std::runtime_error("Line dependencies are inconsistent");
-        }
-        return std::pair{resolvePoint(dependencies[0]), resolvePoint(dependencies[1])};
-    };
-
-    const auto resolveCircleData = [&](Utils::ID circleId) {
-        auto* circle = requireGeometry(_storage->get<Figures::Circle2D>(circleId));
-        const auto dependencies = _storage->getDependencies(circleId);
-        if (dependencies.size() != 1) {
-            throw std::runtime_error("Circle dependencies are inconsistent");
-        }
-        return std::pair{resolvePoint(dependencies[0]), circle->ptrRadius()};
-    };
-
-    const auto resolveArcPoints = [&](Utils::ID arcId) {
-        requireGeometry(_storage->get<Figures::Arc2D>(arcId));
-        const auto dependencies = _storage->getDependencies(arcId);
-        if (dependencies.size() != 3) {
-            throw std::runtime_error("Arc dependencies are inconsistent");
-        }
-        return std::tuple{
-            resolvePoint(dependencies[0]),
-            resolvePoint(dependencies[1]),
-            resolvePoint(dependencies[2])};
-    };
-
     for (const auto& entry : _requirements) {
-        const auto& ids = entry.objectIds;
-
-        switch (entry.type) {
-            case Utils::RequirementType::ET_POINTLINEDIST: {
-                auto* point = resolvePoint(ids[0]);
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[1]);
-                addFunction(std::make_shared<Function::PointLineDistanceFunction>(
-                    makePointLineVars(point, lineP1, lineP2),
-                    entry.param.value()));
-                break;
-            }
-            case Utils::RequirementType::ET_POINTONLINE: {
-                auto* point = resolvePoint(ids[0]);
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[1]);
-                addFunction(std::make_shared<Function::PointOnLineFunction>(
-                    makePointLineVars(point, lineP1, lineP2)));
-                break;
-            }
-            case Utils::RequirementType::ET_POINTPOINTDIST: {
-                auto* p1 = resolvePoint(ids[0]);
-                auto* p2 = resolvePoint(ids[1]);
-                addFunction(std::make_shared<Function::PointPointDistanceFunction>(
-                    makeTwoPointVars(p1, p2),
-                    entry.param.value()));
-                break;
-            }
-            case Utils::RequirementType::ET_POINTONPOINT:
-                break;
-            case Utils::RequirementType::ET_LINECIRCLEDIST: {
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                const auto [center, radius] = resolveCircleData(ids[1]);
-                addFunction(std::make_shared<Function::LineCircleDistanceFunction>(
-                    makeLineCircleVars(lineP1, lineP2, center, radius),
-                    entry.param.value()));
-                break;
-            }
-            case Utils::RequirementType::ET_LINEONCIRCLE: {
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                const auto [center, radius] = resolveCircleData(ids[1]);
-                addFunction(std::make_shared<Function::LineOnCircleFunction>(
-                    makeLineCircleVars(lineP1, lineP2, center, radius)));
-                break;
-            }
-            case Utils::RequirementType::ET_LINEINCIRCLE:
-                throw std::runtime_error("LineInCircle requirement is not yet supported via unified interface");
-            case Utils::RequirementType::ET_LINELINEPARALLEL: {
-                const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                addFunction(std::make_shared<Function::LineLineParallelFunction>(
-                    makeLineLineVars(l1p1, l1p2, l2p1, l2p2)));
-                break;
-            }
-            case Utils::RequirementType::ET_LINELINEPERPENDICULAR: {
-                const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                addFunction(std::make_shared<Function::LineLinePerpendicularFunction>(
-                    makeLineLineVars(l1p1, l1p2, l2p1, l2p2)));
-                break;
-            }
-            case Utils::RequirementType::ET_LINELINEANGLE: {
-                const auto [l1p1, l1p2] = resolveLinePoints(ids[0]);
-                const auto [l2p1, l2p2] = resolveLinePoints(ids[1]);
-                addFunction(std::make_shared<Function::LineLineAngleFunction>(
-                    makeLineLineVars(l1p1, l1p2, l2p1, l2p2),
-                    entry.param.value()));
-                break;
-            }
-            case Utils::RequirementType::ET_VERTICAL: {
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                addFunction(std::make_shared<Function::VerticalFunction>(
-                    makeTwoPointVars(lineP1, lineP2)));
-                break;
-            }
-            case Utils::RequirementType::ET_HORIZONTAL: {
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                addFunction(std::make_shared<Function::HorizontalFunction>(
-                    makeTwoPointVars(lineP1, lineP2)));
-                break;
-            }
-            case Utils::RequirementType::ET_ARCCENTERONPERPENDICULAR: {
-                const auto [arcP1, arcP2, center] = resolveArcPoints(ids[0]);
-                addFunction(std::make_shared<Function::ArcCenterOnPerpendicularFunction>(
-                    std::vector<VAR>{
-                        arcP1->ptrX(), arcP1->ptrY(),
-                        arcP2->ptrX(), arcP2->ptrY(),
-                        center->ptrX(), center->ptrY()}));
-                break;
-            }
-            case Utils::RequirementType::ET_FIXPOINT: {
-                auto* originalPoint = requireGeometry(_storage->get<Figures::Point2D>(ids[0]));
-                auto* point = resolvePoint(ids[0]);
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXPOINT,
-                    std::vector<VAR>{point->ptrX()},
-                    originalPoint->x()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXPOINT,
-                    std::vector<VAR>{point->ptrY()},
-                    originalPoint->y()));
-                break;
-            }
-            case Utils::RequirementType::ET_FIXLINE: {
-                requireGeometry(_storage->get<Figures::Line2D>(ids[0]));
-                const auto dependencies = _storage->getDependencies(ids[0]);
-                if (dependencies.size() != 2) {
-                    throw std::runtime_error("Line dependencies are inconsistent");
+        Requirements::visitRequirementType(entry.type, [&](auto tag) {
+            using Tag = decltype(tag);
+            if constexpr (Tag::rows == Requirements::RowKind::Coincidence) {
+                return;
+            } else if constexpr (std::is_void_v<typename Tag::Kernel>) {
+                throw std::runtime_error("Requirement type is not yet supported via unified interface");
+            } else if constexpr (Tag::rows == Requirements::RowKind::Fix) {
+                // Rows act on the merged variables but keep the fixed object's own position.
+                const auto vars = requirementVariables<Tag>(entry.objectIds);
+                const auto originals = requirementVariables<Tag>(entry.objectIds, false);
+                std::array<double, Tag::variableCount> targets{};
+                for (std::size_t k = 0; k < targets.size(); ++k) {
+                    targets[k] = *originals[k];
                 }
-                auto* originalP1 = requireGeometry(_storage->get<Figures::Point2D>(dependencies[0]));
-                auto* originalP2 = requireGeometry(_storage->get<Figures::Point2D>(dependencies[1]));
-                const auto [lineP1, lineP2] = resolveLinePoints(ids[0]);
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXLINE,
-                    std::vector<VAR>{lineP1->ptrX()},
-                    originalP1->x()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXLINE,
-                    std::vector<VAR>{lineP1->ptrY()},
-                    originalP1->y()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXLINE,
-                    std::vector<VAR>{lineP2->ptrX()},
-                    originalP2->x()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXLINE,
-                    std::vector<VAR>{lineP2->ptrY()},
-                    originalP2->y()));
-                break;
-            }
-            case Utils::RequirementType::ET_FIXCIRCLE: {
-                const auto [center, radius] = resolveCircleData(ids[0]);
-                auto* circle = requireGeometry(_storage->get<Figures::Circle2D>(ids[0]));
-                const auto dependencies = _storage->getDependencies(ids[0]);
-                if (dependencies.size() != 1) {
-                    throw std::runtime_error("Circle dependencies are inconsistent");
+                for (auto& row : Requirements::makeFixKernels<Tag>(vars, targets)) {
+                    addFunction(std::move(row));
                 }
-                auto* originalCenter = requireGeometry(_storage->get<Figures::Point2D>(dependencies[0]));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXCIRCLE,
-                    std::vector<VAR>{center->ptrX()},
-                    originalCenter->x()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXCIRCLE,
-                    std::vector<VAR>{center->ptrY()},
-                    originalCenter->y()));
-                addFunction(std::make_shared<Function::FixCoordinateFunction>(
-                    Utils::RequirementType::ET_FIXCIRCLE,
-                    std::vector<VAR>{radius},
-                    circle->radius));
-                break;
+            } else {
+                addFunction(Requirements::makeKernel<Tag>(
+                    requirementVariables<Tag>(entry.objectIds),
+                    Tag::hasParam ? entry.param.value() : 0.0));
             }
-        }
+        });
     }
 
     applyDirectAssignments();
@@ -439,6 +307,16 @@ void RequirementSystem::clear() {
     _coincidentPointGroups.clear();
 }
 
+void RequirementSystem::accumulateMemoryUsage(Utils::MemoryUsage& usage) const noexcept {
+    RequirementFunctionSystem::accumulateMemoryUsage(usage);
+    std::size_t bytes = Utils::heapBytes(_requirements);
+    for (const auto& entry : _requirements) {
+        bytes += Utils::heapBytes(entry.objectIds);
+    }
+    usage.requirementFunctions += bytes + Utils::heapBytes(_pointRepresentative) +
+                                  Utils::heapBytes(_coincidentPointGroups);
+}
+
 Utils::ID RequirementSystem::resolvePointRepresentative(Utils::ID pointId) const noexcept {
     const auto it = _pointRepresentative.find(pointId);
     if (it == _pointRepresentative.end()) {
@@ -451,12 +329,61 @@ Figures::Point2D* RequirementSystem::resolvePoint(Utils::ID pointId) const {
     return requireGeometry(_storage->get<Figures::Point2D>(resolvePointRepresentative(pointId)));
 }
 
+void RequirementSystem::objectVariables(Requirements::ObjectKind kind, Utils::ID objectId, VAR* out,
+                                        bool mergeCoincident) const {
+    const auto point = [&](Utils::ID pointId) {
+        return mergeCoincident ? resolvePoint(pointId) : requireGeometry(_storage->get<Figures::Point2D>(pointId));
+    };
+    const auto dependencies = [&](std::size_t count, const char* message) {
+        auto ids = _storage->getDependencies(objectId);
+        if (ids.size() != count) {
+            throw std::runtime_error(message);
+        }
+        return ids;
+    };
+
+    switch (kind) {
+        case Requirements::ObjectKind::Point:
+            Requirements::figureVariables(point(objectId), out);
+            break;
+        case Requirements::ObjectKind::Line: {
+            requireGeometry(_storage->get<Figures::Line2D>(objectId));
+            const auto ids = dependencies(2, "Line dependencies are inconsistent");
+            Requirements::figureVariables(point(ids[0]), out);
+            Requirements::figureVariables(point(ids[1]), out + 2);
+            break;
+        }
+        case Requirements::ObjectKind::Circle: {
+            auto* circle = requireGeometry(_storage->get<Figures::Circle2D>(objectId));
+            const auto ids = dependencies(1, "Circle dependencies are inconsistent");
+            Requirements::figureVariables(point(ids[0]), out);
+            out[2] = circle->ptrRadius();
+            break;
+        }
+        case Requirements::ObjectKind::Arc: {
+            requireGeometry(_storage->get<Figures::Arc2D>(objectId));
+            const auto ids = dependencies(3, "Arc dependencies are inconsistent");
+            Requirements::figureVariables(point(ids[0]), out);
+            Requirements::figureVariables(point(ids[1]), out + 2);
+            Requirements::figureVariables(point(ids[2]), out + 4);
+            break;
+        }
+    }
+}
+
 std::vector<Utils::ID> RequirementSystem::getCoincidentPoints(Utils::ID pointId) const {
-    const Utils::ID representative = resolvePointRepresentative(pointId);
-    const auto groupIt = _coincidentPointGroups.find(representative);
-    if (groupIt == _coincidentPointGroups.end()) {
+    const auto group = coincidentGroup(pointId);
+    if (group.empty()) {
         return {pointId};
     }
+    return {group.begin(), group.end()};
+}
+
+std::span<const Utils::ID> RequirementSystem::coincidentGroup(Utils::ID pointId) const noexcept {
+    const auto groupIt = _coincidentPointGroups.find(resolvePointRepresentative(pointId));
+    if (groupIt == _coincidentPointGroups.end()) {
+        return {};
+    }
     return groupIt->second;
 }
 
@@ -0,0 +1,42 @@
+#include "system/VariableRegistry.h"
+#include "utils/MemoryUsage.h"
+
+using namespace OurPaintDCM::System;
+
+std::size_t VariableRegistry::intern(double* valueRef) {
+    const auto [it, inserted] = _indexOf.try_emplace(valueRef, _refs.size());
+    if (inserted) {
+        _refs.push_back(valueRef);
+        _variables.emplace_back(valueRef);
+    }
+    return it->second;
+}
+
+bool VariableRegistry::contains(double* valueRef) const {
+    return _indexOf.contains(valueRef);
+}
+
+std::size_t VariableRegistry::indexOf(double* valueRef) const {
+    return _indexOf.at(valueRef);
+}
+
+std::size_t VariableRegistry::size() const noexcept {
+    return _refs.size();
+}
+
+bool VariableRegistry::empty() const noexcept {
+    return _refs.empty();
+}
+
+const std::vector<double*>& VariableRegistry::refs() const noexcept {
+    return _refs;
+}
+
+Variable* VariableRegistry::variable(std::size_t index) {
+    return &_variables[index];
+}
+
+std::size_t VariableRegistry::heapBytes() const noexcept {
+    return OurPaintDCM::Utils::heapBytes(_indexOf) + OurPaintDCM::Utils::heapBytes(_refs) +
+           _variables.size() * sizeof(Variable);
+}
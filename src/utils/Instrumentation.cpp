@@ -0,0 +1,119 @@
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace OurPaintDCM::Utils;
+
+namespace {
+/// Slots of one thread. Only the owning thread writes; snapshots read concurrently.
+struct ThreadSlots {
+    std::array<std::atomic<std::uint64_t>, kProbeCount> count{};
+    std::array<std::atomic<std::int64_t>, kProbeCount> total{};
+    std::array<std::atomic<std::int64_t>, kProbeCount> max{};
+
+    void addTo(InstrumentationSnapshot& snapshot) const noexcept {
+        for (std::size_t i = 0; i < kProbeCount; ++i) {
+            auto& stats = snapshot.probes[i];
+            stats.count += count[i].load(std::memory_order_relaxed);
+            stats.total += std::chrono::nanoseconds(total[i].load(std::memory_order_relaxed));
+            stats.max = std::max(stats.max, std::chrono::nanoseconds(max[i].load(std::memory_order_relaxed)));
+        }
+    }
+
+    void clear() noexcept {
+        for (std::size_t i = 0; i < kProbeCount; ++i) {
+            count[i].store(0, std::memory_order_relaxed);
+            total[i].store(0, std::memory_order_relaxed);
+            max[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/// Live thread slots plus the folded totals of threads that have exited.
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadSlots*> live;
+    InstrumentationSnapshot retired;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+/// Registers the thread's slots on first use and folds them into the registry at thread exit.
+struct ThreadSlotsOwner {
+    ThreadSlots slots;
+
+    ThreadSlotsOwner() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.live.push_back(&slots);
+    }
+
+    ~ThreadSlotsOwner() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        slots.addTo(reg.retired);
+        std::erase(reg.live, &slots);
+    }
+};
+
+ThreadSlots& threadSlots() {
+    thread_local ThreadSlotsOwner owner;
+    return owner.slots;
+}
+
+constexpr std::array<std::string_view, kProbeCount> kProbeNames{
+    "GeometryStorage::get",
+    "RequirementSystem::rebuildFunctionsAndAliases",
+    "DCMManager::buildSubsystem",
+    "DCMManager::buildPipeline",
+    "SparseLMSolver::optimize",
+    "DCMManager::mergeComponents",
+    "DCMManager::rebuildComponents"
+};
+}
+
+std::string_view OurPaintDCM::Utils::probeName(Probe probe) noexcept {
+    const auto index = static_cast<std::size_t>(probe);
+    return index < kProbeCount ? kProbeNames[index] : std::string_view("unknown");
+}
+
+void OurPaintDCM::Utils::recordProbe(Probe probe, std::chrono::nanoseconds elapsed) noexcept {
+    auto& slots = threadSlots();
+    const auto index = static_cast<std::size_t>(probe);
+    const std::int64_t ns = elapsed.count();
+    slots.count[index].store(slots.count[index].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slots.total[index].store(slots.total[index].load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > slots.max[index].load(std::memory_order_relaxed)) {
+        slots.max[index].store(ns, std::memory_order_relaxed);
+    }
+}
+
+void OurPaintDCM::Utils::countProbe(Probe probe) noexcept {
+    auto& counter = threadSlots().count[static_cast<std::size_t>(probe)];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+InstrumentationSnapshot OurPaintDCM::Utils::instrumentationSnapshot() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    InstrumentationSnapshot snapshot = reg.retired;
+    for (const ThreadSlots* slots : reg.live) {
+        slots->addTo(snapshot);
+    }
+    return snapshot;
+}
+
+void OurPaintDCM::Utils::resetInstrumentation() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    reg.retired = InstrumentationSnapshot{};
+    for (ThreadSlots* slots : reg.live) {
+        slots->clear();
+    }
+}
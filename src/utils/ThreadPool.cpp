@@ -0,0 +1,115 @@
+#include "utils/ThreadPool.h"
+
+using namespace OurPaintDCM::Utils;
+
+namespace {
+/// Set while a thread executes pool chunks; nested parallelFor() calls then run inline.
+thread_local bool tInsideJob = false;
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount) {
+    const std::size_t workers = threadCount > 1 ? threadCount - 1 : 0;
+    _workers.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        _workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::runChunks(Task task, void* context, std::size_t chunkCount) {
+    const bool outer = !tInsideJob;
+    tInsideJob = true;
+    for (std::size_t chunk = _nextChunk++; chunk < chunkCount; chunk = _nextChunk++) {
+        try {
+            task(context, chunk);
+        } catch (...) {
+            std::lock_guard lock(_mutex);
+            if (!_failure) {
+                _failure = std::current_exception();
+            }
+        }
+    }
+    if (outer) {
+        tInsideJob = false;
+    }
+}
+
+void ThreadPool::run(Task task, void* context, std::size_t chunkCount) {
+    if (chunkCount <= 1 || _workers.empty() || tInsideJob || !_submitMutex.try_lock()) {
+        for (std::size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            task(context, chunk);
+        }
+        return;
+    }
+    std::lock_guard submitted(_submitMutex, std::adopt_lock);
+
+    {
+        std::lock_guard lock(_mutex);
+        _task = task;
+        _context = context;
+        _chunkCount = chunkCount;
+        _nextChunk = 0;
+        _activeWorkers = _workers.size();
+        _failure = nullptr;
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    runChunks(task, context, chunkCount);
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock lock(_mutex);
+        _done.wait(lock, [this] { return _activeWorkers == 0; });
+        _task = nullptr;
+        _context = nullptr;
+        failure = std::exchange(_failure, nullptr);
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::size_t seenGeneration = 0;
+    for (;;) {
+        Task task = nullptr;
+        void* context = nullptr;
+        std::size_t chunkCount = 0;
+        {
+            std::unique_lock lock(_mutex);
+            _wake.wait(lock, [&] { return _stop || _generation != seenGeneration; });
+            if (_stop) {
+                return;
+            }
+            seenGeneration = _generation;
+            task = _task;
+            context = _context;
+            chunkCount = _chunkCount;
+        }
+
+        runChunks(task, context, chunkCount);
+
+        {
+            std::lock_guard lock(_mutex);
+            if (--_activeWorkers == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+}
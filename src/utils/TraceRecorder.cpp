@@ -0,0 +1,146 @@
+#include "utils/TraceRecorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+using namespace OurPaintDCM::Utils;
+
+namespace {
+std::int64_t steadyNow() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::uint32_t currentThreadNumber() noexcept {
+    static std::atomic<std::uint32_t> nextNumber{1};
+    thread_local const std::uint32_t number = nextNumber.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+const char* chromePhase(TracePhase phase) noexcept {
+    switch (phase) {
+        case TracePhase::ET_BEGIN:
+            return "B";
+        case TracePhase::ET_END:
+            return "E";
+        case TracePhase::ET_INSTANT:
+            return "i";
+    }
+    return "i";
+}
+
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; c != nullptr && *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+}
+
+TraceRecorder::TraceRecorder(std::size_t capacity)
+    : _slots(std::make_unique<Slot[]>(std::max<std::size_t>(capacity, 1))),
+      _capacity(std::max<std::size_t>(capacity, 1)) {}
+
+TraceRecorder& TraceRecorder::shared() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::start() noexcept {
+    _enabled.store(false, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < _capacity; ++i) {
+        _slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    _next.store(0, std::memory_order_relaxed);
+    _epoch.store(steadyNow(), std::memory_order_relaxed);
+    _enabled.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::stop() noexcept {
+    _enabled.store(false, std::memory_order_release);
+}
+
+void TraceRecorder::record(const char* name, TracePhase phase) noexcept {
+    if (!enabled()) {
+        return;
+    }
+    const std::int64_t timestamp = std::max<std::int64_t>(steadyNow() - _epoch.load(std::memory_order_relaxed), 0);
+    const std::uint64_t index = _next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = _slots[index % _capacity];
+
+    // Seqlock write: readers discard the slot unless the sequence matches before and after.
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    slot.thread.store(currentThreadNumber(), std::memory_order_relaxed);
+    slot.phase.store(phase, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceRecorder::events() const {
+    const std::uint64_t end = _next.load(std::memory_order_acquire);
+    const std::uint64_t begin = end > _capacity ? end - _capacity : 0;
+
+    std::vector<TraceEvent> result;
+    result.reserve(static_cast<std::size_t>(end - begin));
+    for (std::uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = _slots[index % _capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        TraceEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.timestamp = std::chrono::nanoseconds(slot.timestamp.load(std::memory_order_relaxed));
+        event.thread = slot.thread.load(std::memory_order_relaxed);
+        event.phase = slot.phase.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1) {
+            continue;
+        }
+        result.push_back(event);
+    }
+    return result;
+}
+
+void TraceRecorder::writeChromeTrace(std::ostream& out) const {
+    const auto recorded = events();
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& event : recorded) {
+        if (!first) {
+            out << ',';
+        }
+        first = false;
+        out << "\n{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"dcm\",\"ph\":\"" << chromePhase(event.phase) << '"';
+        if (event.phase == TracePhase::ET_INSTANT) {
+            out << ",\"s\":\"t\"";
+        }
+        // Chrome trace timestamps are in microseconds.
+        const auto ns = event.timestamp.count();
+        out << ",\"ts\":" << ns / 1000 << '.';
+        const auto fraction = ns % 1000;
+        out << (fraction < 100 ? "0" : "") << (fraction < 10 ? "0" : "") << fraction;
+        out << ",\"pid\":1,\"tid\":" << event.thread << '}';
+    }
+    out << "\n]}\n";
+}
+
+void TraceRecorder::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    writeChromeTrace(file);
+    if (!file) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef OURPAINTDCM_TESTS_ALLOCATIONCOUNTER_H
+#define OURPAINTDCM_TESTS_ALLOCATIONCOUNTER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+/**
+ * @file AllocationCounter.h
+ * @brief Global operator new hook that counts heap allocations inside a scope.
+ *
+ * Replaces the global allocation functions, so include it from exactly one translation
+ * unit of a test executable. Counting covers every thread while an AllocationScope is alive.
+ *
+ * Example:
+ * @code
+ * AllocationScope scope;
+ * manager.updatePoint(drag);
+ * EXPECT_EQ(scope.count().calls, 0U);
+ * @endcode
+ */
+namespace OurPaintDCM::Testing {
+struct AllocationCount {
+    std::size_t calls = 0;
+    std::size_t bytes = 0;
+};
+
+namespace Detail {
+inline std::atomic<int> activeScopes{0};
+inline std::atomic<std::size_t> calls{0};
+inline std::atomic<std::size_t> bytes{0};
+
+inline void* allocate(std::size_t size, std::size_t alignment = 0) noexcept {
+    if (activeScopes.load(std::memory_order_relaxed) > 0) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment > alignof(std::max_align_t)) {
+#if defined(_WIN32)
+        return _aligned_malloc(size, alignment);
+#else
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+    return std::malloc(size);
+}
+
+inline void deallocateAligned(void* p) noexcept {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+}
+
+/**
+ * @brief Counts allocations from construction until count() is read.
+ */
+class AllocationScope {
+    std::size_t _calls;
+    std::size_t _bytes;
+
+public:
+    AllocationScope() noexcept
+        : _calls(Detail::calls.load()), _bytes(Detail::bytes.load()) {
+        ++Detail::activeScopes;
+    }
+
+    ~AllocationScope() { --Detail::activeScopes; }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    AllocationCount count() const noexcept {
+        return {Detail::calls.load() - _calls, Detail::bytes.load() - _bytes};
+    }
+};
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = OurPaintDCM::Testing::Detail::allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = OurPaintDCM::Testing::Detail::allocate(size, static_cast<std::size_t>(alignment))) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return OurPaintDCM::Testing::Detail::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return OurPaintDCM::Testing::Detail::allocate(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { OurPaintDCM::Testing::Detail::deallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { OurPaintDCM::Testing::Detail::deallocateAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { OurPaintDCM::Testing::Detail::deallocateAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { OurPaintDCM::Testing::Detail::deallocateAligned(p); }
+
+#endif // OURPAINTDCM_TESTS_ALLOCATIONCOUNTER_H
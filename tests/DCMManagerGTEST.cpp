@@ -357,6 +357,56 @@ TEST_F(DCMManagerTest, AddRequirementDuplicateExplicitIdThrows) {
     EXPECT_THROW(manager.addRequirement(d2), std::invalid_argument);
 }
 
+TEST_F(DCMManagerTest, AddRequirementsMatchesSequentialAdds) {
+    const auto build = [](DCMManager& target) {
+        const ID a = target.addFigure(FigureDescriptor::point(0.0, 0.0));
+        const ID b = target.addFigure(FigureDescriptor::point(4.0, 0.5));
+        const ID c = target.addFigure(FigureDescriptor::point(4.0, 3.0));
+        const ID d = target.addFigure(FigureDescriptor::point(4.1, 3.1));
+        const ID base = target.addFigure(FigureDescriptor::line(a, b));
+        auto fixed = RequirementDescriptor::fixPoint(a);
+        fixed.id = ID(10);
+        return std::vector<RequirementDescriptor>{
+            RequirementDescriptor::pointPointDist(a, b, 4.0), fixed, RequirementDescriptor::horizontal(base),
+            RequirementDescriptor::pointPointDist(b, c, 3.0), RequirementDescriptor::pointOnPoint(c, d)};
+    };
+
+    DCMManager sequential;
+    std::vector<ID> expected;
+    for (const auto& descriptor : build(sequential)) {
+        expected.push_back(sequential.addRequirement(descriptor));
+    }
+    const auto actual = manager.addRequirements(build(manager));
+
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(manager.getRequirementSystem().getFunctions().size(),
+              sequential.getRequirementSystem().getFunctions().size());
+    EXPECT_EQ(manager.getComponentCount(), sequential.getComponentCount());
+}
+
+TEST_F(DCMManagerTest, AddRequirementsRejectsWholeBatch) {
+    const auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const auto p2 = manager.addFigure(FigureDescriptor::point(1.0, 0.0));
+
+    auto first = RequirementDescriptor::pointPointDist(p1, p2, 1.0);
+    first.id = ID(5);
+    auto repeated = RequirementDescriptor::fixPoint(p1);
+    repeated.id = ID(5);
+    EXPECT_THROW(manager.addRequirements({first, repeated}), std::invalid_argument);
+    EXPECT_EQ(manager.requirementCount(), 0U);
+
+    // The first descriptor would be given ID 1.
+    auto takesGenerated = RequirementDescriptor::fixPoint(p1);
+    takesGenerated.id = ID(1);
+    EXPECT_THROW(manager.addRequirements({RequirementDescriptor::pointPointDist(p1, p2, 1.0), takesGenerated}),
+                 std::invalid_argument);
+    EXPECT_EQ(manager.requirementCount(), 0U);
+
+    const auto missing = RequirementDescriptor::fixPoint(ID(999));
+    EXPECT_THROW(manager.addRequirements({RequirementDescriptor::fixPoint(p2), missing}), std::runtime_error);
+    EXPECT_EQ(manager.getRequirementSystem().getRequirements().size(), 0U);
+}
+
 TEST_F(DCMManagerTest, RemoveRequirement) {
     auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
     auto p2 = manager.addFigure(FigureDescriptor::point(10.0, 0.0));
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "DCMManager.h"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace OurPaintDCM;
 using namespace OurPaintDCM::Utils;
@@ -442,3 +444,684 @@ TEST_F(DCMManagerSolveTest, LocalSolve_ThrowsWithoutComponentId) {
     manager.setSolveMode(SolveMode::LOCAL);
     EXPECT_THROW(manager.solve(), std::runtime_error);
 }
+
+TEST_F(DCMManagerSolveTest, DirtyComponents_MarkedByEditsAndClearedBySolve) {
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    auto p3 = manager.addFigure(FigureDescriptor::point(100.0, 0.0));
+    auto p4 = manager.addFigure(FigureDescriptor::point(103.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p3, p4, 5.0));
+
+    EXPECT_EQ(manager.getDirtyComponents().size(), 2U);
+    EXPECT_TRUE(manager.solve());
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+
+    manager.updatePoint(PointUpdateDescriptor(p3, 90.0, 0.0));
+    const auto component = manager.getComponentForFigure(p3);
+    ASSERT_TRUE(component.has_value());
+    EXPECT_EQ(manager.getDirtyComponents(), std::vector<ComponentID>{component.value()});
+
+    manager.setSolveMode(SolveMode::LOCAL);
+    EXPECT_TRUE(manager.solve(component.value()));
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+}
+
+TEST_F(DCMManagerSolveTest, SolveDirty_LeavesCleanComponentsUntouched) {
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    auto p3 = manager.addFigure(FigureDescriptor::point(100.0, 0.0));
+    auto p4 = manager.addFigure(FigureDescriptor::point(103.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p3, p4, 5.0));
+    ASSERT_TRUE(manager.solveDirty());
+    ASSERT_TRUE(manager.getDirtyComponents().empty());
+
+    const auto req = manager.getRequirementsInComponent(manager.getComponentForFigure(p1).value());
+    ASSERT_EQ(req.size(), 1U);
+    manager.updateRequirementParam(req.front(), 8.0);
+    const auto cleanP3 = manager.getFigure(p3);
+    const auto cleanP4 = manager.getFigure(p4);
+    ASSERT_TRUE(cleanP3.has_value() && cleanP4.has_value());
+
+    EXPECT_TRUE(manager.solveDirty());
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+
+    const auto d1 = manager.getFigure(p1);
+    const auto d2 = manager.getFigure(p2);
+    const auto d3 = manager.getFigure(p3);
+    const auto d4 = manager.getFigure(p4);
+    ASSERT_TRUE(d1.has_value() && d2.has_value() && d3.has_value() && d4.has_value());
+    const double dx = d2->x.value() - d1->x.value();
+    const double dy = d2->y.value() - d1->y.value();
+    EXPECT_NEAR(std::sqrt(dx * dx + dy * dy), 8.0, 1e-6);
+    EXPECT_EQ(d3->x.value(), cleanP3->x.value());
+    EXPECT_EQ(d4->x.value(), cleanP4->x.value());
+}
+
+TEST_F(DCMManagerSolveTest, SolveDirty_SolvesManyComponentsInParallel) {
+    constexpr int componentCount = 16;
+    std::vector<std::pair<ID, ID>> pairs;
+    for (int i = 0; i < componentCount; ++i) {
+        const double offset = 100.0 * i;
+        auto a = manager.addFigure(FigureDescriptor::point(offset, 0.0));
+        auto b = manager.addFigure(FigureDescriptor::point(offset + 1.0, 0.5));
+        manager.addRequirement(RequirementDescriptor::pointPointDist(a, b, 2.0 + i));
+        pairs.emplace_back(a, b);
+    }
+    EXPECT_EQ(manager.getDirtyComponents().size(), static_cast<std::size_t>(componentCount));
+
+    EXPECT_TRUE(manager.solveDirty());
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+
+    for (int i = 0; i < componentCount; ++i) {
+        const auto a = manager.getFigure(pairs[i].first);
+        const auto b = manager.getFigure(pairs[i].second);
+        ASSERT_TRUE(a.has_value() && b.has_value());
+        const double dx = b->x.value() - a->x.value();
+        const double dy = b->y.value() - a->y.value();
+        EXPECT_NEAR(std::sqrt(dx * dx + dy * dy), 2.0 + i, 1e-6);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, DirtyComponents_FollowMergeAndSplit) {
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    auto p3 = manager.addFigure(FigureDescriptor::point(6.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    const auto bridge = manager.addRequirement(RequirementDescriptor::pointPointDist(p2, p3, 5.0));
+    ASSERT_TRUE(manager.solve());
+    ASSERT_TRUE(manager.getDirtyComponents().empty());
+
+    manager.updatePoint(PointUpdateDescriptor(p3, 20.0, 0.0));
+    ASSERT_EQ(manager.getDirtyComponents().size(), 1U);
+
+    manager.removeRequirement(bridge);
+    ASSERT_EQ(manager.getComponentCount(), 2U);
+    const auto dirty = manager.getDirtyComponents();
+    ASSERT_EQ(dirty.size(), 2U);
+    EXPECT_NE(std::find(dirty.begin(), dirty.end(), manager.getComponentForFigure(p1).value()), dirty.end());
+    EXPECT_NE(std::find(dirty.begin(), dirty.end(), manager.getComponentForFigure(p3).value()), dirty.end());
+
+    manager.clear();
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+}
+
+TEST_F(DCMManagerSolveTest, SolveSatisfiedSketchLeavesGeometryUntouched) {
+    auto p1 = manager.addFigure(FigureDescriptor::point(1.0, 2.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(4.0, 6.0));
+    auto line = manager.addFigure(FigureDescriptor::line(0.0, 10.0, 7.0, 10.0));
+    manager.addRequirement(RequirementDescriptor::fixPoint(p1));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    manager.addRequirement(RequirementDescriptor::horizontal(line));
+    manager.setSolveMode(SolveMode::GLOBAL);
+
+    const auto before = manager.getAllFigures();
+    EXPECT_TRUE(manager.solve());
+    EXPECT_TRUE(manager.getDirtyComponents().empty());
+
+    const auto after = manager.getAllFigures();
+    ASSERT_EQ(before.size(), after.size());
+    for (std::size_t i = 0; i < before.size(); ++i) {
+        EXPECT_EQ(before[i].x, after[i].x);
+        EXPECT_EQ(before[i].y, after[i].y);
+    }
+
+    manager.setSolveMode(SolveMode::LOCAL);
+    const auto component = manager.getComponentForFigure(p2);
+    ASSERT_TRUE(component.has_value());
+    EXPECT_TRUE(manager.solve(component.value()));
+    const auto d2 = manager.getFigure(p2);
+    ASSERT_TRUE(d2.has_value());
+    EXPECT_EQ(d2->x.value(), 4.0);
+    EXPECT_EQ(d2->y.value(), 6.0);
+}
+
+TEST_F(DCMManagerSolveTest, DragMode_RelaxationSolvesOnlyNeighbourhood) {
+    constexpr int pointCount = 12;
+    std::vector<ID> points;
+    for (int i = 0; i < pointCount; ++i) {
+        points.push_back(manager.addFigure(FigureDescriptor::point(8.0 * i, (i % 2) * 6.0)));
+    }
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+    }
+    ASSERT_EQ(manager.getComponentCount(), 1U);
+
+    manager.setRelaxationHops(1);
+    EXPECT_EQ(manager.getRelaxationHops(), 1U);
+    manager.setSolveMode(SolveMode::DRAG);
+    manager.updatePoint(PointUpdateDescriptor(points[0], 1.0, 0.0));
+
+    const auto d0 = manager.getFigure(points[0]);
+    const auto d1 = manager.getFigure(points[1]);
+    const auto d2 = manager.getFigure(points[2]);
+    ASSERT_TRUE(d0.has_value() && d1.has_value() && d2.has_value());
+    EXPECT_NEAR(d0->x.value(), 1.0, 1e-9);
+    EXPECT_NEAR(std::hypot(d1->x.value() - d0->x.value(), d1->y.value() - d0->y.value()), 10.0, 1e-6);
+    EXPECT_NEAR(std::hypot(d2->x.value() - d1->x.value(), d2->y.value() - d1->y.value()), 10.0, 1e-6);
+
+    for (int i = 2; i < pointCount; ++i) {
+        const auto d = manager.getFigure(points[i]);
+        ASSERT_TRUE(d.has_value());
+        EXPECT_EQ(d->x.value(), 8.0 * i);
+        EXPECT_EQ(d->y.value(), (i % 2) * 6.0);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, DragMode_RelaxationExpandsWhenBoundaryIsViolated) {
+    constexpr int pointCount = 6;
+    std::vector<ID> points;
+    for (int i = 0; i < pointCount; ++i) {
+        points.push_back(manager.addFigure(FigureDescriptor::point(10.0 * i, 0.0)));
+    }
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+    }
+
+    manager.setRelaxationHops(1);
+    manager.setSolveMode(SolveMode::DRAG);
+    manager.updatePoint(PointUpdateDescriptor(points[0], -5.0, 0.0));
+
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        const auto a = manager.getFigure(points[i]);
+        const auto b = manager.getFigure(points[i + 1]);
+        ASSERT_TRUE(a.has_value() && b.has_value());
+        EXPECT_NEAR(std::hypot(b->x.value() - a->x.value(), b->y.value() - a->y.value()), 10.0, 1e-6);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, DragMode_RelaxationReusesCachedRegion) {
+    constexpr int pointCount = 12;
+    std::vector<ID> points;
+    for (int i = 0; i < pointCount; ++i) {
+        points.push_back(manager.addFigure(FigureDescriptor::point(8.0 * i, (i % 2) * 6.0)));
+    }
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+    }
+    manager.setRelaxationHops(1);
+    manager.setSolveMode(SolveMode::DRAG);
+
+    manager.updatePoint(PointUpdateDescriptor(points[0], 1.0, 0.0));
+    EXPECT_EQ(manager.getLastSolveReport().cacheMisses, 1U);
+    manager.updatePoint(PointUpdateDescriptor(points[0], 1.5, 0.5));
+    EXPECT_EQ(manager.getLastSolveReport().cacheHits, 1U);
+    EXPECT_EQ(manager.getLastSolveReport().cacheMisses, 0U);
+
+    const auto d0 = manager.getFigure(points[0]);
+    const auto d1 = manager.getFigure(points[1]);
+    ASSERT_TRUE(d0.has_value() && d1.has_value());
+    EXPECT_NEAR(d0->x.value(), 1.5, 1e-9);
+    EXPECT_NEAR(std::hypot(d1->x.value() - d0->x.value(), d1->y.value() - d0->y.value()), 10.0, 1e-6);
+    EXPECT_EQ(manager.getFigure(points[3])->x.value(), 24.0);
+}
+
+TEST_F(DCMManagerSolveTest, LinearPresolve_PinnedValuesEqualUpToRoundingDoNotConflict) {
+    auto a = manager.addFigure(FigureDescriptor::point(0.0, 2.0));
+    auto b = manager.addFigure(FigureDescriptor::point(5.0, 5.0));
+    auto c = manager.addFigure(FigureDescriptor::point(10.0, 2.0 + 1e-12));
+    auto ab = manager.addFigure(FigureDescriptor::line(a, b));
+    auto bc = manager.addFigure(FigureDescriptor::line(b, c));
+    manager.addRequirement(RequirementDescriptor::fixPoint(a));
+    manager.addRequirement(RequirementDescriptor::fixPoint(c));
+    manager.addRequirement(RequirementDescriptor::horizontal(ab));
+    manager.addRequirement(RequirementDescriptor::horizontal(bc));
+    manager.setSolveMode(SolveMode::GLOBAL);
+    EXPECT_TRUE(manager.solve());
+
+    // One class, one target: every member takes the same value instead of keeping residuals.
+    const auto da = manager.getFigure(a);
+    const auto db = manager.getFigure(b);
+    const auto dc = manager.getFigure(c);
+    ASSERT_TRUE(da.has_value() && db.has_value() && dc.has_value());
+    EXPECT_EQ(db->y.value(), da->y.value());
+    EXPECT_EQ(dc->y.value(), da->y.value());
+    EXPECT_NEAR(da->y.value(), 2.0, 1e-11);
+}
+
+TEST_F(DCMManagerSolveTest, LinearPresolve_HorizontalAlignsExactlyWithFixedEndpoint) {
+    auto line = manager.addFigure(FigureDescriptor::line(1.0, 2.0, 5.0, 3.0));
+    const auto lineDesc = manager.getFigure(line);
+    ASSERT_TRUE(lineDesc.has_value());
+    const auto p1 = lineDesc->pointIds[0];
+    const auto p2 = lineDesc->pointIds[1];
+
+    manager.addRequirement(RequirementDescriptor::fixPoint(p1));
+    manager.addRequirement(RequirementDescriptor::horizontal(line));
+    manager.setSolveMode(SolveMode::GLOBAL);
+    EXPECT_TRUE(manager.solve());
+
+    const auto d1 = manager.getFigure(p1);
+    const auto d2 = manager.getFigure(p2);
+    ASSERT_TRUE(d1.has_value() && d2.has_value());
+    EXPECT_EQ(d1->x.value(), 1.0);
+    EXPECT_EQ(d1->y.value(), 2.0);
+    EXPECT_EQ(d2->x.value(), 5.0);
+    EXPECT_EQ(d2->y.value(), 2.0);
+}
+
+TEST_F(DCMManagerSolveTest, LinearPresolve_DragFollowsHorizontalAndVerticalChain) {
+    auto bottom = manager.addFigure(FigureDescriptor::line(0.0, 0.0, 10.0, 1.0));
+    auto side = manager.addFigure(FigureDescriptor::line(10.0, 1.0, 11.0, 8.0));
+    const auto bottomDesc = manager.getFigure(bottom);
+    const auto sideDesc = manager.getFigure(side);
+    ASSERT_TRUE(bottomDesc.has_value() && sideDesc.has_value());
+
+    manager.addRequirement(RequirementDescriptor::pointOnPoint(bottomDesc->pointIds[1], sideDesc->pointIds[0]));
+    manager.addRequirement(RequirementDescriptor::horizontal(bottom));
+    manager.addRequirement(RequirementDescriptor::vertical(side));
+    manager.addRequirement(
+        RequirementDescriptor::pointPointDist(bottomDesc->pointIds[0], bottomDesc->pointIds[1], 10.0));
+
+    manager.setSolveMode(SolveMode::DRAG);
+    manager.updatePoint(PointUpdateDescriptor(sideDesc->pointIds[1], 14.0, 9.0));
+
+    const auto b1 = manager.getFigure(bottomDesc->pointIds[0]);
+    const auto b2 = manager.getFigure(bottomDesc->pointIds[1]);
+    const auto s1 = manager.getFigure(sideDesc->pointIds[0]);
+    const auto s2 = manager.getFigure(sideDesc->pointIds[1]);
+    ASSERT_TRUE(b1.has_value() && b2.has_value() && s1.has_value() && s2.has_value());
+
+    EXPECT_EQ(s2->x.value(), 14.0);
+    EXPECT_EQ(s2->y.value(), 9.0);
+    EXPECT_EQ(s1->x.value(), 14.0);
+    EXPECT_EQ(b2->x.value(), s1->x.value());
+    EXPECT_EQ(b2->y.value(), s1->y.value());
+    EXPECT_EQ(b1->y.value(), b2->y.value());
+    EXPECT_NEAR(std::abs(b2->x.value() - b1->x.value()), 10.0, 1e-6);
+}
+
+TEST_F(DCMManagerSolveTest, GlobalSolve_IndependentBlocksAroundFixedPoint) {
+    auto hub = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto a = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    auto b = manager.addFigure(FigureDescriptor::point(0.0, -4.0));
+    auto line = manager.addFigure(FigureDescriptor::line(0.0, 0.0, 2.0, 6.0));
+    const auto lineDesc = manager.getFigure(line);
+    ASSERT_TRUE(lineDesc.has_value());
+
+    manager.addRequirement(RequirementDescriptor::fixPoint(hub));
+    manager.addRequirement(RequirementDescriptor::pointOnPoint(hub, lineDesc->pointIds[0]));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(hub, a, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(hub, b, 7.0));
+    manager.addRequirement(RequirementDescriptor::vertical(line));
+    manager.setSolveMode(SolveMode::GLOBAL);
+
+    EXPECT_TRUE(manager.solve());
+    // The hub is fixed and the vertical line presolved, leaving a and b uncoupled.
+    EXPECT_EQ(manager.getLastSolveReport().blocks, 2U);
+
+    const auto h = manager.getFigure(hub);
+    const auto da = manager.getFigure(a);
+    const auto db = manager.getFigure(b);
+    const auto end = manager.getFigure(lineDesc->pointIds[1]);
+    ASSERT_TRUE(h.has_value() && da.has_value() && db.has_value() && end.has_value());
+    EXPECT_NEAR(std::hypot(da->x.value() - h->x.value(), da->y.value() - h->y.value()), 5.0, 1e-6);
+    EXPECT_NEAR(std::hypot(db->x.value() - h->x.value(), db->y.value() - h->y.value()), 7.0, 1e-6);
+    EXPECT_EQ(end->x.value(), 0.0);
+    EXPECT_EQ(end->y.value(), 6.0);
+}
+
+TEST_F(DCMManagerSolveTest, GlobalSolve_SplitsSeparableAxesOfConflictingLines) {
+    // The middle point hangs between horizontal lines to fixed points at y = 0 and y = 1 and
+    // vertical lines to fixed points at x = 0 and x = 1. The pinned values conflict, so the
+    // presolve keeps the rows as coordinate differences, and x and y of the middle point end up
+    // in separate blocks.
+    const ID middle = manager.addFigure(FigureDescriptor::point(3.0, 4.0));
+    const ID left = manager.addFigure(FigureDescriptor::point(-5.0, 0.0));
+    const ID right = manager.addFigure(FigureDescriptor::point(5.0, 1.0));
+    const ID bottom = manager.addFigure(FigureDescriptor::point(0.0, -5.0));
+    const ID top = manager.addFigure(FigureDescriptor::point(1.0, 5.0));
+    for (const ID pinned : {left, right, bottom, top}) {
+        manager.addRequirement(RequirementDescriptor::fixPoint(pinned));
+    }
+    manager.addRequirement(RequirementDescriptor::horizontal(manager.addFigure(FigureDescriptor::line(left, middle))));
+    manager.addRequirement(RequirementDescriptor::horizontal(manager.addFigure(FigureDescriptor::line(middle, right))));
+    manager.addRequirement(RequirementDescriptor::vertical(manager.addFigure(FigureDescriptor::line(bottom, middle))));
+    manager.addRequirement(RequirementDescriptor::vertical(manager.addFigure(FigureDescriptor::line(middle, top))));
+    manager.setSolveMode(SolveMode::GLOBAL);
+
+    EXPECT_FALSE(manager.solve());
+    const auto& report = manager.getLastSolveReport();
+    EXPECT_EQ(report.freeVariables, 2U);
+    EXPECT_EQ(report.blocks, 2U);
+
+    // Each axis settles on its least-squares compromise.
+    const auto point = manager.getFigure(middle);
+    ASSERT_TRUE(point.has_value());
+    EXPECT_NEAR(point->x.value(), 0.5, 1e-6);
+    EXPECT_NEAR(point->y.value(), 0.5, 1e-6);
+}
+
+TEST_F(DCMManagerSolveTest, RigidClusters_BracedRectangleIsDetected) {
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(4.0, 0.0));
+    const ID c = manager.addFigure(FigureDescriptor::point(4.0, 3.0));
+    const ID d = manager.addFigure(FigureDescriptor::point(0.0, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, b, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, c, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(c, d, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(d, a, 3.0));
+
+    const auto component = manager.getComponentForFigure(a);
+    ASSERT_TRUE(component.has_value());
+    EXPECT_TRUE(manager.getRigidClusters(*component).empty());
+
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+    const auto clusters = manager.getRigidClusters(*component);
+    ASSERT_EQ(clusters.size(), 1U);
+    EXPECT_EQ(clusters.front(), (std::vector<ID>{a, b, c, d}));
+}
+
+TEST_F(DCMManagerSolveTest, RigidClusters_DragMovesClusterAsRigidBody) {
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(4.0, 0.0));
+    const ID c = manager.addFigure(FigureDescriptor::point(4.0, 3.0));
+    const ID d = manager.addFigure(FigureDescriptor::point(0.0, 3.0));
+    const ID handle = manager.addFigure(FigureDescriptor::point(10.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, b, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, c, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(c, d, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(d, a, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, handle, 6.0));
+
+    manager.setRigidClustersEnabled(true);
+    EXPECT_TRUE(manager.getRigidClustersEnabled());
+    manager.setSolveMode(SolveMode::DRAG);
+    manager.updatePoint(PointUpdateDescriptor(handle, 13.0, 1.0));
+
+    const auto distance = [&](ID lhs, ID rhs) {
+        const auto p = manager.getFigure(lhs);
+        const auto q = manager.getFigure(rhs);
+        return std::hypot(p->x.value() - q->x.value(), p->y.value() - q->y.value());
+    };
+    const auto h = manager.getFigure(handle);
+    ASSERT_TRUE(h.has_value());
+    EXPECT_NEAR(h->x.value(), 13.0, 1e-9);
+    EXPECT_NEAR(h->y.value(), 1.0, 1e-9);
+    EXPECT_NEAR(distance(b, handle), 6.0, 1e-6);
+    EXPECT_NEAR(distance(a, b), 4.0, 1e-9);
+    EXPECT_NEAR(distance(b, c), 3.0, 1e-9);
+    EXPECT_NEAR(distance(c, d), 4.0, 1e-9);
+    EXPECT_NEAR(distance(d, a), 3.0, 1e-9);
+    EXPECT_NEAR(distance(a, c), 5.0, 1e-9);
+    EXPECT_NEAR(distance(b, d), 5.0, 1e-9);
+}
+
+TEST_F(DCMManagerSolveTest, RigidClusters_FailedAttemptLeavesGeometryToFallback) {
+    // The fixed corner pins the cluster, so the handle cannot be reached rigidly. The free tail
+    // ends wherever the fallback starts it from, which must be the geometry before the attempt.
+    const auto build = [](DCMManager& target, bool rigid) {
+        const ID a = target.addFigure(FigureDescriptor::point(0.0, 0.0));
+        const ID b = target.addFigure(FigureDescriptor::point(4.0, 0.0));
+        const ID c = target.addFigure(FigureDescriptor::point(4.0, 3.0));
+        const ID d = target.addFigure(FigureDescriptor::point(0.0, 3.0));
+        const ID handle = target.addFigure(FigureDescriptor::point(10.0, 0.0));
+        const ID tail = target.addFigure(FigureDescriptor::point(0.0, 5.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(a, b, 4.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(b, c, 3.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(c, d, 4.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(d, a, 3.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(b, handle, 6.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(d, tail, 2.0));
+        target.addRequirement(RequirementDescriptor::fixPoint(a));
+        target.setRigidClustersEnabled(rigid);
+        target.setSolveMode(SolveMode::DRAG);
+        target.updatePoint(PointUpdateDescriptor(handle, 30.0, 5.0));
+    };
+    DCMManager reference;
+    build(reference, false);
+    build(manager, true);
+
+    const auto expected = reference.getAllPoints();
+    const auto actual = manager.getAllPoints();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].x.value(), expected[i].x.value());
+        EXPECT_EQ(actual[i].y.value(), expected[i].y.value());
+    }
+}
+
+TEST_F(DCMManagerSolveTest, ConstructiveSolve_PlacesTriangleApexOnCurrentBranch) {
+    EXPECT_FALSE(manager.getConstructiveSolveEnabled());
+    manager.setConstructiveSolveEnabled(true);
+    EXPECT_TRUE(manager.getConstructiveSolveEnabled());
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(6.0, 0.0));
+    const ID up = manager.addFigure(FigureDescriptor::point(2.0, 3.0));
+    const ID down = manager.addFigure(FigureDescriptor::point(2.0, -3.0));
+    manager.addRequirement(RequirementDescriptor::fixPoint(a));
+    manager.addRequirement(RequirementDescriptor::fixPoint(b));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, up, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, up, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, down, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, down, 5.0));
+    ASSERT_TRUE(manager.solve());
+
+    const auto upDesc = manager.getFigure(up);
+    const auto downDesc = manager.getFigure(down);
+    ASSERT_TRUE(upDesc.has_value() && downDesc.has_value());
+    EXPECT_NEAR(upDesc->x.value(), 3.0, 1e-12);
+    EXPECT_NEAR(upDesc->y.value(), 4.0, 1e-12);
+    EXPECT_NEAR(downDesc->x.value(), 3.0, 1e-12);
+    EXPECT_NEAR(downDesc->y.value(), -4.0, 1e-12);
+}
+
+TEST_F(DCMManagerSolveTest, ConstructiveSolve_ChainsDistancesAndLineIncidence) {
+    manager.setConstructiveSolveEnabled(true);
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(8.0, 0.0));
+    const ID base = manager.addFigure(FigureDescriptor::line(a, b));
+    const ID apex = manager.addFigure(FigureDescriptor::point(3.0, 2.0));
+    const ID foot = manager.addFigure(FigureDescriptor::point(5.0, 1.0));
+    manager.addRequirement(RequirementDescriptor::fixPoint(a));
+    manager.addRequirement(RequirementDescriptor::fixPoint(b));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, apex, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, apex, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointOnLine(foot, base));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(apex, foot, 5.0));
+    ASSERT_TRUE(manager.solve());
+
+    const auto apexDesc = manager.getFigure(apex);
+    const auto footDesc = manager.getFigure(foot);
+    ASSERT_TRUE(apexDesc.has_value() && footDesc.has_value());
+    EXPECT_NEAR(apexDesc->x.value(), 4.0, 1e-12);
+    EXPECT_NEAR(apexDesc->y.value(), 3.0, 1e-12);
+    EXPECT_NEAR(footDesc->x.value(), 8.0, 1e-12);
+    EXPECT_NEAR(footDesc->y.value(), 0.0, 1e-12);
+}
+
+TEST_F(DCMManagerSolveTest, ConstructiveSolve_DisabledStageGivesSameGeometry) {
+    manager.setConstructiveSolveEnabled(false);
+    EXPECT_FALSE(manager.getConstructiveSolveEnabled());
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(6.0, 0.0));
+    const ID c = manager.addFigure(FigureDescriptor::point(2.0, 3.0));
+    manager.addRequirement(RequirementDescriptor::fixPoint(a));
+    manager.addRequirement(RequirementDescriptor::fixPoint(b));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, c, 5.0));
+    ASSERT_TRUE(manager.solve());
+
+    const auto desc = manager.getFigure(c);
+    ASSERT_TRUE(desc.has_value());
+    EXPECT_NEAR(desc->x.value(), 3.0, 1e-6);
+    EXPECT_NEAR(desc->y.value(), 4.0, 1e-6);
+}
+
+TEST_F(DCMManagerSolveTest, ExpressionTreeSolve_ReachesSameGeometryAsDefaultSolve) {
+    const auto build = [](DCMManager& target) {
+        const ID a = target.addFigure(FigureDescriptor::point(0.0, 0.0));
+        const ID b = target.addFigure(FigureDescriptor::point(6.0, 0.5));
+        const ID c = target.addFigure(FigureDescriptor::point(2.0, 3.0));
+        const ID d = target.addFigure(FigureDescriptor::point(7.0, 4.0));
+        target.addRequirement(RequirementDescriptor::fixPoint(a));
+        target.addRequirement(RequirementDescriptor::pointPointDist(a, b, 6.0));
+        target.addRequirement(RequirementDescriptor::horizontal(target.addFigure(FigureDescriptor::line(a, b))));
+        target.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(b, c, 5.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(c, d, 4.0));
+        target.addRequirement(RequirementDescriptor::pointPointDist(b, d, 5.0));
+        return target.solve();
+    };
+
+    EXPECT_FALSE(manager.getExpressionTreeSolveEnabled());
+    ASSERT_TRUE(build(manager));
+    EXPECT_GT(manager.getLastSolveReport().iterations, 0U);
+
+    DCMManager expressionTrees;
+    expressionTrees.setExpressionTreeSolveEnabled(true);
+    EXPECT_TRUE(expressionTrees.getExpressionTreeSolveEnabled());
+    ASSERT_TRUE(build(expressionTrees));
+
+    const auto expected = expressionTrees.getAllPoints();
+    const auto actual = manager.getAllPoints();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_NEAR(actual[i].x.value(), expected[i].x.value(), 1e-6);
+        EXPECT_NEAR(actual[i].y.value(), expected[i].y.value(), 1e-6);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, ExpressionTreeSolve_InternsSharedCoordinatesOnce) {
+    manager.setExpressionTreeSolveEnabled(true);
+    manager.setConstructiveSolveEnabled(false);
+    // Five rods share the hub, so its coordinates appear in every requirement.
+    const ID hub = manager.addFigure(FigureDescriptor::point(0.5, 0.5));
+    std::vector<ID> spokes;
+    for (int i = 0; i < 5; ++i) {
+        spokes.push_back(manager.addFigure(FigureDescriptor::point(3.0 * std::cos(i), 3.0 * std::sin(i))));
+        manager.addRequirement(RequirementDescriptor::pointPointDist(hub, spokes.back(), 2.0));
+    }
+    manager.addRequirement(RequirementDescriptor::fixPoint(spokes.front()));
+
+    ASSERT_TRUE(manager.solve());
+    // 20 coordinate references over the hub and the four free spokes.
+    EXPECT_EQ(manager.getLastSolveReport().freeVariables, 10U);
+    const auto center = manager.getFigure(hub);
+    ASSERT_TRUE(center.has_value());
+    for (const ID spoke : spokes) {
+        const auto end = manager.getFigure(spoke);
+        ASSERT_TRUE(end.has_value());
+        EXPECT_NEAR(std::hypot(end->x.value() - center->x.value(), end->y.value() - center->y.value()), 2.0, 1e-6);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, IterativeSolve_MatchesRequirementsAboveThreshold) {
+    manager.setConstructiveSolveEnabled(false);
+    manager.setIterativeSolveThreshold(1);
+    EXPECT_EQ(manager.getIterativeSolveThreshold(), 1U);
+
+    constexpr int pointCount = 10;
+    std::vector<ID> points;
+    for (int i = 0; i < pointCount; ++i) {
+        points.push_back(manager.addFigure(FigureDescriptor::point(7.0 * i, (i % 2) * 3.0)));
+    }
+    const ID base = manager.addFigure(FigureDescriptor::line(points[0], points[1]));
+    manager.addRequirement(RequirementDescriptor::fixPoint(points[0]));
+    manager.addRequirement(RequirementDescriptor::horizontal(base));
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+    }
+    ASSERT_TRUE(manager.solve());
+
+    const auto first = manager.getFigure(points[0]);
+    const auto second = manager.getFigure(points[1]);
+    ASSERT_TRUE(first.has_value() && second.has_value());
+    EXPECT_EQ(first->x.value(), 0.0);
+    EXPECT_EQ(first->y.value(), 0.0);
+    EXPECT_EQ(second->y.value(), 0.0);
+    for (int i = 0; i + 1 < pointCount; ++i) {
+        const auto p = manager.getFigure(points[i]);
+        const auto q = manager.getFigure(points[i + 1]);
+        EXPECT_NEAR(std::hypot(q->x.value() - p->x.value(), q->y.value() - p->y.value()), 10.0, 1e-8);
+    }
+}
+
+TEST_F(DCMManagerSolveTest, SolveReport_DescribesLastSolve) {
+    EXPECT_EQ(manager.getLastSolveReport().termination, SolveTermination::ET_NONE);
+
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    manager.setSolveMode(SolveMode::GLOBAL);
+
+    ASSERT_TRUE(manager.solve());
+    const auto& first = manager.getLastSolveReport();
+    EXPECT_EQ(first.termination, SolveTermination::ET_CONVERGED);
+    EXPECT_TRUE(first.succeeded());
+    EXPECT_EQ(first.components, 1U);
+    EXPECT_EQ(first.cacheMisses, 1U);
+    EXPECT_EQ(first.requirements, 1U);
+    EXPECT_GT(first.freeVariables, 0U);
+    EXPECT_NEAR(first.initialResidualNorm, 2.0, 1e-12);
+    EXPECT_LT(first.finalResidualNorm, 1e-6);
+    EXPECT_GT(first.phases.total().count(), 0);
+
+    ASSERT_TRUE(manager.solve());
+    const auto& second = manager.getLastSolveReport();
+    EXPECT_EQ(second.termination, SolveTermination::ET_ALREADY_SATISFIED);
+    EXPECT_EQ(second.cacheHits, 1U);
+    EXPECT_EQ(second.cacheMisses, 0U);
+    EXPECT_EQ(second.initialResidualNorm, second.finalResidualNorm);
+}
+
+TEST_F(DCMManagerSolveTest, SolveReport_RecordsIterativeDamping) {
+    manager.setConstructiveSolveEnabled(false);
+    manager.setIterativeSolveThreshold(1);
+
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 1.0));
+    manager.addRequirement(RequirementDescriptor::fixPoint(p1));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    ASSERT_TRUE(manager.solve());
+
+    const auto& report = manager.getLastSolveReport();
+    EXPECT_EQ(report.termination, SolveTermination::ET_CONVERGED);
+    EXPECT_GT(report.iterations, 0U);
+    EXPECT_EQ(report.damping.size(), report.iterations);
+}
+
+TEST_F(DCMManagerSolveTest, MemoryUsage_TracksFiguresAndSolveCache) {
+    const auto empty = manager.memoryUsage();
+    EXPECT_EQ(empty.solveCacheEntries, 0U);
+
+    manager.setConstructiveSolveEnabled(false);
+    manager.setIterativeSolveThreshold(1);
+    std::vector<ID> points;
+    for (int i = 0; i < 16; ++i) {
+        points.push_back(manager.addFigure(FigureDescriptor::point(7.0 * i, (i % 2) * 3.0)));
+    }
+    const ID base = manager.addFigure(FigureDescriptor::line(points[0], points[1]));
+    manager.addRequirement(RequirementDescriptor::fixPoint(points[0]));
+    manager.addRequirement(RequirementDescriptor::horizontal(base));
+    for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+        manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+    }
+
+    const auto built = manager.memoryUsage();
+    EXPECT_GT(built.geometrySlots, empty.geometrySlots);
+    EXPECT_GT(built.geometryIndex, empty.geometryIndex);
+    EXPECT_GT(built.figureRecords, 0U);
+    EXPECT_GT(built.requirementRecords, 0U);
+    EXPECT_GT(built.components, 0U);
+    EXPECT_GT(built.requirementFunctions, 0U);
+
+    ASSERT_TRUE(manager.solve());
+    const auto solved = manager.memoryUsage();
+    EXPECT_EQ(solved.solveCacheEntries, 1U);
+    EXPECT_GT(solved.solveCache, built.solveCache);
+    EXPECT_EQ(solved.total(), solved.geometrySlots + solved.geometryFreeLists + solved.geometryIndex +
+                                  solved.geometryDependencies + solved.figureRecords + solved.requirementRecords +
+                                  solved.components + solved.requirementFunctions + solved.jacobian +
+                                  solved.solveCache);
+
+    manager.clear();
+    const auto cleared = manager.memoryUsage();
+    EXPECT_EQ(cleared.solveCacheEntries, 0U);
+    EXPECT_LT(cleared.solveCache, solved.solveCache);
+    EXPECT_LT(cleared.figureRecords, solved.figureRecords);
+    EXPECT_LT(cleared.total(), solved.total());
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "AllocationCounter.h"
+#include "DCMManager.h"
+#include "TraceRecorder.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Testing;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+/**
+ * @brief Chain of rods from a fixed base, dragged by its free end.
+ */
+class DragChainTest : public ::testing::Test {
+protected:
+    static constexpr int kPointCount = 8;
+
+    DCMManager manager;
+    std::vector<ID> points;
+
+    void buildChain() {
+        for (int i = 0; i < kPointCount; ++i) {
+            points.push_back(manager.addFigure(FigureDescriptor::point(10.0 * i, (i % 2) * 1.0)));
+        }
+        const ID base = manager.addFigure(FigureDescriptor::line(points[0], points[1]));
+        manager.addRequirement(RequirementDescriptor::fixPoint(points[0]));
+        manager.addRequirement(RequirementDescriptor::horizontal(base));
+        for (int i = 0; i + 1 < kPointCount; ++i) {
+            manager.addRequirement(RequirementDescriptor::pointPointDist(points[i], points[i + 1], 10.0));
+        }
+        manager.solveDirty();
+        manager.setSolveMode(SolveMode::DRAG);
+    }
+
+    PointUpdateDescriptor frame(int i) const {
+        return PointUpdateDescriptor(points.back(), 60.0 + 0.05 * (i % 8), 5.0 - 0.05 * (i % 5));
+    }
+};
+
+/// @brief The chain with the conjugate-gradient inner solver pinned and the constructive stage off.
+class DragAllocationTest : public DragChainTest {
+protected:
+    void SetUp() override {
+        manager.setConstructiveSolveEnabled(false);
+        manager.setIterativeSolveThreshold(1);
+        buildChain();
+    }
+};
+
+/// @brief The chain with default solver settings.
+class DefaultSettingsDragAllocationTest : public DragChainTest {
+protected:
+    void SetUp() override { buildChain(); }
+};
+}
+
+TEST(AllocationCounterTest, CountsAllocationsInsideScope) {
+    AllocationScope scope;
+    auto values = std::make_unique<std::vector<int>>(16);
+    const auto count = scope.count();
+    EXPECT_EQ(count.calls, 2U);
+    EXPECT_GE(count.bytes, sizeof(std::vector<int>) + 16 * sizeof(int));
+}
+
+TEST_F(DragAllocationTest, IterativeDragFrameAllocatesNothing) {
+    // Warm-up builds the cached subsystem and pipeline and grows every workspace.
+    for (int i = 0; i < 16; ++i) {
+        manager.updatePoint(frame(i));
+    }
+    ASSERT_EQ(manager.getLastSolveReport().cacheHits, 1U);
+    ASSERT_GT(manager.getLastSolveReport().iterations, 0U);
+
+    for (int i = 16; i < 48; ++i) {
+        const auto drag = frame(i);
+        AllocationScope scope;
+        manager.updatePoint(drag);
+        const auto count = scope.count();
+        EXPECT_EQ(count.calls, 0U) << "frame " << i << " allocated " << count.bytes << " bytes";
+    }
+    EXPECT_EQ(manager.getLastSolveReport().cacheMisses, 0U);
+}
+
+TEST_F(DragAllocationTest, BatchedIterativeDragFrameAllocatesNothing) {
+    std::vector<PointUpdateDescriptor> drags{frame(0), PointUpdateDescriptor(points[3], 30.0, 2.0)};
+    for (int i = 0; i < 16; ++i) {
+        drags[0] = frame(i);
+        manager.updatePoints(drags);
+    }
+
+    for (int i = 16; i < 32; ++i) {
+        drags[0] = frame(i);
+        AllocationScope scope;
+        manager.updatePoints(drags);
+        EXPECT_EQ(scope.count().calls, 0U) << "frame " << i;
+    }
+}
+
+TEST_F(DefaultSettingsDragAllocationTest, MovingDragFrameAllocatesNothing) {
+    for (int i = 0; i < 16; ++i) {
+        manager.updatePoint(frame(i));
+    }
+    ASSERT_EQ(manager.getLastSolveReport().termination, SolveTermination::ET_CONVERGED);
+
+    for (int i = 16; i < 48; ++i) {
+        const auto drag = frame(i);
+        AllocationScope scope;
+        manager.updatePoint(drag);
+        const auto count = scope.count();
+        EXPECT_EQ(count.calls, 0U) << "frame " << i << " allocated " << count.bytes << " bytes";
+        const auto& report = manager.getLastSolveReport();
+        EXPECT_EQ(report.cacheMisses, 0U);
+    }
+    EXPECT_GT(manager.getLastSolveReport().iterations, 0U);
+}
+
+TEST_F(DefaultSettingsDragAllocationTest, InTreeFrameWorkAllocatesNothing) {
+    for (int i = 0; i < 16; ++i) {
+        manager.updatePoint(frame(i));
+    }
+    ASSERT_EQ(manager.getLastSolveReport().termination, SolveTermination::ET_CONVERGED);
+
+    // Holding the handle still leaves the chain satisfied, so each frame runs the cache lookup,
+    // the drag lock bookkeeping, the fix-target visit and the report and trace bookkeeping,
+    // but not the optimizer.
+    const auto end = manager.getFigure(points.back());
+    ASSERT_TRUE(end.has_value());
+    const PointUpdateDescriptor hold(points.back(), end->x.value(), end->y.value());
+    auto& trace = TraceRecorder::shared();
+    trace.start();
+    for (int i = 0; i < 16; ++i) {
+        AllocationScope scope;
+        manager.updatePoint(hold);
+        const auto count = scope.count();
+        EXPECT_EQ(count.calls, 0U) << "frame " << i << " allocated " << count.bytes << " bytes";
+        const auto& report = manager.getLastSolveReport();
+        EXPECT_EQ(report.termination, SolveTermination::ET_ALREADY_SATISFIED);
+        EXPECT_EQ(report.cacheHits, 1U);
+        EXPECT_EQ(report.cacheMisses, 0U);
+    }
+    trace.stop();
+    EXPECT_GT(trace.recordedCount(), 0U);
+}
+
+TEST(RigidClusterDragAllocationTest, RigidDragFrameAllocatesNothing) {
+    // A braced rectangle moved rigidly by a rod to the dragged handle.
+    DCMManager manager;
+    const ID a = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    const ID b = manager.addFigure(FigureDescriptor::point(4.0, 0.0));
+    const ID c = manager.addFigure(FigureDescriptor::point(4.0, 3.0));
+    const ID d = manager.addFigure(FigureDescriptor::point(0.0, 3.0));
+    const ID handle = manager.addFigure(FigureDescriptor::point(10.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, b, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, c, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(c, d, 4.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(d, a, 3.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(a, c, 5.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(b, handle, 6.0));
+    manager.setRigidClustersEnabled(true);
+    manager.setSolveMode(SolveMode::DRAG);
+
+    const auto drag = [&](int i) {
+        return PointUpdateDescriptor(handle, 10.0 + 0.1 * (i % 16), 0.2 * (i % 7));
+    };
+    for (int i = 0; i < 16; ++i) {
+        manager.updatePoint(drag(i));
+    }
+
+    for (int i = 16; i < 48; ++i) {
+        const auto update = drag(i);
+        AllocationScope scope;
+        manager.updatePoint(update);
+        const auto count = scope.count();
+        EXPECT_EQ(count.calls, 0U) << "frame " << i << " allocated " << count.bytes << " bytes";
+        // Solved by the rigid path: the component solve would have looked up its cache.
+        const auto& report = manager.getLastSolveReport();
+        EXPECT_EQ(report.termination, SolveTermination::ET_CONVERGED);
+        EXPECT_EQ(report.cacheHits + report.cacheMisses, 0U);
+        EXPECT_GT(report.iterations, 0U);
+    }
+
+    const auto distance = [&](ID lhs, ID rhs) {
+        const auto p = manager.getFigure(lhs);
+        const auto q = manager.getFigure(rhs);
+        return std::hypot(p->x.value() - q->x.value(), p->y.value() - q->y.value());
+    };
+    EXPECT_NEAR(distance(b, handle), 6.0, 1e-6);
+    EXPECT_NEAR(distance(a, c), 5.0, 1e-9);
+    EXPECT_NEAR(distance(b, d), 5.0, 1e-9);
+}
@@ -297,6 +297,61 @@ TEST(GeometryStorageTest, GetNotFound) {
     EXPECT_EQ(storage.get<Point2D>(ID(999)), nullptr);
 }
 
+TEST(GeometryStorageTest, VarHandleResolvesToFigureScalars) {
+    GeometryStorage storage;
+    const ID center = storage.createPoint(1.0, 2.0);
+    const auto circleId = storage.createCircle(center, 3.0);
+    ASSERT_TRUE(circleId);
+    const auto lineId = storage.createLine(center, storage.createPoint(4.0, 5.0));
+    ASSERT_TRUE(lineId);
+
+    const auto x = storage.varHandle(center, OurPaintDCM::Utils::kPointX);
+    const auto y = storage.varHandle(center, OurPaintDCM::Utils::kPointY);
+    const auto radius = storage.varHandle(*circleId, OurPaintDCM::Utils::kCircleRadius);
+    ASSERT_TRUE(x && y && radius);
+    EXPECT_NE(*x, *y);
+    EXPECT_LT(*x, *y);
+
+    EXPECT_EQ(storage.resolve(*x), storage.get<Point2D>(center)->ptrX());
+    EXPECT_EQ(storage.resolve(*y), storage.get<Point2D>(center)->ptrY());
+    EXPECT_EQ(storage.resolve(*radius), storage.get<Circle2D>(*circleId)->ptrRadius());
+
+    EXPECT_FALSE(storage.varHandle(center, 2));
+    EXPECT_FALSE(storage.varHandle(*lineId, 0));
+    EXPECT_FALSE(storage.varHandle(ID(999), 0));
+
+    EXPECT_EQ(storage.remove(center, true), RemoveResult::Ok);
+    EXPECT_EQ(storage.resolve(*x), nullptr);
+    EXPECT_EQ(storage.resolve(*radius), nullptr);
+}
+
+TEST(GeometryStorageTest, VarHandleOfRemovedFigureDoesNotResolveToReusedSlot) {
+    GeometryStorage storage;
+    const ID first = storage.createPoint(1.0, 2.0);
+    const auto stale = storage.varHandle(first, OurPaintDCM::Utils::kPointX);
+    ASSERT_TRUE(stale);
+    ASSERT_EQ(storage.remove(first, false), RemoveResult::Ok);
+
+    // The new point takes the freed slot, under a newer generation.
+    const ID second = storage.createPoint(3.0, 4.0);
+    const auto fresh = storage.varHandle(second, OurPaintDCM::Utils::kPointX);
+    ASSERT_TRUE(fresh);
+    EXPECT_EQ(fresh->slot, stale->slot);
+    EXPECT_NE(*fresh, *stale);
+    EXPECT_EQ(storage.resolve(*stale), nullptr);
+    EXPECT_EQ(storage.resolve(*fresh), storage.get<Point2D>(second)->ptrX());
+
+    const auto circleId = storage.createCircle(second, 1.0);
+    ASSERT_TRUE(circleId);
+    const auto radius = storage.varHandle(*circleId, OurPaintDCM::Utils::kCircleRadius);
+    ASSERT_TRUE(radius);
+    storage.clear();
+    const ID center = storage.createPoint(0.0, 0.0);
+    ASSERT_TRUE(storage.createCircle(center, 2.0));
+    EXPECT_EQ(storage.resolve(*fresh), nullptr);
+    EXPECT_EQ(storage.resolve(*radius), nullptr);
+}
+
 #ifndef NDEBUG
 TEST(GeometryStorageTest, SlotReuse_NoUnboundedGrowth) {
     GeometryStorage storage;
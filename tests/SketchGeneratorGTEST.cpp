@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "SketchGenerator.h"
+#include <array>
+#include <cmath>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+constexpr std::array<SketchFamily, 5> kFamilies{
+    SketchFamily::ET_RECTANGLE_GRID, SketchFamily::ET_TRUSS_LATTICE, SketchFamily::ET_BOLT_CIRCLE,
+    SketchFamily::ET_OPEN_LINKAGE, SketchFamily::ET_DISCONNECTED_PARTS};
+}
+
+TEST(SketchGeneratorTest, SameSeedGivesSameSketch) {
+    for (const auto family : kFamilies) {
+        const SketchSpec spec{family, 300, 7, ConstraintLevel::ET_UNDER, 0.5, 0.1};
+        DCMManager first;
+        DCMManager second;
+        const auto a = generateSketch(first, spec);
+        const auto b = generateSketch(second, spec);
+
+        ASSERT_EQ(a.entityCount(), b.entityCount()) << sketchFamilyName(family);
+        ASSERT_EQ(a.requirements.size(), b.requirements.size()) << sketchFamilyName(family);
+        for (std::size_t i = 0; i < a.requirements.size(); ++i) {
+            EXPECT_EQ(a.requirements[i].type, b.requirements[i].type);
+            EXPECT_EQ(a.requirements[i].param, b.requirements[i].param);
+        }
+        for (std::size_t i = 0; i < a.points.size(); ++i) {
+            const auto pa = first.getFigure(a.points[i]);
+            const auto pb = second.getFigure(b.points[i]);
+            ASSERT_TRUE(pa.has_value() && pb.has_value());
+            EXPECT_EQ(pa->coords, pb->coords);
+        }
+    }
+}
+
+TEST(SketchGeneratorTest, DifferentSeedsGiveDifferentGeometry) {
+    DCMManager first;
+    DCMManager second;
+    const auto a = generateSketch(first, {SketchFamily::ET_OPEN_LINKAGE, 100, 1});
+    const auto b = generateSketch(second, {SketchFamily::ET_OPEN_LINKAGE, 100, 2});
+    ASSERT_EQ(a.points.size(), b.points.size());
+    EXPECT_NE(first.getFigure(a.points.back())->coords, second.getFigure(b.points.back())->coords);
+}
+
+TEST(SketchGeneratorTest, FamiliesReachTargetSizeAndPartCount) {
+    for (const auto family : kFamilies) {
+        for (const std::size_t target : {30U, 1000U}) {
+            DCMManager manager;
+            const auto sketch = generateSketch(manager, {family, target, 3});
+            EXPECT_GT(sketch.entityCount(), target / 2) << sketchFamilyName(family) << " " << target;
+            EXPECT_LT(sketch.entityCount(), target * 2) << sketchFamilyName(family) << " " << target;
+            EXPECT_EQ(manager.figureCount(), sketch.entityCount());
+            EXPECT_EQ(manager.requirementCount(), sketch.requirements.size());
+            EXPECT_EQ(sketch.requirementIds.size(), sketch.requirements.size());
+            EXPECT_EQ(manager.getComponentCount(), sketch.parts) << sketchFamilyName(family);
+            EXPECT_FALSE(sketch.anchors.empty());
+            EXPECT_FALSE(sketch.handles.empty());
+        }
+    }
+}
+
+TEST(SketchGeneratorTest, ConstraintLevelsChangeRequirementCount) {
+    for (const auto family : kFamilies) {
+        std::array<std::size_t, 3> counts{};
+        for (const auto level : {ConstraintLevel::ET_WELL, ConstraintLevel::ET_UNDER, ConstraintLevel::ET_OVER}) {
+            DCMManager manager;
+            const auto sketch = generateFigures(manager, {family, 500, 11, level});
+            counts[static_cast<std::size_t>(level)] = sketch.requirements.size();
+            EXPECT_EQ(manager.requirementCount(), 0U);
+        }
+        EXPECT_LT(counts[1], counts[0]) << sketchFamilyName(family);
+        EXPECT_GT(counts[2], counts[0]) << sketchFamilyName(family);
+    }
+}
+
+TEST(SketchGeneratorTest, JitteredWellConstrainedSketchesSolveBack) {
+    for (const auto family : {SketchFamily::ET_RECTANGLE_GRID, SketchFamily::ET_TRUSS_LATTICE,
+                              SketchFamily::ET_BOLT_CIRCLE, SketchFamily::ET_DISCONNECTED_PARTS}) {
+        DCMManager manager;
+        const auto sketch = generateSketch(manager, {family, 120, 5, ConstraintLevel::ET_WELL, 0.5, 0.05});
+        EXPECT_TRUE(manager.solve()) << sketchFamilyName(family);
+        EXPECT_LT(manager.getLastSolveReport().finalResidualNorm, 1e-6) << sketchFamilyName(family);
+    }
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include "BlockSparseMatrix.h"
+#include "IterativeLMSolver.h"
+#include "RequirementFunctionSystem.h"
+#include <array>
+#include <cmath>
+#include <Eigen/Dense>
+
+using namespace OurPaintDCM::System;
+using namespace OurPaintDCM::Function;
+
+class BlockSparseMatrixTest : public ::testing::Test {
+protected:
+    // Three points and one free scalar; the scalar only appears in a 1×1 block.
+    double x1 = 0.0, y1 = 0.0, x2 = 3.0, y2 = 4.5, x3 = -1.0, y3 = 2.0, s = 0.7;
+    std::vector<std::shared_ptr<RequirementFunction>> functions;
+    std::vector<VAR> variables;
+    std::unordered_map<VAR, Eigen::Index> columnOf;
+
+    void SetUp() override {
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x1, &y1, &x2, &y2}, 5.0));
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x2, &y2, &x3, &y3}, 4.0));
+        functions.push_back(std::make_shared<VerticalFunction>(std::vector<VAR>{&x1, &y1, &x3, &y3}));
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x3, &y3, &s, &y1}, 1.0));
+        variables = {&x2, &s, &y2, &x3, &y3, &x1};
+        for (std::size_t j = 0; j < variables.size(); ++j) {
+            columnOf.emplace(variables[j], static_cast<Eigen::Index>(j));
+        }
+    }
+
+    BlockLayout layout() {
+        return BlockLayout(variables, {{&x2, &y2}, {&x3, &y3}});
+    }
+
+    Eigen::MatrixXd denseJacobian() const {
+        Eigen::MatrixXd dense = Eigen::MatrixXd::Zero(static_cast<Eigen::Index>(functions.size()),
+                                                      static_cast<Eigen::Index>(variables.size()));
+        for (std::size_t i = 0; i < functions.size(); ++i) {
+            for (const auto& [var, value] : functions[i]->gradient()) {
+                if (const auto it = columnOf.find(var); it != columnOf.end()) {
+                    dense(static_cast<Eigen::Index>(i), it->second) += value * functions[i]->getWeight();
+                }
+            }
+        }
+        return dense;
+    }
+};
+
+TEST_F(BlockSparseMatrixTest, LayoutPairsPointsAndPadsScalars) {
+    const auto blocks = layout();
+    EXPECT_EQ(blocks.blockCount(), 4U);
+    EXPECT_EQ(blocks.variableCount(), variables.size());
+    EXPECT_EQ(blocks.paddedSize(), 8);
+    EXPECT_EQ(blocks.paddedIndex(0), 0);
+    EXPECT_EQ(blocks.paddedIndex(2), 1);
+    EXPECT_EQ(blocks.columns(2)[1], -1);
+
+    Eigen::VectorXd scalar = Eigen::VectorXd::LinSpaced(6, 1.0, 6.0);
+    Eigen::VectorXd padded;
+    Eigen::VectorXd back;
+    blocks.gather(scalar, padded);
+    blocks.scatter(padded, back);
+    EXPECT_EQ(back, scalar);
+}
+
+TEST_F(BlockSparseMatrixTest, JacobianMatchesScalarAssemblyAndProducts) {
+    BlockSparseJacobian jacobian(layout(), functions, columnOf);
+    jacobian.assemble(functions);
+    const Eigen::MatrixXd dense = denseJacobian();
+    EXPECT_TRUE(Eigen::MatrixXd(jacobian.toSparse()).isApprox(dense));
+    EXPECT_LT(jacobian.blockNonZeros(), static_cast<std::size_t>(jacobian.toSparse().nonZeros()));
+
+    const Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(6, -1.0, 2.0);
+    Eigen::VectorXd padded;
+    jacobian.layout().gather(x, padded);
+    Eigen::VectorXd product;
+    jacobian.multiply(padded, product);
+    EXPECT_TRUE(product.isApprox(dense * x));
+
+    const Eigen::VectorXd r = Eigen::VectorXd::LinSpaced(4, 0.5, 2.0);
+    Eigen::VectorXd transposed;
+    Eigen::VectorXd scalar;
+    jacobian.multiplyTransposed(r, transposed);
+    jacobian.layout().scatter(transposed, scalar);
+    EXPECT_TRUE(scalar.isApprox(dense.transpose() * r));
+
+    Eigen::VectorXd norms;
+    jacobian.columnSquaredNorms(norms);
+    jacobian.layout().scatter(norms, scalar);
+    EXPECT_TRUE(scalar.isApprox(dense.colwise().squaredNorm().transpose()));
+}
+
+TEST_F(BlockSparseMatrixTest, NormalMatrixAndBlockCholeskySolve) {
+    BlockSparseJacobian jacobian(layout(), functions, columnOf);
+    jacobian.assemble(functions);
+    const Eigen::MatrixXd dense = denseJacobian();
+
+    const Eigen::VectorXd damping = Eigen::VectorXd::Constant(6, 0.25);
+    Eigen::VectorXd paddedDamping;
+    jacobian.layout().gather(damping, paddedDamping);
+
+    BlockSparseSymmetricMatrix normal(jacobian);
+    normal.assign(jacobian, paddedDamping);
+    const Eigen::MatrixXd expected = dense.transpose() * dense + Eigen::MatrixXd(damping.asDiagonal());
+
+    const Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(6, 1.0, -2.0);
+    Eigen::VectorXd padded;
+    jacobian.layout().gather(x, padded);
+    Eigen::VectorXd product;
+    Eigen::VectorXd scalar;
+    normal.multiply(padded, product);
+    jacobian.layout().scatter(product, scalar);
+    EXPECT_TRUE(scalar.isApprox(expected * x));
+
+    BlockCholesky cholesky;
+    cholesky.analyze(normal);
+    ASSERT_TRUE(cholesky.factorize(normal));
+    EXPECT_GE(cholesky.blockNonZeros(), normal.blockNonZeros());
+
+    const Eigen::VectorXd b = Eigen::VectorXd::LinSpaced(6, -3.0, 3.0);
+    jacobian.layout().gather(b, padded);
+    Eigen::VectorXd solution;
+    cholesky.solve(padded, solution);
+    jacobian.layout().scatter(solution, scalar);
+    EXPECT_TRUE(scalar.isApprox(expected.ldlt().solve(b), 1e-10));
+}
+
+TEST_F(BlockSparseMatrixTest, RequirementFunctionSystemProvidesBlockJacobian) {
+    RequirementFunctionSystem system;
+    for (const auto& function : functions) {
+        system.addFunction(function);
+    }
+    const auto& blockJacobian = system.blockJ();
+    EXPECT_TRUE(Eigen::MatrixXd(blockJacobian.toSparse()).isApprox(Eigen::MatrixXd(system.J())));
+    EXPECT_EQ(blockJacobian.layout().variableCount(), system.getAllVars().size());
+}
+
+TEST(IterativeLMSolverBlockCholeskyTest, SolvesDistanceChain) {
+    constexpr std::size_t pointCount = 20;
+    std::vector<std::array<double, 2>> points(pointCount);
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        points[i] = {7.0 * static_cast<double>(i), (i % 2 == 0) ? 0.0 : 3.0};
+    }
+    std::vector<std::shared_ptr<RequirementFunction>> functions;
+    std::vector<VAR> variables;
+    std::vector<std::pair<VAR, VAR>> blocks;
+    for (std::size_t i = 0; i + 1 < pointCount; ++i) {
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(
+            std::vector<VAR>{&points[i][0], &points[i][1], &points[i + 1][0], &points[i + 1][1]}, 10.0));
+        variables.push_back(&points[i + 1][0]);
+        variables.push_back(&points[i + 1][1]);
+        blocks.emplace_back(&points[i + 1][0], &points[i + 1][1]);
+    }
+
+    IterativeLMSolver solver(functions, variables, blocks);
+    IterativeLMSolver::Options options;
+    options.innerSolver = IterativeLMSolver::InnerSolver::BlockCholesky;
+    solver.setOptions(options);
+    ASSERT_TRUE(solver.solve());
+    EXPECT_EQ(solver.getInnerIterationCount(), 0U);
+    for (std::size_t i = 0; i + 1 < pointCount; ++i) {
+        EXPECT_NEAR(std::hypot(points[i + 1][0] - points[i][0], points[i + 1][1] - points[i][1]), 10.0, 1e-8);
+    }
+}
+
+TEST(BlockCholeskyTest, FillReducingOrderKeepsStarFactorSparse) {
+    // A hub point tied to every other point: eliminated first, it fills in every leaf pair.
+    constexpr std::size_t leafCount = 12;
+    std::array<double, 2> hub{0.0, 0.0};
+    std::vector<std::array<double, 2>> leaves(leafCount);
+    std::vector<std::shared_ptr<RequirementFunction>> functions;
+    std::vector<VAR> variables{&hub[0], &hub[1]};
+    std::vector<std::pair<VAR, VAR>> blocks{{&hub[0], &hub[1]}};
+    std::unordered_map<VAR, Eigen::Index> columnOf;
+    for (std::size_t i = 0; i < leafCount; ++i) {
+        leaves[i] = {std::cos(static_cast<double>(i)), std::sin(static_cast<double>(i))};
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(
+            std::vector<VAR>{&hub[0], &hub[1], &leaves[i][0], &leaves[i][1]}, 2.0));
+        variables.push_back(&leaves[i][0]);
+        variables.push_back(&leaves[i][1]);
+        blocks.emplace_back(&leaves[i][0], &leaves[i][1]);
+    }
+    for (std::size_t j = 0; j < variables.size(); ++j) {
+        columnOf.emplace(variables[j], static_cast<Eigen::Index>(j));
+    }
+
+    BlockSparseJacobian natural(BlockLayout(variables, blocks), functions, columnOf);
+    const auto order = natural.fillReducingOrder();
+    ASSERT_EQ(order.size(), leafCount + 1);
+    EXPECT_EQ(order.back(), 0U);
+    BlockSparseJacobian ordered(natural.layout().permuted(order), functions, columnOf);
+
+    const Eigen::VectorXd damping = Eigen::VectorXd::Constant(natural.layout().paddedSize(), 0.1);
+    BlockSparseSymmetricMatrix naturalNormal(natural);
+    BlockCholesky naturalFactor;
+    naturalFactor.analyze(naturalNormal);
+    BlockSparseSymmetricMatrix orderedNormal(ordered);
+    BlockCholesky orderedFactor;
+    orderedFactor.analyze(orderedNormal);
+    EXPECT_EQ(naturalFactor.blockNonZeros(), (leafCount + 1) * (leafCount + 2) / 2);
+    EXPECT_EQ(orderedFactor.blockNonZeros(), 2 * leafCount + 1);
+
+    // Both orders solve the same system.
+    natural.assemble(functions);
+    ordered.assemble(functions);
+    naturalNormal.assign(natural, damping);
+    orderedNormal.assign(ordered, damping);
+    ASSERT_TRUE(naturalFactor.factorize(naturalNormal));
+    ASSERT_TRUE(orderedFactor.factorize(orderedNormal));
+    const Eigen::VectorXd rhs = Eigen::VectorXd::LinSpaced(static_cast<Eigen::Index>(variables.size()), -1.0, 1.0);
+    Eigen::VectorXd naturalPadded, orderedPadded, naturalStep, orderedStep, naturalScalar, orderedScalar;
+    natural.layout().gather(rhs, naturalPadded);
+    ordered.layout().gather(rhs, orderedPadded);
+    naturalFactor.solve(naturalPadded, naturalStep);
+    orderedFactor.solve(orderedPadded, orderedStep);
+    natural.layout().scatter(naturalStep, naturalScalar);
+    ordered.layout().scatter(orderedStep, orderedScalar);
+    EXPECT_TRUE(orderedScalar.isApprox(naturalScalar, 1e-10));
+}
+
+TEST(BlockSparseSymmetricMatrixTest, LargeParallelAssemblyMatchesSparseProduct) {
+    // Enough rows for assign() to accumulate several per-chunk buffers.
+    constexpr std::size_t pointCount = 5000;
+    std::vector<std::array<double, 2>> points(pointCount);
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        points[i] = {static_cast<double>(i), 0.2 * static_cast<double>(i % 5)};
+    }
+    std::vector<std::shared_ptr<RequirementFunction>> functions;
+    std::vector<VAR> variables;
+    std::vector<std::pair<VAR, VAR>> blocks;
+    std::unordered_map<VAR, Eigen::Index> columnOf;
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        columnOf.emplace(&points[i][0], static_cast<Eigen::Index>(variables.size()));
+        variables.push_back(&points[i][0]);
+        columnOf.emplace(&points[i][1], static_cast<Eigen::Index>(variables.size()));
+        variables.push_back(&points[i][1]);
+        blocks.emplace_back(&points[i][0], &points[i][1]);
+    }
+    for (std::size_t i = 0; i + 2 < pointCount; ++i) {
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(
+            std::vector<VAR>{&points[i][0], &points[i][1], &points[i + 2][0], &points[i + 2][1]}, 2.5));
+    }
+
+    BlockSparseJacobian jacobian(BlockLayout(variables, blocks), functions, columnOf);
+    jacobian.assemble(functions);
+    BlockSparseSymmetricMatrix normal(jacobian);
+    const Eigen::VectorXd damping = Eigen::VectorXd::Constant(jacobian.layout().paddedSize(), 0.5);
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        normal.assign(jacobian, damping);
+    }
+
+    const Eigen::SparseMatrix<double> J = jacobian.toSparse();
+    Eigen::SparseMatrix<double> expected = Eigen::SparseMatrix<double>(J.transpose()) * J;
+    for (Eigen::Index j = 0; j < expected.cols(); ++j) {
+        expected.coeffRef(j, j) += 0.5;
+    }
+    EXPECT_NEAR((normal.toSparse() - expected).norm(), 0.0, 1e-9);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "IterativeLMSolver.h"
+#include "RequirementFunction.h"
+#include <array>
+#include <cmath>
+
+using namespace OurPaintDCM::System;
+using namespace OurPaintDCM::Function;
+
+TEST(IterativeLMSolverTest, SolvesDistanceChainFromAnchoredPoint) {
+    constexpr std::size_t pointCount = 40;
+    std::vector<std::array<double, 2>> points(pointCount);
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        points[i] = {7.0 * static_cast<double>(i), (i % 2 == 0) ? 0.0 : 3.0};
+    }
+
+    std::vector<std::shared_ptr<RequirementFunction>> functions;
+    for (std::size_t i = 0; i + 1 < pointCount; ++i) {
+        functions.push_back(std::make_shared<PointPointDistanceFunction>(
+            std::vector<VAR>{&points[i][0], &points[i][1], &points[i + 1][0], &points[i + 1][1]}, 10.0));
+    }
+
+    // The first point is not a variable, so it stays where it is.
+    std::vector<VAR> variables;
+    std::vector<std::pair<VAR, VAR>> blocks;
+    for (std::size_t i = 1; i < pointCount; ++i) {
+        variables.push_back(&points[i][0]);
+        variables.push_back(&points[i][1]);
+        blocks.emplace_back(&points[i][0], &points[i][1]);
+    }
+
+    IterativeLMSolver solver(functions, variables, blocks);
+    EXPECT_TRUE(solver.solve());
+    EXPECT_TRUE(solver.isConverged());
+    EXPECT_GT(solver.getIterationCount(), 0U);
+    EXPECT_GT(solver.getInnerIterationCount(), 0U);
+
+    EXPECT_EQ(points[0][0], 0.0);
+    EXPECT_EQ(points[0][1], 0.0);
+    for (std::size_t i = 0; i + 1 < pointCount; ++i) {
+        const double distance = std::hypot(points[i + 1][0] - points[i][0], points[i + 1][1] - points[i][1]);
+        EXPECT_NEAR(distance, 10.0, 1e-8);
+    }
+}
+
+TEST(IterativeLMSolverTest, AliasedVariablesFollowTheirRepresentative) {
+    double x1 = 0.0, y1 = 0.0, x2 = 4.0, y2 = 1.0;
+    double alias = 0.0;
+    auto distance = std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x1, &y1, &x2, &y2}, 5.0);
+    auto horizontal = std::make_shared<HorizontalFunction>(std::vector<VAR>{&x1, &alias, &x2, &y2});
+
+    IterativeLMSolver solver({distance, horizontal}, {&x2, &y2}, {{&x2, &y2}}, {{&alias, &y1}});
+    ASSERT_TRUE(solver.solve());
+    EXPECT_NEAR(std::hypot(x2 - x1, y2 - y1), 5.0, 1e-9);
+    EXPECT_NEAR(y2, alias, 1e-9);
+    EXPECT_EQ(alias, y1);
+}
+
+TEST(IterativeLMSolverTest, AlreadySatisfiedSystemTakesNoIterations) {
+    double x1 = 0.0, y1 = 0.0, x2 = 3.0, y2 = 4.0;
+    auto distance = std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x1, &y1, &x2, &y2}, 5.0);
+
+    IterativeLMSolver solver({distance}, {&x2, &y2});
+    EXPECT_TRUE(solver.solve());
+    EXPECT_EQ(solver.getIterationCount(), 0U);
+    EXPECT_EQ(x2, 3.0);
+    EXPECT_EQ(y2, 4.0);
+}
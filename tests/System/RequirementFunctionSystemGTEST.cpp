@@ -2,6 +2,9 @@
 #include "RequirementFunctionSystem.h"
 #include "RequirementFunction.h"
 #include <Eigen/Dense>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 
 using namespace OurPaintDCM::System;
 using namespace OurPaintDCM::Function;
@@ -74,3 +77,110 @@ TEST(RequirementFunctionSystemTest, ClearResetsSystem) {
     EXPECT_EQ(system.J().rows(), 0);
     EXPECT_EQ(system.J().cols(), 0);
 }
+
+TEST(RequirementFunctionSystemTest, CachedNormalMatrixAndResidualBuffer) {
+    RequirementFunctionSystem system;
+
+    double x1 = 0, y1 = 0, x2 = 3, y2 = 4, x3 = 1, y3 = 7;
+    system.addFunction(std::make_shared<PointPointDistanceFunction>(std::vector<double*>{&x1, &y1, &x2, &y2}, 4.0));
+    system.addFunction(std::make_shared<PointPointDistanceFunction>(std::vector<double*>{&x2, &y2, &x3, &y3}, 2.0));
+    system.addFunction(std::make_shared<VerticalFunction>(std::vector<double*>{&x1, &y1, &x3, &y3}));
+
+    static_assert(std::is_same_v<decltype(system.J()), const Eigen::SparseMatrix<double>&>,
+                  "J() keeps returning the column-major matrix");
+    const auto& J = system.J();
+    EXPECT_EQ(&J, &system.J());
+    const Eigen::MatrixXd dense = Eigen::MatrixXd(J);
+
+    const auto& upper = system.JTJUpper();
+    const Eigen::MatrixXd expected = dense.transpose() * dense;
+    EXPECT_TRUE(Eigen::MatrixXd(upper).isApprox(Eigen::MatrixXd(expected.triangularView<Eigen::Upper>())));
+    EXPECT_TRUE(Eigen::MatrixXd(system.JTJ()).isApprox(expected));
+    const double* values = upper.valuePtr();
+
+    Eigen::VectorXd buffer(3);
+    system.residualsInto(buffer);
+    EXPECT_TRUE(buffer.isApprox(system.residuals()));
+    EXPECT_NEAR(buffer[0], 1.0, 1e-12);
+    Eigen::VectorXd wrongSize(2);
+    EXPECT_THROW(system.residualsInto(wrongSize), std::invalid_argument);
+
+    // A move refreshes the values in the existing pattern.
+    x3 = 2.0;
+    system.updateJ();
+    const Eigen::MatrixXd movedJ = Eigen::MatrixXd(system.J());
+    EXPECT_EQ(system.JTJUpper().valuePtr(), values);
+    EXPECT_TRUE(Eigen::MatrixXd(system.JTJ()).isApprox(movedJ.transpose() * movedJ));
+}
+
+TEST(RequirementFunctionSystemTest, JacobianKeepsZeroPartialsInItsFixedPattern) {
+    RequirementFunctionSystem system;
+
+    // The points share y, so both y partials are currently zero.
+    double x1 = 0, y1 = 1, x2 = 3, y2 = 1;
+    system.addFunction(std::make_shared<PointPointDistanceFunction>(std::vector<double*>{&x1, &y1, &x2, &y2}, 5.0));
+
+    const auto& J = system.J();
+    const double* values = J.valuePtr();
+    EXPECT_EQ(J.nonZeros(), 4);
+    EXPECT_EQ(J.coeff(0, 1), 0.0);
+    EXPECT_EQ(J.coeff(0, 3), 0.0);
+    EXPECT_NEAR(J.coeff(0, 0), -1.0, 1e-12);
+
+    // New values land in the same storage.
+    y2 = 5;
+    system.updateJ();
+    const auto& moved = system.J();
+    EXPECT_EQ(&moved, &J);
+    EXPECT_EQ(moved.valuePtr(), values);
+    EXPECT_EQ(moved.nonZeros(), 4);
+    EXPECT_NEAR(moved.coeff(0, 1), -0.8, 1e-12);
+    EXPECT_NEAR(moved.coeff(0, 3), 0.8, 1e-12);
+}
+
+TEST(RequirementFunctionSystemTest, LargeSystemMatchesRowByRowAssembly) {
+    // Enough rows for the thread pool to split the assembly into several chunks.
+    constexpr size_t pointCount = 6000;
+    std::vector<double> coords(2 * pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        coords[2 * i] = static_cast<double>(i) + 0.1 * static_cast<double>(i % 7);
+        coords[2 * i + 1] = 0.3 * static_cast<double>(i % 11);
+    }
+
+    RequirementFunctionSystem system;
+    for (size_t i = 0; i + 1 < pointCount; ++i) {
+        std::vector<double*> vars = {&coords[2 * i], &coords[2 * i + 1], &coords[2 * i + 2], &coords[2 * i + 3]};
+        system.addFunction(std::make_shared<PointPointDistanceFunction>(vars, 1.0));
+    }
+    system.updateJ();
+
+    const auto& functions = system.getFunctions();
+    const auto vars = system.getAllVars();
+    std::unordered_map<double*, int> column;
+    for (size_t j = 0; j < vars.size(); ++j) {
+        column.emplace(vars[j], static_cast<int>(j));
+    }
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::VectorXd expectedResiduals(static_cast<Eigen::Index>(functions.size()));
+    for (size_t i = 0; i < functions.size(); ++i) {
+        expectedResiduals[static_cast<Eigen::Index>(i)] = functions[i]->evaluate() * functions[i]->getWeight();
+        for (const auto& [var, value] : functions[i]->gradient()) {
+            triplets.emplace_back(static_cast<int>(i), column.at(var), value);
+        }
+    }
+    Eigen::SparseMatrix<double> expectedJ(static_cast<Eigen::Index>(functions.size()),
+                                          static_cast<Eigen::Index>(vars.size()));
+    expectedJ.setFromTriplets(triplets.begin(), triplets.end());
+    const Eigen::SparseMatrix<double> expectedJTJ = Eigen::SparseMatrix<double>(expectedJ.transpose()) * expectedJ;
+
+    EXPECT_NEAR((Eigen::SparseMatrix<double>(system.J()) - expectedJ).norm(), 0.0, 1e-12);
+    EXPECT_NEAR((system.JTJ() - expectedJTJ).norm(), 0.0, 1e-10);
+    EXPECT_NEAR((system.residuals() - expectedResiduals).norm(), 0.0, 1e-12);
+
+    // Refreshing values after a move keeps the pattern and tracks the new gradients.
+    coords[5] += 0.5;
+    system.updateJ();
+    const auto& moved = functions[1]->gradient();
+    const Eigen::SparseMatrix<double> J = system.J();
+    EXPECT_DOUBLE_EQ(J.coeff(1, column.at(&coords[5])), moved.at(&coords[5]));
+}
@@ -53,6 +53,27 @@ TEST_F(RequirementSystemTest, AddPointPointDist) {
     EXPECT_NEAR(residuals[0], 0.0, 1e-9);
 }
 
+TEST_F(RequirementSystemTest, AddRequirementsAssignsIdsLikeSequentialAdds) {
+    RequirementSystem system(&storage);
+    auto explicitId = RequirementDescriptor::pointPointDist(p1Id, p2Id, 5.0);
+    explicitId.id = ID(5);
+    const auto ids = system.addRequirements(std::vector<RequirementDescriptor>{
+        RequirementDescriptor::horizontal(line2Id), explicitId, RequirementDescriptor::vertical(line1Id)});
+    EXPECT_EQ(ids, (std::vector<ID>{ID(1), ID(5), ID(6)}));
+    EXPECT_EQ(system.addRequirement(RequirementDescriptor::pointOnLine(centerId, line1Id)), ID(7));
+}
+
+TEST_F(RequirementSystemTest, AddRequirementsRejectsExplicitIdRepeatingGeneratedOne) {
+    RequirementSystem system(&storage);
+    auto repeated = RequirementDescriptor::pointPointDist(p1Id, p3Id, 6.0);
+    repeated.id = ID(1);
+    EXPECT_THROW(system.addRequirements(std::vector<RequirementDescriptor>{
+                     RequirementDescriptor::pointPointDist(p1Id, p2Id, 5.0), repeated}),
+                 std::invalid_argument);
+    EXPECT_TRUE(system.getRequirements().empty());
+    EXPECT_EQ(system.addRequirement(RequirementDescriptor::pointPointDist(p1Id, p2Id, 5.0)), ID(1));
+}
+
 TEST_F(RequirementSystemTest, AddPointOnPointCreatesAliasWithoutResidual) {
     RequirementSystem system(&storage);
     system.addPointOnPoint(p1Id, p2Id);
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "../AllocationCounter.h"
+#include "VariableRegistry.h"
+#include <vector>
+
+using namespace OurPaintDCM::System;
+using namespace OurPaintDCM::Testing;
+
+TEST(VariableRegistryTest, SharedCoordinateInternsToOneEntry) {
+    double x = 1.0, y = 2.0;
+    VariableRegistry registry;
+
+    // x is shared by three requirements, y by one.
+    const std::size_t first = registry.intern(&x);
+    EXPECT_EQ(registry.intern(&y), 1U);
+    EXPECT_EQ(registry.intern(&x), first);
+    EXPECT_EQ(registry.intern(&x), first);
+
+    EXPECT_EQ(registry.size(), 2U);
+    EXPECT_EQ(registry.refs(), (std::vector<double*>{&x, &y}));
+    EXPECT_EQ(registry.indexOf(&x), first);
+    EXPECT_EQ(registry.variable(first), registry.variable(registry.indexOf(&x)));
+    EXPECT_NE(registry.variable(0), registry.variable(1));
+}
+
+TEST(VariableRegistryTest, VariablesKeepTheirAddressesWhileInterning) {
+    std::vector<double> values(1000, 0.0);
+    VariableRegistry registry;
+    registry.intern(&values[0]);
+    Variable* const first = registry.variable(0);
+    for (double& value : values) {
+        registry.intern(&value);
+    }
+    EXPECT_EQ(registry.variable(0), first);
+}
+
+TEST(VariableRegistryTest, InterningAllocatesVariablesInChunks) {
+    constexpr std::size_t kCount = 1024;
+    std::vector<double> values(kCount, 0.0);
+    VariableRegistry registry;
+
+    AllocationScope scope;
+    for (double& value : values) {
+        registry.intern(&value);
+    }
+    // One hash node per coordinate, plus amortized table, vector and deque growth. A Variable
+    // allocated per coordinate would add kCount more.
+    EXPECT_LT(scope.count().calls, kCount + kCount / 8);
+
+    // Interning coordinates already present, as requirements sharing a point do, allocates nothing.
+    AllocationScope repeat;
+    for (double& value : values) {
+        registry.intern(&value);
+    }
+    EXPECT_EQ(repeat.count().calls, 0U);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "DCMManager.h"
+#include "Instrumentation.h"
+#include <thread>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Utils;
+
+class InstrumentationTest : public ::testing::Test {
+protected:
+    void SetUp() override { resetInstrumentation(); }
+};
+
+TEST_F(InstrumentationTest, ScopedTimerRecordsCountTotalAndMax) {
+    {
+        ScopedProbeTimer timer(Probe::ET_OPTIMIZE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    recordProbe(Probe::ET_OPTIMIZE, std::chrono::nanoseconds(5));
+    countProbe(Probe::ET_GEOMETRY_GET);
+
+    const auto snapshot = instrumentationSnapshot();
+    const auto& optimize = snapshot[Probe::ET_OPTIMIZE];
+    EXPECT_EQ(optimize.count, 2U);
+    EXPECT_GE(optimize.max, std::chrono::milliseconds(2));
+    EXPECT_EQ(optimize.total, optimize.max + std::chrono::nanoseconds(5));
+    EXPECT_EQ(snapshot[Probe::ET_GEOMETRY_GET].count, 1U);
+    EXPECT_EQ(snapshot[Probe::ET_GEOMETRY_GET].total.count(), 0);
+
+    resetInstrumentation();
+    EXPECT_EQ(instrumentationSnapshot()[Probe::ET_OPTIMIZE].count, 0U);
+}
+
+TEST_F(InstrumentationTest, SnapshotSumsLiveAndExitedThreads) {
+    constexpr int kThreads = 4;
+    constexpr int kCalls = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kCalls; ++i) {
+                countProbe(Probe::ET_MERGE_COMPONENTS);
+            }
+            recordProbe(Probe::ET_BUILD_PIPELINE, std::chrono::nanoseconds(100 * (t + 1)));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    countProbe(Probe::ET_MERGE_COMPONENTS);
+
+    const auto snapshot = instrumentationSnapshot();
+    EXPECT_EQ(snapshot[Probe::ET_MERGE_COMPONENTS].count, static_cast<std::uint64_t>(kThreads * kCalls + 1));
+    EXPECT_EQ(snapshot[Probe::ET_BUILD_PIPELINE].count, static_cast<std::uint64_t>(kThreads));
+    EXPECT_EQ(snapshot[Probe::ET_BUILD_PIPELINE].total, std::chrono::nanoseconds(1000));
+    EXPECT_EQ(snapshot[Probe::ET_BUILD_PIPELINE].max, std::chrono::nanoseconds(400));
+}
+
+TEST_F(InstrumentationTest, ProbeNamesAreDistinct) {
+    for (std::size_t i = 0; i < kProbeCount; ++i) {
+        EXPECT_FALSE(probeName(static_cast<Probe>(i)).empty());
+        for (std::size_t j = i + 1; j < kProbeCount; ++j) {
+            EXPECT_NE(probeName(static_cast<Probe>(i)), probeName(static_cast<Probe>(j)));
+        }
+    }
+}
+
+TEST_F(InstrumentationTest, SolveHitsHotPathProbesOnlyWhenEnabled) {
+    DCMManager manager;
+    manager.setConstructiveSolveEnabled(false);
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    ASSERT_TRUE(manager.solveDirty());
+
+    const auto snapshot = instrumentationSnapshot();
+    for (const Probe probe : {Probe::ET_GEOMETRY_GET, Probe::ET_REBUILD_FUNCTIONS, Probe::ET_BUILD_SUBSYSTEM,
+                              Probe::ET_BUILD_PIPELINE, Probe::ET_OPTIMIZE, Probe::ET_MERGE_COMPONENTS}) {
+        if constexpr (kInstrumentationEnabled) {
+            EXPECT_GT(snapshot[probe].count, 0U) << probeName(probe);
+        } else {
+            EXPECT_EQ(snapshot[probe].count, 0U) << probeName(probe);
+        }
+    }
+}
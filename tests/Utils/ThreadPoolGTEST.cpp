@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "ThreadPool.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+using namespace OurPaintDCM::Utils;
+
+TEST(ThreadPoolTest, CoversEveryIndexExactlyOnce) {
+    ThreadPool pool(4);
+    std::vector<int> hits(10000, 0);
+    pool.parallelFor(hits.size(), 100, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            ++hits[i];
+        }
+    });
+    EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<long>(hits.size()));
+}
+
+TEST(ThreadPoolTest, ChunksAreContiguousAndBoundedByThreadCount) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.threadCount(), 3U);
+    EXPECT_EQ(pool.chunkCount(0, 10), 0U);
+    EXPECT_EQ(pool.chunkCount(5, 10), 1U);
+    EXPECT_EQ(pool.chunkCount(25, 10), 2U);
+    EXPECT_EQ(pool.chunkCount(1000, 10), 3U);
+
+    std::vector<std::pair<std::size_t, std::size_t>> ranges(3);
+    pool.parallelFor(1000, 10, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        ranges[chunk] = {begin, end};
+    });
+    EXPECT_EQ(ranges[0].first, 0U);
+    EXPECT_EQ(ranges[0].second, ranges[1].first);
+    EXPECT_EQ(ranges[1].second, ranges[2].first);
+    EXPECT_EQ(ranges[2].second, 1000U);
+}
+
+TEST(ThreadPoolTest, PerChunkBuffersMergeToSerialResult) {
+    ThreadPool pool(4);
+    const std::size_t count = 100000;
+    std::vector<long long> partial(pool.chunkCount(count, 1000), 0);
+    for (int repeat = 0; repeat < 20; ++repeat) {
+        std::fill(partial.begin(), partial.end(), 0);
+        pool.parallelFor(count, 1000, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                partial[chunk] += static_cast<long long>(i);
+            }
+        });
+        EXPECT_EQ(std::accumulate(partial.begin(), partial.end(), 0LL),
+                  static_cast<long long>(count) * (count - 1) / 2);
+    }
+}
+
+TEST(ThreadPoolTest, NestedCallsRunInline) {
+    ThreadPool pool(4);
+    std::vector<int> hits(4 * 64, 0);
+    pool.parallelFor(4, 1, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t outer = begin; outer < end; ++outer) {
+            pool.parallelFor(64, 1, [&](std::size_t, std::size_t innerBegin, std::size_t innerEnd) {
+                for (std::size_t inner = innerBegin; inner < innerEnd; ++inner) {
+                    ++hits[outer * 64 + inner];
+                }
+            });
+        }
+    });
+    EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<long>(hits.size()));
+}
+
+TEST(ThreadPoolTest, RethrowsFirstExceptionAndStaysUsable) {
+    ThreadPool pool(4);
+    EXPECT_THROW(pool.parallelFor(8, 1, [](std::size_t chunk, std::size_t, std::size_t) {
+        if (chunk == 2) {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+
+    std::size_t total = 0;
+    std::vector<std::size_t> sizes(4, 0);
+    pool.parallelFor(8, 1, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        sizes[chunk] = end - begin;
+    });
+    total = std::accumulate(sizes.begin(), sizes.end(), std::size_t{0});
+    EXPECT_EQ(total, 8U);
+}
+
+TEST(ThreadPoolTest, SingleThreadPoolRunsInline) {
+    ThreadPool pool(1);
+    EXPECT_EQ(pool.threadCount(), 1U);
+    int calls = 0;
+    pool.parallelFor(100, 1, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        EXPECT_EQ(chunk, 0U);
+        EXPECT_EQ(begin, 0U);
+        EXPECT_EQ(end, 100U);
+        ++calls;
+    });
+    EXPECT_EQ(calls, 1);
+}
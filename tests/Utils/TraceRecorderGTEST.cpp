@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "DCMManager.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OurPaintDCM;
+using namespace OurPaintDCM::Utils;
+
+namespace {
+std::size_t countEvents(const std::vector<TraceEvent>& events, const std::string& name, TracePhase phase) {
+    return static_cast<std::size_t>(std::count_if(events.begin(), events.end(), [&](const TraceEvent& event) {
+        return event.phase == phase && name == event.name;
+    }));
+}
+}
+
+TEST(TraceRecorderTest, RecordsOnlyWhileStarted) {
+    TraceRecorder recorder(16);
+    recorder.record("ignored", TracePhase::ET_INSTANT);
+    EXPECT_TRUE(recorder.events().empty());
+
+    recorder.start();
+    {
+        TraceScope outer("outer", recorder);
+        TraceScope inner("inner", recorder);
+    }
+    recorder.stop();
+    recorder.record("ignored", TracePhase::ET_INSTANT);
+
+    const auto events = recorder.events();
+    ASSERT_EQ(events.size(), 4U);
+    EXPECT_STREQ(events[0].name, "outer");
+    EXPECT_EQ(events[0].phase, TracePhase::ET_BEGIN);
+    EXPECT_STREQ(events[1].name, "inner");
+    EXPECT_STREQ(events[2].name, "inner");
+    EXPECT_EQ(events[2].phase, TracePhase::ET_END);
+    EXPECT_STREQ(events[3].name, "outer");
+    EXPECT_EQ(events[3].phase, TracePhase::ET_END);
+    for (std::size_t i = 1; i < events.size(); ++i) {
+        EXPECT_GE(events[i].timestamp, events[i - 1].timestamp);
+        EXPECT_EQ(events[i].thread, events[0].thread);
+    }
+}
+
+TEST(TraceRecorderTest, RingKeepsMostRecentEvents) {
+    TraceRecorder recorder(4);
+    recorder.start();
+    const char* names[] = {"e0", "e1", "e2", "e3", "e4", "e5"};
+    for (const char* name : names) {
+        recorder.record(name, TracePhase::ET_INSTANT);
+    }
+    EXPECT_EQ(recorder.recordedCount(), 6U);
+
+    const auto events = recorder.events();
+    ASSERT_EQ(events.size(), 4U);
+    EXPECT_STREQ(events.front().name, "e2");
+    EXPECT_STREQ(events.back().name, "e5");
+
+    recorder.start();
+    EXPECT_TRUE(recorder.events().empty());
+}
+
+TEST(TraceRecorderTest, ConcurrentThreadsGetDistinctIds) {
+    TraceRecorder recorder(1024);
+    recorder.start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&recorder] {
+            for (int i = 0; i < 50; ++i) {
+                TraceScope scope("work", recorder);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto events = recorder.events();
+    ASSERT_EQ(events.size(), 400U);
+    std::vector<std::uint32_t> ids;
+    for (const auto& event : events) {
+        ids.push_back(event.thread);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    EXPECT_EQ(ids.size(), 4U);
+}
+
+TEST(TraceRecorderTest, WritesChromeTraceJson) {
+    TraceRecorder recorder(8);
+    recorder.start();
+    {
+        TraceScope scope("span", recorder);
+        recorder.record("mark", TracePhase::ET_INSTANT);
+    }
+
+    std::ostringstream out;
+    recorder.writeChromeTrace(out);
+    const std::string json = out.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0U);
+    EXPECT_NE(json.find("\"name\":\"span\",\"cat\":\"dcm\",\"ph\":\"B\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"span\",\"cat\":\"dcm\",\"ph\":\"E\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"mark\",\"cat\":\"dcm\",\"ph\":\"i\",\"s\":\"t\""), std::string::npos);
+    EXPECT_NE(json.find("]}"), std::string::npos);
+}
+
+TEST(TraceRecorderTest, ManagerTracesPublicCallsAndSolvePhases) {
+    auto& recorder = TraceRecorder::shared();
+    recorder.start();
+
+    DCMManager manager;
+    manager.setConstructiveSolveEnabled(false);
+    auto p1 = manager.addFigure(FigureDescriptor::point(0.0, 0.0));
+    auto p2 = manager.addFigure(FigureDescriptor::point(3.0, 0.0));
+    manager.addRequirement(RequirementDescriptor::pointPointDist(p1, p2, 5.0));
+    ASSERT_TRUE(manager.solveDirty());
+    recorder.stop();
+
+    const auto events = recorder.events();
+    EXPECT_EQ(countEvents(events, "DCMManager::addFigure", TracePhase::ET_BEGIN), 2U);
+    EXPECT_EQ(countEvents(events, "DCMManager::solveDirty", TracePhase::ET_BEGIN), 1U);
+    EXPECT_EQ(countEvents(events, "DCMManager::solveDirty", TracePhase::ET_END), 1U);
+    EXPECT_GE(countEvents(events, "solve.subsystemBuild", TracePhase::ET_BEGIN), 1U);
+    EXPECT_GE(countEvents(events, "solve.pipelineBuild", TracePhase::ET_BEGIN), 1U);
+    EXPECT_GE(countEvents(events, "solve.optimize", TracePhase::ET_BEGIN), 1U);
+    EXPECT_GE(countEvents(events, "solveCacheMiss", TracePhase::ET_INSTANT), 1U);
+    EXPECT_GE(countEvents(events, "solveCacheInvalidated", TracePhase::ET_INSTANT), 1U);
+
+    std::size_t begins = 0;
+    std::size_t ends = 0;
+    for (const auto& event : events) {
+        begins += event.phase == TracePhase::ET_BEGIN;
+        ends += event.phase == TracePhase::ET_END;
+    }
+    EXPECT_EQ(begins, ends);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "RequirementFunctionFactory.h"
+#include "RequirementTraits.h"
 #include "GeometryStorage.h"
 
 using namespace OurPaintDCM::Function;
@@ -162,3 +163,39 @@ TEST_F(RequirementFunctionFactoryTest, VarsPointToStorageData) {
     *vars[1] = 200.0;
     EXPECT_DOUBLE_EQ(p1->y(), 200.0);
 }
+
+TEST(RequirementTraitsTest, ShapesMatchDescriptors) {
+    using namespace OurPaintDCM::Requirements;
+    using OurPaintDCM::Utils::RequirementType;
+    static_assert(RequirementTraits<RequirementType::ET_POINTLINEDIST>::variableCount == 6);
+    static_assert(RequirementTraits<RequirementType::ET_LINECIRCLEDIST>::variableCount == 7);
+    static_assert(RequirementTraits<RequirementType::ET_ARCCENTERONPERPENDICULAR>::variableCount == 6);
+    static_assert(RequirementTraits<RequirementType::ET_FIXCIRCLE>::rows == RowKind::Fix);
+    static_assert(RequirementTraits<RequirementType::ET_POINTONPOINT>::rows == RowKind::Coincidence);
+
+    const auto arityOf = [](RequirementType type) {
+        return visitRequirementType(type, [](auto tag) { return decltype(tag)::arity; });
+    };
+    EXPECT_EQ(arityOf(RequirementType::ET_POINTPOINTDIST), 2u);
+    EXPECT_EQ(arityOf(RequirementType::ET_VERTICAL), 1u);
+    EXPECT_EQ(arityOf(RequirementType::ET_LINELINEANGLE), 2u);
+
+    const auto typeOf = [](RequirementType type) {
+        return visitRequirementType(type, [](auto tag) { return decltype(tag)::type; });
+    };
+    EXPECT_EQ(typeOf(RequirementType::ET_FIXLINE), RequirementType::ET_FIXLINE);
+    EXPECT_EQ(typeOf(RequirementType::ET_HORIZONTAL), RequirementType::ET_HORIZONTAL);
+    EXPECT_THROW(typeOf(static_cast<RequirementType>(255)), std::invalid_argument);
+}
+
+TEST_F(RequirementFunctionFactoryTest, TraitVariableLayoutMatchesFactory) {
+    using namespace OurPaintDCM::Requirements;
+    using Traits = RequirementTraits<OurPaintDCM::Utils::RequirementType::ET_LINECIRCLEDIST>;
+    const auto expected = collectFigureVariables<Traits>(line1, circle);
+    auto func = RequirementFunctionFactory::createLineCircleDist(line1, circle, 1.0);
+    const auto vars = func->getVars();
+    ASSERT_EQ(vars.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(vars[i], expected[i]);
+    }
+}
@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
 #include "functions/RequirementFunction.h"
+#include "functions/Dual.h"
+#include <array>
 #include <cmath>
+#include <functional>
 #include <memory>
+#include <random>
 #include <unordered_map>
 #include <vector>
 
@@ -41,8 +45,212 @@ void expectGradientsNear(const std::unordered_map<VAR, double>& actual,
     }
 }
 
+// Hand-derived gradients the constraint classes used before their residuals were
+// differentiated automatically. They act as regression oracles for the dual-number path.
+namespace oracle {
+
+using Values = std::vector<double>;
+
+Values pointLineSignedDistance(const Values& v) {
+    const double dx = v[4] - v[2];
+    const double dy = v[5] - v[3];
+    const double lineLen = std::sqrt(dx * dx + dy * dy);
+    const double cross = (v[0] - v[2]) * dy - (v[1] - v[3]) * dx;
+    const double lineLen3 = lineLen * lineLen * lineLen;
+    return {dy / lineLen,
+            -dx / lineLen,
+            (v[1] - v[5]) / lineLen + cross * dx / lineLen3,
+            (v[4] - v[0]) / lineLen + cross * dy / lineLen3,
+            (v[3] - v[1]) / lineLen - cross * dx / lineLen3,
+            (v[0] - v[2]) / lineLen - cross * dy / lineLen3};
+}
+
+Values pointPointDistance(const Values& v) {
+    const double dx = v[2] - v[0];
+    const double dy = v[3] - v[1];
+    const double dist = std::sqrt(dx * dx + dy * dy);
+    return {-dx / dist, -dy / dist, dx / dist, dy / dist};
+}
+
+Values lineOnCircle(const Values& v) {
+    const double dx1 = v[0] - v[4];
+    const double dy1 = v[1] - v[5];
+    const double dx2 = v[2] - v[4];
+    const double dy2 = v[3] - v[5];
+    const double dist1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
+    const double dist2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
+    return {dx1 / dist1, dy1 / dist1, dx2 / dist2, dy2 / dist2,
+            -(dx1 / dist1 + dx2 / dist2), -(dy1 / dist1 + dy2 / dist2), -2.0};
+}
+
+Values lineLineParallel(const Values& v) {
+    const double dx1 = v[2] - v[0];
+    const double dy1 = v[3] - v[1];
+    const double dx2 = v[6] - v[4];
+    const double dy2 = v[7] - v[5];
+    return {-dy2, dx2, dy2, -dx2, dy1, -dx1, -dy1, dx1};
+}
+
+Values lineLinePerpendicular(const Values& v) {
+    const double dx1 = v[2] - v[0];
+    const double dy1 = v[3] - v[1];
+    const double dx2 = v[6] - v[4];
+    const double dy2 = v[7] - v[5];
+    return {-dx2, -dy2, dx2, dy2, -dx1, -dy1, dx1, dy1};
+}
+
+Values lineLineAngle(const Values& v) {
+    const double dx1 = v[2] - v[0];
+    const double dy1 = v[3] - v[1];
+    const double dx2 = v[6] - v[4];
+    const double dy2 = v[7] - v[5];
+    const double len1 = std::sqrt(dx1 * dx1 + dy1 * dy1);
+    const double len2 = std::sqrt(dx2 * dx2 + dy2 * dy2);
+    const double dot = dx1 * dx2 + dy1 * dy2;
+    const double len1_3 = len1 * len1 * len1;
+    const double len2_3 = len2 * len2 * len2;
+    const double dCosDdx1 = dx2 / (len1 * len2) - dx1 * dot / (len1_3 * len2);
+    const double dCosDdy1 = dy2 / (len1 * len2) - dy1 * dot / (len1_3 * len2);
+    const double dCosDdx2 = dx1 / (len1 * len2) - dx2 * dot / (len1 * len2_3);
+    const double dCosDdy2 = dy1 / (len1 * len2) - dy2 * dot / (len1 * len2_3);
+    return {-dCosDdx1, -dCosDdy1, dCosDdx1, dCosDdy1, -dCosDdx2, -dCosDdy2, dCosDdx2, dCosDdy2};
+}
+
+Values vertical(const Values& v) {
+    const double dx = v[2] - v[0];
+    const double dy = v[3] - v[1];
+    const double len = std::sqrt(dx * dx + dy * dy);
+    const double len3 = len * len * len;
+    return {-1.0 / len + dx * dx / len3, dx * dy / len3, 1.0 / len - dx * dx / len3, -dx * dy / len3};
+}
+
+Values horizontal(const Values& v) {
+    const double dx = v[2] - v[0];
+    const double dy = v[3] - v[1];
+    const double len = std::sqrt(dx * dx + dy * dy);
+    const double len3 = len * len * len;
+    return {dx * dy / len3, -1.0 / len + dy * dy / len3, -dx * dy / len3, 1.0 / len - dy * dy / len3};
+}
+
+Values arcCenterOnPerpendicular(const Values& v) {
+    const double dx = v[2] - v[0];
+    const double dy = v[3] - v[1];
+    const double mx = v[4] - 0.5 * (v[0] + v[2]);
+    const double my = v[5] - 0.5 * (v[1] + v[3]);
+    return {-mx - 0.5 * dx, -my - 0.5 * dy, mx - 0.5 * dx, my - 0.5 * dy, dx, dy};
+}
+
+} // namespace oracle
+
+using FunctionBuilder = std::function<std::unique_ptr<RequirementFunction>(const std::vector<VAR>&)>;
+
+/// Compare the gradient of the function built by @p make with @p oracleGradient at random points.
+void expectGradientMatchesOracle(std::size_t varCount, const FunctionBuilder& make,
+                                 oracle::Values (*oracleGradient)(const oracle::Values&)) {
+    std::mt19937 engine(20240611u);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::vector<double> values(varCount);
+    std::vector<VAR> vars;
+    for (double& value : values) {
+        vars.push_back(&value);
+    }
+    const auto function = make(vars);
+
+    for (int sample = 0; sample < 25; ++sample) {
+        for (double& value : values) {
+            value = coordinate(engine);
+        }
+        const auto grad = function->gradient();
+        const auto expected = oracleGradient(values);
+        for (std::size_t i = 0; i < varCount; ++i) {
+            EXPECT_NEAR(grad.at(vars[i]), expected[i], 1e-9 * (1.0 + std::abs(expected[i])))
+                << "sample " << sample << ", variable " << i;
+        }
+    }
+}
+
 } // namespace
 
+// ======== Dual ========
+TEST(DualTest, PropagatesDerivativesThroughArithmetic) {
+    using D = Dual<2>;
+    const D x = D::variable(3.0, 0);
+    const D y = D::variable(4.0, 1);
+
+    const D r = sqrt(x * x + y * y);
+    EQ(r.value(), 5.0);
+    EQ(r.derivative(0), 0.6);
+    EQ(r.derivative(1), 0.8);
+
+    const D q = (x - 1.0) / y;
+    EQ(q.value(), 0.5);
+    EQ(q.derivative(0), 0.25);
+    EQ(q.derivative(1), -2.0 / 16.0);
+
+    const D c = cos(x * 2.0);
+    EQ(c.derivative(0), -2.0 * std::sin(6.0));
+    EQ(sqrt(D::variable(0.0, 0)).derivative(0), 0.0);
+}
+
+// ======== Automatic gradients against the analytic oracles ========
+TEST(RequirementFunctionAutodiffTest, GradientsMatchAnalyticOracles) {
+    expectGradientMatchesOracle(6, [](const auto& v) { return std::make_unique<PointLineDistanceFunction>(v, 1.5); },
+                                oracle::pointLineSignedDistance);
+    expectGradientMatchesOracle(6, [](const auto& v) { return std::make_unique<PointOnLineFunction>(v); },
+                                oracle::pointLineSignedDistance);
+    expectGradientMatchesOracle(4, [](const auto& v) { return std::make_unique<PointPointDistanceFunction>(v, 2.0); },
+                                oracle::pointPointDistance);
+    expectGradientMatchesOracle(4, [](const auto& v) { return std::make_unique<PointOnPointFunction>(v); },
+                                oracle::pointPointDistance);
+    expectGradientMatchesOracle(7, [](const auto& v) { return std::make_unique<LineOnCircleFunction>(v); },
+                                oracle::lineOnCircle);
+    expectGradientMatchesOracle(8, [](const auto& v) { return std::make_unique<LineLineParallelFunction>(v); },
+                                oracle::lineLineParallel);
+    expectGradientMatchesOracle(8, [](const auto& v) { return std::make_unique<LineLinePerpendicularFunction>(v); },
+                                oracle::lineLinePerpendicular);
+    expectGradientMatchesOracle(8, [](const auto& v) { return std::make_unique<LineLineAngleFunction>(v, 0.75); },
+                                oracle::lineLineAngle);
+    expectGradientMatchesOracle(4, [](const auto& v) { return std::make_unique<VerticalFunction>(v); },
+                                oracle::vertical);
+    expectGradientMatchesOracle(4, [](const auto& v) { return std::make_unique<HorizontalFunction>(v); },
+                                oracle::horizontal);
+    expectGradientMatchesOracle(6, [](const auto& v) { return std::make_unique<ArcCenterOnPerpendicularFunction>(v); },
+                                oracle::arcCenterOnPerpendicular);
+}
+
+// The former hand-derived LineCircleDistanceFunction gradient still moved the projection with
+// the far endpoint after clamping, so it is checked against finite differences in each
+// projection regime (interior, before L1, past L2) instead.
+TEST(RequirementFunctionAutodiffTest, LineCircleDistanceGradientMatchesFiniteDifference) {
+    const std::array<std::array<double, 2>, 3> centers{{{1.0, 3.0}, {-3.0, 2.0}, {6.0, -2.5}}};
+    for (const auto& [centerX, centerY] : centers) {
+        double x1 = 0, y1 = 0, x2 = 4, y2 = 1, cx = centerX, cy = centerY, r = 0.5;
+        std::vector<VAR> vars = {&x1, &y1, &x2, &y2, &cx, &cy, &r};
+        LineCircleDistanceFunction f(vars, 0.25);
+        expectGradientsNear(f.gradient(), finiteDifferenceGradient(f, vars), vars);
+    }
+}
+
+TEST(RequirementFunctionAutodiffTest, RepeatedVariableAccumulates) {
+    double x = 1, y = 2, y2 = 6;
+    PointPointDistanceFunction shared({&x, &y, &x, &y2}, 0.0);
+    const auto grad = shared.gradient();
+    EXPECT_EQ(grad.size(), 3u);
+    EQ(grad.at(&x), 0.0);
+    EQ(grad.at(&y), -1.0);
+    EQ(grad.at(&y2), 1.0);
+}
+
+TEST(RequirementFunctionTest, ObjectBytesReportsDynamicType) {
+    double x1 = 0, y1 = 0, x2 = 3, y2 = 4;
+    const std::shared_ptr<RequirementFunction> distance =
+        std::make_shared<PointPointDistanceFunction>(std::vector<VAR>{&x1, &y1, &x2, &y2}, 5.0);
+    const std::shared_ptr<RequirementFunction> fix = std::make_shared<FixCoordinateFunction>(
+        OurPaintDCM::Utils::RequirementType::ET_FIXPOINT, std::vector<VAR>{&x1}, 0.0);
+    EXPECT_EQ(distance->objectBytes(), sizeof(PointPointDistanceFunction));
+    EXPECT_EQ(fix->objectBytes(), sizeof(FixCoordinateFunction));
+}
+
 // ======== PointPointDistanceFunction ========
 TEST(PointPointDistanceFunctionTest, EvaluateAndGradient) {
     double x1 = 0, y1 = 0, x2 = 3, y2 = 4;